@@ -108,11 +108,24 @@ else()
 	#
 	check_include_file("alloca.h"    HAVE_ALLOCA_H)
 endif()
+check_function_exists("fallocate"        HAVE_FALLOCATE)
 check_function_exists("getifaddrs"       HAVE_GETIFADDRS)
 check_function_exists("issetugid"        HAVE_ISSETUGID)
 check_function_exists("mkstemps"         HAVE_MKSTEMPS)
 check_function_exists("setresgid"        HAVE_SETRESGID)
 check_function_exists("setresuid"        HAVE_SETRESUID)
+check_function_exists("shm_open"         HAVE_SHM_OPEN)
+if(NOT HAVE_SHM_OPEN)
+	#
+	# Older glibc have shm_open() in librt.
+	#
+	include(CheckLibraryExists)
+	check_library_exists(rt shm_open "" HAVE_LIBRT)
+	if(HAVE_LIBRT)
+		set(HAVE_SHM_OPEN 1)
+		set(SHM_LIBRARIES rt)
+	endif()
+endif()
 check_function_exists("strptime"         HAVE_STRPTIME)
 if (APPLE)
 	cmake_push_check_state()
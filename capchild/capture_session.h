@@ -52,6 +52,7 @@ typedef struct _capture_session {
     capture_options *capture_opts;        /**< options for this capture */
     capture_file *cf;                     /**< handle to cfile */
     struct _info_data *cap_data_info;          /**< stats for this capture */
+    struct _capture_shm_ring *shm_ring;   /**< packets handed over by the child, if any */
 } capture_session;
 
 extern void
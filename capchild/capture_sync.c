@@ -70,6 +70,8 @@
 
 #include "sync_pipe.h"
 
+#include "caputils/capture_shm_ring.h"
+
 #ifdef _WIN32
 #include "caputils/capture-wpcap.h"
 #endif
@@ -128,6 +130,7 @@ capture_session_init(capture_session *cap_session, capture_file *cf)
 #endif
     cap_session->count                           = 0;
     cap_session->session_started                 = FALSE;
+    cap_session->shm_ring                        = NULL;
 }
 
 /* Append an arg (realloc) to an argc/argv array */
@@ -419,6 +422,11 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
         argv = sync_pipe_add_arg(argv, &argc, "-w");
         argv = sync_pipe_add_arg(argv, &argc, capture_opts->save_file);
     }
+
+#ifdef HAVE_SHM_OPEN
+    if (capture_opts->use_shm_ring)
+        argv = sync_pipe_add_arg(argv, &argc, "--shm-ring");
+#endif
     for (i = 0; i < argc; i++) {
         g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_DEBUG, "argv[%d]: %s", i, argv[i]);
     }
@@ -1652,6 +1660,8 @@ sync_pipe_input_cb(gint source, gpointer user_data)
         extcap_if_cleanup(cap_session->capture_opts, &primary_msg);
         capture_input_closed(cap_session, primary_msg);
         g_free(primary_msg);
+        capture_shm_ring_close(cap_session->shm_ring);
+        cap_session->shm_ring = NULL;
         return FALSE;
     }
 
@@ -1718,6 +1728,19 @@ sync_pipe_input_cb(gint source, gpointer user_data)
     case SP_DROPS:
         capture_input_drops(cap_session, (guint32)strtoul(buffer, NULL, 10));
         break;
+    case SP_SHM_RING: {
+        int err;
+
+        capture_shm_ring_close(cap_session->shm_ring);
+        cap_session->shm_ring = capture_shm_ring_open(buffer, &err);
+        if (cap_session->shm_ring == NULL) {
+            /* Not fatal; we'll read the packets from the file instead. */
+            g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_WARNING,
+                  "sync_pipe_input_cb: can't open shared memory ring %s: %s",
+                  buffer, g_strerror(err));
+        }
+        break;
+        }
     default:
         g_assert_not_reached();
     }
@@ -75,6 +75,8 @@
 #include <wsutil/file_util.h>
 
 #include <wsutil/wsgcrypt.h>
+#include <wsutil/pint.h>
+#include <wsutil/clopts_common.h>
 
 #ifndef HAVE_GETOPT_LONG
 #include "wsutil/wsgetopt.h"
@@ -89,6 +91,8 @@
 #define INVALID_OPTION 1
 #define BAD_FLAG 1
 
+#define LONGOPT_ISB_COUNTS (65536+1)
+
 /*
  * By default capinfos now continues processing
  * the next filename if and when wiretap detects
@@ -101,6 +105,12 @@
 
 static gboolean continue_after_wtap_open_offline_failure = TRUE;
 
+/*
+ * Get the packet count of pcapng files from their final Interface
+ * Statistics Blocks when possible, rather than by reading them.
+ */
+static gboolean use_isb_counts = FALSE;
+
 /*
  * table report variables
  */
@@ -156,10 +166,6 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_BUF_SIZE (1024 * 1024)
 
 
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_rmd160[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
 /*
  * If we have at least two packets with time stamps, and they're not in
  * order - i.e., the later packet has a time stamp older than the earlier
@@ -212,6 +218,10 @@ typedef struct _capture_info {
   GArray        *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
   guint32        pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
   GArray        *idb_info_strings;       /* array of IDB info strings */
+
+  gchar          file_sha256[HASH_STR_SIZE];
+  gchar          file_rmd160[HASH_STR_SIZE];
+  gchar          file_sha1[HASH_STR_SIZE];
 } capture_info;
 
 static char *decimal_point;
@@ -687,9 +697,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
   }
   if (cap_file_hashes) {
-    printf     ("SHA256:              %s\n", file_sha256);
-    printf     ("RIPEMD160:           %s\n", file_rmd160);
-    printf     ("SHA1:                %s\n", file_sha1);
+    printf     ("SHA256:              %s\n", cf_info->file_sha256);
+    printf     ("RIPEMD160:           %s\n", cf_info->file_rmd160);
+    printf     ("SHA1:                %s\n", cf_info->file_sha1);
   }
   if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -943,17 +953,17 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
   if (cap_file_hashes) {
     putsep();
     putquote();
-    printf("%s", file_sha256);
+    printf("%s", cf_info->file_sha256);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_rmd160);
+    printf("%s", cf_info->file_rmd160);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_sha1);
+    printf("%s", cf_info->file_sha1);
     putquote();
   }
 
@@ -1048,8 +1058,179 @@ cleanup_capture_info(capture_info *cf_info)
   cf_info->idb_info_strings = NULL;
 }
 
+/*
+ * Whether some of the infos asked for can only be found by reading all
+ * the records of the file; the others come from the file header, or from
+ * the file itself.
+ */
+static gboolean
+need_records(wtap *wth)
+{
+  return (cap_file_encap && wtap_file_encap(wth) == WTAP_ENCAP_PER_PACKET) ||
+         cap_snaplen || cap_data_size || cap_duration || cap_start_time ||
+         cap_end_time || cap_data_rate_byte || cap_data_rate_bit ||
+         cap_packet_size || cap_packet_rate || cap_order || cap_file_idb;
+}
+
+#define PCAPNG_SHB_TYPE     0x0A0D0D0A
+#define PCAPNG_ISB_TYPE     0x00000005
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4D
+#define PCAPNG_ISB_USRDELIV 8
+#define PCAPNG_MAX_ISB_SIZE 65536
+
+static gboolean
+read_at(int fd, gint64 offset, void *buf, unsigned int len)
+{
+  return ws_lseek64(fd, offset, SEEK_SET) == offset &&
+         ws_read(fd, buf, len) == (int)len;
+}
+
+/*
+ * Whether a pcapng file of size bytes has a single section. That's the
+ * case if the section length in its SHB covers the whole file; if the
+ * section length isn't given, the block headers are walked looking for
+ * another SHB, which reads 8 bytes per block but none of their data.
+ */
+static gboolean
+pcapng_single_section(int fd, gboolean big_endian, gint64 size)
+{
+  guint8   shb[24];
+  guint8   hdr[8];
+  guint32  block_len;
+  guint64  section_len;
+  gint64   pos;
+
+  if (!read_at(fd, 0, shb, sizeof shb))
+    return FALSE;
+  block_len = big_endian ? pntoh32(shb + 4) : pletoh32(shb + 4);
+  section_len = big_endian ? pntoh64(shb + 16) : pletoh64(shb + 16);
+  if (section_len != G_MAXUINT64)
+    return (guint64)size - block_len == section_len;
+
+  for (pos = block_len; pos < size; pos += block_len) {
+    if (!read_at(fd, pos, hdr, sizeof hdr))
+      return FALSE;
+    block_len = big_endian ? pntoh32(hdr + 4) : pletoh32(hdr + 4);
+    if (block_len < 12 || block_len % 4 != 0 ||
+        (big_endian ? pntoh32(hdr) : pletoh32(hdr)) == PCAPNG_SHB_TYPE)
+      return FALSE;
+  }
+  return pos == size;
+}
+
+/*
+ * Get the number of packets of a pcapng file from the Interface Statistics
+ * Blocks at its end, without reading the packets: dumpcap and other
+ * capture programs write an ISB for each interface when they close the
+ * file. This only works if the file isn't compressed, has a single
+ * section, and has a final ISB with the number of packets delivered to the
+ * user (isb_usrdeliv) for each of its num_interfaces interfaces, which is
+ * only the case for some capture programs (--isb-counts). The blocks are
+ * read backwards from the end of the file, using the total length at the
+ * end of each block.
+ */
+static gboolean
+isb_packet_count(wtap *wth, const char *filename, guint num_interfaces,
+                 guint32 *count)
+{
+  int       fd;
+  guint8    hdr[12];
+  guint8   *block = NULL;
+  gboolean  big_endian;
+  gint64    pos;
+  guint32   block_len, if_id, opt_off;
+  guint64  *delivered = NULL;         /* G_MAXUINT64 if not found yet */
+  guint64   total = 0;
+  guint     found = 0;
+  guint     i;
+  gboolean  ok = FALSE;
+
+  if (wtap_file_type_subtype(wth) != WTAP_FILE_TYPE_SUBTYPE_PCAPNG ||
+      wtap_iscompressed(wth) || num_interfaces == 0)
+    return FALSE;
+
+  fd = ws_open(filename, O_RDONLY|O_BINARY, 0000);
+  if (fd == -1)
+    return FALSE;
+
+  if (!read_at(fd, 0, hdr, sizeof hdr) || pletoh32(hdr) != PCAPNG_SHB_TYPE)
+    goto done;
+  if (pletoh32(hdr + 8) == PCAPNG_BYTE_ORDER)
+    big_endian = FALSE;
+  else if (pntoh32(hdr + 8) == PCAPNG_BYTE_ORDER)
+    big_endian = TRUE;
+  else
+    goto done;
+#define ISB_GET32(p) (big_endian ? pntoh32(p) : pletoh32(p))
+#define ISB_GET64(p) (big_endian ? pntoh64(p) : pletoh64(p))
+
+  pos = ws_lseek64(fd, 0, SEEK_END);
+  if (pos < 0 || !pcapng_single_section(fd, big_endian, pos))
+    goto done;
+  delivered = g_new(guint64, num_interfaces);
+  for (i = 0; i < num_interfaces; i++)
+    delivered[i] = G_MAXUINT64;
+  block = (guint8 *)g_malloc(PCAPNG_MAX_ISB_SIZE);
+
+  while (found < num_interfaces && pos > 12) {
+    if (!read_at(fd, pos - 4, hdr, 4))
+      break;
+    block_len = ISB_GET32(hdr);
+    /* An ISB has at least a header, an interface ID and a time stamp */
+    if (block_len < 24 || block_len % 4 != 0 || block_len > PCAPNG_MAX_ISB_SIZE ||
+        block_len > pos - 12 || !read_at(fd, pos - block_len, block, block_len) ||
+        ISB_GET32(block) != PCAPNG_ISB_TYPE || ISB_GET32(block + 4) != block_len)
+      break;
+    pos -= block_len;
+
+    if_id = ISB_GET32(block + 8);
+    if (if_id >= num_interfaces)
+      goto done;
+    if (delivered[if_id] != G_MAXUINT64)
+      continue;         /* an earlier ISB of the same interface */
+
+    for (opt_off = 20; opt_off + 4 <= block_len - 4; ) {
+      guint16 opt_code = big_endian ? pntoh16(block + opt_off) : pletoh16(block + opt_off);
+      guint16 opt_len = big_endian ? pntoh16(block + opt_off + 2) : pletoh16(block + opt_off + 2);
+
+      if (opt_code == 0 || opt_off + 4 + opt_len > block_len - 4)
+        break;
+      if (opt_code == PCAPNG_ISB_USRDELIV && opt_len == 8) {
+        delivered[if_id] = ISB_GET64(block + opt_off + 4);
+        found++;
+        break;
+      }
+      opt_off += 4 + ((opt_len + 3) & ~3U);
+    }
+  }
+#undef ISB_GET32
+#undef ISB_GET64
+
+  if (found < num_interfaces)
+    goto done;
+  for (i = 0; i < num_interfaces; i++) {
+    if (delivered[i] > G_MAXUINT32 - total)
+      goto done;
+    total += delivered[i];
+  }
+  *count = (guint32)total;
+  ok = TRUE;
+
+done:
+  g_free(block);
+  g_free(delivered);
+  ws_close(fd);
+  return ok;
+}
+
+/*
+ * Gather the infos about a capture file into cf_info, setting *have_info
+ * if they can be reported; return a non-zero status if an error occurred.
+ * This can be called from several threads at once, for different files.
+ */
 static int
-process_cap_file(wtap *wth, const char *filename)
+process_cap_file(wtap *wth, const char *filename, capture_info *cf_info,
+                 gboolean *have_info)
 {
   int                   status = 0;
   int                   err;
@@ -1062,8 +1243,8 @@ process_cap_file(wtap *wth, const char *filename)
   guint32               snaplen_min_inferred = 0xffffffff;
   guint32               snaplen_max_inferred =          0;
   wtap_rec             *rec;
-  capture_info          cf_info;
   gboolean              have_times = TRUE;
+  gboolean              read_records;
   nstime_t              start_time;
   int                   start_time_tsprec;
   nstime_t              stop_time;
@@ -1085,24 +1266,37 @@ process_cap_file(wtap *wth, const char *filename)
   nstime_set_zero(&cur_time);
   nstime_set_zero(&prev_time);
 
-  cf_info.shb = wtap_file_get_shb(wth);
+  cf_info->shb = wtap_file_get_shb(wth);
 
-  cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+  cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
   idb_info = wtap_file_get_idb_info(wth);
 
   g_assert(idb_info->interface_data != NULL);
 
-  cf_info.num_interfaces = idb_info->interface_data->len;
-  cf_info.interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info.num_interfaces);
-  g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-  cf_info.pkt_interface_id_unknown = 0;
+  cf_info->num_interfaces = idb_info->interface_data->len;
+  cf_info->interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info->num_interfaces);
+  g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+  cf_info->pkt_interface_id_unknown = 0;
 
   g_free(idb_info);
   idb_info = NULL;
 
+  *have_info = FALSE;
+
+  /*
+   * Only read the records if some of the infos asked for need them,
+   * and if the packet count can't be got from the interface statistics.
+   */
+  read_records = need_records(wth);
+  if (!read_records && cap_packet_count) {
+    read_records = !(use_isb_counts &&
+                     isb_packet_count(wth, filename, cf_info->num_interfaces, &packet));
+  }
+
   /* Tally up data that we need to parse through the file to find */
-  while (wtap_read(wth, &err, &err_info, &data_offset))  {
+  err = 0;
+  while (read_records && wtap_read(wth, &err, &err_info, &data_offset))  {
     rec = wtap_get_rec(wth);
     if (rec->presence_flags & WTAP_HAS_TS) {
       prev_time = cur_time;
@@ -1148,7 +1342,7 @@ process_cap_file(wtap *wth, const char *filename)
 
       if ((rec->rec_header.packet_header.pkt_encap > 0) &&
           (rec->rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-        cf_info.encap_counts[rec->rec_header.packet_header.pkt_encap] += 1;
+        cf_info->encap_counts[rec->rec_header.packet_header.pkt_encap] += 1;
       } else {
         fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
                 rec->rec_header.packet_header.pkt_encap, packet, filename);
@@ -1156,8 +1350,8 @@ process_cap_file(wtap *wth, const char *filename)
 
       /* Packet interface_id info */
       if (rec->presence_flags & WTAP_HAS_INTERFACE_ID) {
-        /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-        if (rec->rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+        /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+        if (rec->rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
           /*
            * OK, re-fetch the number of interfaces, as there might have
            * been an interface that was in the middle of packets, and
@@ -1166,27 +1360,27 @@ process_cap_file(wtap *wth, const char *filename)
            */
           idb_info = wtap_file_get_idb_info(wth);
 
-          cf_info.num_interfaces = idb_info->interface_data->len;
-          g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+          cf_info->num_interfaces = idb_info->interface_data->len;
+          g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
 
           g_free(idb_info);
           idb_info = NULL;
         }
-        if (rec->rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-          g_array_index(cf_info.interface_packet_counts, guint32,
+        if (rec->rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+          g_array_index(cf_info->interface_packet_counts, guint32,
                         rec->rec_header.packet_header.interface_id) += 1;
         }
         else {
-          cf_info.pkt_interface_id_unknown += 1;
+          cf_info->pkt_interface_id_unknown += 1;
         }
       }
       else {
         /* it's for interface_id 0 */
-        if (cf_info.num_interfaces != 0) {
-          g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+        if (cf_info->num_interfaces != 0) {
+          g_array_index(cf_info->interface_packet_counts, guint32, 0) += 1;
         }
         else {
-          cf_info.pkt_interface_id_unknown += 1;
+          cf_info->pkt_interface_id_unknown += 1;
         }
       }
     }
@@ -1200,12 +1394,12 @@ process_cap_file(wtap *wth, const char *filename)
    */
   idb_info = wtap_file_get_idb_info(wth);
 
-  cf_info.idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info.num_interfaces);
-  cf_info.num_interfaces = idb_info->interface_data->len;
-  for (i = 0; i < cf_info.num_interfaces; i++) {
+  cf_info->idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info->num_interfaces);
+  cf_info->num_interfaces = idb_info->interface_data->len;
+  for (i = 0; i < cf_info->num_interfaces; i++) {
     const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
     gchar *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-    g_array_append_val(cf_info.idb_info_strings, s);
+    g_array_append_val(cf_info->idb_info_strings, s);
   }
 
   g_free(idb_info);
@@ -1222,7 +1416,7 @@ process_cap_file(wtap *wth, const char *filename)
         fprintf(stderr,
           "  (will continue anyway, checksums might be incorrect)\n");
     } else {
-        cleanup_capture_info(&cf_info);
+        cleanup_capture_info(cf_info);
         return 1;
     }
   }
@@ -1233,72 +1427,66 @@ process_cap_file(wtap *wth, const char *filename)
     fprintf(stderr,
         "capinfos: Can't get size of \"%s\": %s.\n",
         filename, g_strerror(err));
-    cleanup_capture_info(&cf_info);
+    cleanup_capture_info(cf_info);
     return 1;
   }
 
-  cf_info.filesize = size;
+  cf_info->filesize = size;
 
   /* File Type */
-  cf_info.file_type = wtap_file_type_subtype(wth);
-  cf_info.iscompressed = wtap_iscompressed(wth);
+  cf_info->file_type = wtap_file_type_subtype(wth);
+  cf_info->iscompressed = wtap_iscompressed(wth);
 
   /* File Encapsulation */
-  cf_info.file_encap = wtap_file_encap(wth);
+  cf_info->file_encap = wtap_file_encap(wth);
 
-  cf_info.file_tsprec = wtap_file_tsprec(wth);
+  cf_info->file_tsprec = wtap_file_tsprec(wth);
 
   /* Packet size limit (snaplen) */
-  cf_info.snaplen = wtap_snapshot_length(wth);
-  if (cf_info.snaplen > 0)
-    cf_info.snap_set = TRUE;
+  cf_info->snaplen = wtap_snapshot_length(wth);
+  if (cf_info->snaplen > 0)
+    cf_info->snap_set = TRUE;
   else
-    cf_info.snap_set = FALSE;
+    cf_info->snap_set = FALSE;
 
-  cf_info.snaplen_min_inferred = snaplen_min_inferred;
-  cf_info.snaplen_max_inferred = snaplen_max_inferred;
+  cf_info->snaplen_min_inferred = snaplen_min_inferred;
+  cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
   /* # of packets */
-  cf_info.packet_count = packet;
+  cf_info->packet_count = packet;
 
   /* File Times */
-  cf_info.times_known = have_times;
-  cf_info.start_time = start_time;
-  cf_info.start_time_tsprec = start_time_tsprec;
-  cf_info.stop_time = stop_time;
-  cf_info.stop_time_tsprec = stop_time_tsprec;
-  nstime_delta(&cf_info.duration, &stop_time, &start_time);
+  cf_info->times_known = have_times;
+  cf_info->start_time = start_time;
+  cf_info->start_time_tsprec = start_time_tsprec;
+  cf_info->stop_time = stop_time;
+  cf_info->stop_time_tsprec = stop_time_tsprec;
+  nstime_delta(&cf_info->duration, &stop_time, &start_time);
   /* Duration precision is the higher of the start and stop time precisions. */
-  if (cf_info.stop_time_tsprec > cf_info.start_time_tsprec)
-    cf_info.duration_tsprec = cf_info.stop_time_tsprec;
+  if (cf_info->stop_time_tsprec > cf_info->start_time_tsprec)
+    cf_info->duration_tsprec = cf_info->stop_time_tsprec;
   else
-    cf_info.duration_tsprec = cf_info.start_time_tsprec;
-  cf_info.know_order = know_order;
-  cf_info.order = order;
+    cf_info->duration_tsprec = cf_info->start_time_tsprec;
+  cf_info->know_order = know_order;
+  cf_info->order = order;
 
   /* Number of packet bytes */
-  cf_info.packet_bytes = bytes;
+  cf_info->packet_bytes = bytes;
 
-  cf_info.data_rate   = 0.0;
-  cf_info.packet_rate = 0.0;
-  cf_info.packet_size = 0.0;
+  cf_info->data_rate   = 0.0;
+  cf_info->packet_rate = 0.0;
+  cf_info->packet_size = 0.0;
 
   if (packet > 0) {
     double delta_time = nstime_to_sec(&stop_time) - nstime_to_sec(&start_time);
     if (delta_time > 0.0) {
-      cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-      cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+      cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+      cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
     }
-    cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
   }
 
-  if (long_report) {
-    print_stats(filename, &cf_info);
-  } else {
-    print_stats_table(filename, &cf_info);
-  }
-
-  cleanup_capture_info(&cf_info);
+  *have_info = TRUE;
 
   return status;
 }
@@ -1358,6 +1546,11 @@ print_usage(FILE *output)
   fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
   fprintf(output, "  -A generate all infos (default)\n");
   fprintf(output, "  -K disable displaying the capture comment\n");
+  fprintf(output, "  -j <threads> process up to <threads> files at once (default 1)\n");
+  fprintf(output, "  --isb-counts\n");
+  fprintf(output, "     get the number of packets of pcapng files from their final\n");
+  fprintf(output, "     Interface Statistics Blocks if only header infos and the number\n");
+  fprintf(output, "     of packets are displayed\n");
   fprintf(output, "\n");
   fprintf(output, "Options are processed from left to right order with later options superceding\n");
   fprintf(output, "or adding to earlier options.\n");
@@ -1397,28 +1590,148 @@ hash_to_str(const unsigned char *hash, size_t length, char *str) {
   }
 }
 
+/*
+ * A capture file to report on. Its hashes and the infos found by reading
+ * it are gathered by two tasks, which run at the same time when several
+ * threads are used (-j); the infos are always reported in the order of
+ * the files on the command line, by the main thread.
+ */
+typedef struct _capinfos_job capinfos_job;
+
+typedef struct _capinfos_task {
+  capinfos_job  *job;
+  gboolean       hash;          /* hash the file, rather than read it */
+} capinfos_task;
+
+struct _capinfos_job {
+  const char    *filename;
+  capinfos_task  tasks[2];
+  guint          pending;       /* tasks not done yet, protected by jobs_mutex */
+
+  wtap          *wth;           /* NULL if the file couldn't be opened */
+  int            err;
+  gchar         *err_info;
+  int            status;
+  gboolean       have_info;
+  capture_info   cf_info;
+};
+
+static GMutex jobs_mutex;
+static GCond  jobs_cond;
+
+static void
+hash_cap_file(capinfos_job *job)
+{
+  FILE         *fh;
+  gcry_md_hd_t  hd = NULL;
+  char         *hash_buf;
+  size_t        hash_bytes;
+
+  fh = ws_fopen(job->filename, "rb");
+  if (!fh)
+    return;
+
+  gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+  if (hd) {
+    gcry_md_enable(hd, GCRY_MD_RMD160);
+    gcry_md_enable(hd, GCRY_MD_SHA1);
+
+    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
+    while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
+      gcry_md_write(hd, hash_buf, hash_bytes);
+    }
+    g_free(hash_buf);
+    gcry_md_final(hd);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, job->cf_info.file_sha256);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, job->cf_info.file_rmd160);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, job->cf_info.file_sha1);
+    gcry_md_close(hd);
+  }
+  fclose(fh);
+}
+
+static void
+read_cap_file(capinfos_job *job)
+{
+  job->wth = wtap_open_offline(job->filename, WTAP_TYPE_AUTO, &job->err, &job->err_info, FALSE);
+  if (job->wth)
+    job->status = process_cap_file(job->wth, job->filename, &job->cf_info, &job->have_info);
+}
+
+static void
+run_task(gpointer data, gpointer user_data _U_)
+{
+  capinfos_task *task = (capinfos_task *)data;
+
+  if (task->hash)
+    hash_cap_file(task->job);
+  else
+    read_cap_file(task->job);
+
+  g_mutex_lock(&jobs_mutex);
+  task->job->pending--;
+  g_cond_broadcast(&jobs_cond);
+  g_mutex_unlock(&jobs_mutex);
+}
+
+/* Start the tasks of a job, or run them if there's no thread pool */
+static void
+start_job(capinfos_job *job, GThreadPool *pool)
+{
+  guint i, num_tasks = 0;
+
+  g_strlcpy(job->cf_info.file_sha256, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(job->cf_info.file_rmd160, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(job->cf_info.file_sha1, "<unknown>", HASH_STR_SIZE);
+
+  if (cap_file_hashes) {
+    job->tasks[num_tasks].job = job;
+    job->tasks[num_tasks].hash = TRUE;
+    num_tasks++;
+  }
+  job->tasks[num_tasks].job = job;
+  job->tasks[num_tasks].hash = FALSE;
+  num_tasks++;
+
+  job->pending = num_tasks;
+  for (i = 0; i < num_tasks; i++) {
+    if (pool)
+      g_thread_pool_push(pool, &job->tasks[i], NULL);
+    else
+      run_task(&job->tasks[i], NULL);
+  }
+}
+
+static void
+wait_job(capinfos_job *job)
+{
+  g_mutex_lock(&jobs_mutex);
+  while (job->pending > 0)
+    g_cond_wait(&jobs_cond, &jobs_mutex);
+  g_mutex_unlock(&jobs_mutex);
+}
+
 int
 main(int argc, char *argv[])
 {
   GString *comp_info_str;
   GString *runtime_info_str;
   char  *init_progfile_dir_error;
-  wtap  *wth;
-  int    err;
-  gchar *err_info;
   int    opt;
   int    overall_error_status = EXIT_SUCCESS;
   static const struct option long_options[] = {
       {"help", no_argument, NULL, 'h'},
       {"version", no_argument, NULL, 'v'},
+      {"isb-counts", no_argument, NULL, LONGOPT_ISB_COUNTS},
       {0, 0, 0, 0 }
   };
 
-  int status = 0;
-  FILE  *fh;
-  char  *hash_buf = NULL;
-  gcry_md_hd_t hd = NULL;
-  size_t hash_bytes;
+  guint         num_threads = 1;
+  GThreadPool  *pool = NULL;
+  capinfos_job *jobs = NULL;
+  int           num_jobs = 0;
+  int           next_job = 0;
+  int           i;
 
   /* Set the C-language locale to the native environment. */
   setlocale(LC_ALL, "");
@@ -1472,7 +1785,7 @@ main(int argc, char *argv[])
   wtap_init(TRUE);
 
   /* Process the options */
-  while ((opt = getopt_long(argc, argv, "abcdehiklmoqrstuvxyzABCEFHIKLMNQRST", long_options, NULL)) !=-1) {
+  while ((opt = getopt_long(argc, argv, "abcdehij:klmoqrstuvxyzABCEFHIKLMNQRST", long_options, NULL)) !=-1) {
 
     switch (opt) {
 
@@ -1578,6 +1891,14 @@ main(int argc, char *argv[])
         continue_after_wtap_open_offline_failure = FALSE;
         break;
 
+      case 'j':
+        num_threads = get_nonzero_guint32(optarg, "number of threads");
+        break;
+
+      case LONGOPT_ISB_COUNTS:
+        use_isb_counts = TRUE;
+        break;
+
       case 'A':
         enable_all_infos();
         break;
@@ -1664,62 +1985,72 @@ main(int argc, char *argv[])
 
   if (cap_file_hashes) {
     gcry_check_version(NULL);
-    gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-    if (hd) {
-      gcry_md_enable(hd, GCRY_MD_RMD160);
-      gcry_md_enable(hd, GCRY_MD_SHA1);
-    }
-    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
   }
 
   overall_error_status = 0;
 
-  for (opt = optind; opt < argc; opt++) {
+  num_jobs = argc - optind;
+  jobs = g_new0(capinfos_job, num_jobs);
+  for (i = 0; i < num_jobs; i++) {
+    jobs[i].filename = argv[optind + i];
+  }
+  if (num_threads > 1) {
+    pool = g_thread_pool_new(run_task, NULL, num_threads, FALSE, NULL);
+  }
 
-    g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+  for (i = 0; i < num_jobs; i++) {
+    capinfos_job *job = &jobs[i];
 
-    if (cap_file_hashes) {
-      fh = ws_fopen(argv[opt], "rb");
-      if (fh && hd) {
-        while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-          gcry_md_write(hd, hash_buf, hash_bytes);
-        }
-        gcry_md_final(hd);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
-      }
-      if (fh) fclose(fh);
-      if (hd) gcry_md_reset(hd);
+    /*
+     * Keep the threads busy with the next files, but not too far ahead,
+     * as the files stay open until they are reported on.
+     */
+    while (next_job < num_jobs && (next_job == i || (pool && next_job < i + 2 * (int)num_threads))) {
+      start_job(&jobs[next_job], pool);
+      next_job++;
     }
+    wait_job(job);
 
-    wth = wtap_open_offline(argv[opt], WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-
-    if (!wth) {
-      cfile_open_failure_message("capinfos", argv[opt], err, err_info);
+    if (!job->wth) {
+      cfile_open_failure_message("capinfos", job->filename, job->err, job->err_info);
       overall_error_status = 2; /* remember that an error has occurred */
       if (!continue_after_wtap_open_offline_failure)
         goto exit;
+      continue;
     }
 
-    if (wth) {
-      if ((opt > optind) && (long_report))
-        printf("\n");
-      status = process_cap_file(wth, argv[opt]);
-
-      wtap_close(wth);
-      if (status) {
-        overall_error_status = status;
-        goto exit;
+    if ((i > 0) && (long_report))
+      printf("\n");
+    if (job->have_info) {
+      if (long_report) {
+        print_stats(job->filename, &job->cf_info);
+      } else {
+        print_stats_table(job->filename, &job->cf_info);
       }
+      cleanup_capture_info(&job->cf_info);
+    }
+
+    wtap_close(job->wth);
+    job->wth = NULL;
+    if (job->status) {
+      overall_error_status = job->status;
+      goto exit;
     }
   }
 
 exit:
-  g_free(hash_buf);
-  gcry_md_close(hd);
+  if (pool) {
+    /* Drop the tasks not started yet, and wait for the others */
+    g_thread_pool_free(pool, TRUE, TRUE);
+  }
+  for (i = 0; i < num_jobs; i++) {
+    if (jobs[i].wth) {
+      if (jobs[i].have_info)
+        cleanup_capture_info(&jobs[i].cf_info);
+      wtap_close(jobs[i].wth);
+    }
+  }
+  g_free(jobs);
   wtap_cleanup();
   free_progdirs();
   return overall_error_status;
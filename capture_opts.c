@@ -116,6 +116,7 @@ capture_opts_init(capture_options *capture_opts)
 
     capture_opts->output_to_pipe                  = FALSE;
     capture_opts->capture_child                   = FALSE;
+    capture_opts->use_shm_ring                    = FALSE;
 }
 
 void
@@ -55,6 +55,13 @@ extern "C" {
 #define LONGOPT_NUM_CAP_COMMENT   128
 #define LONGOPT_LIST_TSTAMP_TYPES 129
 #define LONGOPT_SET_TSTAMP_TYPE   130
+#define LONGOPT_SHM_RING          131
+#define LONGOPT_PER_INTERFACE_FILES 132
+#define LONGOPT_SAMPLE            133
+#define LONGOPT_SAMPLE_FLOWS      134
+#define LONGOPT_FLOW_BYTES        135
+#define LONGOPT_PROTOCOL_SNAPLEN  136
+#define LONGOPT_MAX_QUEUE_MEMORY  137
 
 /*
  * Options for capturing common to all capturing programs.
@@ -319,6 +326,8 @@ typedef struct capture_options_tag {
     /* internally used (don't touch from outside) */
     gboolean           output_to_pipe;        /**< save_file is a pipe (named or stdout) */
     gboolean           capture_child;         /**< hidden option: Wireshark child mode */
+    gboolean           use_shm_ring;          /**< also hand packets to the parent
+                                                   in a capture_shm_ring */
 } capture_options;
 
 /* initialize the capture_options with some reasonable values */
@@ -0,0 +1,444 @@
+/* capture_reduce.c
+ * Reducing the captured data in dumpcap: packet and flow sampling,
+ * per-flow byte caps and per-protocol snapshot lengths
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/pint.h>
+#include <wsutil/strtoi.h>
+
+#include "capture_reduce.h"
+
+/*
+ * Link-layer types we can find the IP header in. dumpcap gets DLT_ values
+ * from libpcap and LINKTYPE_ values from capture pipes; they're the same
+ * except for raw IP.
+ */
+#define LINKTYPE_NULL           0
+#define LINKTYPE_ETHERNET       1
+#define DLT_RAW_12              12      /* DLT_RAW on most platforms */
+#define DLT_RAW_14              14      /* DLT_RAW on OpenBSD */
+#define LINKTYPE_RAW            101
+#define LINKTYPE_LOOP           108
+#define LINKTYPE_LINUX_SLL      113
+#define LINKTYPE_IPV4           228
+#define LINKTYPE_IPV6           229
+
+#define ETHERTYPE_IPv4          0x0800
+#define ETHERTYPE_VLAN          0x8100
+#define ETHERTYPE_IPv6          0x86dd
+#define ETHERTYPE_QINQ_OLD      0x9100
+#define ETHERTYPE_IEEE_802_1AD  0x88a8
+
+#define IP_PROTO_HOPOPTS        0
+#define IP_PROTO_ICMP           1
+#define IP_PROTO_TCP            6
+#define IP_PROTO_UDP            17
+#define IP_PROTO_ROUTING        43
+#define IP_PROTO_FRAGMENT       44
+#define IP_PROTO_ICMPV6         58
+#define IP_PROTO_DSTOPTS        60
+#define IP_PROTO_SCTP           132
+
+/*
+ * The per-flow byte cap uses a direct-mapped table of flows: a flow
+ * whose slot is taken by another one evicts it, and the evicted flow
+ * starts over with a full allowance if it's seen again. That keeps the
+ * cost per packet constant, at the price of letting some flows through
+ * twice on a busy link.
+ */
+#define FLOW_TABLE_BITS         16
+#define FLOW_TABLE_SIZE         (1 << FLOW_TABLE_BITS)
+
+/* A flow, independent of the direction: the "lower" endpoint first. */
+typedef struct _flow_key {
+    guint8  addr_a[16];
+    guint8  addr_b[16];
+    guint16 port_a;
+    guint16 port_b;
+    guint8  ip_proto;
+    guint8  addr_len;
+    guint8  pad[2];
+} flow_key;
+
+typedef struct _flow_entry {
+    flow_key key;
+    gboolean in_use;
+    guint64  payload_bytes;     /* payload seen so far */
+} flow_entry;
+
+/* What capture_reduce_dissect() found in a packet */
+typedef struct _packet_info {
+    capture_reduce_proto proto;
+    gboolean has_flow;          /* key is filled in */
+    flow_key key;
+    guint32  header_len;        /* up to the end of the transport header */
+    guint32  payload_len;       /* bytes of transport payload on the wire */
+} packet_info;
+
+struct _capture_reduce {
+    capture_reduce_opts   opts;
+    int                   linktype;
+    guint32               sample_count;
+    flow_entry           *flows;        /* if flow_byte_cap != 0 */
+    capture_reduce_counts counts;
+};
+
+static const char *proto_names[CAPTURE_REDUCE_NUM_PROTOS] = {
+    "tcp",
+    "udp",
+    "sctp",
+    "icmp",
+    "ip",
+    "other"
+};
+
+gboolean
+capture_reduce_enabled(const capture_reduce_opts *opts)
+{
+    int i;
+
+    if (opts->sample_rate > 1 || opts->flow_sample_rate > 1 || opts->flow_byte_cap != 0)
+        return TRUE;
+    for (i = 0; i < CAPTURE_REDUCE_NUM_PROTOS; i++) {
+        if (opts->snaplen[i] != 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean
+capture_reduce_parse_snaplen(capture_reduce_opts *opts, const char *arg)
+{
+    const char *colon;
+    guint32     snaplen;
+    int         i;
+
+    colon = strchr(arg, ':');
+    if (colon == NULL || !ws_strtou32(colon + 1, NULL, &snaplen) || snaplen == 0)
+        return FALSE;
+    for (i = 0; i < CAPTURE_REDUCE_NUM_PROTOS; i++) {
+        if (strlen(proto_names[i]) == (size_t)(colon - arg) &&
+            g_ascii_strncasecmp(arg, proto_names[i], colon - arg) == 0) {
+            opts->snaplen[i] = snaplen;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+capture_reduce *
+capture_reduce_new(const capture_reduce_opts *opts, int linktype)
+{
+    capture_reduce *red;
+
+    red = g_new0(capture_reduce, 1);
+    red->opts = *opts;
+    red->linktype = linktype;
+    if (opts->flow_byte_cap != 0)
+        red->flows = g_new0(flow_entry, FLOW_TABLE_SIZE);
+    return red;
+}
+
+void
+capture_reduce_free(capture_reduce *red)
+{
+    if (red == NULL)
+        return;
+    g_free(red->flows);
+    g_free(red);
+}
+
+void
+capture_reduce_get_counts(const capture_reduce *red, capture_reduce_counts *counts)
+{
+    *counts = red->counts;
+}
+
+/* Fill in the direction-independent flow key of a packet. */
+static void
+set_flow_key(flow_key *key, const guint8 *src, const guint8 *dst, guint8 addr_len,
+             guint16 src_port, guint16 dst_port, guint8 ip_proto)
+{
+    int cmp;
+
+    memset(key, 0, sizeof *key);
+    cmp = memcmp(src, dst, addr_len);
+    if (cmp < 0 || (cmp == 0 && src_port <= dst_port)) {
+        memcpy(key->addr_a, src, addr_len);
+        memcpy(key->addr_b, dst, addr_len);
+        key->port_a = src_port;
+        key->port_b = dst_port;
+    } else {
+        memcpy(key->addr_a, dst, addr_len);
+        memcpy(key->addr_b, src, addr_len);
+        key->port_a = dst_port;
+        key->port_b = src_port;
+    }
+    key->ip_proto = ip_proto;
+    key->addr_len = addr_len;
+}
+
+/* FNV-1a over the key */
+static guint32
+flow_hash(const flow_key *key)
+{
+    const guint8 *p = (const guint8 *)key;
+    guint32       hash = 2166136261U;
+    size_t        i;
+
+    for (i = 0; i < sizeof *key; i++) {
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/* Find the transport header of an IP packet starting at offset off. */
+static void
+dissect_ip(const guint8 *pd, guint32 caplen, guint32 off, packet_info *pinfo)
+{
+    const guint8 *src, *dst;
+    guint8        addr_len;
+    guint8        ip_proto;
+    guint32       ip_end;
+    guint32       hdr_len;
+    guint16       src_port = 0, dst_port = 0;
+    gboolean      fragmented = FALSE;
+    gboolean      first_fragment = TRUE;
+    int           ext;
+
+    pinfo->proto = CAPTURE_REDUCE_PROTO_NON_IP;
+    if (caplen < off + 1)
+        return;
+
+    switch (pd[off] >> 4) {
+
+    case 4:
+        if (caplen < off + 20)
+            return;
+        hdr_len = (pd[off] & 0x0f) * 4;
+        if (hdr_len < 20)
+            return;
+        /* A total length of 0 is left by TCP segmentation offload. */
+        ip_end = pntoh16(&pd[off + 2]) != 0 ? off + pntoh16(&pd[off + 2]) : caplen;
+        ip_proto = pd[off + 9];
+        fragmented = (pntoh16(&pd[off + 6]) & 0x3fff) != 0;
+        first_fragment = (pntoh16(&pd[off + 6]) & 0x1fff) == 0;
+        src = &pd[off + 12];
+        dst = &pd[off + 16];
+        addr_len = 4;
+        off += hdr_len;
+        break;
+
+    case 6:
+        if (caplen < off + 40)
+            return;
+        /* Same for a payload length of 0, which is also used by jumbograms. */
+        ip_end = pntoh16(&pd[off + 4]) != 0 ? off + 40 + pntoh16(&pd[off + 4]) : caplen;
+        ip_proto = pd[off + 6];
+        src = &pd[off + 8];
+        dst = &pd[off + 24];
+        addr_len = 16;
+        off += 40;
+        /* Skip the extension headers we know about. */
+        for (ext = 0; ext < 8; ext++) {
+            if (ip_proto == IP_PROTO_HOPOPTS || ip_proto == IP_PROTO_ROUTING ||
+                ip_proto == IP_PROTO_DSTOPTS) {
+                if (caplen < off + 2)
+                    break;
+                ip_proto = pd[off];
+                off += (pd[off + 1] + 1) * 8;
+            } else if (ip_proto == IP_PROTO_FRAGMENT) {
+                if (caplen < off + 8)
+                    break;
+                ip_proto = pd[off];
+                fragmented = TRUE;
+                first_fragment = (pntoh16(&pd[off + 2]) & 0xfff8) == 0;
+                off += 8;
+            } else {
+                break;
+            }
+        }
+        break;
+
+    default:
+        return;
+    }
+
+    pinfo->proto = CAPTURE_REDUCE_PROTO_OTHER_IP;
+    hdr_len = 0;
+    if (first_fragment) {
+        switch (ip_proto) {
+
+        case IP_PROTO_TCP:
+            pinfo->proto = CAPTURE_REDUCE_PROTO_TCP;
+            if (caplen >= off + 20)
+                hdr_len = (pd[off + 12] >> 4) * 4;
+            break;
+
+        case IP_PROTO_UDP:
+            pinfo->proto = CAPTURE_REDUCE_PROTO_UDP;
+            hdr_len = 8;
+            break;
+
+        case IP_PROTO_SCTP:
+            pinfo->proto = CAPTURE_REDUCE_PROTO_SCTP;
+            hdr_len = 12;
+            break;
+
+        case IP_PROTO_ICMP:
+        case IP_PROTO_ICMPV6:
+            pinfo->proto = CAPTURE_REDUCE_PROTO_ICMP;
+            break;
+        }
+    }
+    /* Only the first fragment has the ports, so identify the flow of all
+       fragments, including the first one, by the addresses alone. */
+    if (hdr_len != 0 && caplen >= off + 4 && !fragmented) {
+        src_port = pntoh16(&pd[off]);
+        dst_port = pntoh16(&pd[off + 2]);
+    }
+
+    set_flow_key(&pinfo->key, src, dst, addr_len, src_port, dst_port, ip_proto);
+    pinfo->has_flow = TRUE;
+    pinfo->header_len = off + hdr_len;
+    pinfo->payload_len = ip_end > pinfo->header_len ? ip_end - pinfo->header_len : 0;
+}
+
+/* Find the IP header of a packet, if any, and what's in it. */
+static void
+capture_reduce_dissect(const capture_reduce *red, const guint8 *pd, guint32 caplen,
+                       packet_info *pinfo)
+{
+    guint32 off;
+    guint16 ethertype;
+    int     tags;
+
+    memset(pinfo, 0, sizeof *pinfo);
+    pinfo->proto = CAPTURE_REDUCE_PROTO_NON_IP;
+
+    switch (red->linktype) {
+
+    case LINKTYPE_ETHERNET:
+        if (caplen < 14)
+            return;
+        off = 12;
+        ethertype = pntoh16(&pd[off]);
+        for (tags = 0; tags < 2; tags++) {
+            if (ethertype != ETHERTYPE_VLAN && ethertype != ETHERTYPE_IEEE_802_1AD &&
+                ethertype != ETHERTYPE_QINQ_OLD)
+                break;
+            off += 4;
+            if (caplen < off + 2)
+                return;
+            ethertype = pntoh16(&pd[off]);
+        }
+        if (ethertype != ETHERTYPE_IPv4 && ethertype != ETHERTYPE_IPv6)
+            return;
+        dissect_ip(pd, caplen, off + 2, pinfo);
+        break;
+
+    case LINKTYPE_LINUX_SLL:
+        if (caplen < 16)
+            return;
+        ethertype = pntoh16(&pd[14]);
+        if (ethertype != ETHERTYPE_IPv4 && ethertype != ETHERTYPE_IPv6)
+            return;
+        dissect_ip(pd, caplen, 16, pinfo);
+        break;
+
+    case LINKTYPE_NULL:
+    case LINKTYPE_LOOP:
+        /* The address family is in host or network byte order, with
+           differing AF_INET6 values; just look at the IP version. */
+        dissect_ip(pd, caplen, 4, pinfo);
+        break;
+
+    case DLT_RAW_12:
+    case DLT_RAW_14:
+    case LINKTYPE_RAW:
+    case LINKTYPE_IPV4:
+    case LINKTYPE_IPV6:
+        dissect_ip(pd, caplen, 0, pinfo);
+        break;
+    }
+}
+
+guint32
+capture_reduce_packet(capture_reduce *red, const guint8 *pd, guint32 caplen)
+{
+    packet_info  pinfo;
+    guint32      keep = caplen;
+    guint32      snaplen;
+    flow_entry  *flow;
+    guint64      allowance;
+
+    /* 1-in-N sampling needs no look at the packet at all. */
+    if (red->opts.sample_rate > 1) {
+        if (++red->sample_count < red->opts.sample_rate) {
+            red->counts.sampled_out++;
+            return 0;
+        }
+        red->sample_count = 0;
+    }
+
+    capture_reduce_dissect(red, pd, caplen, &pinfo);
+
+    if (red->opts.flow_sample_rate > 1 && pinfo.has_flow &&
+        flow_hash(&pinfo.key) % red->opts.flow_sample_rate != 0) {
+        red->counts.flow_sampled_out++;
+        return 0;
+    }
+
+    if (red->flows != NULL &&
+        (pinfo.proto == CAPTURE_REDUCE_PROTO_TCP || pinfo.proto == CAPTURE_REDUCE_PROTO_UDP)) {
+        flow = &red->flows[flow_hash(&pinfo.key) >> (32 - FLOW_TABLE_BITS)];
+        if (!flow->in_use || memcmp(&flow->key, &pinfo.key, sizeof pinfo.key) != 0) {
+            /* New flow, or another one took its slot. */
+            flow->key = pinfo.key;
+            flow->in_use = TRUE;
+            flow->payload_bytes = 0;
+        }
+        allowance = flow->payload_bytes < red->opts.flow_byte_cap ?
+                    red->opts.flow_byte_cap - flow->payload_bytes : 0;
+        flow->payload_bytes += pinfo.payload_len;
+        if (pinfo.payload_len > allowance && (guint64)pinfo.header_len + allowance < keep) {
+            keep = pinfo.header_len + (guint32)allowance;
+            red->counts.flow_capped++;
+        }
+    }
+
+    snaplen = red->opts.snaplen[pinfo.proto];
+    if (snaplen != 0 && snaplen < keep) {
+        keep = snaplen;
+        red->counts.snaplen_cut++;
+    }
+
+    red->counts.bytes_cut += caplen - keep;
+    return keep;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,114 @@
+/* capture_reduce.h
+ * Definitions for reducing the captured data in dumpcap: packet and flow
+ * sampling, per-flow byte caps and per-protocol snapshot lengths
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_REDUCE_H__
+#define __CAPTURE_REDUCE_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * The stages are applied in this order to each packet, before it is
+ * copied anywhere:
+ *
+ *   1. 1-in-N sampling: only every Nth packet of the interface is kept.
+ *   2. Flow sampling: only the packets of the flows whose (direction
+ *      independent) address/port hash is 0 modulo N are kept, so that
+ *      the kept flows are complete. Non-IP packets are always kept.
+ *      Fragmented packets, including first fragments, are hashed on
+ *      their addresses and protocol only, so that all the fragments of
+ *      a packet are kept or dropped together.
+ *   3. Per-flow byte cap: once K bytes of TCP or UDP payload of a flow
+ *      have been kept, only the headers of its packets are kept.
+ *   4. Per-protocol snapshot length: packets of the given protocol are
+ *      cut after the given number of bytes.
+ */
+
+/** Transport protocols that can have a snapshot length of their own */
+typedef enum {
+    CAPTURE_REDUCE_PROTO_TCP,
+    CAPTURE_REDUCE_PROTO_UDP,
+    CAPTURE_REDUCE_PROTO_SCTP,
+    CAPTURE_REDUCE_PROTO_ICMP,      /**< ICMP and ICMPv6 */
+    CAPTURE_REDUCE_PROTO_OTHER_IP,  /**< any other IPv4 or IPv6 packet */
+    CAPTURE_REDUCE_PROTO_NON_IP,    /**< anything that isn't IP */
+    CAPTURE_REDUCE_NUM_PROTOS
+} capture_reduce_proto;
+
+/** What to reduce; all zeroes means nothing. */
+typedef struct _capture_reduce_opts {
+    guint32 sample_rate;          /**< keep 1 packet in sample_rate; 0 or 1: all */
+    guint32 flow_sample_rate;     /**< keep 1 flow in flow_sample_rate; 0 or 1: all */
+    guint32 flow_byte_cap;        /**< payload bytes kept per flow; 0: no cap */
+    guint32 snaplen[CAPTURE_REDUCE_NUM_PROTOS];  /**< per-protocol snapshot length; 0: none */
+} capture_reduce_opts;
+
+/** What was dropped or cut by which stage */
+typedef struct _capture_reduce_counts {
+    guint64 sampled_out;          /**< packets dropped by 1-in-N sampling */
+    guint64 flow_sampled_out;     /**< packets dropped by flow sampling */
+    guint64 flow_capped;          /**< packets cut by the per-flow byte cap */
+    guint64 snaplen_cut;          /**< packets cut by a per-protocol snapshot length */
+    guint64 bytes_cut;            /**< bytes cut by the last two */
+} capture_reduce_counts;
+
+/** Per-interface reduction state */
+typedef struct _capture_reduce capture_reduce;
+
+/** Returns TRUE if opts ask for any reduction at all. */
+extern gboolean
+capture_reduce_enabled(const capture_reduce_opts *opts);
+
+/** Parse a "<protocol>:<length>" per-protocol snapshot length, as given
+ * on the command line, into opts. Returns FALSE if it isn't valid. */
+extern gboolean
+capture_reduce_parse_snaplen(capture_reduce_opts *opts, const char *arg);
+
+/** Set up to reduce the packets of an interface with the given link-layer
+ * type (a LINKTYPE_/DLT_ value). A state must only be used by one thread
+ * at a time. */
+extern capture_reduce *
+capture_reduce_new(const capture_reduce_opts *opts, int linktype);
+
+extern void
+capture_reduce_free(capture_reduce *red);
+
+/** Apply the reduction stages to a packet with caplen bytes of data.
+ * Returns the number of bytes of it to keep, which is 0 if it is to be
+ * dropped altogether. */
+extern guint32
+capture_reduce_packet(capture_reduce *red, const guint8 *pd, guint32 caplen);
+
+/** Get what was dropped and cut so far. */
+extern void
+capture_reduce_get_counts(const capture_reduce *red, capture_reduce_counts *counts);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CAPTURE_REDUCE_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
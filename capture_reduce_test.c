@@ -0,0 +1,326 @@
+/* capture_reduce_test.c
+ * Standalone program to test the capture_reduce.h stages used by dumpcap
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "capture_reduce.h"
+
+#define LINKTYPE_ETHERNET       1
+#define LINKTYPE_RAW            101
+
+#define IP_PROTO_TCP            6
+#define IP_PROTO_UDP            17
+
+#define ETH_HDR_LEN             14
+#define IPV4_HDR_LEN            20
+#define UDP_HDR_LEN             8
+#define TCP_HDR_LEN             20
+
+/* Build an Ethernet/IPv4/UDP or TCP packet with payload_len bytes of
+ * payload into buf and return its length. frag_field is the IPv4 flags
+ * and fragment offset field; a non-first fragment gets no transport
+ * header. With tso, the IPv4 total length is left at 0. */
+static guint32
+build_packet(guint8 *buf, guint8 ip_proto, guint32 src, guint32 dst,
+             guint16 src_port, guint16 dst_port, guint32 payload_len,
+             guint16 frag_field, gboolean tso)
+{
+    guint32 trans_len = 0;
+    guint32 ip_len;
+    guint8 *ip = buf + ETH_HDR_LEN;
+    guint8 *trans = ip + IPV4_HDR_LEN;
+
+    if ((frag_field & 0x1fff) == 0)
+        trans_len = ip_proto == IP_PROTO_TCP ? TCP_HDR_LEN : UDP_HDR_LEN;
+    ip_len = IPV4_HDR_LEN + trans_len + payload_len;
+
+    memset(buf, 0, ETH_HDR_LEN + ip_len);
+    buf[12] = 0x08;                                 /* IPv4 */
+    ip[0] = 0x45;
+    if (!tso) {
+        ip[2] = ip_len >> 8;
+        ip[3] = ip_len & 0xff;
+    }
+    ip[6] = frag_field >> 8;
+    ip[7] = frag_field & 0xff;
+    ip[8] = 64;
+    ip[9] = ip_proto;
+    ip[12] = src >> 24; ip[13] = src >> 16; ip[14] = src >> 8; ip[15] = src;
+    ip[16] = dst >> 24; ip[17] = dst >> 16; ip[18] = dst >> 8; ip[19] = dst;
+    if (trans_len != 0) {
+        trans[0] = src_port >> 8; trans[1] = src_port & 0xff;
+        trans[2] = dst_port >> 8; trans[3] = dst_port & 0xff;
+        if (ip_proto == IP_PROTO_TCP)
+            trans[12] = (TCP_HDR_LEN / 4) << 4;
+    }
+    return ETH_HDR_LEN + ip_len;
+}
+
+static void
+capture_reduce_test_parse_snaplen(void)
+{
+    capture_reduce_opts opts;
+
+    memset(&opts, 0, sizeof opts);
+    g_assert(!capture_reduce_enabled(&opts));
+
+    g_assert(capture_reduce_parse_snaplen(&opts, "tcp:64"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_TCP], ==, 64);
+    g_assert(capture_reduce_parse_snaplen(&opts, "UDP:128"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_UDP], ==, 128);
+    g_assert(capture_reduce_parse_snaplen(&opts, "icmp:1"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_ICMP], ==, 1);
+    g_assert(capture_reduce_parse_snaplen(&opts, "ip:96"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_OTHER_IP], ==, 96);
+    g_assert(capture_reduce_parse_snaplen(&opts, "other:32"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_NON_IP], ==, 32);
+    g_assert(capture_reduce_enabled(&opts));
+
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcp"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcp:"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcp:0"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcp:-1"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcp:64k"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tc:64"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "tcpx:64"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, ":64"));
+    g_assert(!capture_reduce_parse_snaplen(&opts, "sctp;64"));
+    g_assert_cmpuint(opts.snaplen[CAPTURE_REDUCE_PROTO_TCP], ==, 64);
+}
+
+static void
+capture_reduce_test_sample(void)
+{
+    capture_reduce_opts opts;
+    capture_reduce_counts counts;
+    capture_reduce *red;
+    guint8 pkt[256];
+    guint32 len;
+    int i, kept = 0;
+
+    memset(&opts, 0, sizeof opts);
+    opts.sample_rate = 4;
+    red = capture_reduce_new(&opts, LINKTYPE_ETHERNET);
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1000, 53, 20, 0, FALSE);
+
+    for (i = 0; i < 40; i++) {
+        guint32 keep = capture_reduce_packet(red, pkt, len);
+        if (keep != 0) {
+            g_assert_cmpuint(keep, ==, len);
+            /* Every fourth packet is kept. */
+            g_assert_cmpint(i % 4, ==, 3);
+            kept++;
+        }
+    }
+    g_assert_cmpint(kept, ==, 10);
+
+    capture_reduce_get_counts(red, &counts);
+    g_assert_cmpuint(counts.sampled_out, ==, 30);
+    g_assert_cmpuint(counts.bytes_cut, ==, 0);
+    capture_reduce_free(red);
+}
+
+static void
+capture_reduce_test_flow_sample(void)
+{
+    capture_reduce_opts opts;
+    capture_reduce_counts counts;
+    capture_reduce *red;
+    guint8 pkt[256];
+    guint8 arp[60];
+    guint32 len;
+    guint16 port;
+    int kept = 0, dropped = 0;
+
+    memset(&opts, 0, sizeof opts);
+    opts.flow_sample_rate = 2;
+    red = capture_reduce_new(&opts, LINKTYPE_ETHERNET);
+
+    for (port = 1024; port < 1024 + 256; port++) {
+        gboolean fwd, rev, frag1, frag2, frag1_other;
+
+        /* Both directions of a flow get the same verdict. */
+        len = build_packet(pkt, IP_PROTO_TCP, 0x0a000001, 0x0a000002, port, 80, 10, 0, FALSE);
+        fwd = capture_reduce_packet(red, pkt, len) != 0;
+        len = build_packet(pkt, IP_PROTO_TCP, 0x0a000002, 0x0a000001, 80, port, 10, 0, FALSE);
+        rev = capture_reduce_packet(red, pkt, len) != 0;
+        g_assert(fwd == rev);
+        if (fwd)
+            kept++;
+        else
+            dropped++;
+
+        /* All the fragments of a packet do too, whatever its ports. */
+        len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000000 + port, 5000, port, 100, 0x2000, FALSE);
+        frag1 = capture_reduce_packet(red, pkt, len) != 0;
+        len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000000 + port, 0, 0, 100, 0x000e, FALSE);
+        frag2 = capture_reduce_packet(red, pkt, len) != 0;
+        g_assert(frag1 == frag2);
+        len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000000 + port, 6000, port + 1, 100, 0x2000, FALSE);
+        frag1_other = capture_reduce_packet(red, pkt, len) != 0;
+        g_assert(frag1 == frag1_other);
+    }
+    /* With 256 flows, both verdicts must show up. */
+    g_assert_cmpint(kept, >, 0);
+    g_assert_cmpint(dropped, >, 0);
+
+    /* Non-IP packets are always kept. */
+    memset(arp, 0, sizeof arp);
+    arp[12] = 0x08;
+    arp[13] = 0x06;
+    g_assert_cmpuint(capture_reduce_packet(red, arp, sizeof arp), ==, sizeof arp);
+
+    capture_reduce_get_counts(red, &counts);
+    g_assert_cmpuint(counts.flow_sampled_out, >=, (guint64)dropped * 2);
+    g_assert_cmpuint(counts.sampled_out, ==, 0);
+    capture_reduce_free(red);
+}
+
+static void
+capture_reduce_test_flow_bytes(void)
+{
+    capture_reduce_opts opts;
+    capture_reduce_counts counts;
+    capture_reduce *red;
+    guint8 pkt[256];
+    guint32 len;
+    const guint32 hdr = ETH_HDR_LEN + IPV4_HDR_LEN + UDP_HDR_LEN;
+
+    memset(&opts, 0, sizeof opts);
+    opts.flow_byte_cap = 100;
+    red = capture_reduce_new(&opts, LINKTYPE_ETHERNET);
+
+    /* 80 bytes of payload: the first packet fits, the second gets the
+     * remaining 20 bytes, the third only its headers. */
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1000, 2000, 80, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, len);
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000002, 0x0a000001, 2000, 1000, 80, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, hdr + 20);
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1000, 2000, 80, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, hdr);
+
+    /* Another flow has its own allowance. */
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1001, 2000, 80, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, len);
+
+    /* A TSO packet, with an IP total length of 0, is measured by what
+     * was captured of it. */
+    len = build_packet(pkt, IP_PROTO_TCP, 0x0a000003, 0x0a000004, 1000, 80, 200, 0, TRUE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==,
+                     ETH_HDR_LEN + IPV4_HDR_LEN + TCP_HDR_LEN + 100);
+
+    capture_reduce_get_counts(red, &counts);
+    g_assert_cmpuint(counts.flow_capped, ==, 3);
+    g_assert_cmpuint(counts.bytes_cut, ==, 60 + 80 + 100);
+    capture_reduce_free(red);
+}
+
+static void
+capture_reduce_test_protocol_snaplen(void)
+{
+    capture_reduce_opts opts;
+    capture_reduce_counts counts;
+    capture_reduce *red;
+    guint8 pkt[256];
+    guint8 arp[60];
+    guint32 len;
+
+    memset(&opts, 0, sizeof opts);
+    g_assert(capture_reduce_parse_snaplen(&opts, "tcp:54"));
+    g_assert(capture_reduce_parse_snaplen(&opts, "other:20"));
+    red = capture_reduce_new(&opts, LINKTYPE_ETHERNET);
+
+    len = build_packet(pkt, IP_PROTO_TCP, 0x0a000001, 0x0a000002, 1000, 80, 100, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, 54);
+
+    /* UDP has no snapshot length of its own. */
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1000, 53, 100, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, len);
+
+    /* A non-first TCP fragment has no TCP header and counts as other IP. */
+    len = build_packet(pkt, IP_PROTO_TCP, 0x0a000001, 0x0a000002, 0, 0, 100, 0x0010, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, len);
+
+    /* A packet shorter than the snapshot length isn't touched. */
+    len = build_packet(pkt, IP_PROTO_TCP, 0x0a000001, 0x0a000002, 1000, 80, 0, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt, len), ==, len);
+
+    memset(arp, 0, sizeof arp);
+    arp[12] = 0x08;
+    arp[13] = 0x06;
+    g_assert_cmpuint(capture_reduce_packet(red, arp, sizeof arp), ==, 20);
+
+    capture_reduce_get_counts(red, &counts);
+    g_assert_cmpuint(counts.snaplen_cut, ==, 2);
+    g_assert_cmpuint(counts.bytes_cut, ==, (ETH_HDR_LEN + IPV4_HDR_LEN + TCP_HDR_LEN + 100 - 54) + 40);
+    capture_reduce_free(red);
+
+    /* Raw IP, with no link-layer header at all. */
+    red = capture_reduce_new(&opts, LINKTYPE_RAW);
+    len = build_packet(pkt, IP_PROTO_TCP, 0x0a000001, 0x0a000002, 1000, 80, 100, 0, FALSE);
+    g_assert_cmpuint(capture_reduce_packet(red, pkt + ETH_HDR_LEN, len - ETH_HDR_LEN), ==, 54);
+    capture_reduce_free(red);
+}
+
+static void
+capture_reduce_test_vlan(void)
+{
+    capture_reduce_opts opts;
+    capture_reduce *red;
+    guint8 pkt[256];
+    guint8 tagged[260];
+    guint32 len;
+
+    memset(&opts, 0, sizeof opts);
+    g_assert(capture_reduce_parse_snaplen(&opts, "udp:50"));
+    red = capture_reduce_new(&opts, LINKTYPE_ETHERNET);
+
+    len = build_packet(pkt, IP_PROTO_UDP, 0x0a000001, 0x0a000002, 1000, 53, 100, 0, FALSE);
+    memcpy(tagged, pkt, 12);
+    tagged[12] = 0x81;
+    tagged[13] = 0x00;
+    tagged[14] = 0x00;
+    tagged[15] = 0x0a;
+    memcpy(tagged + 16, pkt + 12, len - 12);
+    g_assert_cmpuint(capture_reduce_packet(red, tagged, len + 4), ==, 50);
+    capture_reduce_free(red);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/capture_reduce/parse_snaplen",    capture_reduce_test_parse_snaplen);
+    g_test_add_func("/capture_reduce/sample",           capture_reduce_test_sample);
+    g_test_add_func("/capture_reduce/flow_sample",      capture_reduce_test_flow_sample);
+    g_test_add_func("/capture_reduce/flow_bytes",       capture_reduce_test_flow_bytes);
+    g_test_add_func("/capture_reduce/protocol_snaplen", capture_reduce_test_protocol_snaplen);
+    g_test_add_func("/capture_reduce/vlan",             capture_reduce_test_vlan);
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
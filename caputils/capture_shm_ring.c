@@ -0,0 +1,342 @@
+/* capture_shm_ring.c
+ * Shared memory ring of captured packets, passed from dumpcap to its parent
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "caputils/capture_shm_ring.h"
+
+#define CAPTURE_SHM_RING_MAGIC 0x57535252    /* "WSRR" */
+
+/* Records are aligned on this boundary, so that the 64-bit fields of
+ * capture_shm_record can be read in place. */
+#define CAPTURE_SHM_RING_ALIGN 8
+
+/*
+ * The start of the shared memory; the records follow it.
+ *
+ * head is the offset at which the producer puts the next record, tail the
+ * offset of the oldest record the consumer hasn't released; both are only
+ * written by their owner and read with atomic loads by the other side.
+ * A record never wraps around the end of the ring: if there isn't enough
+ * room left at the end, the producer puts a record with just a zero
+ * rec_len there and starts over at offset 0. One byte of the ring is kept
+ * free so that head == tail always means "empty".
+ *
+ * Each side keeps its own copy of size and of the offset it owns, and
+ * checks the offset the other side wrote before using it: the consumer
+ * may run with less privileges than dumpcap and could write anything in
+ * the shared memory.
+ */
+typedef struct _capture_shm_ring_hdr {
+    guint32 magic;
+    guint32 size;           /* bytes available for records */
+    volatile gint head;
+    volatile gint tail;
+    volatile gint overflowed;
+    guint32 reserved;
+} capture_shm_ring_hdr;
+
+struct _capture_shm_ring {
+    capture_shm_ring_hdr *hdr;
+    guint8 *data;
+    size_t  map_len;
+    guint32 size;           /* bytes available for records */
+    guint32 offset;         /* head for the producer, tail for the consumer */
+    gchar  *name;           /* NULL on the consumer side */
+};
+
+#define ALIGN_REC_LEN(len) \
+    (((len) + CAPTURE_SHM_RING_ALIGN - 1) & ~(guint32)(CAPTURE_SHM_RING_ALIGN - 1))
+
+/* Is an offset written by the other side one we can use? */
+#define VALID_OFFSET(ring, off) \
+    ((off) < (ring)->size && (off) % CAPTURE_SHM_RING_ALIGN == 0)
+
+#ifdef HAVE_SHM_OPEN
+static capture_shm_ring *
+capture_shm_ring_map(int fd, size_t map_len, int *err)
+{
+    capture_shm_ring *ring;
+    void *map;
+
+    map = mmap(NULL, map_len, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        *err = errno;
+        return NULL;
+    }
+
+    ring = g_new0(capture_shm_ring, 1);
+    ring->hdr = (capture_shm_ring_hdr *)map;
+    ring->data = (guint8 *)map + ALIGN_REC_LEN(sizeof(capture_shm_ring_hdr));
+    ring->map_len = map_len;
+    return ring;
+}
+#endif
+
+capture_shm_ring *
+capture_shm_ring_create(guint32 size, const char **name, int *err)
+{
+#ifdef HAVE_SHM_OPEN
+    static guint ring_count;
+    capture_shm_ring *ring;
+    gchar *shm_name;
+    size_t map_len;
+    int fd;
+
+    size = ALIGN_REC_LEN(size);
+    map_len = ALIGN_REC_LEN(sizeof(capture_shm_ring_hdr)) + size;
+
+    shm_name = g_strdup_printf("/wireshark-capture-%u-%u", (guint)getpid(), ring_count++);
+    fd = shm_open(shm_name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (fd == -1) {
+        *err = errno;
+        g_free(shm_name);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)map_len) == -1) {
+        *err = errno;
+        close(fd);
+        shm_unlink(shm_name);
+        g_free(shm_name);
+        return NULL;
+    }
+
+    ring = capture_shm_ring_map(fd, map_len, err);
+    close(fd);
+    if (ring == NULL) {
+        shm_unlink(shm_name);
+        g_free(shm_name);
+        return NULL;
+    }
+
+    ring->size = size;
+    ring->hdr->size = size;
+    ring->hdr->head = 0;
+    ring->hdr->tail = 0;
+    ring->hdr->overflowed = 0;
+    ring->name = shm_name;
+    /* Publish the header last; the consumer checks the magic number. */
+    g_atomic_int_set((volatile gint *)&ring->hdr->magic, CAPTURE_SHM_RING_MAGIC);
+
+    *name = shm_name;
+    return ring;
+#else
+    (void)size;
+    (void)name;
+    *err = ENOSYS;
+    return NULL;
+#endif
+}
+
+capture_shm_ring *
+capture_shm_ring_open(const char *name, int *err)
+{
+#ifdef HAVE_SHM_OPEN
+    capture_shm_ring *ring;
+    struct stat st;
+    int fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1) {
+        *err = errno;
+        return NULL;
+    }
+    /* Nobody else is supposed to open it. */
+    shm_unlink(name);
+
+    if (fstat(fd, &st) == -1) {
+        *err = errno;
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size <= ALIGN_REC_LEN(sizeof(capture_shm_ring_hdr))) {
+        *err = EINVAL;
+        close(fd);
+        return NULL;
+    }
+
+    ring = capture_shm_ring_map(fd, (size_t)st.st_size, err);
+    close(fd);
+    if (ring == NULL)
+        return NULL;
+
+    if ((guint32)g_atomic_int_get((volatile gint *)&ring->hdr->magic) != CAPTURE_SHM_RING_MAGIC ||
+        ALIGN_REC_LEN(sizeof(capture_shm_ring_hdr)) + ring->hdr->size != ring->map_len) {
+        *err = EINVAL;
+        capture_shm_ring_close(ring);
+        return NULL;
+    }
+    ring->size = (guint32)(ring->map_len - ALIGN_REC_LEN(sizeof(capture_shm_ring_hdr)));
+    return ring;
+#else
+    (void)name;
+    *err = ENOSYS;
+    return NULL;
+#endif
+}
+
+void
+capture_shm_ring_close(capture_shm_ring *ring)
+{
+    if (ring == NULL)
+        return;
+#ifdef HAVE_SHM_OPEN
+    munmap(ring->hdr, ring->map_len);
+    if (ring->name) {
+        /* In case the consumer never opened it. */
+        shm_unlink(ring->name);
+        g_free(ring->name);
+    }
+#endif
+    g_free(ring);
+}
+
+gboolean
+capture_shm_ring_put(capture_shm_ring *ring, const capture_shm_record *rec,
+                     const guint8 *pd)
+{
+    capture_shm_ring_hdr *hdr = ring->hdr;
+    guint32 size = ring->size;
+    guint32 head, tail, rec_len, avail;
+    capture_shm_record *dst;
+
+    if (g_atomic_int_get(&hdr->overflowed))
+        return FALSE;
+
+    rec_len = ALIGN_REC_LEN((guint32)sizeof(capture_shm_record) + rec->caplen);
+    head = ring->offset;
+    tail = (guint32)g_atomic_int_get(&hdr->tail);
+
+    if (!VALID_OFFSET(ring, tail)) {
+        /* Not written by a well-behaved consumer; stop using the ring. */
+        avail = 0;
+    } else if (rec_len <= size) {
+        if (head >= tail) {
+            /* Free space is [head, size) and [0, tail - 1). */
+            if (size - head < rec_len) {
+                /* Doesn't fit at the end; wrap if it fits at the start. */
+                if (rec_len < tail) {
+                    if (size - head >= sizeof(guint32))
+                        *(guint32 *)(ring->data + head) = 0;
+                    head = 0;
+                    avail = tail - 1;
+                } else {
+                    avail = 0;
+                }
+            } else {
+                avail = (tail == 0) ? size - head - 1 : size - head;
+            }
+        } else {
+            avail = tail - head - 1;
+        }
+    } else {
+        avail = 0;
+    }
+
+    if (avail < rec_len) {
+        g_atomic_int_set(&hdr->overflowed, 1);
+        return FALSE;
+    }
+
+    dst = (capture_shm_record *)(ring->data + head);
+    memcpy(dst, rec, sizeof(capture_shm_record));
+    dst->rec_len = rec_len;
+    memcpy(dst + 1, pd, rec->caplen);
+
+    head += rec_len;
+    if (head == size)
+        head = 0;
+    ring->offset = head;
+    /* Make the record visible before moving head past it. */
+    g_atomic_int_set(&hdr->head, (gint)head);
+    return TRUE;
+}
+
+const capture_shm_record *
+capture_shm_ring_get(capture_shm_ring *ring)
+{
+    capture_shm_ring_hdr *hdr = ring->hdr;
+    guint32 size = ring->size;
+    guint32 head, tail;
+    const capture_shm_record *rec;
+
+    head = (guint32)g_atomic_int_get(&hdr->head);
+    tail = ring->offset;
+    if (!VALID_OFFSET(ring, head)) {
+        /* Corrupted; don't look at it any further. */
+        g_atomic_int_set(&hdr->overflowed, 1);
+        return NULL;
+    }
+    if (head == tail)
+        return NULL;
+
+    if (size - tail < sizeof(guint32) ||
+        *(const guint32 *)(ring->data + tail) == 0) {
+        /* The producer wrapped around here. */
+        tail = 0;
+        ring->offset = 0;
+        g_atomic_int_set(&hdr->tail, 0);
+        if (head == 0)
+            return NULL;
+    }
+
+    rec = (const capture_shm_record *)(ring->data + tail);
+    if (rec->rec_len < sizeof(capture_shm_record) ||
+        rec->rec_len > size - tail ||
+        rec->caplen > rec->rec_len - sizeof(capture_shm_record)) {
+        /* Corrupted; don't look at it any further. */
+        g_atomic_int_set(&hdr->overflowed, 1);
+        return NULL;
+    }
+    return rec;
+}
+
+void
+capture_shm_ring_release(capture_shm_ring *ring, const capture_shm_record *rec)
+{
+    guint32 tail;
+
+    tail = (guint32)((const guint8 *)rec - ring->data) + rec->rec_len;
+    if (tail == ring->size)
+        tail = 0;
+    ring->offset = tail;
+    g_atomic_int_set(&ring->hdr->tail, (gint)tail);
+}
+
+gboolean
+capture_shm_ring_overflowed(capture_shm_ring *ring)
+{
+    return g_atomic_int_get(&ring->hdr->overflowed) != 0;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,118 @@
+/* capture_shm_ring.h
+ * Shared memory ring of captured packets, passed from dumpcap to its parent
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_SHM_RING_H__
+#define __CAPTURE_SHM_RING_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * While capturing, dumpcap writes every packet to the capture file and
+ * tells its parent how many packets it wrote; the parent then reads those
+ * packets back from the file. If the parent asks for it, dumpcap also puts
+ * each packet it wrote in a shared memory ring, so that the parent can
+ * dissect it from there instead of reading it back from the file.
+ *
+ * The ring has a single producer (dumpcap) and a single consumer (the
+ * parent). Each packet is described by a capture_shm_record, followed by
+ * the packet data. The records are put in the ring in the order the
+ * packets are written to the file, and each one has the offset of the
+ * packet in the file, so that the parent can still read it from the file
+ * later.
+ *
+ * dumpcap never waits for the parent. If the ring is full, dumpcap marks
+ * it as overflowed and stops using it; the parent must then go back to
+ * reading the packets after the last one it got from the ring from the
+ * capture file.
+ *
+ * Only available where POSIX shared memory is (HAVE_SHM_OPEN).
+ */
+
+/** Default size of the ring, in bytes */
+#define CAPTURE_SHM_RING_SIZE (32 * 1024 * 1024)
+
+typedef struct _capture_shm_ring capture_shm_ring;
+
+/** A packet in the ring; the packet data follows. */
+typedef struct _capture_shm_record {
+    guint32 rec_len;        /**< Length of the record in the ring, including padding */
+    guint32 interface_id;   /**< Interface (IDB) the packet was captured on */
+    gint64  file_offset;    /**< Offset of the packet in the capture file */
+    gint64  ts_secs;        /**< Time stamp, seconds */
+    guint32 ts_nsecs;       /**< Time stamp, nanoseconds */
+    guint32 caplen;         /**< Number of bytes of packet data */
+    guint32 len;            /**< Length of the packet on the wire */
+    guint32 reserved;
+} capture_shm_record;
+
+/** Create a new shared memory ring with room for size bytes of records
+ * (used by dumpcap).
+ * Returns NULL and sets *err to an errno value on failure. On success,
+ * *name is set to the name the consumer passes to capture_shm_ring_open();
+ * it belongs to the ring. */
+extern capture_shm_ring *
+capture_shm_ring_create(guint32 size, const char **name, int *err);
+
+/** Open the ring created by capture_shm_ring_create() with the given name
+ * (used by the parent of dumpcap). The name is removed from the system, so
+ * the ring can't be opened again; it goes away once both sides closed it.
+ * Returns NULL and sets *err to an errno value on failure. */
+extern capture_shm_ring *
+capture_shm_ring_open(const char *name, int *err);
+
+/** Close a ring, on either side. */
+extern void
+capture_shm_ring_close(capture_shm_ring *ring);
+
+/** Put a packet in the ring (producer only). The rec_len field of rec
+ * is ignored. Returns FALSE if the packet didn't fit, in which case the
+ * ring is now overflowed and nothing is put in it anymore. */
+extern gboolean
+capture_shm_ring_put(capture_shm_ring *ring, const capture_shm_record *rec,
+                     const guint8 *pd);
+
+/** Get the oldest packet in the ring (consumer only), or NULL if the ring
+ * is empty. The packet data follows the record. The record stays valid
+ * until it is released with capture_shm_ring_release(). */
+extern const capture_shm_record *
+capture_shm_ring_get(capture_shm_ring *ring);
+
+/** Release the packet returned by capture_shm_ring_get() (consumer only),
+ * so that its space can be reused. */
+extern void
+capture_shm_ring_release(capture_shm_ring *ring, const capture_shm_record *rec);
+
+/** Returns TRUE if the producer stopped using the ring because it was
+ * full. Packets that were put in the ring before can still be read. */
+extern gboolean
+capture_shm_ring_overflowed(capture_shm_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CAPTURE_SHM_RING_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -6,6 +6,8 @@
 #  LUA_INCLUDE_DIRS - Where to find lua.h
 #  LUA_DLL_DIR      - (Windows) Path to the Lua DLL.
 #  LUA_DLL          - (Windows) Name of the Lua DLL.
+#  LUA_IS_LUAJIT    - If ENABLE_LUAJIT is set and LuaJIT was found instead
+#                     of Lua. LuaJIT implements the Lua 5.1 API.
 #
 # Note that the expected include convention is
 #  #include "lua.h"
@@ -17,10 +19,18 @@
 INCLUDE(FindWSWinLibs)
 FindWSWinLibs("lua5*" "LUA_HINTS")
 
+if(ENABLE_LUAJIT)
+  set(_lua_pkgs luajit)
+  set(_lua_path_suffixes include/luajit-2.1 include/luajit-2.0)
+else()
+  set(_lua_pkgs lua5.2 lua-5.2 lua52 lua5.1 lua-5.1 lua51 lua5.0 lua-5.0 lua50)
+  set(_lua_path_suffixes include/lua52 include/lua5.2 include/lua51 include/lua5.1 include/lua include)
+endif()
+
 if(NOT WIN32)
   find_package(PkgConfig)
-  pkg_search_module(LUA lua5.2 lua-5.2 lua52 lua5.1 lua-5.1 lua51 lua5.0 lua-5.0 lua50)
-  if(NOT LUA_FOUND)
+  pkg_search_module(LUA ${_lua_pkgs})
+  if(NOT LUA_FOUND AND NOT ENABLE_LUAJIT)
       pkg_search_module(LUA "lua<=5.2.99")
   endif()
 endif()
@@ -30,7 +40,7 @@ FIND_PATH(LUA_INCLUDE_DIR lua.h
     "${LUA_INCLUDEDIR}"
     "$ENV{LUA_DIR}"
   ${LUA_HINTS}
-  PATH_SUFFIXES include/lua52 include/lua5.2 include/lua51 include/lua5.1 include/lua include
+  PATH_SUFFIXES ${_lua_path_suffixes}
   PATHS
   ~/Library/Frameworks
   /Library/Frameworks
@@ -56,8 +66,17 @@ if ( LUA_INCLUDE_DIR STREQUAL LUA_INC_SUFFIX )
   set( LUA_INC_SUFFIX "")
 endif()
 
+if(ENABLE_LUAJIT)
+  set(_lua_lib_names luajit-5.1 luajit51 luajit)
+  if(LUA_INCLUDE_DIR AND EXISTS "${LUA_INCLUDE_DIR}/luajit.h")
+    set(LUA_IS_LUAJIT TRUE)
+  endif()
+else()
+  set(_lua_lib_names lua${LUA_INC_SUFFIX} lua52 lua5.2 lua51 lua5.1 lua)
+endif()
+
 FIND_LIBRARY(LUA_LIBRARY
-  NAMES lua${LUA_INC_SUFFIX} lua52 lua5.2 lua51 lua5.1 lua
+  NAMES ${_lua_lib_names}
   HINTS
     "${LUA_LIBDIR}"
     "$ENV{LUA_DIR}"
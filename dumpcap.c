@@ -61,6 +61,7 @@
 #include "caputils/capture_ifinfo.h"
 #include "caputils/capture-pcap-util.h"
 #include "caputils/capture-pcap-util-int.h"
+#include "caputils/capture_shm_ring.h"
 #ifdef _WIN32
 #include "caputils/capture-wpcap.h"
 #endif /* _WIN32 */
@@ -86,6 +87,7 @@
 
 #include "conditions.h"
 #include "capture_stop_conditions.h"
+#include "capture_reduce.h"
 
 #include "wsutil/tempfile.h"
 #include "log.h"
@@ -124,12 +126,15 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
+/* Used by the writer thread to sleep while all of the capture rings are
+   empty; see capture_loop_dequeue_packet(). */
+static GMutex pcap_queue_mtx;
+static GCond pcap_queue_cond;
+static volatile gint pcap_queue_writer_waiting;
+
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 #ifdef _WIN32
 static gchar *sig_pipe_name = NULL;
@@ -237,6 +242,48 @@ typedef struct _pcapng_pipe_info {
 
 struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispatch function pointer */
 
+/*
+ * A record in a capture ring: a packet (or pcapng block) header followed
+ * by the packet data, padded so that the next record is 8-byte aligned.
+ */
+typedef struct _pcap_ring_record {
+    guint32                          rec_len;   /**< Length of the record including padding; 0 means "skip to the start of the ring" */
+    gboolean                         is_pcapng; /**< TRUE if u.bh is valid, FALSE if u.phdr is */
+    guint64                          ts_key;    /**< Timestamp in nanoseconds used to merge the rings; 0 if not known */
+    union {
+        struct pcap_pkthdr           phdr;
+        struct pcapng_block_header_s bh;
+    } u;
+} pcap_ring_record;
+
+#define PCAP_RING_ALIGN(len)        (((len) + 7U) & ~7U)
+#define PCAP_RING_RECORD_LEN(len)   PCAP_RING_ALIGN((guint32)sizeof(pcap_ring_record) + (len))
+/* Largest ring used if no byte limit was given, see --max-queue-memory */
+#define PCAP_RING_DEFAULT_SIZE      (16U * 1024U * 1024U)
+static guint64 pcap_ring_max_size = PCAP_RING_DEFAULT_SIZE;
+
+/*
+ * A single-producer/single-consumer queue of captured packets, used when
+ * capturing with a thread per interface. The capture thread of the source
+ * is the only one moving head and the writer thread is the only one moving
+ * tail, so the only synchronization needed is publishing those with atomic
+ * stores. The records are stored inline in a buffer allocated once when
+ * the capture starts, so queueing a packet is a single copy.
+ *
+ * head and tail are free-running byte offsets; the position in the buffer
+ * is the offset modulo size, which is a power of two.
+ */
+typedef struct _pcap_ring {
+    guint8                      *buf;
+    guint32                      size;
+    volatile gint                head;          /**< Written by the capture thread */
+    volatile gint                tail;          /**< Written by the writer thread */
+    volatile gint                packets_in;    /**< Written by the capture thread */
+    volatile gint                packets_out;   /**< Written by the writer thread */
+    guint32                      max_packets;   /**< High-water mark of queued packets */
+    guint32                      max_bytes;     /**< High-water mark of queued bytes */
+} pcap_ring;
+
 /*
  * A source of packets from which we're capturing.
  */
@@ -287,6 +334,14 @@ typedef struct _capture_src {
     GMutex                      *cap_pipe_read_mtx;
     GAsyncQueue                 *cap_pipe_pending_q, *cap_pipe_done_q;
 #endif
+    pcap_ring                    ring;                   /**< Queue of captured packets, if use_threads */
+                                                         /**< output file of this source, if per_interface_files */
+    FILE                        *pdh;
+    void                        *pdh_buf;                /**< stdio buffer of pdh, see pcapio_set_write_buffer() */
+    gchar                       *save_file;              /**< name of pdh */
+    guint64                      bytes_written;
+    int                          write_err;              /**< if non-zero, error seen while writing to pdh */
+    capture_reduce              *reduce;                 /**< sampling/truncation state, if any was asked for */
 } capture_src;
 
 /*
@@ -299,26 +354,23 @@ typedef struct _loop_data {
     gint      packet_count;        /**< Number of packets we have already captured */
     gint      packet_max;          /**< Number of packets we're supposed to capture - 0 means infinite */
     guint     inpkts_to_sync_pipe; /**< Packets not already send out to the sync_pipe */
+    gboolean  switch_unreported;   /**< The last file switch wasn't sent out to the sync_pipe yet */
+    guint     inpkts_before_switch; /**< Packets written to the previous file not sent out yet */
 #ifdef SIGINFO
     gboolean  report_packet_count; /**< Set by SIGINFO handler; print packet count */
 #endif
     GArray   *pcaps;               /**< Array of capture_src's on which we're capturing */
     /* output file(s) */
     FILE     *pdh;
+    void     *pdh_buf;             /**< stdio buffer of pdh if not multi_files_on, see pcapio_set_write_buffer() */
     int       save_file_fd;
     guint64   bytes_written;
     guint32   autostop_files;
+    capture_shm_ring *shm_ring;    /**< packets handed to our parent, if it asked for it */
+    volatile gint packets_taken;   /**< Packets taken from the -c limit by all capture threads, if per_interface_files */
+    volatile gint packets_written; /**< Packets written by all capture threads, if per_interface_files */
 } loop_data;
 
-typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
-    union {
-        struct pcap_pkthdr  phdr;
-        struct pcapng_block_header_s  bh;
-    } u;
-    u_char             *pd;
-} pcap_queue_element;
-
 /*
  * Standard secondary message for unexpected errors.
  */
@@ -376,6 +428,8 @@ console_log_handler(const char *log_domain, GLogLevelFlags log_level,
 static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
+static gboolean per_interface_files = FALSE;
+static capture_reduce_opts reduce_opts;
 static guint64 start_time;
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -384,6 +438,7 @@ static void capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_p
                                          const u_char *pd);
 static void capture_loop_write_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_header_s *bh, const u_char *pd);
 static void capture_loop_queue_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_header_s *bh, const u_char *pd);
+static int capture_loop_count_src_packets(gboolean wait);
 static void capture_loop_get_errmsg(char *errmsg, int errmsglen, const char *fname,
                                     int err, gboolean is_close);
 
@@ -391,8 +446,10 @@ static void WS_NORETURN exit_main(int err);
 
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
-static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop,
+                                guint32 queue_max_packets, guint32 queue_max_bytes, gchar *name);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
+static void report_packet_reduction(const capture_reduce *reduce, gchar *name);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
 #define MSG_MAX_LENGTH 4096
@@ -444,6 +501,13 @@ print_usage(FILE *output)
     fprintf(output, "                           timer:NUM - capture no more than 1 packet in NUM ms\n");
 #endif
 #endif
+    fprintf(output, "Sampling and truncation (applied before any copy):\n");
+    fprintf(output, "  --sample <N>             keep one packet in N\n");
+    fprintf(output, "  --sample-flows <N>       keep one IP flow in N, whole\n");
+    fprintf(output, "  --flow-bytes <K>         keep only the headers after K payload bytes of a flow\n");
+    fprintf(output, "  --protocol-snaplen <proto>:<len>\n");
+    fprintf(output, "                           snapshot length for tcp, udp, sctp, icmp,\n");
+    fprintf(output, "                           ip (other IP) or other (non-IP) packets\n");
     fprintf(output, "Stop conditions:\n");
     fprintf(output, "  -c <packet count>        stop after n packets (def: infinite)\n");
     fprintf(output, "  -a <autostop cond.> ...  duration:NUM - stop after NUM seconds\n");
@@ -462,12 +526,16 @@ print_usage(FILE *output)
     fprintf(output, "  --capture-comment <comment>\n");
     fprintf(output, "                           add a capture comment to the output file\n");
     fprintf(output, "                           (only for pcapng)\n");
+    fprintf(output, "  --per-interface-files    write the packets of each interface to its own file,\n");
+    fprintf(output, "                           <outfile>_<N><ext>, from its own capture thread\n");
+    fprintf(output, "                           (merge them with mergecap)\n");
     fprintf(output, "\n");
     fprintf(output, "Miscellaneous:\n");
-    fprintf(output, "  -N <packet_limit>        maximum number of packets buffered within dumpcap\n");
-    fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
+    fprintf(output, "  -N <packet_limit>        maximum number of packets buffered per interface\n");
+    fprintf(output, "  -C <byte_limit>          maximum number of bytes buffered per interface\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+    fprintf(output, "  --max-queue-memory <MB>  memory buffered per interface without -C (def: 16)\n");
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v                       print version information and exit\n");
     fprintf(output, "  -h                       display this help and exit\n");
@@ -2751,6 +2819,10 @@ static void capture_loop_close_input(loop_data *ld)
                 pcap_src->pcap_h = NULL;
             }
         }
+        if (pcap_src->reduce != NULL) {
+            capture_reduce_free(pcap_src->reduce);
+            pcap_src->reduce = NULL;
+        }
     }
 
     ld->go = FALSE;
@@ -2821,6 +2893,8 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
         ld->pdh = ws_fdopen(ld->save_file_fd, "wb");
         if (ld->pdh == NULL) {
             err = errno;
+        } else {
+            ld->pdh_buf = pcapio_set_write_buffer(ld->pdh, PCAPIO_WRITE_BUFFER_SIZE);
         }
     }
     if (ld->pdh) {
@@ -2888,6 +2962,8 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
         if (!successful) {
             fclose(ld->pdh);
             ld->pdh = NULL;
+            g_free(ld->pdh_buf);
+            ld->pdh_buf = NULL;
         }
     }
 
@@ -2917,6 +2993,279 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
     return TRUE;
 }
 
+/*
+ * If our parent asked for it, set up a shared memory ring in which we put
+ * every packet we write, so that it can dissect the packets from there
+ * rather than read them back from the capture file, and tell it the name
+ * of the ring.
+ *
+ * Only done when all packets go to a single capture file that our parent
+ * reads, and that file's packets are written by capture_loop_write_packet_cb().
+ * If the ring can't be created, our parent just reads the file as usual.
+ */
+static void
+capture_loop_open_shm_ring(capture_options *capture_opts, loop_data *ld)
+{
+    guint        i;
+    capture_src *pcap_src;
+    const char  *name;
+    int          err;
+
+    if (!capture_child || !capture_opts->use_shm_ring ||
+        capture_opts->multi_files_on || capture_opts->output_to_pipe)
+        return;
+    for (i = 0; i < ld->pcaps->len; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->from_pcapng)
+            return;
+    }
+
+    ld->shm_ring = capture_shm_ring_create(CAPTURE_SHM_RING_SIZE, &name, &err);
+    if (ld->shm_ring == NULL) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Can't create the shared memory ring: %s", g_strerror(err));
+        return;
+    }
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "Shared memory ring: %s", name);
+    pipe_write_block(2, SP_SHM_RING, name);
+}
+
+/* Put a packet we just wrote at offset in the capture file in the shared
+ * memory ring. If our parent didn't keep up and the ring is full, give up
+ * on the ring; our parent will then read the rest from the file. */
+static void
+capture_loop_put_shm_ring(capture_src *pcap_src, const struct pcap_pkthdr *phdr,
+                          const u_char *pd, guint64 offset)
+{
+    capture_shm_record rec;
+
+    rec.interface_id = global_capture_opts.use_pcapng ? pcap_src->interface_id : 0;
+    rec.file_offset  = (gint64)offset;
+    rec.ts_secs      = (gint64)phdr->ts.tv_sec;
+    rec.ts_nsecs     = (guint32)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    rec.caplen       = phdr->caplen;
+    rec.len          = phdr->len;
+    rec.reserved     = 0;
+
+    if (!capture_shm_ring_put(global_ld.shm_ring, &rec, pd)) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Shared memory ring full, parent reads the capture file from now on");
+        capture_shm_ring_close(global_ld.shm_ring);
+        global_ld.shm_ring = NULL;
+    }
+}
+
+/*
+ * Name of the output file of the interface with the given index if
+ * per_interface_files is set: "<outfile>_<index><extension>". The index is
+ * the interface's position on the command line, so that merging the files
+ * in that order keeps the interface IDs of a regular multi-interface
+ * capture.
+ */
+static gchar *
+capture_loop_src_file_name(const char *save_file, guint i)
+{
+    gchar      *basename;
+    const char *suffix;
+    gchar      *name;
+
+    basename = g_path_get_basename(save_file);
+    suffix = strrchr(basename, '.');
+    if (suffix == NULL)
+        suffix = "";
+    name = g_strdup_printf("%.*s_%u%s", (int)(strlen(save_file) - strlen(suffix)),
+                           save_file, i, suffix);
+    g_free(basename);
+    return name;
+}
+
+/* The comment of the ISB of an interface: who provided the counters and,
+   if packets were sampled or truncated, how many by which stage. */
+static gchar *
+capture_loop_isb_comment(capture_src *pcap_src)
+{
+    capture_reduce_counts counts;
+
+    if (pcap_src->reduce == NULL)
+        return g_strdup("Counters provided by dumpcap");
+
+    capture_reduce_get_counts(pcap_src->reduce, &counts);
+    return g_strdup_printf("Counters provided by dumpcap; "
+                           "sampled out: %" G_GUINT64_FORMAT
+                           ", flow sampled out: %" G_GUINT64_FORMAT
+                           ", flow byte capped: %" G_GUINT64_FORMAT
+                           ", protocol snaplen cut: %" G_GUINT64_FORMAT
+                           ", bytes cut: %" G_GUINT64_FORMAT,
+                           counts.sampled_out, counts.flow_sampled_out,
+                           counts.flow_capped, counts.snaplen_cut,
+                           counts.bytes_cut);
+}
+
+/* Close the output files of all interfaces (per_interface_files), writing
+   an ISB to each first, or, if discard is set, close and remove them. */
+static gboolean
+capture_loop_close_src_outputs(loop_data *ld, gboolean discard, int *err_close)
+{
+    guint        i;
+    capture_src *pcap_src;
+    gboolean     close_ok = TRUE;
+    guint64      end_time = create_timestamp();
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->pdh == NULL)
+            continue;
+
+        if (!discard && !pcap_src->from_cap_pipe) {
+            guint64 isb_ifrecv, isb_ifdrop;
+            struct pcap_stat stats;
+            gchar *isb_comment;
+
+            if (pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
+                isb_ifrecv = pcap_src->received;
+                isb_ifdrop = stats.ps_drop + pcap_src->dropped + pcap_src->flushed;
+            } else {
+                isb_ifrecv = G_MAXUINT64;
+                isb_ifdrop = G_MAXUINT64;
+            }
+            isb_comment = capture_loop_isb_comment(pcap_src);
+            pcapng_write_interface_statistics_block(pcap_src->pdh,
+                                                    0,
+                                                    &pcap_src->bytes_written,
+                                                    isb_comment,
+                                                    start_time,
+                                                    end_time,
+                                                    isb_ifrecv,
+                                                    isb_ifdrop,
+                                                    err_close);
+            g_free(isb_comment);
+        }
+        if (fclose(pcap_src->pdh) == EOF) {
+            if (err_close != NULL) {
+                *err_close = errno;
+            }
+            close_ok = FALSE;
+        }
+        pcap_src->pdh = NULL;
+        g_free(pcap_src->pdh_buf);
+        pcap_src->pdh_buf = NULL;
+        if (discard)
+            ws_unlink(pcap_src->save_file);
+    }
+    return close_ok;
+}
+
+/*
+ * Open an output file for each interface (per_interface_files) and write
+ * the SHB, which is the same for all of them, and the IDB of the interface
+ * to it. The packets of each interface are then written to its file by the
+ * capture thread of that interface, see capture_loop_write_src_packet().
+ */
+static gboolean
+capture_loop_open_src_outputs(capture_options *capture_opts, loop_data *ld,
+                              char *errmsg, int errmsg_len)
+{
+    guint              i;
+    capture_src       *pcap_src;
+    interface_options *interface_opts;
+    char              *appname;
+    GString           *cpu_info_str;
+    GString           *os_info_str;
+    int                fd;
+    int                err = 0;
+    gboolean           successful = TRUE;
+
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_open_src_outputs");
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->from_pcapng) {
+            g_snprintf(errmsg, errmsg_len,
+                       "One file per interface can't be written when capturing from a pcapng pipe.");
+            return FALSE;
+        }
+    }
+
+    cpu_info_str = g_string_new("");
+    os_info_str = g_string_new("");
+    get_cpu_info(cpu_info_str);
+    get_os_version_info(os_info_str);
+    appname = g_strdup_printf("Dumpcap (Wireshark) %s", get_ws_vcs_version_info());
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+
+        pcap_src->save_file = capture_loop_src_file_name(capture_opts->save_file, i);
+        fd = ws_open(pcap_src->save_file, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
+                     (capture_opts->group_read_access) ? 0640 : 0600);
+        if (fd == -1) {
+            err = errno;
+            successful = FALSE;
+            break;
+        }
+        pcap_src->pdh = ws_fdopen(fd, "wb");
+        if (pcap_src->pdh == NULL) {
+            err = errno;
+            ws_close(fd);
+            ws_unlink(pcap_src->save_file);
+            successful = FALSE;
+            break;
+        }
+        pcap_src->pdh_buf = pcapio_set_write_buffer(pcap_src->pdh, PCAPIO_WRITE_BUFFER_SIZE);
+
+        if (pcap_src->from_cap_pipe) {
+            pcap_src->snaplen = pcap_src->cap_pipe_info.pcap.hdr.snaplen;
+        } else {
+            pcap_src->snaplen = pcap_snapshot(pcap_src->pcap_h);
+        }
+        successful = pcapng_write_session_header_block(pcap_src->pdh,
+                            (const char *)capture_opts->capture_comment,   /* Comment */
+                            cpu_info_str->str,           /* HW */
+                            os_info_str->str,            /* OS */
+                            appname,
+                            -1,                          /* section_length */
+                            &pcap_src->bytes_written,
+                            &err) &&
+                     pcapng_write_interface_description_block(pcap_src->pdh,
+                            NULL,                       /* OPT_COMMENT       1 */
+                            interface_opts->name,       /* IDB_NAME          2 */
+                            interface_opts->descr,      /* IDB_DESCRIPTION   3 */
+                            interface_opts->cfilter,    /* IDB_FILTER       11 */
+                            os_info_str->str,           /* IDB_OS           12 */
+                            pcap_src->linktype,
+                            pcap_src->snaplen,
+                            &pcap_src->bytes_written,
+                            0,                          /* IDB_IF_SPEED      8 */
+                            pcap_src->ts_nsec ? 9 : 6,  /* IDB_TSRESOL       9 */
+                            &err);
+        if (!successful)
+            break;
+        /* Make the header visible to whoever reads the file. */
+        fflush(pcap_src->pdh);
+    }
+
+    g_string_free(cpu_info_str, TRUE);
+    g_string_free(os_info_str, TRUE);
+    g_free(appname);
+
+    if (!successful) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        g_snprintf(errmsg, errmsg_len,
+                   "The file to which the capture would be saved (\"%s\") "
+                   "could not be opened: %s.", pcap_src->save_file,
+                   g_strerror(err));
+        capture_loop_close_src_outputs(ld, TRUE, NULL);
+        return FALSE;
+    }
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        report_new_capture_file(pcap_src->save_file);
+    }
+    return TRUE;
+}
+
 static gboolean
 capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err_close)
 {
@@ -2927,7 +3276,9 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
 
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_close_output");
 
-    if (capture_opts->multi_files_on) {
+    if (per_interface_files) {
+        return capture_loop_close_src_outputs(ld, FALSE, err_close);
+    } else if (capture_opts->multi_files_on) {
         return ringbuf_libpcap_dump_close(&capture_opts->save_file, err_close);
     } else {
         if (capture_opts->use_pcapng) {
@@ -2936,6 +3287,7 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                 if (!pcap_src->from_cap_pipe) {
                     guint64 isb_ifrecv, isb_ifdrop;
                     struct pcap_stat stats;
+                    gchar *isb_comment;
 
                     if (pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
                         isb_ifrecv = pcap_src->received;
@@ -2944,15 +3296,17 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                         isb_ifrecv = G_MAXUINT64;
                         isb_ifdrop = G_MAXUINT64;
                     }
+                    isb_comment = capture_loop_isb_comment(pcap_src);
                     pcapng_write_interface_statistics_block(ld->pdh,
                                                             i,
                                                             &ld->bytes_written,
-                                                            "Counters provided by dumpcap",
+                                                            isb_comment,
                                                             start_time,
                                                             end_time,
                                                             isb_ifrecv,
                                                             isb_ifdrop,
                                                             err_close);
+                    g_free(isb_comment);
                 }
             }
         }
@@ -2960,8 +3314,12 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
             if (err_close != NULL) {
                 *err_close = errno;
             }
+            g_free(ld->pdh_buf);
+            ld->pdh_buf = NULL;
             return (FALSE);
         } else {
+            g_free(ld->pdh_buf);
+            ld->pdh_buf = NULL;
             return (TRUE);
         }
     }
@@ -3224,7 +3582,8 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                 /* ringbuffer is enabled */
                 *save_file_fd = ringbuf_init(capfile_name,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
-                                             capture_opts->group_read_access);
+                                             capture_opts->group_read_access,
+                                             (capture_opts->has_autostop_filesize) ? (guint64)capture_opts->autostop_filesize * 1000 : 0);
 
                 /* we need the ringbuf name */
                 if (*save_file_fd != -1) {
@@ -3309,6 +3668,23 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
 }
 
 
+/* Tell our parent about the last file switch, with the packets written to
+   the previous file, once the ring buffer helper thread has flushed and
+   closed that file, so that our parent can read all of them; if wait is
+   TRUE, wait for that. */
+static void
+capture_loop_report_file_switch(capture_options *capture_opts, gboolean wait)
+{
+    if (!global_ld.switch_unreported || !ringbuf_previous_files_closed(wait))
+        return;
+
+    if (!quiet)
+        report_packet_count(global_ld.inpkts_before_switch);
+    global_ld.inpkts_before_switch = 0;
+    report_new_capture_file(capture_opts->save_file);
+    global_ld.switch_unreported = FALSE;
+}
+
 /* Do the work of handling either the file size or file duration capture
    conditions being reached, and switching files or stopping. */
 static gboolean
@@ -3331,6 +3707,9 @@ do_file_switch_or_stop(capture_options *capture_opts,
             return FALSE;
         }
 
+        /* Our parent must know about the previous switch first */
+        capture_loop_report_file_switch(capture_opts, TRUE);
+
         /* Switch to the next ringbuffer file */
         if (ringbuf_switch_file(&global_ld.pdh, &capture_opts->save_file,
                                 &global_ld.save_file_fd, &global_ld.err)) {
@@ -3410,10 +3789,10 @@ do_file_switch_or_stop(capture_options *capture_opts,
             if (cnd_file_interval)
                 cnd_reset(cnd_file_interval);
             fflush(global_ld.pdh);
-            if (!quiet)
-                report_packet_count(global_ld.inpkts_to_sync_pipe);
+            global_ld.inpkts_before_switch = global_ld.inpkts_to_sync_pipe;
             global_ld.inpkts_to_sync_pipe = 0;
-            report_new_capture_file(capture_opts->save_file);
+            global_ld.switch_unreported = TRUE;
+            capture_loop_report_file_switch(capture_opts, FALSE);
         } else {
             /* File switch failed: stop here */
             global_ld.go = FALSE;
@@ -3427,6 +3806,223 @@ do_file_switch_or_stop(capture_options *capture_opts,
     return TRUE;
 }
 
+/* Allocate the buffer of a capture ring, big enough for the configured
+   queue limits and at least two packets of the maximum standard size.
+   With only a packet limit, the ring is sized for that many packets of
+   the snapshot length of the source, but no larger than
+   pcap_ring_max_size. */
+static void
+pcap_ring_init(pcap_ring *ring, guint32 snaplen)
+{
+    guint64 wanted;
+    guint32 size;
+
+    if (pcap_queue_byte_limit > 0) {
+        wanted = (guint64)pcap_queue_byte_limit +
+                 (guint64)pcap_queue_packet_limit * sizeof(pcap_ring_record);
+    } else {
+        if (snaplen == 0 || snaplen > WTAP_MAX_PACKET_SIZE_STANDARD)
+            snaplen = WTAP_MAX_PACKET_SIZE_STANDARD;
+        wanted = (guint64)pcap_queue_packet_limit * PCAP_RING_RECORD_LEN(snaplen);
+        wanted = MIN(wanted, pcap_ring_max_size);
+    }
+    wanted = MAX(wanted, 2 * (guint64)PCAP_RING_RECORD_LEN(WTAP_MAX_PACKET_SIZE_STANDARD));
+
+    for (size = 4096; size < wanted && size < (1U << 30); size <<= 1)
+        ;
+
+    ring->buf = (guint8 *)g_malloc(size);
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->packets_in = 0;
+    ring->packets_out = 0;
+    ring->max_packets = 0;
+    ring->max_bytes = 0;
+}
+
+static void
+pcap_ring_free(pcap_ring *ring)
+{
+    g_free(ring->buf);
+    ring->buf = NULL;
+    ring->size = 0;
+}
+
+/* Add a record to a capture ring. Called from the capture thread of the
+   source only. Returns FALSE, without blocking, if the ring is full or the
+   queue limits have been reached. */
+static gboolean
+pcap_ring_push(pcap_ring *ring, const pcap_ring_record *rec_hdr, const u_char *pd, guint32 data_len)
+{
+    guint32           head     = (guint32)ring->head;
+    guint32           tail     = (guint32)g_atomic_int_get(&ring->tail);
+    guint32           packets  = (guint32)ring->packets_in - (guint32)g_atomic_int_get(&ring->packets_out);
+    guint32           rec_len  = PCAP_RING_RECORD_LEN(data_len);
+    guint32           offset   = head & (ring->size - 1);
+    guint32           contig   = ring->size - offset;
+    guint32           needed   = rec_len;
+    pcap_ring_record *rec;
+
+    if (pcap_queue_packet_limit > 0 && packets >= pcap_queue_packet_limit) {
+        return FALSE;
+    }
+    if (pcap_queue_byte_limit > 0 && head - tail >= pcap_queue_byte_limit) {
+        return FALSE;
+    }
+
+    /* A record is never split; if it doesn't fit at the end of the buffer,
+       the rest of the buffer is skipped. */
+    if (contig < rec_len) {
+        needed += contig;
+    }
+    if (needed > ring->size - (head - tail)) {
+        return FALSE;
+    }
+
+    if (contig < rec_len) {
+        /* Records are 8-byte aligned, so there is always room for rec_len */
+        ((pcap_ring_record *)(ring->buf + offset))->rec_len = 0;
+        head += contig;
+        offset = 0;
+    }
+
+    rec = (pcap_ring_record *)(ring->buf + offset);
+    *rec = *rec_hdr;
+    rec->rec_len = rec_len;
+    memcpy(rec + 1, pd, data_len);
+
+    /* Publish the record to the writer thread */
+    head += rec_len;
+    g_atomic_int_set(&ring->head, (gint)head);
+    packets++;
+    g_atomic_int_set(&ring->packets_in, ring->packets_in + 1);
+
+    if (packets > ring->max_packets) {
+        ring->max_packets = packets;
+    }
+    if (head - tail > ring->max_bytes) {
+        ring->max_bytes = head - tail;
+    }
+
+    /* Wake up the writer thread if it's waiting for packets */
+    if (g_atomic_int_get(&pcap_queue_writer_waiting)) {
+        g_mutex_lock(&pcap_queue_mtx);
+        g_cond_signal(&pcap_queue_cond);
+        g_mutex_unlock(&pcap_queue_mtx);
+    }
+
+    return TRUE;
+}
+
+/* Get the oldest record of a capture ring without removing it, or NULL if
+   the ring is empty. Called from the writer thread only. */
+static pcap_ring_record *
+pcap_ring_peek(pcap_ring *ring)
+{
+    guint32           head = (guint32)g_atomic_int_get(&ring->head);
+    guint32           tail = (guint32)ring->tail;
+    pcap_ring_record *rec;
+
+    if (head == tail) {
+        return NULL;
+    }
+    rec = (pcap_ring_record *)(ring->buf + (tail & (ring->size - 1)));
+    if (rec->rec_len == 0) {
+        /* The producer wrapped around; the next record is at the start */
+        tail += ring->size - (tail & (ring->size - 1));
+        g_atomic_int_set(&ring->tail, (gint)tail);
+        rec = (pcap_ring_record *)ring->buf;
+    }
+    return rec;
+}
+
+/* Remove the record returned by pcap_ring_peek(), handing its space back
+   to the capture thread. */
+static void
+pcap_ring_pop(pcap_ring *ring, const pcap_ring_record *rec)
+{
+    g_atomic_int_set(&ring->tail, ring->tail + (gint)rec->rec_len);
+    g_atomic_int_set(&ring->packets_out, ring->packets_out + 1);
+}
+
+/* Write the oldest queued packet of all capture sources to the output.
+   The rings are merged on the timestamps of the packets at their heads;
+   as we can't wait for idle interfaces that only gives timestamp order
+   among the packets queued at that time. Blocks from pcapng pipes have
+   no comparable timestamp and are written as soon as they are seen.
+   If wait is TRUE and nothing is queued, wait up to WRITER_THREAD_TIMEOUT
+   for a packet to arrive.
+   Returns TRUE if a packet was written. */
+static gboolean
+capture_loop_dequeue_packet(gboolean wait)
+{
+    capture_src      *pcap_src;
+    capture_src      *oldest_src;
+    pcap_ring_record *rec;
+    pcap_ring_record *oldest_rec;
+    guint             i;
+
+    for (;;) {
+        oldest_src = NULL;
+        oldest_rec = NULL;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            rec = pcap_ring_peek(&pcap_src->ring);
+            if (rec != NULL && (oldest_rec == NULL || rec->ts_key < oldest_rec->ts_key)) {
+                oldest_src = pcap_src;
+                oldest_rec = rec;
+            }
+        }
+
+        if (oldest_rec != NULL || !wait) {
+            break;
+        }
+
+        /* Nothing queued; sleep until a capture thread queues a packet.
+           The flag is set before checking the rings once more, so a packet
+           queued in between either is seen here or wakes us up. */
+        g_mutex_lock(&pcap_queue_mtx);
+        g_atomic_int_set(&pcap_queue_writer_waiting, 1);
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_ring_peek(&pcap_src->ring) != NULL) {
+                break;
+            }
+        }
+        if (i == global_ld.pcaps->len) {
+            g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mtx,
+                              g_get_monotonic_time() + WRITER_THREAD_TIMEOUT);
+        }
+        g_atomic_int_set(&pcap_queue_writer_waiting, 0);
+        g_mutex_unlock(&pcap_queue_mtx);
+        wait = FALSE;
+    }
+
+    if (oldest_rec == NULL) {
+        return FALSE;
+    }
+
+    if (oldest_rec->is_pcapng) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dequeued a block of length %d captured on interface %d.",
+              oldest_rec->u.bh.block_total_length, oldest_src->interface_id);
+
+        capture_loop_write_pcapng_cb(oldest_src, &oldest_rec->u.bh,
+                                     (const u_char *)(oldest_rec + 1));
+    } else {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dequeued a packet of length %d captured on interface %d.",
+              oldest_rec->u.phdr.caplen, oldest_src->interface_id);
+
+        capture_loop_write_packet_cb((u_char *)oldest_src, &oldest_rec->u.phdr,
+                                     (const u_char *)(oldest_rec + 1));
+    }
+    pcap_ring_pop(&oldest_src->ring, oldest_rec);
+
+    return TRUE;
+}
+
 static void *
 pcap_read_handler(void* arg)
 {
@@ -3488,10 +4084,16 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     else
         global_ld.packet_max      = 0;        /* no limit */
     global_ld.inpkts_to_sync_pipe = 0;
+    global_ld.switch_unreported   = FALSE;
+    global_ld.inpkts_before_switch = 0;
     global_ld.err                 = 0;  /* no error seen yet */
     global_ld.pdh                 = NULL;
+    global_ld.pdh_buf             = NULL;
     global_ld.autostop_files      = 0;
     global_ld.save_file_fd        = -1;
+    global_ld.shm_ring            = NULL;
+    global_ld.packets_taken       = 0;
+    global_ld.packets_written     = 0;
 
     /* We haven't yet gotten the capture statistics. */
     *stats_known      = FALSE;
@@ -3532,11 +4134,22 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             g_snprintf(secondary_errmsg, sizeof(secondary_errmsg), "%s", please_report);
             goto error;
         }
+
+        /* Set up sampling and truncation; packets from a pcapng pipe
+           arrive as blocks and are passed through as they are. */
+        if (capture_reduce_enabled(&reduce_opts) && !pcap_src->from_pcapng) {
+            pcap_src->reduce = capture_reduce_new(&reduce_opts, pcap_src->linktype);
+        }
     }
 
     /* If we're supposed to write to a capture file, open it for output
-       (temporary/specified name/ringbuffer) */
-    if (capture_opts->saving_to_file) {
+       (temporary/specified name/ringbuffer/one file per interface) */
+    if (capture_opts->saving_to_file && per_interface_files) {
+        if (!capture_loop_open_src_outputs(capture_opts, &global_ld, errmsg,
+                                           sizeof(errmsg))) {
+            goto error;
+        }
+    } else if (capture_opts->saving_to_file) {
         if (!capture_loop_open_output(capture_opts, &global_ld.save_file_fd,
                                       errmsg, sizeof(errmsg))) {
             goto error;
@@ -3562,13 +4175,15 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
            update its windows to indicate that we have a live capture in
            progress. */
         fflush(global_ld.pdh);
+        capture_loop_open_shm_ring(capture_opts, &global_ld);
         report_new_capture_file(capture_opts->save_file);
     }
 
     /* initialize capture stop (and alike) conditions */
     init_capture_stop_conditions();
-    /* create stop conditions */
-    if (capture_opts->has_autostop_filesize) {
+    /* create stop conditions (with one file per interface, the capture
+       threads check the size of their files themselves) */
+    if (capture_opts->has_autostop_filesize && !per_interface_files) {
         if (capture_opts->autostop_filesize > (((guint32)INT_MAX + 1) / 1000)) {
             capture_opts->autostop_filesize = ((guint32)INT_MAX + 1) / 1000;
         }
@@ -3606,9 +4221,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            /* With a file per interface, the capture threads write their
+               packets themselves and don't queue them */
+            if (!per_interface_files)
+                pcap_ring_init(&pcap_src->ring, (guint32)pcap_src->snaplen);
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -3617,45 +4236,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     }
     while (global_ld.go) {
         /* dispatch incoming packets */
-        if (use_threads) {
-            pcap_queue_element *queue_element;
-
-            g_async_queue_lock(pcap_queue);
-            queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-            if (queue_element) {
-                if (queue_element->pcap_src->from_pcapng) {
-                    pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-                    pcap_queue_packets -= 1;
-                } else {
-                    pcap_queue_bytes -= queue_element->u.phdr.caplen;
-                    pcap_queue_packets -= 1;
-                }
-            }
-            g_async_queue_unlock(pcap_queue);
-            if (queue_element) {
-                if (queue_element->pcap_src->from_pcapng) {
-                    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                        "Dequeued a block of length %d captured on interface %d.",
-                        queue_element->u.bh.block_total_length, queue_element->pcap_src->interface_id);
-
-                    capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                                &queue_element->u.bh,
-                                                queue_element->pd);
-                } else {
-                    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                        "Dequeued a packet of length %d captured on interface %d.",
-                        queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
-
-                    capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
-                                                &queue_element->u.phdr,
-                                                queue_element->pd);
-                }
-                g_free(queue_element->pd);
-                g_free(queue_element);
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+        if (per_interface_files) {
+            inpkts = capture_loop_count_src_packets(TRUE);
+        } else if (use_threads) {
+            inpkts = capture_loop_dequeue_packet(TRUE) ? 1 : 0;
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -3718,10 +4302,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 *stats_known = TRUE;
             }
 #endif
-            /* Let the parent process know. */
-            if (global_ld.inpkts_to_sync_pipe) {
+            /* Let the parent process know, once it knows about the file
+               the packets are in. */
+            capture_loop_report_file_switch(capture_opts, FALSE);
+            if (global_ld.inpkts_to_sync_pipe && !global_ld.switch_unreported) {
                 /* do sync here */
-                fflush(global_ld.pdh);
+                if (global_ld.pdh)
+                    fflush(global_ld.pdh);
 
                 /* Send our parent a message saying we've written out
                    "global_ld.inpkts_to_sync_pipe" packets to the capture file. */
@@ -3764,8 +4351,6 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Capture loop stopping ...");
     if (use_threads) {
-        pcap_queue_element *queue_element;
-
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Waiting for thread of interface %u...",
@@ -3774,30 +4359,15 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Thread of interface %u terminated.",
                   pcap_src->interface_id);
         }
-        while (1) {
-            g_async_queue_lock(pcap_queue);
-            queue_element = (pcap_queue_element *)g_async_queue_try_pop_unlocked(pcap_queue);
-            if (queue_element) {
-                pcap_queue_bytes -= queue_element->u.phdr.caplen;
-                pcap_queue_packets -= 1;
-            }
-            g_async_queue_unlock(pcap_queue);
-            if (queue_element == NULL) {
-                break;
-            }
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                  "Dequeued a packet of length %d captured on interface %d.",
-                  queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
-            capture_loop_write_packet_cb((u_char *)queue_element->pcap_src,
-                                         &queue_element->u.phdr,
-                                         queue_element->pd);
-            g_free(queue_element->pd);
-            g_free(queue_element);
+        while (capture_loop_dequeue_packet(FALSE)) {
             global_ld.inpkts_to_sync_pipe += 1;
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
             }
         }
+        if (per_interface_files) {
+            global_ld.inpkts_to_sync_pipe += capture_loop_count_src_packets(FALSE);
+        }
     }
 
 
@@ -3862,6 +4432,17 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         report_capture_error(errmsg, please_report);
         write_ok = FALSE;
     }
+    if (per_interface_files) {
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_src->write_err != 0) {
+                capture_loop_get_errmsg(errmsg, sizeof(errmsg), pcap_src->save_file,
+                                        pcap_src->write_err, FALSE);
+                report_capture_error(errmsg, please_report);
+                write_ok = FALSE;
+            }
+        }
+    }
 
     if (capture_opts->saving_to_file) {
         /* close the output file */
@@ -3869,8 +4450,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     } else
         close_ok = TRUE;
 
+    /* Our parent still has the packets it didn't read yet mapped. */
+    capture_shm_ring_close(global_ld.shm_ring);
+    global_ld.shm_ring = NULL;
+
     /* there might be packets not yet notified to the parent */
     /* (do this after closing the file, so all packets are already flushed) */
+    capture_loop_report_file_switch(capture_opts, TRUE);
     if (global_ld.inpkts_to_sync_pipe) {
         if (!quiet)
             report_packet_count(global_ld.inpkts_to_sync_pipe);
@@ -3923,7 +4509,19 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 report_capture_error(errmsg, please_report);
             }
         }
-        report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->console_display_name);
+        report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop,
+                            pcap_src->ring.max_packets, pcap_src->ring.max_bytes,
+                            interface_opts->console_display_name);
+        if (pcap_src->reduce != NULL) {
+            report_packet_reduction(pcap_src->reduce, interface_opts->console_display_name);
+        }
+    }
+
+    if (use_threads) {
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_ring_free(&pcap_src->ring);
+        }
     }
 
     /* close the input file (pcap or capture pipe) */
@@ -3935,7 +4533,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     return write_ok && close_ok;
 
 error:
-    if (capture_opts->multi_files_on) {
+    if (per_interface_files) {
+        /* capture_loop_open_src_outputs() removes the files it created if
+           it fails, and we don't get here once they're all open. */
+    } else if (capture_opts->multi_files_on) {
         /* cleanup ringbuffer */
         ringbuf_error_cleanup();
     } else {
@@ -4078,6 +4679,29 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_he
     }
 }
 
+/* Sample and truncate a captured packet, if we were asked to, before it is
+   copied anywhere. Returns FALSE if the packet is to be dropped; if it is
+   to be truncated, *phdr is pointed at reduced_hdr, with the new length. */
+static gboolean
+capture_loop_reduce_packet(capture_src *pcap_src, const struct pcap_pkthdr **phdr,
+                           struct pcap_pkthdr *reduced_hdr, const u_char *pd)
+{
+    guint32 caplen;
+
+    if (pcap_src->reduce == NULL)
+        return TRUE;
+
+    caplen = capture_reduce_packet(pcap_src->reduce, pd, (*phdr)->caplen);
+    if (caplen == 0)
+        return FALSE;
+    if (caplen < (*phdr)->caplen) {
+        *reduced_hdr = **phdr;
+        reduced_hdr->caplen = caplen;
+        *phdr = reduced_hdr;
+    }
+    return TRUE;
+}
+
 /* one packet was captured, process it */
 static void
 capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -4086,6 +4710,8 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
     int          err;
     guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    guint64      offset;
+    struct pcap_pkthdr reduced_hdr;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4095,12 +4721,17 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
+    /* With capture threads, the packet was reduced before it was queued. */
+    if (!use_threads && !capture_loop_reduce_packet(pcap_src, &phdr, &reduced_hdr, pd))
+        return;
+
     if (global_ld.pdh) {
         gboolean successful;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
            "ld->err" to the error. */
+        offset = global_ld.bytes_written;
         if (global_capture_opts.use_pcapng) {
             successful = pcapng_write_enhanced_packet_block(global_ld.pdh,
                                                             NULL,
@@ -4127,6 +4758,8 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                   "Wrote a packet of length %d captured on interface %u.",
                    phdr->caplen, pcap_src->interface_id);
 #endif
+            if (global_ld.shm_ring)
+                capture_loop_put_shm_ring(pcap_src, phdr, pd, offset);
             global_ld.packet_count++;
             pcap_src->received++;
             /* if the user told us to stop after x packets, do we already have enough? */
@@ -4137,14 +4770,80 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     }
 }
 
+/* one packet was captured, write it to the output file of its interface
+   (per_interface_files; called from the capture thread of the interface) */
+static void
+capture_loop_write_src_packet(capture_src *pcap_src, const struct pcap_pkthdr *phdr,
+                              const u_char *pd)
+{
+    int   err;
+    guint ts_mul = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    gint  count;
+
+    /* The packet count limit is shared by all threads; take a packet
+       from it before writing, so that we don't write too many. It only
+       counts as written once it has been. */
+    count = g_atomic_int_add(&global_ld.packets_taken, 1) + 1;
+    if ((global_ld.packet_max > 0) && (count > global_ld.packet_max)) {
+        pcap_src->flushed++;
+        return;
+    }
+
+    if (!pcapng_write_enhanced_packet_block(pcap_src->pdh,
+                                            NULL,
+                                            phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
+                                            phdr->caplen, phdr->len,
+                                            0,      /* the only interface in the file */
+                                            ts_mul,
+                                            pd, 0,
+                                            &pcap_src->bytes_written, &err)) {
+        global_ld.go = FALSE;
+        pcap_src->write_err = err;
+        pcap_src->dropped++;
+        g_atomic_int_add(&global_ld.packets_taken, -1);
+        return;
+    }
+    g_atomic_int_inc(&global_ld.packets_written);
+    pcap_src->received++;
+
+    /* if the user told us to stop after x packets, do we already have enough? */
+    if ((global_ld.packet_max > 0) && (count >= global_ld.packet_max)) {
+        global_ld.go = FALSE;
+    }
+    /* The file size limit applies to each file; the first one reaching
+       it stops the capture on all interfaces. */
+    if (global_capture_opts.has_autostop_filesize &&
+        pcap_src->bytes_written >= (guint64)global_capture_opts.autostop_filesize * 1000) {
+        global_ld.go = FALSE;
+    }
+}
+
+/* Wait a bit for the capture threads to write packets to their files
+   (per_interface_files), and return how many they wrote since the last
+   call. */
+static int
+capture_loop_count_src_packets(gboolean wait)
+{
+    gint count;
+    int  inpkts;
+
+    if (wait)
+        g_usleep(CAP_READ_TIMEOUT * 1000);
+
+    count = g_atomic_int_get(&global_ld.packets_written);
+    inpkts = count - global_ld.packet_count;
+    global_ld.packet_count = count;
+    return inpkts;
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                              const u_char *pd)
 {
-    capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    capture_src      *pcap_src = (capture_src *) (void *) pcap_src_p;
+    pcap_ring_record  rec_hdr;
+    struct pcap_pkthdr reduced_hdr;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4154,35 +4853,21 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
+    if (!capture_loop_reduce_packet(pcap_src, &phdr, &reduced_hdr, pd))
+        return;
+
+    if (per_interface_files) {
+        capture_loop_write_src_packet(pcap_src, phdr, pd);
         return;
     }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
+
+    rec_hdr.is_pcapng = FALSE;
+    rec_hdr.ts_key = (guint64)phdr->ts.tv_sec * 1000000000 +
+                     (guint64)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    rec_hdr.u.phdr = *phdr;
+
+    if (!pcap_ring_push(&pcap_src->ring, &rec_hdr, pd, phdr->caplen)) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
@@ -4192,19 +4877,13 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
               "Queued a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
 }
 
 /* one pcapng block was captured, queue it */
 static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_header_s *bh, const u_char *pd)
 {
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    pcap_ring_record  rec_hdr;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4214,35 +4893,12 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_he
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
+    rec_hdr.is_pcapng = TRUE;
+    rec_hdr.ts_key = 0;
+    rec_hdr.u.bh = *bh;
+
+    if (!pcap_ring_push(&pcap_src->ring, &rec_hdr, pd, bh->block_total_length)) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
@@ -4252,11 +4908,6 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const struct pcapng_block_he
               "Queued a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
 }
 
 static int
@@ -4340,6 +4991,13 @@ main(int argc, char *argv[])
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         LONGOPT_CAPTURE_COMMON
+        {"shm-ring", no_argument, NULL, LONGOPT_SHM_RING},
+        {"per-interface-files", no_argument, NULL, LONGOPT_PER_INTERFACE_FILES},
+        {"sample", required_argument, NULL, LONGOPT_SAMPLE},
+        {"sample-flows", required_argument, NULL, LONGOPT_SAMPLE_FLOWS},
+        {"flow-bytes", required_argument, NULL, LONGOPT_FLOW_BYTES},
+        {"protocol-snaplen", required_argument, NULL, LONGOPT_PROTOCOL_SNAPLEN},
+        {"max-queue-memory", required_argument, NULL, LONGOPT_MAX_QUEUE_MEMORY},
         {0, 0, 0, 0 }
     };
 
@@ -4753,6 +5411,38 @@ main(int argc, char *argv[])
 #endif
             break;
 
+        case LONGOPT_SHM_RING: /* hidden option: hand packets to the parent in shared memory */
+            global_capture_opts.use_shm_ring = TRUE;
+            break;
+
+        case LONGOPT_PER_INTERFACE_FILES: /* One output file per interface */
+            per_interface_files = TRUE;
+            break;
+
+        case LONGOPT_SAMPLE: /* Keep one packet in N */
+            reduce_opts.sample_rate = get_positive_int(optarg, "sampling rate");
+            break;
+
+        case LONGOPT_SAMPLE_FLOWS: /* Keep one flow in N */
+            reduce_opts.flow_sample_rate = get_positive_int(optarg, "flow sampling rate");
+            break;
+
+        case LONGOPT_FLOW_BYTES: /* Keep K payload bytes per flow */
+            reduce_opts.flow_byte_cap = get_positive_int(optarg, "flow byte cap");
+            break;
+
+        case LONGOPT_PROTOCOL_SNAPLEN: /* Per-protocol snapshot length */
+            if (!capture_reduce_parse_snaplen(&reduce_opts, optarg)) {
+                cmdarg_err("Invalid protocol snapshot length \"%s\"; it must be <protocol>:<length>,\n"
+                           "with tcp, udp, sctp, icmp, ip or other as the protocol.", optarg);
+                exit_main(1);
+            }
+            break;
+
+        case LONGOPT_MAX_QUEUE_MEMORY: /* Ring size limit without -C, in MB */
+            pcap_ring_max_size = (guint64)get_positive_int(optarg, "queue memory limit") * 1024 * 1024;
+            break;
+
         case 'q':        /* Quiet */
             quiet = TRUE;
             break;
@@ -4872,6 +5562,25 @@ main(int argc, char *argv[])
             global_capture_opts.use_pcapng = TRUE;
         }
 
+        /* One file per interface is written by the capture thread of
+           each interface, and only in pcapng. */
+        if (per_interface_files) {
+            if (capture_child) {
+                cmdarg_err("One file per interface can't be written when capturing for another program.");
+                exit_main(1);
+            }
+            if (global_capture_opts.save_file == NULL || global_capture_opts.output_to_pipe) {
+                cmdarg_err("One file per interface requested, but capture isn't being saved to a permanent file.");
+                exit_main(1);
+            }
+            if (global_capture_opts.multi_files_on) {
+                cmdarg_err("One file per interface can't be written with a ring buffer.");
+                exit_main(1);
+            }
+            use_threads = TRUE;
+            global_capture_opts.use_pcapng = TRUE;
+        }
+
         if (global_capture_opts.capture_comment &&
             (!global_capture_opts.use_pcapng || global_capture_opts.multi_files_on)) {
             /* XXX - for ringbuffer, should we apply the comment to each file? */
@@ -5289,7 +5998,8 @@ report_capture_error(const char *error_msg, const char *secondary_error_msg)
 }
 
 static void
-report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name)
+report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop,
+                    guint32 queue_max_packets, guint32 queue_max_bytes, gchar *name)
 {
     char tmp[SP_DECISIZE+1+1];
     guint32 total_drops = pcap_drops + drops + flushed;
@@ -5300,6 +6010,11 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
             "Packets received/dropped on interface '%s': %u/%u (pcap:%u/dumpcap:%u/flushed:%u/ps_ifdrop:%u)",
             name, received, total_drops, pcap_drops, drops, flushed, ps_ifdrop);
+        if (use_threads) {
+            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+                "Maximum queue depth on interface '%s': %u packets/%u bytes",
+                name, queue_max_packets, queue_max_bytes);
+        }
         /* XXX: Need to provide interface id, changes to consumers required. */
         pipe_write_block(2, SP_DROPS, tmp);
     } else {
@@ -5307,11 +6022,46 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
             "Packets received/dropped on interface '%s': %u/%u (pcap:%u/dumpcap:%u/flushed:%u/ps_ifdrop:%u) (%.1f%%)\n",
             name, received, total_drops, pcap_drops, drops, flushed, ps_ifdrop,
             received ? 100.0 * received / (received + total_drops) : 0.0);
+        if (use_threads) {
+            fprintf(stderr,
+                "Maximum queue depth on interface '%s': %u packets/%u bytes\n",
+                name, queue_max_packets, queue_max_bytes);
+        }
         /* stderr could be line buffered */
         fflush(stderr);
     }
 }
 
+static void
+report_packet_reduction(const capture_reduce *reduce, gchar *name)
+{
+    capture_reduce_counts counts;
+
+    capture_reduce_get_counts(reduce, &counts);
+    if (capture_child) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Packets sampled out/cut on interface '%s': %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+            " (sampled:%" G_GUINT64_FORMAT "/flow sampled:%" G_GUINT64_FORMAT
+            "/flow capped:%" G_GUINT64_FORMAT "/snaplen:%" G_GUINT64_FORMAT
+            ") (%" G_GUINT64_FORMAT " bytes cut)",
+            name, counts.sampled_out + counts.flow_sampled_out,
+            counts.flow_capped + counts.snaplen_cut,
+            counts.sampled_out, counts.flow_sampled_out,
+            counts.flow_capped, counts.snaplen_cut, counts.bytes_cut);
+    } else {
+        fprintf(stderr,
+            "Packets sampled out/cut on interface '%s': %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+            " (sampled:%" G_GUINT64_FORMAT "/flow sampled:%" G_GUINT64_FORMAT
+            "/flow capped:%" G_GUINT64_FORMAT "/snaplen:%" G_GUINT64_FORMAT
+            ") (%" G_GUINT64_FORMAT " bytes cut)\n",
+            name, counts.sampled_out + counts.flow_sampled_out,
+            counts.flow_capped + counts.snaplen_cut,
+            counts.sampled_out, counts.flow_sampled_out,
+            counts.flow_capped, counts.snaplen_cut, counts.bytes_cut);
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
@@ -99,22 +99,50 @@ struct select_item {
 
 /*
  * Duplicate frame detection
+ *
+ * Every frame is hashed, and the hashes of the frames in the duplicate
+ * window are kept both in the order the frames were read (dup_ring[],
+ * used to drop frames that leave the window) and in a hash table indexed
+ * by the hash (dup_index, used to find duplicates), so that checking a
+ * frame doesn't depend on the size of the window.  The frames of the window
+ * with the same hash are chained together in dup_ring[], so that with -w
+ * all of them can be compared with the current frame.
  */
 typedef struct _fd_hash_t {
     guint8     digest[16];
     guint32    len;
-    nstime_t   frame_time;
+    guint      count;       /* number of frames of the window with this hash */
+    int        last;        /* the most recent of them in dup_ring[] */
 } fd_hash_t;
 
+typedef struct _fd_ring_entry_t {
+    fd_hash_t *hash;
+    nstime_t   frame_time;
+    int        prev;        /* previous frame with the same hash, or -1 */
+    int        next;        /* next frame with the same hash, or -1 */
+} fd_ring_entry_t;
+
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
-#define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
+#define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of dup_ring[]) for de-duplication */
 
-static fd_hash_t fd_hash[MAX_DUP_DEPTH];
-static int       dup_window    = DEFAULT_DUP_DEPTH;
-static int       cur_dup_entry = 0;
+static fd_ring_entry_t *dup_ring      = NULL;
+static GHashTable      *dup_index     = NULL;
+static int              dup_window    = DEFAULT_DUP_DEPTH;
+static int              dup_entries   = 0;  /* frames in dup_ring[] */
+static int              cur_dup_entry = 0;  /* most recent frame in dup_ring[] */
+static guint8           cur_digest[16];     /* hash of the last frame checked */
+static guint8          *dup_scratch   = NULL;
+static guint32          dup_scratch_len = 0;
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
+/* Header fields cleared before hashing (--dup-mask) */
+#define DUP_MASK_TTL     0x01   /* IPv4 TTL and IPv6 hop limit */
+#define DUP_MASK_IPCSUM  0x02   /* IPv4 header checksum */
+#define DUP_MASK_VLAN    0x04   /* 802.1Q/802.1ad tags */
+
+static guint     dup_mask       = 0;
+
 #define ONE_BILLION 1000000000
 
 /* Weights of different errors we can introduce */
@@ -573,156 +601,317 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+/*
+ * MurmurHash3_x64_128, by Austin Appleby (public domain).  Duplicates are
+ * found by comparing hashes, not frames, so the hash has to be wide enough
+ * for collisions not to matter, but it needn't be a cryptographic one.
+ */
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static guint64
+fmix64(guint64 k)
+{
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return k;
+}
+
+static void
+murmur3_128(const guint8 *data, guint32 len, guint8 *digest)
+{
+    const guint64 c1 = G_GUINT64_CONSTANT(0x87c37b91114253d5);
+    const guint64 c2 = G_GUINT64_CONSTANT(0x4cf5ad432745937f);
+    const guint8 *tail = data + (len & ~15U);
+    guint64 h1 = 0, h2 = 0, k1, k2;
+    guint32 i;
+
+    for (; data < tail; data += 16) {
+        k1 = pletoh64(data);
+        k2 = pletoh64(data + 8);
+
+        k1 *= c1; k1 = ROTL64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = ROTL64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = ROTL64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = ROTL64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    k1 = k2 = 0;
+    for (i = len & 15; i > 8; i--)
+        k2 ^= (guint64)tail[i - 1] << ((i - 9) * 8);
+    if (len & 15) {
+        for (i = MIN(len & 15, 8); i > 0; i--)
+            k1 ^= (guint64)tail[i - 1] << ((i - 1) * 8);
+        k2 *= c2; k2 = ROTL64(k2, 33); k2 *= c1; h2 ^= k2;
+        k1 *= c1; k1 = ROTL64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    for (i = 0; i < 8; i++) {
+        digest[i]     = (guint8)(h1 >> (i * 8));
+        digest[i + 8] = (guint8)(h2 >> (i * 8));
+    }
+}
+
+static guint
+fd_hash_hash(gconstpointer key)
+{
+    const fd_hash_t *hash = (const fd_hash_t *)key;
+
+    /* The digest is a good hash already */
+    return pletoh32(hash->digest) ^ hash->len;
+}
+
 static gboolean
-is_duplicate(guint8* fd, guint32 len) {
-    int i;
+fd_hash_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_t *hash_a = (const fd_hash_t *)a;
+    const fd_hash_t *hash_b = (const fd_hash_t *)b;
 
-    /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
-    guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
+    return hash_a->len == hash_b->len
+        && memcmp(hash_a->digest, hash_b->digest, 16) == 0;
+}
 
-    if (len <= ignored_bytes) {
-        offset = 0;
+static gboolean
+set_dup_mask(const char *optarg_str_p)
+{
+    gchar **fields;
+    int i;
+    gboolean ok = TRUE;
+
+    dup_mask = 0;
+    fields = g_strsplit(optarg_str_p, ",", -1);
+    for (i = 0; fields[i] != NULL; i++) {
+        if (strcmp(fields[i], "ttl") == 0) {
+            dup_mask |= DUP_MASK_TTL;
+        } else if (strcmp(fields[i], "ipcsum") == 0) {
+            dup_mask |= DUP_MASK_IPCSUM;
+        } else if (strcmp(fields[i], "vlan") == 0) {
+            dup_mask |= DUP_MASK_VLAN;
+        } else {
+            fprintf(stderr, "editcap: \"%s\" isn't a header field that can be masked (ttl, ipcsum or vlan)\n",
+                    fields[i]);
+            ok = FALSE;
+        }
     }
+    g_strfreev(fields);
+    return ok;
+}
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
+static void
+mask_ip_header(guint8 *ip, guint32 len)
+{
+    if (len >= 20 && (ip[0] >> 4) == 4) {
+        if (dup_mask & DUP_MASK_TTL)
+            ip[8] = 0;
+        if (dup_mask & DUP_MASK_IPCSUM)
+            ip[10] = ip[11] = 0;
+    } else if (len >= 40 && (ip[0] >> 4) == 6) {
+        if (dup_mask & DUP_MASK_TTL)
+            ip[7] = 0;
+    }
+}
 
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
+/*
+ * Return the data to hash for a frame: the frame itself or, if header
+ * fields are masked (--dup-mask), a masked copy of it, whose length is
+ * returned in *len.
+ */
+static const guint8 *
+mask_frame(const wtap_packet_header *phdr, const guint8 *fd, guint32 *len)
+{
+    guint32 off;
+    guint16 etype;
 
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
+    if (dup_mask == 0)
+        return fd;
 
-    fd_hash[cur_dup_entry].len = len;
+    switch (phdr->pkt_encap) {
+        case WTAP_ENCAP_ETHERNET:
+            off = 12;       /* type of the Ethernet header */
+            break;
+        case WTAP_ENCAP_SLL:
+            off = LINUX_SLL_OFFSETP;
+            break;
+        case WTAP_ENCAP_RAW_IP:
+        case WTAP_ENCAP_RAW_IP4:
+        case WTAP_ENCAP_RAW_IP6:
+            off = 0;
+            break;
+        default:
+            /* no support for current pkt_encap */
+            return fd;
+    }
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
+    if (*len > dup_scratch_len) {
+        dup_scratch = (guint8 *)g_realloc(dup_scratch, *len);
+        dup_scratch_len = *len;
+    }
+    memcpy(dup_scratch, fd, *len);
+
+    if (off == 0) {
+        mask_ip_header(dup_scratch, *len);
+        return dup_scratch;
+    }
 
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
+    while (off + 2 <= *len) {
+        etype = pntoh16(dup_scratch + off);
+        if (etype != ETHERTYPE_VLAN && etype != ETHERTYPE_IEEE_802_1AD
+            && etype != ETHERTYPE_QINQ_OLD)
+            break;
+        if (off + VLAN_SIZE + 2 > *len)
+            return dup_scratch;
+        if (dup_mask & DUP_MASK_VLAN) {
+            memmove(dup_scratch + off, dup_scratch + off + VLAN_SIZE,
+                    *len - (off + VLAN_SIZE));
+            *len -= VLAN_SIZE;
+        } else {
+            off += VLAN_SIZE;
         }
     }
 
-    return FALSE;
+    if (off + 2 > *len)
+        return dup_scratch;
+    etype = pntoh16(dup_scratch + off);
+    if (etype == ETHERTYPE_IP || etype == ETHERTYPE_IPv6)
+        mask_ip_header(dup_scratch + off + 2, *len - (off + 2));
+
+    return dup_scratch;
 }
 
+static void
+init_dup_detection(void)
+{
+    dup_ring = g_new(fd_ring_entry_t, MAX(dup_window, 1));
+    dup_index = g_hash_table_new_full(fd_hash_hash, fd_hash_equal, NULL, g_free);
+    dup_entries = 0;
+    cur_dup_entry = 0;
+}
+
+static void
+cleanup_dup_detection(void)
+{
+    if (dup_index != NULL)
+        g_hash_table_destroy(dup_index);
+    g_free(dup_ring);
+    g_free(dup_scratch);
+}
+
+/*
+ * Check whether a frame is a duplicate of one of the previous
+ * dup_window - 1 frames or, if current is not NULL (-w), of one of
+ * them that arrived at most relative_time_window before it.
+ *
+ * For -w, frames leave the window in the order they were read, when the
+ * current frame arrived more than the dup time window after them; if the
+ * packet timestamps are not in chronological order, some frames stay in
+ * the window longer than that.  A frame is a duplicate if any frame of the
+ * window with the same hash arrived at most the dup time window before it,
+ * so out of order frames are compared with all of them, starting with the
+ * most recent one.  A frame that arrived *after* the current one is never
+ * considered a duplicate of it.
+ */
 static gboolean
-is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+is_duplicate(const wtap_packet_header *phdr, const guint8* fd, guint32 len,
+             const nstime_t *current) {
+    fd_hash_t  key;
+    fd_hash_t *hash;
+    const guint8 *data;
+    nstime_t   delta;
+    gboolean   dup = FALSE;
+    int        i;
+
+    key.count = 0;
+    key.last = -1;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
+
+    data = mask_frame(phdr, fd, &len);
 
     if (len <= ignored_bytes) {
         offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
-
     /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
-     *
-     * Of course this assumes that the input trace file is
-     * "well-formed" in the sense that the packet timestamps are
-     * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
+     * Calculate our digest. The verbose output has always shown MD5
+     * hashes, which scripts may compare across files, so keep them there.
      */
+    if (verbose)
+        gcry_md_hash_buffer(GCRY_MD_MD5, key.digest, data + offset, len - offset);
+    else
+        murmur3_128(data + offset, len - offset, key.digest);
+    memcpy(cur_digest, key.digest, 16);
 
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
-
-        if (i < 0)
-            i = dup_window - 1;
-
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
+    if (dup_window == 0)
+        return FALSE;
 
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
+    key.len = len;
 
-        nstime_delta(&delta, current, &fd_hash[i].frame_time);
+    /* Drop the frames that leave the window */
+    while (dup_entries > 0) {
+        fd_ring_entry_t *oldest = &dup_ring[(cur_dup_entry + dup_window - dup_entries + 1) % dup_window];
 
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specifed dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
+        if (dup_entries < dup_window) {
+            if (current == NULL)
+                break;
+            nstime_delta(&delta, current, &oldest->frame_time);
+            if (nstime_cmp(&delta, &relative_time_window) <= 0)
+                break;
         }
+        /* it is the least recent frame with its hash */
+        if (oldest->next != -1)
+            dup_ring[oldest->next].prev = -1;
+        if (--oldest->hash->count == 0)
+            g_hash_table_remove(dup_index, oldest->hash);
+        dup_entries--;
+    }
 
-        cmp = nstime_cmp(&delta, &relative_time_window);
-
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
-            break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
+    /* Look for duplicates */
+    hash = (fd_hash_t *)g_hash_table_lookup(dup_index, &key);
+    if (hash != NULL) {
+        if (current != NULL) {
+            for (i = hash->last; i != -1 && !dup; i = dup_ring[i].prev) {
+                nstime_delta(&delta, current, &dup_ring[i].frame_time);
+                dup = delta.secs >= 0 && delta.nsecs >= 0
+                    && nstime_cmp(&delta, &relative_time_window) <= 0;
+            }
+        } else {
+            dup = TRUE;
         }
+    } else {
+        hash = g_new(fd_hash_t, 1);
+        *hash = key;
+        g_hash_table_insert(dup_index, hash, hash);
     }
 
-    return FALSE;
+    /* Add the frame to the window */
+    cur_dup_entry = (cur_dup_entry + 1) % dup_window;
+    dup_ring[cur_dup_entry].hash = hash;
+    if (current != NULL)
+        dup_ring[cur_dup_entry].frame_time = *current;
+    else
+        nstime_set_unset(&dup_ring[cur_dup_entry].frame_time);
+    dup_ring[cur_dup_entry].prev = hash->last;
+    dup_ring[cur_dup_entry].next = -1;
+    if (hash->last != -1)
+        dup_ring[hash->last].next = cur_dup_entry;
+    hash->last = cur_dup_entry;
+    hash->count++;
+    dup_entries++;
+
+    return dup;
 }
 
 static void
@@ -743,6 +932,11 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Duplicate packet removal:\n");
     fprintf(output, "  --novlan               remove vlan info from packets before checking for duplicates.\n");
+    fprintf(output, "  --dup-mask <fields>    ignore the given comma-separated header fields when\n");
+    fprintf(output, "                         checking for duplicates, without changing the packets:\n");
+    fprintf(output, "                         ttl (IPv4 TTL and IPv6 hop limit), ipcsum (IPv4\n");
+    fprintf(output, "                         header checksum), vlan (802.1Q/802.1ad tags).\n");
+    fprintf(output, "                         Supported for Ethernet, Linux cooked and raw IP.\n");
     fprintf(output, "  -d                     remove packet if duplicate (window == %d).\n", DEFAULT_DUP_DEPTH);
     fprintf(output, "  -D <dup window>        remove packet if duplicate; configurable <dup window>.\n");
     fprintf(output, "                         Valid <dup window> values are 0 to %d.\n", MAX_DUP_DEPTH);
@@ -755,7 +949,7 @@ print_usage(FILE *output)
     fprintf(output, "  -a <framenum>:<comment> Add or replace comment for given frame number\n");
     fprintf(output, "\n");
     fprintf(output, "  -I <bytes to ignore>   ignore the specified number of bytes at the beginning\n");
-    fprintf(output, "                         of the frame during MD5 hash calculation, unless the\n");
+    fprintf(output, "                         of the frame during hash calculation, unless the\n");
     fprintf(output, "                         frame is too short, then the full frame is used.\n");
     fprintf(output, "                         Useful to remove duplicated packets taken on\n");
     fprintf(output, "                         several routers (different mac addresses for\n");
@@ -952,6 +1146,7 @@ main(int argc, char *argv[])
     int           opt;
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, 0x8100},
+        {"dup-mask", required_argument, NULL, 0x8101},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'V'},
         {0, 0, 0, 0 }
@@ -1043,6 +1238,15 @@ main(int argc, char *argv[])
             break;
         }
 
+        case 0x8101:
+        {
+            if (!set_dup_mask(optarg)) {
+                ret = INVALID_OPTION;
+                goto clean_exit;
+            }
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1361,13 +1565,8 @@ main(int argc, char *argv[])
         if (keep_em == FALSE)
             max_packet_number = G_MAXUINT;
 
-        if (dup_detect || dup_detect_by_time) {
-            for (i = 0; i < dup_window; i++) {
-                memset(&fd_hash[i].digest, 0, 16);
-                fd_hash[i].len = 0;
-                nstime_set_unset(&fd_hash[i].frame_time);
-            }
-        }
+        if (dup_detect || dup_detect_by_time)
+            init_dup_detection();
 
         /* Read all of the packets in turn */
         while (wtap_read(wth, &read_err, &read_err_info, &data_offset)) {
@@ -1642,14 +1841,15 @@ main(int argc, char *argv[])
 
                     /* suppress duplicates by packet window */
                     if (dup_detect) {
-                        if (is_duplicate(buf, rec->rec_header.packet_header.caplen)) {
+                        if (is_duplicate(&rec->rec_header.packet_header, buf,
+                                         rec->rec_header.packet_header.caplen, NULL)) {
                             if (verbose) {
                                 fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
                                         count,
                                         rec->rec_header.packet_header.caplen);
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)cur_digest[i]);
                                 fprintf(stderr, "\n");
                             }
                             duplicate_count++;
@@ -1662,7 +1862,7 @@ main(int argc, char *argv[])
                                         rec->rec_header.packet_header.caplen);
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)cur_digest[i]);
                                 fprintf(stderr, "\n");
                             }
                         }
@@ -1676,16 +1876,16 @@ main(int argc, char *argv[])
                             current.secs  = rec->ts.secs;
                             current.nsecs = rec->ts.nsecs;
 
-                            if (is_duplicate_rel_time(buf,
-                                                      rec->rec_header.packet_header.caplen,
-                                                      &current)) {
+                            if (is_duplicate(&rec->rec_header.packet_header, buf,
+                                             rec->rec_header.packet_header.caplen,
+                                             &current)) {
                                 if (verbose) {
                                     fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
                                             count,
                                             rec->rec_header.packet_header.caplen);
                                     for (i = 0; i < 16; i++)
                                         fprintf(stderr, "%02x",
-                                                (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                                (unsigned char)cur_digest[i]);
                                     fprintf(stderr, "\n");
                                 }
                                 duplicate_count++;
@@ -1698,7 +1898,7 @@ main(int argc, char *argv[])
                                             rec->rec_header.packet_header.caplen);
                                     for (i = 0; i < 16; i++)
                                         fprintf(stderr, "%02x",
-                                                (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                                (unsigned char)cur_digest[i]);
                                     fprintf(stderr, "\n");
                                 }
                             }
@@ -1873,6 +2073,7 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    cleanup_dup_detection();
     wtap_block_array_free(shb_hdrs);
     wtap_block_array_free(nrb_hdrs);
     g_free(idb_inf);
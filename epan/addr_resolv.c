@@ -293,6 +293,7 @@ e_addr_resolve gbl_resolv_flags = {
 };
 #ifdef HAVE_C_ARES
 static guint name_resolve_concurrency = 500;
+static const char *name_resolve_servers = "";
 #endif
 
 /*
@@ -323,6 +324,12 @@ gchar *g_penterprises_path = NULL;  /* personal enterprises file */
  * popped off the front of c_ares_queue_head and submitted using
  * ares_gethostbyaddr().
  * The callback processes the response, then frees the request.
+ *
+ * host_name_lookup_process() only submits as many queries as it may and
+ * handles the answers that are already there, so that it can be called
+ * for every packet; host_name_lookup_wait() keeps doing so until all the
+ * queued queries got an answer, which lets TShark resolve all the
+ * addresses it gathered during its first pass in one go.
  */
 typedef struct _async_dns_queue_msg
 {
@@ -331,6 +338,7 @@ typedef struct _async_dns_queue_msg
         ws_in6_addr ip6;
     } addr;
     int                 family;
+    gint64              submitted;  /* when it was submitted, in microseconds */
 } async_dns_queue_msg_t;
 
 typedef struct _async_hostent {
@@ -345,6 +353,7 @@ ares_channel ghbn_chan; /* ares_gethostbyname -- Usually interactive, timeout */
 static  gboolean  async_dns_initialized = FALSE;
 static  guint       async_dns_in_flight = 0;
 static  wmem_list_t *async_dns_queue_head = NULL;
+static  host_name_lookup_stats_t async_dns_stats;
 
 /* push a dns request */
 static void
@@ -356,6 +365,19 @@ add_async_dns_ipv4(int type, guint32 addr)
     msg->family = type;
     msg->addr.ip4 = addr;
     wmem_list_append(async_dns_queue_head, (gpointer) msg);
+    async_dns_stats.queued++;
+}
+
+static void
+add_async_dns_ipv6(int type, const ws_in6_addr *addr)
+{
+    async_dns_queue_msg_t *msg;
+
+    msg = wmem_new(wmem_epan_scope(), async_dns_queue_msg_t);
+    msg->family = type;
+    memcpy(&msg->addr.ip6, addr, sizeof(msg->addr.ip6));
+    wmem_list_append(async_dns_queue_head, (gpointer) msg);
+    async_dns_stats.queued++;
 }
 #endif /* HAVE_C_ARES */
 
@@ -821,11 +843,23 @@ static void
 c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     async_dns_queue_msg_t *caqm = (async_dns_queue_msg_t *)arg;
     char **p;
+    guint64 latency;
 
     if (!caqm) return;
     /* XXX, what to do if async_dns_in_flight == 0? */
     async_dns_in_flight--;
 
+    latency = (guint64)(g_get_monotonic_time() - caqm->submitted);
+    async_dns_stats.total_latency += latency;
+    if (latency > async_dns_stats.max_latency)
+        async_dns_stats.max_latency = latency;
+    if (status == ARES_SUCCESS)
+        async_dns_stats.resolved++;
+    else if (status == ARES_ETIMEOUT)
+        async_dns_stats.timed_out++;
+    else
+        async_dns_stats.failed++;
+
     if (status == ARES_SUCCESS) {
         for (p = he->h_addr_list; *p != NULL; p++) {
             switch(caqm->family) {
@@ -914,9 +948,6 @@ static hashipv6_t *
 host_lookup6(const ws_in6_addr *addr)
 {
     hashipv6_t * volatile tp;
-#ifdef HAVE_C_ARES
-    async_dns_queue_msg_t *caqm;
-#endif
 
     tp = (hashipv6_t *)wmem_map_lookup(ipv6_hash_table, addr);
     if (tp == NULL) {
@@ -947,10 +978,7 @@ host_lookup6(const ws_in6_addr *addr)
         tp->flags |= TRIED_RESOLVE_ADDRESS;
 #ifdef HAVE_C_ARES
         if (async_dns_initialized && name_resolve_concurrency > 0) {
-            caqm = wmem_new(wmem_epan_scope(), async_dns_queue_msg_t);
-            caqm->family = AF_INET6;
-            memcpy(&caqm->addr.ip6, addr, sizeof(caqm->addr.ip6));
-            wmem_list_append(async_dns_queue_head, (gpointer) caqm);
+            add_async_dns_ipv6(AF_INET6, addr);
         }
 #endif
     }
@@ -2469,11 +2497,20 @@ addr_resolve_pref_init(module_t *nameres)
             " your DNS server behave badly.",
             10,
             &name_resolve_concurrency);
+
+    prefs_register_string_preference(nameres, "dns_servers",
+            "DNS servers",
+            "A comma-separated list of DNS servers to send the"
+            " requests to instead of the system's configured ones,"
+            " each as an address with an optional port, e.g."
+            " 127.0.0.1:5353,[::1]:53. Ports need c-ares 1.11 or later.",
+            &name_resolve_servers);
 #else
     prefs_register_static_text_preference(nameres, "use_external_name_resolver",
             "Use an external network name resolver: N/A",
             "Support for using a concurrent external name resolver was not"
             " compiled into this version of Wireshark");
+    prefs_register_obsolete_preference(nameres, "dns_servers");
 #endif
 
     prefs_register_bool_preference(nameres, "hosts_file_handling",
@@ -2510,39 +2547,75 @@ disable_name_resolution(void) {
 }
 
 #ifdef HAVE_C_ARES
-gboolean
-host_name_lookup_process(void) {
+/* Submit queued requests, as long as we don't have too many in flight. */
+static void
+async_dns_submit_queued(void)
+{
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
         caqm = (async_dns_queue_msg_t *)wmem_list_frame_data(head);
         wmem_list_remove_frame(async_dns_queue_head, head);
+        caqm->submitted = g_get_monotonic_time();
+        /* The callback may be called right away, so count it first. */
         if (caqm->family == AF_INET) {
+            async_dns_in_flight++;
             ares_gethostbyaddr(ghba_chan, &caqm->addr.ip4, sizeof(guint32), AF_INET,
                     c_ares_ghba_cb, caqm);
-            async_dns_in_flight++;
         } else if (caqm->family == AF_INET6) {
+            async_dns_in_flight++;
             ares_gethostbyaddr(ghba_chan, &caqm->addr.ip6, sizeof(ws_in6_addr),
                     AF_INET6, c_ares_ghba_cb, caqm);
-            async_dns_in_flight++;
         }
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+/* Use the DNS servers from the preferences, if any, on both channels. */
+static void
+c_ares_set_servers(void)
+{
+    int status;
+
+    if (name_resolve_servers == NULL || name_resolve_servers[0] == '\0')
+        return;
+
+#if ARES_VERSION >= 0x010b00
+    status = ares_set_servers_ports_csv(ghba_chan, name_resolve_servers);
+    if (status == ARES_SUCCESS)
+        status = ares_set_servers_ports_csv(ghbn_chan, name_resolve_servers);
+#elif ARES_VERSION >= 0x010702
+    status = ares_set_servers_csv(ghba_chan, name_resolve_servers);
+    if (status == ARES_SUCCESS)
+        status = ares_set_servers_csv(ghbn_chan, name_resolve_servers);
+#else
+    status = ARES_ENOTIMP;
+#endif
+    if (status != ARES_SUCCESS) {
+        report_failure("Can't use the DNS servers \"%s\": %s",
+                       name_resolve_servers, ares_strerror(status));
+    }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    async_dns_submit_queued();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -2559,6 +2632,46 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+gboolean
+host_name_lookup_wait(void) {
+    struct timeval tv, *tvp;
+    int nfds;
+    fd_set rfds, wfds;
+
+    if (!async_dns_initialized)
+        return host_name_lookup_process();
+
+    for (;;) {
+        async_dns_submit_queued();
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0) {
+            /* Nothing in flight; we're done unless there's more queued. */
+            if (wmem_list_head(async_dns_queue_head) == NULL)
+                break;
+            continue;
+        }
+        tvp = ares_timeout(ghba_chan, NULL, &tv);
+        if (select(nfds, &rfds, &wfds, NULL, tvp) == -1) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            break;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+
+    return host_name_lookup_process();
+}
+
+void
+host_name_lookup_get_stats(host_name_lookup_stats_t *stats)
+{
+    *stats = async_dns_stats;
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -2586,12 +2699,44 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+gboolean
+host_name_lookup_wait(void) {
+    return host_name_lookup_process();
+}
+
+void
+host_name_lookup_get_stats(host_name_lookup_stats_t *stats)
+{
+    memset(stats, 0, sizeof *stats);
+}
+
 static void
 _host_name_lookup_cleanup(void) {
 }
 
 #endif /* HAVE_C_ARES */
 
+void
+host_name_lookup_queue(const address *addr)
+{
+    guint32 ip4;
+
+    switch (addr->type) {
+
+    case AT_IPv4:
+        memcpy(&ip4, addr->data, sizeof ip4);
+        host_lookup(ip4);
+        break;
+
+    case AT_IPv6:
+        host_lookup6((const ws_in6_addr *)addr->data);
+        break;
+
+    default:
+        break;
+    }
+}
+
 const gchar *
 get_hostname(const guint addr)
 {
@@ -2728,6 +2873,7 @@ host_name_lookup_init(void)
 #ifdef HAVE_C_ARES
     g_assert(async_dns_queue_head == NULL);
     async_dns_queue_head = wmem_list_new(wmem_epan_scope());
+    memset(&async_dns_stats, 0, sizeof async_dns_stats);
 #endif
 
     if (manually_resolved_ipv4_list == NULL)
@@ -2760,6 +2906,7 @@ host_name_lookup_init(void)
 #endif
         if (ares_init(&ghba_chan) == ARES_SUCCESS && ares_init(&ghbn_chan) == ARES_SUCCESS) {
             async_dns_initialized = TRUE;
+            c_ares_set_servers();
         }
 #ifdef CARES_HAVE_ARES_LIBRARY_INIT
     }
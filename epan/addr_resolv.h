@@ -189,6 +189,36 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** Queue an IPv4 or IPv6 address to be resolved, without waiting for the
+ *  result; other addresses are ignored. The name can be looked up with
+ *  get_hostname()/get_hostname6() once it has been resolved.
+ */
+WS_DLL_PUBLIC void host_name_lookup_queue(const address *addr);
+
+/** Like host_name_lookup_process(), but keep processing outstanding host
+ *  name lookups until all the queued ones have been answered or have
+ *  timed out. Up to the maximum number of concurrent requests are in
+ *  flight at any time.
+ *
+ * @return True if any new objects have been resolved since the previous
+ * call to host_name_lookup_process() or host_name_lookup_wait().
+ */
+WS_DLL_PUBLIC gboolean host_name_lookup_wait(void);
+
+/** Statistics of the external (c-ares) address lookups since
+ *  host_name_lookup_init(); all zero without c-ares.
+ */
+typedef struct _host_name_lookup_stats {
+  guint   queued;           /**< Addresses queued to be resolved */
+  guint   resolved;         /**< Lookups that returned a name (hits) */
+  guint   failed;           /**< Lookups that returned no name (misses) */
+  guint   timed_out;        /**< Lookups that got no answer */
+  guint64 total_latency;    /**< Sum of the lookup times, in microseconds */
+  guint64 max_latency;      /**< Longest lookup time, in microseconds */
+} host_name_lookup_stats_t;
+
+WS_DLL_PUBLIC void host_name_lookup_get_stats(host_name_lookup_stats_t *stats);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
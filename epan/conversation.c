@@ -33,6 +33,11 @@ struct endpoint {
 	guint options;
 };
 
+/*
+ * The hashes of the two addresses are computed once, when the key is set
+ * up, so that hashing a key for any of the hash tables only has to mix in
+ * the ports, however many tables a lookup has to probe.
+ */
 struct conversation_key {
 	struct conversation_key *next;
 	address	addr1;
@@ -40,6 +45,8 @@ struct conversation_key {
 	endpoint_type etype;
 	guint32	port1;
 	guint32	port2;
+	guint	addr1_hash;
+	guint	addr2_hash;
 };
 
 /*
@@ -167,38 +174,81 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 	}
 }
 
+/*
+ * One-at-a-Time hash steps; see
+ * http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
+ */
+static inline guint
+conversation_hash_add(guint hash_val, guint32 value)
+{
+	hash_val += value;
+	hash_val += ( hash_val << 10 );
+	hash_val ^= ( hash_val >> 6 );
+	return hash_val;
+}
+
+static inline guint
+conversation_hash_finish(guint hash_val)
+{
+	hash_val += ( hash_val << 3 );
+	hash_val ^= ( hash_val >> 11 );
+	hash_val += ( hash_val << 15 );
+	return hash_val;
+}
+
+/*
+ * Set up a key, hashing its addresses.  The address data isn't copied.
+ */
+static void
+conversation_key_init(struct conversation_key *key, const address *addr1, const address *addr2,
+    const endpoint_type etype, const guint32 port1, const guint32 port2)
+{
+	if (addr1 != NULL) {
+		key->addr1 = *addr1;
+	} else {
+		clear_address(&key->addr1);
+	}
+	if (addr2 != NULL) {
+		key->addr2 = *addr2;
+	} else {
+		clear_address(&key->addr2);
+	}
+	key->etype = etype;
+	key->port1 = port1;
+	key->port2 = port2;
+	key->addr1_hash = add_address_to_hash(0, &key->addr1);
+	key->addr2_hash = add_address_to_hash(0, &key->addr2);
+}
+
+/*
+ * Set up a key for the opposite direction of another one.
+ */
+static void
+conversation_key_reverse(struct conversation_key *rev, const struct conversation_key *key)
+{
+	rev->addr1 = key->addr2;
+	rev->addr2 = key->addr1;
+	rev->etype = key->etype;
+	rev->port1 = key->port2;
+	rev->port2 = key->port1;
+	rev->addr1_hash = key->addr2_hash;
+	rev->addr2_hash = key->addr1_hash;
+}
+
 /*
  * Compute the hash value for two given address/port pairs if the match
  * is to be exact.
- */
-/* http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
- * One-at-a-Time hash
+ *
+ * The hash doesn't depend on the direction, as the match doesn't, so
+ * that a single lookup finds a conversation in either direction.
  */
 guint
 conversation_hash_exact(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
-	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
 
-	return hash_val;
+	return conversation_hash_finish(conversation_hash_add(key->addr1_hash, key->port1)) +
+	       conversation_hash_finish(conversation_hash_add(key->addr2_hash, key->port2));
 }
 
 /*
@@ -262,24 +312,11 @@ conversation_hash_no_addr2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
 
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_add(key->addr1_hash, key->port1);
+	hash_val = conversation_hash_add(hash_val, key->port2);
 
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -327,23 +364,11 @@ conversation_hash_no_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
-	hash_val = 0;
-	tmp_addr.len  = 4;
+	hash_val = conversation_hash_add(key->addr1_hash, key->port1);
+	hash_val = conversation_hash_add(hash_val, key->addr2_hash);
 
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -390,22 +415,8 @@ static guint
 conversation_hash_no_addr2_or_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
-	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
 
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(conversation_hash_add(key->addr1_hash, key->port1));
 }
 
 /*
@@ -652,6 +663,8 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	new_key->etype = etype;
 	new_key->port1 = port1;
 	new_key->port2 = port2;
+	new_key->addr1_hash = add_address_to_hash(0, &new_key->addr1);
+	new_key->addr2_hash = add_address_to_hash(0, &new_key->addr2);
 
 	conversation = wmem_new(wmem_file_scope(), conversation_t);
 	memset(conversation, 0, sizeof(conversation_t));
@@ -744,6 +757,7 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 	}
 	conv->options &= ~NO_ADDR2;
 	copy_address_wmem(wmem_file_scope(), &conv->key_ptr->addr2, addr);
+	conv->key_ptr->addr2_hash = add_address_to_hash(0, &conv->key_ptr->addr2);
 	if (conv->options & NO_PORT2) {
 		conversation_insert_into_hashtable(conversation_hashtable_no_port2, conv);
 	} else {
@@ -753,37 +767,25 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 }
 
 /*
- * Search a particular hash table for a conversation with the specified
- * {addr1, port1, addr2, port2} and set up before frame_num.
+ * Search a particular hash table for a conversation with the
+ * {addr1, port1, addr2, port2} of the key and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
-    const endpoint_type etype, const guint32 port1, const guint32 port2)
+conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num,
+    const struct conversation_key *key)
 {
 	conversation_t* convo=NULL;
 	conversation_t* match=NULL;
 	conversation_t* chain_head=NULL;
-	struct conversation_key key;
 
 	/*
-	 * We don't make a copy of the address data, we just copy the
-	 * pointer to it, as "key" disappears when we return.
+	 * Most captures have few or no wildcarded conversations; don't
+	 * bother looking for one in an empty table.
 	 */
-	if (addr1 != NULL) {
-		key.addr1 = *addr1;
-	} else {
-		clear_address(&key.addr1);
-	}
-	if (addr2 != NULL) {
-		key.addr2 = *addr2;
-	} else {
-		clear_address(&key.addr2);
-	}
-	key.etype = etype;
-	key.port1 = port1;
-	key.port2 = port2;
+	if (wmem_map_size(hashtable) == 0)
+		return NULL;
 
-	chain_head = (conversation_t *)wmem_map_lookup(hashtable, &key);
+	chain_head = (conversation_t *)wmem_map_lookup(hashtable, key);
 
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
@@ -849,6 +851,21 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
     const guint32 port_a, const guint32 port_b, const guint options)
 {
 	conversation_t *conversation;
+	struct conversation_key key_ab, key_ba, key_fc;
+
+	/*
+	 * Set up the keys for both directions, and, for Fibre Channel,
+	 * where OXID & RXID are never swapped as TCP/UDP ports are in
+	 * TCP/IP, for the addresses swapped but not the ports; the
+	 * addresses are only hashed once for all the lookups below.
+	 * We don't make a copy of the address data, we just copy the
+	 * pointer to it, as the keys disappear when we return.
+	 */
+	conversation_key_init(&key_ab, addr_a, addr_b, etype, port_a, port_b);
+	conversation_key_reverse(&key_ba, &key_ab);
+	key_fc = key_ba;
+	key_fc.port1 = port_a;
+	key_fc.port2 = port_b;
 
 	/*
 	 * First try an exact match, if we have two addresses and ports.
@@ -856,29 +873,20 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	if (!(options & (NO_ADDR_B|NO_PORT_B))) {
 		/*
 		 * Neither search address B nor search port B are wildcarded,
-		 * start out with an exact match.
+		 * start out with an exact match.  That finds the conversation
+		 * in either direction.
 		 */
 		DPRINT(("trying exact match"));
 		conversation =
 			conversation_lookup_hashtable(conversation_hashtable_exact,
-			frame_num, addr_a, addr_b, etype,
-			port_a, port_b);
-		/* Didn't work, try the other direction */
-		if (conversation == NULL) {
-			DPRINT(("trying opposite direction"));
-			conversation =
-				conversation_lookup_hashtable(conversation_hashtable_exact,
-				frame_num, addr_b, addr_a, etype,
-				port_b, port_a);
-		}
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP.
 			 */
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_exact,
-				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				frame_num, &key_fc);
 		}
 		DPRINT(("exact match %sfound",conversation?"":"not "));
 		if (conversation != NULL)
@@ -902,15 +910,14 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		DPRINT(("trying wildcarded dest address"));
 		conversation =
 			conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP.
 			 */
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				frame_num, &key_fc);
 		}
 		if (conversation != NULL) {
 			/*
@@ -954,7 +961,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			DPRINT(("trying dest addr:port as source addr:port with wildcarded dest addr"));
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -998,14 +1005,14 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		DPRINT(("trying wildcarded dest port"));
 		conversation =
 			conversation_lookup_hashtable(conversation_hashtable_no_port2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP
 			 */
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, &key_fc);
 		}
 		if (conversation != NULL) {
 			/*
@@ -1049,7 +1056,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			DPRINT(("trying dest addr:port as source addr:port and wildcarded dest port"));
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -1088,7 +1095,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	DPRINT(("trying wildcarding dest addr:port"));
 	conversation =
 		conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-		frame_num, addr_a, addr_b, etype, port_a, port_b);
+		frame_num, &key_ab);
 	if (conversation != NULL) {
 		/*
 		 * If this is for a connection-oriented protocol:
@@ -1142,11 +1149,11 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		if ((addr_a != NULL) && (addr_a->type == AT_FC))
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, &key_fc);
 		else
 			conversation =
 				conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 		if (conversation != NULL) {
 			/*
 			 * If this is for a connection-oriented protocol, set the
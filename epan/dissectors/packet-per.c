@@ -25,6 +25,7 @@ proper helper routines
 #include <epan/asn1.h>
 #include <epan/expert.h>
 #include <wsutil/str_util.h>
+#include <wsutil/pint.h>
 #include "packet-per.h"
 
 void proto_register_per(void);
@@ -121,6 +122,93 @@ static const true_false_string tfs_optional_field_bit = {
 
 #define SEQ_MAX_COMPONENTS 128
 
+/* Dissects the type of entry i of a per_sequence_t or per_choice_t table,
+   with its description in types if there is one, with its function otherwise */
+#define PER_ENTRY_DISSECT(types, i, entry, tvb, offset, actx, tree) \
+	(((types) && (types)[i]) ? dissect_per_type(tvb, offset, actx, tree, *(entry)->p_id, (types)[i]) : \
+	                           (guint32)(entry)->func(tvb, offset, actx, tree, *(entry)->p_id))
+
+/* A cursor over a run of bits of a tvb, for the primitives that read several
+   bit-fields in a row: the bytes holding them are fetched once with
+   tvb_get_ptr(), and the fields are then read from a 64-bit window of them
+   instead of through a tvb_get_guint8() or tvb_get_bits*() call each.
+*/
+typedef struct {
+	const guint8 *data;      /* the bytes holding the bits */
+	guint32       len;       /* number of bytes at data */
+	guint32       pos;       /* bit position of the cursor, from the MSB of data[0] */
+	guint32       win_start; /* byte of data the window was loaded from */
+	guint64       window;    /* the bytes from win_start, big-endian, zero-padded */
+} per_bit_reader_t;
+
+/* Sets up r to read the num_bits bits of tvb at bit offset. Returns FALSE if
+   they aren't all in the captured data; the caller then has to read them with
+   the tvb functions, so that the same exception is thrown at the same place.
+*/
+static inline gboolean
+per_bit_reader_init(per_bit_reader_t *r, tvbuff_t *tvb, guint32 offset, guint32 num_bits)
+{
+	guint32 first = offset>>3;
+	guint32 len = ((offset+num_bits+7)>>3) - first;
+
+	if (!tvb_bytes_exist(tvb, first, len)) {
+		return FALSE;
+	}
+	r->data = tvb_get_ptr(tvb, first, len);
+	r->len = len;
+	r->pos = offset&0x07;
+	r->win_start = G_MAXUINT32;
+	r->window = 0;
+	return TRUE;
+}
+
+static inline void
+per_bit_reader_load(per_bit_reader_t *r, guint32 start)
+{
+	guint32 i, n;
+
+	if (r->len - start >= 8) {
+		r->window = pntoh64(r->data + start);
+	} else {
+		n = r->len - start;
+		r->window = 0;
+		for (i = 0; i < n; i++) {
+			r->window |= (guint64)r->data[start+i] << (56 - 8*i);
+		}
+	}
+	r->win_start = start;
+}
+
+/* Reads the next num_bits (1 to 32) bits */
+static inline guint32
+per_bit_reader_get(per_bit_reader_t *r, int num_bits)
+{
+	guint32 skip;
+
+	/* the window has to hold all the bytes the bits are in */
+	if ((r->pos>>3) < r->win_start || ((r->pos+num_bits+7)>>3) > r->win_start+8) {
+		per_bit_reader_load(r, r->pos>>3);
+	}
+	skip = r->pos - r->win_start*8;
+	r->pos += num_bits;
+	return (guint32)((r->window << skip) >> (64 - num_bits));
+}
+
+/* Reads num_bits (1 to 32) bits of tvb at bit offset, like tvb_get_bits32() */
+static inline guint32
+per_get_bits(tvbuff_t *tvb, guint32 offset, int num_bits)
+{
+	per_bit_reader_t r;
+
+	if (per_bit_reader_init(&r, tvb, offset, num_bits)) {
+		return per_bit_reader_get(&r, num_bits);
+	}
+	return tvb_get_bits32(tvb, offset, num_bits, ENC_BIG_ENDIAN);
+}
+
+static guint32
+dissect_per_bit(per_bit_reader_t *r, tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gboolean *bool_val);
+
 static void per_check_value(guint32 value, guint32 min_len, guint32 max_len, asn1_ctx_t *actx, proto_item *item, gboolean is_signed)
 {
 	if ((is_signed == FALSE) && (value > max_len)) {
@@ -286,8 +374,6 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 	guint32 len;
 	proto_item *pi;
 	int num_bits;
-	int i, bit, str_length, str_index;
-	gboolean tmp;
 
 	if(!length){
 		length=&len;
@@ -302,57 +388,25 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 		byte=tvb_get_guint8(tvb, offset>>3);
 		offset+=8;
 	}else{
-		char *str;
+		const char *str = "";
 		guint32 val;
 
-		val = 0;
-
-		/* prepare the string (max number of bits + quartet separators + prepended space) */
-		str_length = 256+64+1;
-		str=(char *)wmem_alloc(wmem_packet_scope(), str_length+1);
-		str_index = 0;
-
-		str_length = g_snprintf(str, str_length+1, " ");
-		for(bit=0;bit<((int)(offset&0x07));bit++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if (str_index < str_length) str[str_index++] = '.';
+		/* the first two bits tell whether there are 8 or 16 of them */
+		val = per_get_bits(tvb, offset, 2);
+		if (val == 3 && !is_fragmented) {
+			*length = 0;
+			dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
+			return offset + 2;
 		}
-		/* read the bits for the int */
-		num_bits = 8;
-		for(i=0;i<num_bits;i++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if(bit&&(!(bit%8))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			bit++;
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &tmp);
-			val<<=1;
-			if(tmp){
-				val|=1;
-				if (str_index < str_length) str[str_index++] = '1';
-				if (i==0) { /* bit 8 is 1, so not a single byte length */
-					num_bits = 16;
-				}
-				else if (i==1 && val==3) { /* bits 8 and 7 both 1, so unconstrained */
-					if (!is_fragmented) {
-						*length = 0;
-						dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
-						return offset;
-					} else {
-						num_bits = 8;
-						*is_fragmented = TRUE;
-					}
-				}
-			} else {
-				if (str_index < str_length) str[str_index++] = '0';
-			}
+		num_bits = (val == 2) ? 16 : 8;
+		val = per_get_bits(tvb, offset, num_bits);
+		if (hf_index != -1 && display_internal_per_fields) {
+			str = decode_bits_in_field(offset&0x07, num_bits, val);
 		}
-		str[str_index] = '\0'; /* Terminate string */
-		if(is_fragmented && *is_fragmented==TRUE){
+		offset += num_bits;
+
+		if(is_fragmented && (val&0xc0) == 0xc0 && num_bits == 8){
+			*is_fragmented = TRUE;
 			*length = val&0x3f;
 			if (*length>4 || *length==0) {
 				*length = 0;
@@ -447,7 +501,7 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 static guint32
 dissect_per_normally_small_nonnegative_whole_number(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, guint32 *length)
 {
-	gboolean small_number, length_bit;
+	gboolean small_number;
 	guint32 len, length_determinant;
 	proto_item *pi;
 
@@ -459,16 +513,9 @@ DEBUG_ENTRY("dissect_per_normally_small_nonnegative_whole_number");
 	offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_small_number_bit, &small_number);
 	if (!display_internal_per_fields) PROTO_ITEM_SET_HIDDEN(actx->created_item);
 	if(!small_number){
-		int i;
 		/* 10.6.1 */
-		*length=0;
-		for(i=0;i<6;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &length_bit);
-			*length<<=1;
-			if (length_bit) {
-				*length|=1;
-			}
-		}
+		*length=per_get_bits(tvb, offset, 6);
+		offset+=6;
 		if(hf_index!=-1){
 			pi = proto_tree_add_uint(tree, hf_index, tvb, (offset-6)>>3, (offset%8<6)?2:1, *length);
 			if (!display_internal_per_fields) PROTO_ITEM_SET_HIDDEN(pi);
@@ -549,7 +596,7 @@ dissect_per_null(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _U_, proto_tree
 
 /* 19 this function dissects a sequence of */
 static guint32
-dissect_per_sequence_of_helper(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, per_type_fn func, int hf_index, guint32 length)
+dissect_per_sequence_of_helper(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, const per_sequence_t *seq, const per_type_t * const *types, guint32 length)
 {
 	guint32 i;
 
@@ -561,14 +608,14 @@ DEBUG_ENTRY("dissect_per_sequence_of_helper");
 
 		ltree=proto_tree_add_subtree_format(tree, tvb, offset>>3, 0, ett_per_sequence_of_item, &litem, "Item %d", i);
 
-		offset=(*func)(tvb, offset, actx, ltree, hf_index);
+		offset=PER_ENTRY_DISSECT(types, 0, seq, tvb, offset, actx, ltree);
 		proto_item_set_len(litem, (offset>>3)!=(lold_offset>>3)?(offset>>3)-(lold_offset>>3):1);
 	}
 
 	return offset;
 }
-guint32
-dissect_per_sequence_of(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq)
+static guint32
+dissect_per_sequence_of_internal(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq, const per_type_t * const *types)
 {
 	proto_item *item;
 	proto_tree *tree;
@@ -592,13 +639,19 @@ DEBUG_ENTRY("dissect_per_sequence_of");
 	}
 	tree=proto_item_add_subtree(item, ett_index);
 
-	offset=dissect_per_sequence_of_helper(tvb, offset, actx, tree, seq->func, *seq->p_id, length);
+	offset=dissect_per_sequence_of_helper(tvb, offset, actx, tree, seq, types, length);
 
 
 	proto_item_set_len(item, (offset>>3)!=(old_offset>>3)?(offset>>3)-(old_offset>>3):1);
 	return offset;
 }
 
+guint32
+dissect_per_sequence_of(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq)
+{
+	return dissect_per_sequence_of_internal(tvb, offset, actx, parent_tree, hf_index, ett_index, seq, NULL);
+}
+
 
 /* XXX we don't do >64k length strings   yet */
 static guint32
@@ -878,8 +931,8 @@ dissect_per_object_descriptor(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, p
 
 
 /* this function dissects a constrained sequence of */
-guint32
-dissect_per_constrained_sequence_of(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq, int min_len, int max_len, gboolean has_extension _U_)
+static guint32
+dissect_per_constrained_sequence_of_internal(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq, int min_len, int max_len, gboolean has_extension _U_, const per_type_t * const *types)
 {
 	proto_item *item;
 	proto_tree *tree;
@@ -936,7 +989,7 @@ call_sohelper:
 	per_check_items(length, min_len, max_len, actx, item);
 
 	old_offset = offset;
-	offset=dissect_per_sequence_of_helper(tvb, offset, actx, tree, seq->func, *seq->p_id, length);
+	offset=dissect_per_sequence_of_helper(tvb, offset, actx, tree, seq, types, length);
 
 	if (offset == old_offset)
 		length = 0;
@@ -949,6 +1002,12 @@ call_sohelper:
 	return offset;
 }
 
+guint32
+dissect_per_constrained_sequence_of(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq, int min_len, int max_len, gboolean has_extension)
+{
+	return dissect_per_constrained_sequence_of_internal(tvb, offset, actx, parent_tree, hf_index, ett_index, seq, min_len, max_len, has_extension, NULL);
+}
+
 /* this function dissects a constrained set of */
 guint32
 dissect_per_constrained_set_of(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *seq, int min_len, int max_len, gboolean has_extension)
@@ -1059,25 +1118,16 @@ dissect_per_relative_oid_str(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, pr
 }
 
 
-/* this function reads a single bit */
-guint32
-dissect_per_boolean(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gboolean *bool_val)
+/* adds the item for a single bit */
+static void
+dissect_per_boolean_item(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gboolean value)
 {
-	guint8 ch, mask;
-	gboolean value;
+	guint8 mask;
 	header_field_info *hfi;
 
-DEBUG_ENTRY("dissect_per_boolean");
-
-	ch=tvb_get_guint8(tvb, offset>>3);
-	mask=1<<(7-(offset&0x07));
-	if(ch&mask){
-		value=1;
-	} else {
-		value=0;
-	}
 	if(hf_index!=-1){
 		char bits[10];
+		mask=1<<(7-(offset&0x07));
 		bits[0] = mask&0x80?'0'+value:'.';
 		bits[1] = mask&0x40?'0'+value:'.';
 		bits[2] = mask&0x20?'0'+value:'.';
@@ -1096,6 +1146,25 @@ DEBUG_ENTRY("dissect_per_boolean");
 	} else {
 		actx->created_item = NULL;
 	}
+}
+
+/* this function reads a single bit */
+guint32
+dissect_per_boolean(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gboolean *bool_val)
+{
+	guint8 ch, mask;
+	gboolean value;
+
+DEBUG_ENTRY("dissect_per_boolean");
+
+	ch=tvb_get_guint8(tvb, offset>>3);
+	mask=1<<(7-(offset&0x07));
+	if(ch&mask){
+		value=1;
+	} else {
+		value=0;
+	}
+	dissect_per_boolean_item(tvb, offset, actx, tree, hf_index, value);
 
 	if(bool_val){
 		*bool_val=value;
@@ -1103,6 +1172,23 @@ DEBUG_ENTRY("dissect_per_boolean");
 	return offset+1;
 }
 
+/* Like dissect_per_boolean(), but reads the bit through r if it isn't NULL */
+static guint32
+dissect_per_bit(per_bit_reader_t *r, tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gboolean *bool_val)
+{
+	gboolean value;
+
+	if(!r){
+		return dissect_per_boolean(tvb, offset, actx, tree, hf_index, bool_val);
+	}
+	value=per_bit_reader_get(r, 1);
+	dissect_per_boolean_item(tvb, offset, actx, tree, hf_index, value);
+
+	if(bool_val){
+		*bool_val=value;
+	}
+	return offset+1;
+}
 
 
 
@@ -1321,7 +1407,7 @@ DEBUG_ENTRY("dissect_per_constrained_integer");
 
 		val_start = (offset)>>3;
 		val_length = length;
-		val = (guint32)tvb_get_bits64(tvb,offset,num_bits, ENC_BIG_ENDIAN);
+		val = per_get_bits(tvb, offset, num_bits);
 
 		if (display_internal_per_fields){
 			str = decode_bits_in_field((offset&0x07),num_bits,val);
@@ -1677,8 +1763,8 @@ dissect_per_real(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tr
 }
 
 /* 22 Encoding the choice type */
-guint32
-dissect_per_choice(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gint ett_index, const per_choice_t *choice, gint *value)
+static guint32
+dissect_per_choice_internal(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gint ett_index, const per_choice_t *choice, gint *value, const per_type_t * const *types)
 {
 	gboolean /*extension_present,*/ extension_flag;
 	int extension_root_entries;
@@ -1753,9 +1839,9 @@ DEBUG_ENTRY("dissect_per_choice");
 		choice_item = proto_tree_add_uint(tree, hf_index, tvb, old_offset>>3, 0, choice[idx].value);
 		choice_tree = proto_item_add_subtree(choice_item, ett_index);
 		if (!extension_flag) {
-			offset = choice[idx].func(tvb, offset, actx, choice_tree, *choice[idx].p_id);
+			offset = PER_ENTRY_DISSECT(types, idx, &choice[idx], tvb, offset, actx, choice_tree);
 		} else {
-			choice[idx].func(tvb, offset, actx, choice_tree, *choice[idx].p_id);
+			PER_ENTRY_DISSECT(types, idx, &choice[idx], tvb, offset, actx, choice_tree);
 			offset += ext_length * 8;
 		}
 		proto_item_set_len(choice_item, BLEN(old_offset, offset));
@@ -1776,6 +1862,12 @@ DEBUG_ENTRY("dissect_per_choice");
 	return offset;
 }
 
+guint32
+dissect_per_choice(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, gint ett_index, const per_choice_t *choice, gint *value)
+{
+	return dissect_per_choice_internal(tvb, offset, actx, tree, hf_index, ett_index, choice, value, NULL);
+}
+
 
 static const char *
 index_get_optional_name(const per_sequence_t *sequence, int idx)
@@ -1835,8 +1927,8 @@ index_get_field_name(const per_sequence_t *sequence, int idx)
 	   18.8
 	   18.9
 */
-guint32
-dissect_per_sequence(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *sequence)
+static guint32
+dissect_per_sequence_internal(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *sequence, const per_type_t * const *types)
 {
 	gboolean /*extension_present,*/ extension_flag, optional_field_flag;
 	proto_item *item;
@@ -1844,6 +1936,7 @@ dissect_per_sequence(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree
 	guint32 old_offset=offset;
 	guint32 i, j, num_opts;
 	guint32 optional_mask[SEQ_MAX_COMPONENTS>>5];
+	per_bit_reader_t bit_reader, *r;
 
 DEBUG_ENTRY("dissect_per_sequence");
 
@@ -1851,6 +1944,19 @@ DEBUG_ENTRY("dissect_per_sequence");
 	tree=proto_item_add_subtree(item, ett_index);
 
 
+	num_opts=0;
+	for(i=0;sequence[i].p_id;i++){
+		if((sequence[i].extension!=ASN1_NOT_EXTENSION_ROOT)&&(sequence[i].optional==ASN1_OPTIONAL)){
+			num_opts++;
+		}
+	}
+	/* the extension bit and the optional field bits are read in one go */
+	r=NULL;
+	if (num_opts <= SEQ_MAX_COMPONENTS &&
+	    per_bit_reader_init(&bit_reader, tvb, offset, (sequence[0].extension!=ASN1_NO_EXTENSIONS)+num_opts)) {
+		r=&bit_reader;
+	}
+
 	/* first check if there should be an extension bit for this CHOICE.
 	   we do this by just checking the first choice arm
 	 */
@@ -1860,23 +1966,17 @@ DEBUG_ENTRY("dissect_per_sequence");
 		/*extension_present=0;  ?? */
 	} else {
 		/*extension_present=1; ?? */
-		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_extension_bit, &extension_flag);
+		offset=dissect_per_bit(r, tvb, offset, actx, tree, hf_per_extension_bit, &extension_flag);
 		if (!display_internal_per_fields) PROTO_ITEM_SET_HIDDEN(actx->created_item);
 	}
 	/* 18.2 */
-	num_opts=0;
-	for(i=0;sequence[i].p_id;i++){
-		if((sequence[i].extension!=ASN1_NOT_EXTENSION_ROOT)&&(sequence[i].optional==ASN1_OPTIONAL)){
-			num_opts++;
-		}
-	}
 	if (num_opts > SEQ_MAX_COMPONENTS) {
 		dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "too many optional/default components");
 	}
 
 	memset(optional_mask, 0, sizeof(optional_mask));
 	for(i=0;i<num_opts;i++){
-		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
+		offset=dissect_per_bit(r, tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
 		if (tree) {
 			proto_item_append_text(actx->created_item, " (%s %s present)",
 				index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
@@ -1905,7 +2005,7 @@ DEBUG_ENTRY("dissect_per_sequence");
 				}
 			}
 			if(sequence[i].func){
-				offset=sequence[i].func(tvb, offset, actx, tree, *sequence[i].p_id);
+				offset=PER_ENTRY_DISSECT(types, i, &sequence[i], tvb, offset, actx, tree);
 			} else {
 				dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, index_get_field_name(sequence, i));
 			}
@@ -1941,9 +2041,13 @@ DEBUG_ENTRY("dissect_per_sequence");
 			dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "too many extensions");
 		}
 
+		r=NULL;
+		if (per_bit_reader_init(&bit_reader, tvb, offset, num_extensions)) {
+			r=&bit_reader;
+		}
 		extension_mask=0;
 		for(i=0;i<num_extensions;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_extension_present_bit, &extension_bit);
+			offset=dissect_per_bit(r, tvb, offset, actx, tree, hf_per_extension_present_bit, &extension_bit);
 			if (tree) {
 				proto_item_append_text(actx->created_item, " (%s %s present)",
 					index_get_extension_name(sequence, i), extension_bit?"is":"is NOT");
@@ -1995,7 +2099,7 @@ DEBUG_ENTRY("dissect_per_sequence");
 			}
 
 			if(sequence[extension_index].func){
-				new_offset=sequence[extension_index].func(tvb, offset, actx, tree, *sequence[extension_index].p_id);
+				new_offset=PER_ENTRY_DISSECT(types, extension_index, &sequence[extension_index], tvb, offset, actx, tree);
 				offset+=length*8;
 				difference = offset - new_offset;
 				/* A difference of 7 or less might be byte aligning */
@@ -2016,6 +2120,12 @@ DEBUG_ENTRY("dissect_per_sequence");
 	return offset;
 }
 
+guint32
+dissect_per_sequence(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *parent_tree, int hf_index, gint ett_index, const per_sequence_t *sequence)
+{
+	return dissect_per_sequence_internal(tvb, offset, actx, parent_tree, hf_index, ett_index, sequence, NULL);
+}
+
 guint32
 dissect_per_sequence_eag(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, const per_sequence_t *sequence)
 {
@@ -2300,6 +2410,46 @@ guint32 dissect_per_bit_string_containing_pdu_new(tvbuff_t *tvb, guint32 offset,
 	return offset;
 }
 
+/* this function dissects a type from its constant description, as
+   emitted by asn2wrs -t, by calling the function the type's own dissect
+   function would have called */
+guint32
+dissect_per_type(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, const per_type_t *type)
+{
+	switch (type->kind) {
+	case PER_TYPE_NULL:
+		return dissect_per_null(tvb, offset, actx, tree, hf_index);
+	case PER_TYPE_BOOLEAN:
+		return dissect_per_boolean(tvb, offset, actx, tree, hf_index, NULL);
+	case PER_TYPE_INTEGER:
+		return dissect_per_integer(tvb, offset, actx, tree, hf_index, NULL);
+	case PER_TYPE_CONSTRAINED_INTEGER:
+		return dissect_per_constrained_integer(tvb, offset, actx, tree, hf_index,
+						       type->min, type->max, NULL, type->has_extension);
+	case PER_TYPE_ENUMERATED:
+		return dissect_per_enumerated(tvb, offset, actx, tree, hf_index,
+					      type->min, NULL, type->has_extension, type->max, type->value_map);
+	case PER_TYPE_OCTET_STRING:
+		return dissect_per_octet_string(tvb, offset, actx, tree, hf_index,
+						type->min_len, type->max_len, type->has_extension, NULL);
+	case PER_TYPE_BIT_STRING:
+		return dissect_per_bit_string(tvb, offset, actx, tree, hf_index,
+					      type->min_len, type->max_len, type->has_extension, NULL, NULL);
+	case PER_TYPE_SEQUENCE:
+		return dissect_per_sequence_internal(tvb, offset, actx, tree, hf_index, *type->p_ett, type->sequence, type->types);
+	case PER_TYPE_SEQUENCE_OF:
+		return dissect_per_sequence_of_internal(tvb, offset, actx, tree, hf_index, *type->p_ett, type->sequence, type->types);
+	case PER_TYPE_CONSTRAINED_SEQUENCE_OF:
+		return dissect_per_constrained_sequence_of_internal(tvb, offset, actx, tree, hf_index, *type->p_ett, type->sequence,
+								    type->min_len, type->max_len, type->has_extension, type->types);
+	case PER_TYPE_CHOICE:
+		return dissect_per_choice_internal(tvb, offset, actx, tree, hf_index, *type->p_ett, type->choice, NULL, type->types);
+	}
+	DISSECTOR_ASSERT_NOT_REACHED();
+	return offset;
+}
+
+
 /* this function dissects an OCTET STRING
 	16.1
 	16.2
@@ -47,6 +47,41 @@ typedef struct _per_sequence_t {
 	per_type_fn func;
 } per_sequence_t;
 
+/* Kinds of types dissect_per_type() can dissect */
+typedef enum {
+	PER_TYPE_NULL,
+	PER_TYPE_BOOLEAN,
+	PER_TYPE_INTEGER,
+	PER_TYPE_CONSTRAINED_INTEGER,
+	PER_TYPE_ENUMERATED,
+	PER_TYPE_OCTET_STRING,
+	PER_TYPE_BIT_STRING,
+	PER_TYPE_SEQUENCE,
+	PER_TYPE_SEQUENCE_OF,
+	PER_TYPE_CONSTRAINED_SEQUENCE_OF,
+	PER_TYPE_CHOICE
+} per_type_kind;
+
+/* Constant description of a type, as emitted by asn2wrs -t, with the
+   parameters its dissect_per_xxx() function would be called with.
+   types, if not NULL, has the descriptions of the types of the entries of
+   sequence or choice, in the same order; the entries with a NULL one are
+   dissected with their function.
+*/
+typedef struct _per_type_t {
+	per_type_kind kind;
+	const gint *p_ett;              /* SEQUENCE, SEQUENCE OF and CHOICE */
+	guint32 min;                    /* INTEGER lower bound, ENUMERATED root_num */
+	guint32 max;                    /* INTEGER upper bound, ENUMERATED ext_num */
+	int min_len;                    /* size constraint of strings and SEQUENCE OF */
+	int max_len;
+	gboolean has_extension;
+	guint32 *value_map;             /* ENUMERATED */
+	const per_sequence_t *sequence; /* SEQUENCE and SEQUENCE OF */
+	const per_choice_t *choice;     /* CHOICE */
+	const struct _per_type_t * const *types;
+} per_type_t;
+
 WS_DLL_PUBLIC void dissect_per_not_decoded_yet(proto_tree* tree, packet_info* pinfo, tvbuff_t *tvb, const char* reason);
 
 WS_DLL_PUBLIC guint32 dissect_per_null(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index);
@@ -106,6 +141,8 @@ WS_DLL_PUBLIC guint32 dissect_per_restricted_character_string(tvbuff_t *tvb, gui
 
 WS_DLL_PUBLIC guint32 dissect_per_enumerated(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, guint32 root_num, guint32 *value, gboolean has_extension, guint32 ext_num, guint32 *value_map);
 
+WS_DLL_PUBLIC guint32 dissect_per_type(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, const per_type_t *type);
+
 WS_DLL_PUBLIC guint32 dissect_per_open_type(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, per_type_fn type_cb);
 WS_DLL_PUBLIC guint32 dissect_per_open_type_pdu_new(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, dissector_t type_cb);
 
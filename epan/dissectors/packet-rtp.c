@@ -84,10 +84,10 @@ typedef struct _rtp_multisegment_pdu {
 } rtp_multisegment_pdu;
 
 typedef struct  _rtp_private_conv_info {
-    /* This tree is indexed by sequence number and keeps track of all
+    /* This map is indexed by sequence number and keeps track of all
      * all pdus spanning multiple segments for this flow.
      */
-    wmem_tree_t *multisegment_pdus;
+    wmem_flat_map_t *multisegment_pdus;
 } rtp_private_conv_info;
 
 typedef struct {
@@ -1222,7 +1222,7 @@ bluetooth_add_address(packet_info *pinfo, address *addr, guint32 stream_number,
          */
         p_conv_data->extended_seqno = 0x10000;
         p_conv_data->rtp_conv_info = wmem_new(wmem_file_scope(), rtp_private_conv_info);
-        p_conv_data->rtp_conv_info->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+        p_conv_data->rtp_conv_info->multisegment_pdus = wmem_flat_map_new(wmem_file_scope());
         conversation_add_proto_data(p_conv, proto_rtp, p_conv_data);
 
         if (media_types == RTP_MEDIA_AUDIO) {
@@ -1323,7 +1323,7 @@ srtp_add_address(packet_info *pinfo, const port_type ptype, address *addr, int p
          */
         p_conv_data->extended_seqno = 0x10000;
         p_conv_data->rtp_conv_info = wmem_new(wmem_file_scope(), rtp_private_conv_info);
-        p_conv_data->rtp_conv_info->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+        p_conv_data->rtp_conv_info->multisegment_pdus = wmem_flat_map_new(wmem_file_scope());
         DINDENT();
         conversation_add_proto_data(p_conv, proto_rtp, p_conv_data);
         DENDENT();
@@ -1424,7 +1424,7 @@ dissect_rtp_heur_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, voi
             p_conv_data->rtp_dyn_payload = NULL;
             p_conv_data->extended_seqno = 0x10000;
             p_conv_data->rtp_conv_info = wmem_new(wmem_file_scope(), rtp_private_conv_info);
-            p_conv_data->rtp_conv_info->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+            p_conv_data->rtp_conv_info->multisegment_pdus = wmem_flat_map_new(wmem_file_scope());
             conversation_add_proto_data(p_conv, proto_rtp, p_conv_data);
         }
         g_strlcpy(p_conv_data->method, "HEUR RTP", MAX_RTP_SETUP_METHOD_SIZE+1);
@@ -1612,7 +1612,7 @@ dissect_rtp_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 #endif
 
     /* look for a pdu which we might be extending */
-    msp = (rtp_multisegment_pdu *)wmem_tree_lookup32_le(finfo->multisegment_pdus, seqno-1);
+    msp = (rtp_multisegment_pdu *)wmem_flat_map_lookup32_le(finfo->multisegment_pdus, seqno-1);
 
     if(msp && msp->startseq < seqno && msp->endseq >= seqno) {
         guint32 fid = msp->startseq;
@@ -1714,7 +1714,7 @@ dissect_rtp_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
             msp = wmem_new(wmem_file_scope(), rtp_multisegment_pdu);
             msp->startseq = seqno;
             msp->endseq = seqno+1;
-            wmem_tree_insert32(finfo->multisegment_pdus, seqno, msp);
+            wmem_flat_map_insert32(finfo->multisegment_pdus, seqno, msp);
         }
 
         /*
@@ -21144,7 +21144,7 @@ proto_register_smb(void)
 
 	register_srt_table(proto_smb, NULL, 3, smbstat_packet, smbstat_init, NULL);
 	/* Register the tap for the "Export Object" function */
-	smb_eo_tap = register_export_object(proto_smb, smb_eo_packet, smb_eo_cleanup);
+	smb_eo_tap = register_incremental_export_object(proto_smb, smb_eo_packet, smb_eo_cleanup);
 }
 
 void
@@ -2938,7 +2938,7 @@ ssl_create_flow(void)
   flow = (SslFlow *)wmem_alloc(wmem_file_scope(), sizeof(SslFlow));
   flow->byte_seq = 0;
   flow->flags = 0;
-  flow->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+  flow->multisegment_pdus = wmem_flat_map_new(wmem_file_scope());
   return flow;
 }
 /* }}} */
@@ -1313,6 +1313,7 @@ static gboolean tcp_analyze_seq           = TRUE;
 static gboolean tcp_relative_seq          = TRUE;
 static gboolean tcp_track_bytes_in_flight = TRUE;
 static gboolean tcp_calculate_ts          = TRUE;
+static gboolean tcp_compact_closed_flows  = FALSE;
 
 static gboolean tcp_analyze_mptcp                   = TRUE;
 static gboolean mptcp_relative_seq                  = TRUE;
@@ -1340,6 +1341,7 @@ static gboolean mptcp_intersubflows_retransmission  = FALSE;
 #define TCP_S_BASE_SEQ_SET 0x01
 #define TCP_S_SAW_SYN      0x03
 #define TCP_S_SAW_SYNACK   0x05
+#define TCP_S_SAW_FIN      0x08
 
 
 /* Describe the fields sniffed and set in mptcp_meta_flow_t:static_flags */
@@ -1398,6 +1400,83 @@ process_tcp_payload(tvbuff_t *tvb, volatile int offset, packet_info *pinfo,
     struct tcp_analysis *tcpd, struct tcpinfo *tcpinfo);
 
 
+/* Free lists of sequence analysis state released by closed flows (see
+ * tcp_compact_closed_flows) and of acknowledged segments, so that long
+ * captures with many short-lived connections recycle the same file scoped
+ * memory instead of growing it. The freed objects themselves hold the
+ * list links. Both lists are reset in tcp_init() along with the file scope.
+ */
+typedef struct _tcp_free_chunk_t {
+    struct _tcp_free_chunk_t *next;
+} tcp_free_chunk_t;
+
+static tcp_free_chunk_t *tcp_seq_info_pool = NULL;
+static tcp_free_chunk_t *tcp_unacked_pool = NULL;
+
+static tcp_analyze_seq_flow_info_t *
+tcp_seq_info_alloc(void)
+{
+    tcp_analyze_seq_flow_info_t *info;
+
+    if (tcp_seq_info_pool) {
+        info = (tcp_analyze_seq_flow_info_t *)tcp_seq_info_pool;
+        tcp_seq_info_pool = tcp_seq_info_pool->next;
+        memset(info, 0, sizeof(tcp_analyze_seq_flow_info_t));
+    } else {
+        info = wmem_new0(wmem_file_scope(), tcp_analyze_seq_flow_info_t);
+    }
+    return info;
+}
+
+static tcp_unacked_t *
+tcp_unacked_alloc(void)
+{
+    tcp_unacked_t *ual;
+
+    if (tcp_unacked_pool) {
+        ual = (tcp_unacked_t *)tcp_unacked_pool;
+        tcp_unacked_pool = tcp_unacked_pool->next;
+    } else {
+        ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
+    }
+    return ual;
+}
+
+static void
+tcp_unacked_free(tcp_unacked_t *ual)
+{
+    tcp_free_chunk_t *chunk = (tcp_free_chunk_t *)ual;
+
+    chunk->next = tcp_unacked_pool;
+    tcp_unacked_pool = chunk;
+}
+
+/* Return the sequence analysis state of a flow (and any segments still
+ * waiting for an ACK) to the free lists. Everything the second pass and the
+ * taps need (acked_table, multisegment_pdus, base_seq, ...) is kept.
+ */
+static void
+tcp_release_seq_info(tcp_flow_t *flow)
+{
+    tcp_analyze_seq_flow_info_t *info = flow->tcp_analyze_seq_info;
+    tcp_unacked_t *ual, *next;
+    tcp_free_chunk_t *chunk;
+
+    if (!info) {
+        return;
+    }
+
+    for (ual = info->segments; ual; ual = next) {
+        next = ual->next;
+        tcp_unacked_free(ual);
+    }
+
+    chunk = (tcp_free_chunk_t *)info;
+    chunk->next = tcp_seq_info_pool;
+    tcp_seq_info_pool = chunk;
+    flow->tcp_analyze_seq_info = NULL;
+}
+
 static struct tcp_analysis *
 init_tcp_conversation_data(packet_info *pinfo)
 {
@@ -1407,17 +1486,17 @@ init_tcp_conversation_data(packet_info *pinfo)
     tcpd=wmem_new0(wmem_file_scope(), struct tcp_analysis);
     tcpd->flow1.win_scale=-1;
     tcpd->flow1.window = G_MAXUINT32;
-    tcpd->flow1.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow1.multisegment_pdus=wmem_flat_map_new(wmem_file_scope());
 
     tcpd->flow2.window = G_MAXUINT32;
     tcpd->flow2.win_scale=-1;
-    tcpd->flow2.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow2.multisegment_pdus=wmem_flat_map_new(wmem_file_scope());
 
     /* Only allocate the data if its actually going to be analyzed */
     if (tcp_analyze_seq)
     {
-        tcpd->flow1.tcp_analyze_seq_info = wmem_new0(wmem_file_scope(), struct tcp_analyze_seq_flow_info_t);
-        tcpd->flow2.tcp_analyze_seq_info = wmem_new0(wmem_file_scope(), struct tcp_analyze_seq_flow_info_t);
+        tcpd->flow1.tcp_analyze_seq_info = tcp_seq_info_alloc();
+        tcpd->flow2.tcp_analyze_seq_info = tcp_seq_info_alloc();
     }
     /* Only allocate the data if its actually going to be displayed */
     if (tcp_display_process_info)
@@ -1637,12 +1716,12 @@ print_pdu_tracking_data(packet_info *pinfo, tvbuff_t *tvb, proto_tree *tcp_tree,
    and let TCP try to find out what it can about this segment
 */
 static int
-scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int offset, guint32 seq, guint32 nxtseq, wmem_tree_t *multisegment_pdus)
+scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int offset, guint32 seq, guint32 nxtseq, wmem_flat_map_t *multisegment_pdus)
 {
     struct tcp_multisegment_pdu *msp=NULL;
 
     if(!pinfo->fd->flags.visited) {
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, seq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_map_lookup32_le(multisegment_pdus, seq-1);
         if(msp) {
             /* If this is a continuation of a PDU started in a
              * previous segment we need to update the last_frame
@@ -1677,7 +1756,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
          * this segment we also verify that the found PDU does span
          * beyond the end of this segment.
          */
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, nxtseq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_map_lookup32_le(multisegment_pdus, nxtseq-1);
         if(msp) {
             if(pinfo->num==msp->first_frame) {
                 proto_item *item;
@@ -1696,7 +1775,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
         /* Second we check if this segment is part of a PDU started
          * prior to the segment (seq-1)
          */
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, seq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_map_lookup32_le(multisegment_pdus, seq-1);
         if(msp) {
             /* If this segment is completely within a previous PDU
              * then we just skip this packet
@@ -1720,7 +1799,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
    use this function to remember where the next pdu starts
 */
 struct tcp_multisegment_pdu *
-pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus)
+pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_flat_map_t *multisegment_pdus)
 {
     struct tcp_multisegment_pdu *msp;
 
@@ -1731,7 +1810,7 @@ pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nx
     msp->last_frame=pinfo->num;
     msp->last_frame_time=pinfo->abs_ts;
     msp->flags=0;
-    wmem_tree_insert32(multisegment_pdus, seq, (void *)msp);
+    wmem_flat_map_insert32(multisegment_pdus, seq, (void *)msp);
     /*g_warning("pdu_store_sequencenumber_of_next_pdu: seq %u", seq);*/
     return msp;
 }
@@ -1856,6 +1935,21 @@ tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint3
         return;
     }
 
+    /* The state of a closed connection may have been released (see
+     * tcp_compact_closed_flows); start over with a clean slate if another
+     * segment shows up for it.
+     */
+    if (!tcpd->fwd->tcp_analyze_seq_info) {
+        tcpd->fwd->tcp_analyze_seq_info = tcp_seq_info_alloc();
+    }
+    if (!tcpd->rev->tcp_analyze_seq_info) {
+        tcpd->rev->tcp_analyze_seq_info = tcp_seq_info_alloc();
+    }
+
+    if (flags & TH_FIN) {
+        tcpd->fwd->static_flags |= TCP_S_SAW_FIN;
+    }
+
     /* if this is the first segment for this list we need to store the
      * base_seq
      * We use TCP_S_SAW_SYN/SYNACK to distinguish between client and server
@@ -2180,7 +2274,7 @@ finished_checking_retransmission_type:
         /* Add this new sequence number to the fwd list.  But only if there
          * aren't "too many" unacked segments (e.g., we're not seeing the ACKs).
          */
-        ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
+        ual = tcp_unacked_alloc();
         ual->next=tcpd->fwd->tcp_analyze_seq_info->segments;
         tcpd->fwd->tcp_analyze_seq_info->segments=ual;
         tcpd->fwd->tcp_analyze_seq_info->segment_count++;
@@ -2279,7 +2373,7 @@ finished_checking_retransmission_type:
         else{
             prevual->next = tmpual;
         }
-        wmem_free(wmem_file_scope(), ual);
+        tcp_unacked_free(ual);
         ual = tmpual;
         tcpd->rev->tcp_analyze_seq_info->segment_count--;
     }
@@ -2329,6 +2423,19 @@ finished_checking_retransmission_type:
         tcpd->ta->push_bytes_sent = tcpd->fwd->push_bytes_sent;
     }
 
+    /* Once the connection is reset, or both FINs have been sent and
+     * everything has been acknowledged, nothing more is expected from
+     * either side: give the analysis state back for reuse by new flows.
+     */
+    if (tcp_compact_closed_flows &&
+        ((flags & TH_RST) ||
+         ((tcpd->fwd->static_flags & TCP_S_SAW_FIN) &&
+          (tcpd->rev->static_flags & TCP_S_SAW_FIN) &&
+          tcpd->fwd->tcp_analyze_seq_info->segment_count == 0 &&
+          tcpd->rev->tcp_analyze_seq_info->segment_count == 0))) {
+        tcp_release_seq_info(tcpd->fwd);
+        tcp_release_seq_info(tcpd->rev);
+    }
 }
 
 /*
@@ -3018,7 +3125,7 @@ again:
         /* Have we seen this PDU before (and is it the start of a multi-
          * segment PDU)?
          */
-        if ((msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32(tcpd->fwd->multisegment_pdus, seq))) {
+        if ((msp = (struct tcp_multisegment_pdu *)wmem_flat_map_lookup32(tcpd->fwd->multisegment_pdus, seq))) {
             const char* str;
 
             /* Yes.  This could be because we've dissected this frame before
@@ -3071,7 +3178,7 @@ again:
             return;
         }
         /* Else, find the most previous PDU starting before this sequence number */
-        msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(tcpd->fwd->multisegment_pdus, seq-1);
+        msp = (struct tcp_multisegment_pdu *)wmem_flat_map_lookup32_le(tcpd->fwd->multisegment_pdus, seq-1);
     }
 
     if (msp && msp->seq <= seq && msp->nxtpdu > seq) {
@@ -6428,7 +6535,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
              * for this flow, terminate reassembly and dissect the
              * results. */
             tcpd->fwd->fin = pinfo->num;
-            msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(tcpd->fwd->multisegment_pdus, tcph->th_seq-1);
+            msp=(struct tcp_multisegment_pdu *)wmem_flat_map_lookup32_le(tcpd->fwd->multisegment_pdus, tcph->th_seq-1);
             if(msp) {
                 fragment_head *ipfd_head;
 
@@ -6535,6 +6642,10 @@ tcp_init(void)
 {
     tcp_stream_count = 0;
 
+    /* The pooled objects lived in the previous file scope */
+    tcp_seq_info_pool = NULL;
+    tcp_unacked_pool = NULL;
+
     /* MPTCP init */
     mptcp_stream_count = 0;
     mptcp_tokens = wmem_tree_new(wmem_file_scope());
@@ -7514,6 +7625,14 @@ proto_register_tcp(void)
         "Calculate conversation timestamps",
         "Calculate timestamps relative to the first frame and the previous frame in the tcp conversation",
         &tcp_calculate_ts);
+    prefs_register_bool_preference(tcp_module, "compact_closed_flows",
+        "Release analysis state of closed connections",
+        "Make the TCP dissector recycle the sequence analysis state of a connection once it has been reset, "
+        "or closed with a FIN in each direction that has been acknowledged. "
+        "This keeps memory usage bounded on long captures with many short connections, "
+        "but segments seen after the close are analyzed as if they started a new connection. "
+        "To use this option you must also enable \"Analyze TCP sequence numbers\".",
+        &tcp_compact_closed_flows);
     prefs_register_bool_preference(tcp_module, "try_heuristic_first",
         "Try heuristic sub-dissectors first",
         "Try to decode a packet using an heuristic sub-dissector before using a sub-dissector registered to a specific port",
@@ -140,7 +140,7 @@ tcp_dissect_pdus(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 		 dissector_t dissect_pdu, void* dissector_data);
 
 extern struct tcp_multisegment_pdu *
-pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus);
+pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_flat_map_t *multisegment_pdus);
 
 typedef struct _tcp_unacked_t {
 	struct _tcp_unacked_t *next;
@@ -335,10 +335,10 @@ typedef struct _tcp_flow_t {
 	/* see TCP_A_* in packet-tcp.c */
 	guint32 lastsegmentflags;
 
-	/* This tree is indexed by sequence number and keeps track of all
+	/* This map is indexed by sequence number and keeps track of all
 	 * all pdus spanning multiple segments for this flow.
 	 */
-	wmem_tree_t *multisegment_pdus;
+	wmem_flat_map_t *multisegment_pdus;
 
 	/* Process info, currently discovered via IPFIX */
 	tcp_process_info_t* process_info;
@@ -54,6 +54,7 @@
 #include "dissector_filters.h"
 #include "conversation_table.h"
 #include "reassemble.h"
+#include "tvbuff-int.h"
 #include "srt_table.h"
 #include "stats_tree.h"
 #include <dtd.h>
@@ -64,6 +65,9 @@
 
 #ifdef HAVE_LUA
 #include <lua.h>
+#ifdef HAVE_LUAJIT
+#include <luajit.h>
+#endif
 #include <wslua/wslua.h>
 #endif
 
@@ -319,6 +323,7 @@ epan_cleanup(void)
 	export_pdu_cleanup();
 	cleanup_enabled_and_disabled_lists();
 	stats_tree_cleanup();
+	tvb_uncompress_cleanup();
 	dtd_location(NULL);
 #ifdef HAVE_LUA
 	wslua_cleanup();
@@ -698,7 +703,11 @@ epan_get_compiled_version_info(GString *str)
 	g_string_append(str, ", ");
 #ifdef HAVE_LUA
 	g_string_append(str, "with ");
+#ifdef HAVE_LUAJIT
+	g_string_append(str, LUAJIT_VERSION);
+#else
 	g_string_append(str, LUA_RELEASE);
+#endif
 #else
 	g_string_append(str, "without Lua");
 #endif /* HAVE_LUA */
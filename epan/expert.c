@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <wsutil/ws_printf.h>
 
@@ -41,6 +42,11 @@ static int hf_expert_msg      = -1;
 static int hf_expert_group    = -1;
 static int hf_expert_severity = -1;
 
+/* First-pass summary of all expert infos in the capture, see
+ * expert_summary_foreach(). The map is keyed on expert_summary_t itself
+ * (group, severity, protocol and summary) and reset with the file scope. */
+static wmem_map_t *expert_summary_map = NULL;
+
 struct expert_module
 {
 	const char *proto_name;
@@ -180,6 +186,93 @@ static void uat_expert_post_update_cb(void)
 	DISSECTOR_ASSERT_HINT(gpa_expertinfo.ei[eiindex] != NULL, "Unregistered expert info!");	\
 	expinfo = gpa_expertinfo.ei[eiindex];
 
+static guint
+expert_summary_hash(gconstpointer key)
+{
+	const expert_summary_t *es = (const expert_summary_t *)key;
+
+	return g_str_hash(es->summary) ^ g_str_hash(es->protocol) ^
+		(guint)es->group ^ (guint)es->severity;
+}
+
+static gboolean
+expert_summary_equal(gconstpointer a, gconstpointer b)
+{
+	const expert_summary_t *es_a = (const expert_summary_t *)a;
+	const expert_summary_t *es_b = (const expert_summary_t *)b;
+
+	return es_a->group == es_b->group &&
+		es_a->severity == es_b->severity &&
+		strcmp(es_a->protocol, es_b->protocol) == 0 &&
+		strcmp(es_a->summary, es_b->summary) == 0;
+}
+
+/* Account for an expert info seen while a frame is dissected for the first
+ * time. Frames are appended in the order they are first seen, which is
+ * capture order; a frame is only recorded once per summary. */
+static void
+expert_summary_add(packet_info *pinfo, int group, int severity, int hf_index, const gchar *summary)
+{
+	expert_summary_t  key;
+	expert_summary_t *es;
+
+	key.group    = group;
+	key.severity = severity;
+	key.protocol = pinfo->current_proto;
+	key.summary  = summary;
+
+	es = (expert_summary_t *)wmem_map_lookup(expert_summary_map, &key);
+	if (es == NULL) {
+		es = wmem_new(wmem_file_scope(), expert_summary_t);
+		es->group    = group;
+		es->severity = severity;
+		es->hf_index = hf_index;
+		es->protocol = pinfo->current_proto;
+		es->summary  = wmem_strdup(wmem_file_scope(), summary);
+		es->count    = 0;
+		es->frames   = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+		wmem_map_insert(expert_summary_map, es, es);
+	}
+
+	es->count++;
+	if (wmem_array_get_count(es->frames) == 0 ||
+	    *(guint32 *)wmem_array_index(es->frames, wmem_array_get_count(es->frames) - 1) != pinfo->num) {
+		wmem_array_append_one(es->frames, pinfo->num);
+	}
+}
+
+typedef struct {
+	expert_summary_func func;
+	void               *user_data;
+} expert_summary_foreach_t;
+
+static void
+expert_summary_foreach_cb(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	expert_summary_foreach_t *esf = (expert_summary_foreach_t *)user_data;
+
+	esf->func((const expert_summary_t *)value, esf->user_data);
+}
+
+void
+expert_summary_foreach(expert_summary_func func, void *user_data)
+{
+	expert_summary_foreach_t esf;
+
+	if (expert_summary_map == NULL)
+		return;
+
+	esf.func      = func;
+	esf.user_data = user_data;
+	wmem_map_foreach(expert_summary_map, expert_summary_foreach_cb, &esf);
+}
+
+guint
+expert_summary_get_count(void)
+{
+	return expert_summary_map ? wmem_map_size(expert_summary_map) : 0;
+}
+
 void
 expert_packet_init(void)
 {
@@ -244,6 +337,11 @@ expert_packet_init(void)
 
 	}
 
+	if (expert_summary_map == NULL) {
+		expert_summary_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+			expert_summary_hash, expert_summary_equal);
+	}
+
 	highest_severity = 0;
 
 	proto_malformed = proto_get_id_by_filter_name("_ws.malformed");
@@ -291,6 +389,9 @@ expert_cleanup(void)
 		g_ptr_array_free(deregistered_expertinfos, FALSE);
 		deregistered_expertinfos = NULL;
 	}
+
+	/* Freed along with the epan scope */
+	expert_summary_map = NULL;
 }
 
 
@@ -553,6 +654,10 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 					      "%s", val_to_str_const(group, expert_group_vals, "Unknown"));
 	PROTO_ITEM_SET_GENERATED(ti);
 
+	if (!PINFO_FD_VISITED(pinfo)) {
+		expert_summary_add(pinfo, group, severity, hf_index, formatted);
+	}
+
 	tap = have_tap_listener(expert_tap);
 
 	if (!tap)
@@ -15,6 +15,7 @@
 
 #include <epan/packet_info.h>
 #include <epan/proto.h>
+#include <epan/wmem/wmem.h>
 #include "value_string.h"
 #include "ws_symbol_export.h"
 
@@ -95,6 +96,35 @@ expert_get_highest_severity(void);
 WS_DLL_PUBLIC void
 expert_update_comment_count(guint64 count);
 
+/** An expert info summary, aggregated over all frames of the capture
+ file while they are dissected for the first time. */
+typedef struct expert_summary_s {
+	int           group;
+	int           severity;
+	int           hf_index; /* hf_index of the first expert item seen. Might be -1. */
+	const gchar  *protocol;
+	const gchar  *summary;
+	guint32       count;    /* number of times the item was added */
+	wmem_array_t *frames;   /* guint32 frame numbers, in capture order, without duplicates */
+} expert_summary_t;
+
+typedef void (*expert_summary_func)(const expert_summary_t *summary, void *user_data);
+
+/** Call func for every distinct (group, severity, protocol, summary) expert
+ info seen so far in the current capture file, in no particular order.
+ The summaries are valid until the file is closed or redissected, and
+ reflect frames added by a live capture as soon as they are dissected, so
+ users can present expert infos without retapping the whole file.
+ @param func The function to call for each summary
+ @param user_data Passed to func */
+WS_DLL_PUBLIC void
+expert_summary_foreach(expert_summary_func func, void *user_data);
+
+/** Get the number of distinct expert info summaries seen so far in the
+ current capture file. */
+WS_DLL_PUBLIC guint
+expert_summary_get_count(void);
+
 /** Add an expert info.
  Add an expert info tree to a protocol item using registered expert info item
  @param pinfo Packet info of the currently processed packet. May be NULL if
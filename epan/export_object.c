@@ -21,12 +21,13 @@ struct register_eo {
     const char* tap_listen_str;          /* string used in register_tap_listener (NULL to use protocol name) */
     tap_packet_cb eo_func;               /* function to be called for new incoming packets for SRT */
     export_object_gui_reset_cb reset_cb; /* function to parse parameters of optional arguments of tap string */
+    gboolean incremental;                /* entries may be updated after they have been added */
 };
 
 static wmem_tree_t *registered_eo_tables = NULL;
 
-int
-register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb)
+static int
+register_export_object_table(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb, gboolean incremental)
 {
     register_eo_t *table;
     DISSECTOR_ASSERT(export_packet_func);
@@ -37,6 +38,7 @@ register_export_object(const int proto_id, tap_packet_cb export_packet_func, exp
     table->tap_listen_str = wmem_strdup_printf(wmem_epan_scope(), "%s_eo", proto_get_protocol_filter_name(proto_id));
     table->eo_func = export_packet_func;
     table->reset_cb = reset_cb;
+    table->incremental = incremental;
 
     if (registered_eo_tables == NULL)
         registered_eo_tables = wmem_tree_new(wmem_epan_scope());
@@ -45,6 +47,18 @@ register_export_object(const int proto_id, tap_packet_cb export_packet_func, exp
     return register_tap(table->tap_listen_str);
 }
 
+int
+register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb)
+{
+    return register_export_object_table(proto_id, export_packet_func, reset_cb, FALSE);
+}
+
+int
+register_incremental_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb)
+{
+    return register_export_object_table(proto_id, export_packet_func, reset_cb, TRUE);
+}
+
 int get_eo_proto_id(register_eo_t* eo)
 {
     if (!eo) {
@@ -68,6 +82,11 @@ export_object_gui_reset_cb get_eo_reset_func(register_eo_t* eo)
     return eo->reset_cb;
 }
 
+gboolean get_eo_is_incremental(register_eo_t* eo)
+{
+    return eo->incremental;
+}
+
 register_eo_t* get_eo_by_name(const char* name)
 {
     return (register_eo_t*)wmem_tree_lookup_string(registered_eo_tables, name, 0);
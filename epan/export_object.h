@@ -66,6 +66,19 @@ typedef void (*export_object_gui_reset_cb)(void);
  */
 WS_DLL_PUBLIC int register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb);
 
+/** Register the export object handler of a protocol whose tap keeps adding
+ * data to an entry (retrieved again with get_entry) after it has been passed
+ * to add_entry. Entries of other protocols are complete when they are added,
+ * which allows them to be saved and released right away.
+ *
+ * @param proto_id is the protocol with objects to export
+ * @param export_packet_func the tap processing function
+ * @param reset_cb handles clearing intermediate data structures constructed
+ *  for exporting objects. If no function is needed a NULL value should be passed instead
+ * @return Tap id registered for the Export Object
+ */
+WS_DLL_PUBLIC int register_incremental_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb);
+
 /** Get protocol ID from Export Object
  *
  * @param eo Registered Export Object
@@ -94,6 +107,13 @@ WS_DLL_PUBLIC tap_packet_cb get_eo_packet_func(register_eo_t* eo);
  */
 WS_DLL_PUBLIC export_object_gui_reset_cb get_eo_reset_func(register_eo_t* eo);
 
+/** Check whether entries of an Export Object may still change after they have been added
+ *
+ * @param eo Registered Export Object
+ * @return TRUE if registered with register_incremental_export_object
+ */
+WS_DLL_PUBLIC gboolean get_eo_is_incremental(register_eo_t* eo);
+
 /** Get Export Object by its short protocol name
  *
  * @param name short protocol name to fetch.
@@ -27,6 +27,7 @@
 
 #include "addr_resolv.h"
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 #include "epan_dissect.h"
 
 #include "wmem/wmem.h"
@@ -333,6 +334,9 @@ cleanup_dissection(void)
 	/* Cleanup the expert infos */
 	expert_packet_cleanup();
 
+	/* Don't keep the uncompressed bodies of this file around */
+	tvb_uncompress_cleanup();
+
 	wmem_leave_file_scope();
 
 	/*
@@ -69,4 +69,8 @@ void tvb_add_to_chain(tvbuff_t *parent, tvbuff_t *child);
 guint tvb_offset_from_real_beginning_counter(const tvbuff_t *tvb, const guint counter);
 
 void tvb_check_offset_length(const tvbuff_t *tvb, const gint offset, gint const length_val, guint *offset_ptr, guint *length_ptr);
+
+/* Frees the cache of uncompressed bodies kept by tvb_uncompress(); called
+   when a capture file is closed */
+void tvb_uncompress_cleanup(void);
 #endif
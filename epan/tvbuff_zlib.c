@@ -21,6 +21,8 @@
 #endif
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
+#include "wmem/wmem.h"
 #ifdef TVB_Z_DEBUG
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 #endif
@@ -36,13 +38,139 @@
 /* #define TVB_Z_DEBUG 1 */
 #undef TVB_Z_DEBUG
 
+/*
+ * Dissectors uncompress the same bodies over and over: once per pass, and
+ * again every time a packet is selected or a tree is expanded. Keep the most
+ * recently uncompressed bodies around, keyed by their compressed contents
+ * (the result only depends on those), and hand out copies of them instead.
+ * The cache is bounded by the total size of the compressed and uncompressed
+ * data it holds; the least recently used bodies are evicted first. It is
+ * emptied by cleanup_dissection(), so it only holds bodies of the current
+ * capture file.
+ */
+#define TVB_Z_CACHE_MAX_SIZE  (16 * 1024 * 1024)
+/* Don't let a single huge body flush the whole cache */
+#define TVB_Z_CACHE_MAX_ENTRY (TVB_Z_CACHE_MAX_SIZE / 4)
+
+typedef struct {
+	guint8    *compr;
+	guint      comprlen;
+	guint      hash;
+	guint8    *uncompr;
+	guint      uncomprlen;
+	GList     *lru_link;
+} tvb_z_cache_entry_t;
+
+static GHashTable *tvb_z_cache       = NULL;
+static GQueue      tvb_z_cache_lru   = G_QUEUE_INIT;	/* most recently used first */
+static gsize       tvb_z_cache_size  = 0;
+
+static guint
+tvb_z_cache_hash(gconstpointer key)
+{
+	return ((const tvb_z_cache_entry_t *)key)->hash;
+}
+
+static gboolean
+tvb_z_cache_equal(gconstpointer a, gconstpointer b)
+{
+	const tvb_z_cache_entry_t *ea = (const tvb_z_cache_entry_t *)a;
+	const tvb_z_cache_entry_t *eb = (const tvb_z_cache_entry_t *)b;
+
+	return ea->hash == eb->hash && ea->comprlen == eb->comprlen &&
+		memcmp(ea->compr, eb->compr, ea->comprlen) == 0;
+}
+
+static void
+tvb_z_cache_free_entry(tvb_z_cache_entry_t *entry)
+{
+	tvb_z_cache_size -= entry->comprlen + entry->uncomprlen;
+	g_queue_delete_link(&tvb_z_cache_lru, entry->lru_link);
+	g_free(entry->compr);
+	g_free(entry->uncompr);
+	g_free(entry);
+}
+
+static const tvb_z_cache_entry_t *
+tvb_z_cache_lookup(guint8 *compr, guint comprlen)
+{
+	tvb_z_cache_entry_t  key;
+	tvb_z_cache_entry_t *entry;
+
+	if (tvb_z_cache == NULL)
+		return NULL;
+
+	key.compr = compr;
+	key.comprlen = comprlen;
+	key.hash = wmem_strong_hash(compr, comprlen);
+
+	entry = (tvb_z_cache_entry_t *)g_hash_table_lookup(tvb_z_cache, &key);
+	if (entry) {
+		g_queue_unlink(&tvb_z_cache_lru, entry->lru_link);
+		g_queue_push_head_link(&tvb_z_cache_lru, entry->lru_link);
+	}
+	return entry;
+}
+
+/* Takes ownership of compr; uncompr is copied. */
+static void
+tvb_z_cache_insert(guint8 *compr, guint comprlen, const guint8 *uncompr, guint uncomprlen)
+{
+	tvb_z_cache_entry_t *entry;
+	gsize                size = (gsize)comprlen + uncomprlen;
+
+	if (size > TVB_Z_CACHE_MAX_ENTRY) {
+		g_free(compr);
+		return;
+	}
+
+	if (tvb_z_cache == NULL)
+		tvb_z_cache = g_hash_table_new(tvb_z_cache_hash, tvb_z_cache_equal);
+
+	while (tvb_z_cache_size + size > TVB_Z_CACHE_MAX_SIZE) {
+		entry = (tvb_z_cache_entry_t *)g_queue_peek_tail(&tvb_z_cache_lru);
+		g_hash_table_remove(tvb_z_cache, entry);
+		tvb_z_cache_free_entry(entry);
+	}
+
+	entry = g_new(tvb_z_cache_entry_t, 1);
+	entry->compr = compr;
+	entry->comprlen = comprlen;
+	entry->hash = wmem_strong_hash(compr, comprlen);
+	/* g_memdup(..., 0) returns NULL, see the comment in tvb_uncompress() */
+	entry->uncompr = uncomprlen ? (guint8 *)g_memdup(uncompr, uncomprlen) : (guint8 *)g_strdup("");
+	entry->uncomprlen = uncomprlen;
+	g_queue_push_head(&tvb_z_cache_lru, entry);
+	entry->lru_link = g_queue_peek_head_link(&tvb_z_cache_lru);
+
+	g_hash_table_insert(tvb_z_cache, entry, entry);
+	tvb_z_cache_size += size;
+}
+
+void
+tvb_uncompress_cleanup(void)
+{
+	tvb_z_cache_entry_t *entry;
+
+	while ((entry = (tvb_z_cache_entry_t *)g_queue_peek_head(&tvb_z_cache_lru)) != NULL) {
+		tvb_z_cache_free_entry(entry);
+	}
+	if (tvb_z_cache) {
+		g_hash_table_destroy(tvb_z_cache);
+		tvb_z_cache = NULL;
+	}
+}
+
 tvbuff_t *
 tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 {
 	gint       err;
 	guint      bytes_out      = 0;
 	guint8    *compr;
-	guint8    *uncompr        = NULL;
+	const int  orig_comprlen  = comprlen;
+	const tvb_z_cache_entry_t *cached;
+	GByteArray *uncompr       = NULL;
+	guint8    *uncompr_data;
 	tvbuff_t  *uncompr_tvb    = NULL;
 	z_streamp  strm;
 	Bytef     *strmbuf;
@@ -64,6 +192,15 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 		return NULL;
 	}
 
+	cached = tvb_z_cache_lookup(compr, comprlen);
+	if (cached != NULL) {
+		wmem_free(NULL, compr);
+		uncompr_data = (guint8 *)g_memdup(cached->uncompr, cached->uncomprlen ? cached->uncomprlen : 1);
+		uncompr_tvb = tvb_new_real_data(uncompr_data, cached->uncomprlen, cached->uncomprlen);
+		tvb_set_free_cb(uncompr_tvb, g_free);
+		return uncompr_tvb;
+	}
+
 	/*
 	 * Assume that the uncompressed data is at least twice as big as
 	 * the compressed size.
@@ -96,7 +233,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	}
 
 	while (1) {
-		memset(strmbuf, '\0', bufsiz);
 		strm->next_out  = strmbuf;
 		strm->avail_out = bufsiz;
 
@@ -109,26 +245,23 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			++inflate_passes;
 #endif
 
-			if (uncompr == NULL) {
+			if (uncompr == NULL && (bytes_pass || err == Z_STREAM_END)) {
 				/*
 				 * This is ugly workaround for bug #6480
 				 * (https://bugs.wireshark.org/bugzilla/show_bug.cgi?id=6480)
 				 *
-				 * g_memdup(..., 0) returns NULL (g_malloc(0) also)
-				 * when uncompr is NULL logic below doesn't create tvb
-				 * which is later interpreted as decompression failed.
+				 * A stream that ends without any output must
+				 * still give us a (empty) buffer: when uncompr
+				 * is NULL logic below doesn't create tvb which
+				 * is later interpreted as decompression failed.
+				 * The buffer is sized up front so that its data
+				 * is never NULL, and grows geometrically from
+				 * there instead of being copied on every pass.
 				 */
-				uncompr = (guint8 *)((bytes_pass || err != Z_STREAM_END) ?
-						g_memdup(strmbuf, bytes_pass) :
-						g_strdup(""));
-			} else {
-				guint8 *new_data = (guint8 *)g_malloc0(bytes_out + bytes_pass);
-
-				memcpy(new_data, uncompr, bytes_out);
-				memcpy(new_data + bytes_out, strmbuf, bytes_pass);
-
-				g_free(uncompr);
-				uncompr = new_data;
+				uncompr = g_byte_array_sized_new(bufsiz);
+			}
+			if (bytes_pass) {
+				g_byte_array_append(uncompr, strmbuf, bytes_pass);
 			}
 
 			bytes_out += bytes_pass;
@@ -274,7 +407,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			strm->avail_in  = comprlen;
 
 			inflateEnd(strm);
-			memset(strmbuf, '\0', bufsiz);
 			strm->next_out  = strmbuf;
 			strm->avail_out = bufsiz;
 
@@ -286,7 +418,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 				g_free(strm);
 				g_free(strmbuf);
 				wmem_free(NULL, compr);
-				g_free(uncompr);
 
 				return NULL;
 			}
@@ -310,13 +441,22 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 #endif
 
 	if (uncompr != NULL) {
-		uncompr_tvb =  tvb_new_real_data((guint8*) uncompr, bytes_out, bytes_out);
+		uncompr_data = g_byte_array_free(uncompr, FALSE);
+		/* Hands compr over to the cache */
+		tvb_z_cache_insert(compr, orig_comprlen, uncompr_data, bytes_out);
+		uncompr_tvb =  tvb_new_real_data(uncompr_data, bytes_out, bytes_out);
 		tvb_set_free_cb(uncompr_tvb, g_free);
+	} else {
+		wmem_free(NULL, compr);
 	}
-	wmem_free(NULL, compr);
 	return uncompr_tvb;
 }
 #else
+void
+tvb_uncompress_cleanup(void)
+{
+}
+
 tvbuff_t *
 tvb_uncompress(tvbuff_t *tvb _U_, const int offset _U_, int comprlen _U_)
 {
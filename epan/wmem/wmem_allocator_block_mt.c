@@ -0,0 +1,379 @@
+/* wmem_allocator_block_mt.c
+ * Wireshark Memory Manager Thread-Safe Large-Block Allocator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_block_mt.h"
+
+/*
+ * This is the BLOCK_FAST allocator made safe to allocate from in several
+ * threads at once: each thread that allocates gets an arena of its own, from
+ * which it carves its allocations without any locking, exactly as BLOCK_FAST
+ * does. The arena of the calling thread is found through a thread-local
+ * cache, so the allocator's lock is only taken the first time a thread
+ * allocates from it (or when it switches between two of these allocators),
+ * and for jumbo allocations, which are shared by all threads since they can
+ * be reallocated by any of them.
+ *
+ * free_all() doesn't give the blocks back to the OS, but pushes them onto a
+ * stack of free blocks from which the arenas then take their new blocks with
+ * a compare-and-swap, without locking; gc() frees them. As free_all(), gc()
+ * and cleanup() may only be called while no other thread is using the
+ * allocator, blocks are only pushed while nobody pops them, so the stack
+ * doesn't suffer from the ABA problem.
+ *
+ * As with BLOCK_FAST, free is a no-op.
+ */
+
+#define WMEM_ALIGN_AMOUNT (2 * sizeof (gsize))
+#define WMEM_ALIGN_SIZE(SIZE) ((~(WMEM_ALIGN_AMOUNT-1)) & \
+        ((SIZE) + (WMEM_ALIGN_AMOUNT-1)))
+
+#define WMEM_CHUNK_TO_DATA(CHUNK) ((void*)((guint8*)(CHUNK) + WMEM_CHUNK_HEADER_SIZE))
+#define WMEM_DATA_TO_CHUNK(DATA) ((wmem_block_mt_chunk_t*)((guint8*)(DATA) - WMEM_CHUNK_HEADER_SIZE))
+
+#define WMEM_BLOCK_MAX_ALLOC_SIZE (WMEM_BLOCK_SIZE - (WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE))
+
+/* The same 2MB as BLOCK_FAST; see there. */
+#define WMEM_BLOCK_SIZE (2 * 1024 * 1024)
+
+/* The header for an entire OS-level 'block' of memory */
+typedef struct _wmem_block_mt_hdr {
+    struct _wmem_block_mt_hdr *next;
+
+    gint32 pos;
+} wmem_block_mt_hdr_t;
+#define WMEM_BLOCK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_mt_hdr_t))
+
+typedef struct {
+    guint32 len;
+} wmem_block_mt_chunk_t;
+#define WMEM_CHUNK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_mt_chunk_t))
+
+#define JUMBO_MAGIC 0xFFFFFFFF
+typedef struct _wmem_block_mt_jumbo {
+    struct _wmem_block_mt_jumbo *prev, *next;
+} wmem_block_mt_jumbo_t;
+#define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_mt_jumbo_t))
+
+/* The blocks a thread allocates from; only that thread touches them, until
+ * the next free_all(). */
+typedef struct _wmem_block_mt_arena {
+    wmem_block_mt_hdr_t         *block_list;
+    GThread                     *owner;
+    struct _wmem_block_mt_arena *next;
+} wmem_block_mt_arena_t;
+
+typedef struct {
+    guint                  id;          /* for the thread-local caches */
+
+    GMutex                 lock;        /* protects arenas and jumbo_list */
+    wmem_block_mt_arena_t *arenas;
+    wmem_block_mt_jumbo_t *jumbo_list;
+
+    gpointer               free_blocks; /* wmem_block_mt_hdr_t stack */
+} wmem_block_mt_allocator_t;
+
+/* The arena of the calling thread in the last allocator it used */
+typedef struct {
+    guint                  allocator_id;
+    wmem_block_mt_arena_t *arena;
+} wmem_block_mt_cache_t;
+
+static GPrivate wmem_block_mt_cache = G_PRIVATE_INIT(g_free);
+
+static gint wmem_block_mt_last_id = 0;
+
+static wmem_block_mt_arena_t *
+wmem_block_mt_find_arena(wmem_block_mt_allocator_t *allocator)
+{
+    wmem_block_mt_cache_t *cache;
+    wmem_block_mt_arena_t *arena;
+    GThread               *self;
+
+    cache = (wmem_block_mt_cache_t *)g_private_get(&wmem_block_mt_cache);
+    if G_LIKELY(cache && cache->allocator_id == allocator->id) {
+        return cache->arena;
+    }
+
+    if (cache == NULL) {
+        cache = g_new0(wmem_block_mt_cache_t, 1);
+        g_private_set(&wmem_block_mt_cache, cache);
+    }
+
+    self = g_thread_self();
+
+    g_mutex_lock(&allocator->lock);
+    for (arena = allocator->arenas; arena; arena = arena->next) {
+        if (arena->owner == self) {
+            break;
+        }
+    }
+    if (arena == NULL) {
+        arena = wmem_new0(NULL, wmem_block_mt_arena_t);
+        arena->owner = self;
+        arena->next = allocator->arenas;
+        allocator->arenas = arena;
+    }
+    g_mutex_unlock(&allocator->lock);
+
+    cache->allocator_id = allocator->id;
+    cache->arena = arena;
+
+    return arena;
+}
+
+/* Gets a block, recycled if possible, and adds it to the arena. */
+static void
+wmem_block_mt_new_block(wmem_block_mt_allocator_t *allocator,
+        wmem_block_mt_arena_t *arena)
+{
+    wmem_block_mt_hdr_t *block, *next;
+
+    do {
+        block = (wmem_block_mt_hdr_t *)g_atomic_pointer_get(&allocator->free_blocks);
+        if (block == NULL) {
+            break;
+        }
+        next = block->next;
+    } while (!g_atomic_pointer_compare_and_exchange(&allocator->free_blocks, block, next));
+
+    if (block == NULL) {
+        block = (wmem_block_mt_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    }
+
+    block->pos  = WMEM_BLOCK_HEADER_SIZE;
+    block->next = arena->block_list;
+
+    arena->block_list = block;
+}
+
+/* API */
+
+static void *
+wmem_block_mt_alloc(void *private_data, const size_t size)
+{
+    wmem_block_mt_allocator_t *allocator = (wmem_block_mt_allocator_t*) private_data;
+    wmem_block_mt_arena_t     *arena;
+    wmem_block_mt_chunk_t     *chunk;
+    gint32 real_size;
+
+    if (size > WMEM_BLOCK_MAX_ALLOC_SIZE) {
+        wmem_block_mt_jumbo_t *block;
+
+        /* allocate/initialize a new block of the necessary size */
+        block = (wmem_block_mt_jumbo_t *)wmem_alloc(NULL,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+
+        g_mutex_lock(&allocator->lock);
+        block->next = allocator->jumbo_list;
+        block->prev = NULL;
+        if (block->next) {
+            block->next->prev = block;
+        }
+        allocator->jumbo_list = block;
+        g_mutex_unlock(&allocator->lock);
+
+        chunk = ((wmem_block_mt_chunk_t*)((guint8*)(block) + WMEM_JUMBO_HEADER_SIZE));
+        chunk->len = JUMBO_MAGIC;
+
+        return WMEM_CHUNK_TO_DATA(chunk);
+    }
+
+    arena = wmem_block_mt_find_arena(allocator);
+
+    real_size = (gint32)(WMEM_ALIGN_SIZE(size) + WMEM_CHUNK_HEADER_SIZE);
+
+    /* Get a new block if necessary. */
+    if (!arena->block_list ||
+            (WMEM_BLOCK_SIZE - arena->block_list->pos) < real_size) {
+        wmem_block_mt_new_block(allocator, arena);
+    }
+
+    chunk = (wmem_block_mt_chunk_t *) ((guint8 *) arena->block_list + arena->block_list->pos);
+    /* safe to cast, size smaller than WMEM_BLOCK_MAX_ALLOC_SIZE */
+    chunk->len = (guint32) size;
+
+    arena->block_list->pos += real_size;
+
+    /* and return the user's pointer */
+    return WMEM_CHUNK_TO_DATA(chunk);
+}
+
+static void
+wmem_block_mt_free(void *private_data _U_, void *ptr _U_)
+{
+   /* free is NOP */
+}
+
+static void *
+wmem_block_mt_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_block_mt_allocator_t *allocator = (wmem_block_mt_allocator_t*) private_data;
+    wmem_block_mt_chunk_t     *chunk;
+
+    chunk = WMEM_DATA_TO_CHUNK(ptr);
+
+    if (chunk->len == JUMBO_MAGIC) {
+        wmem_block_mt_jumbo_t *block;
+
+        block = ((wmem_block_mt_jumbo_t*)((guint8*)(chunk) - WMEM_JUMBO_HEADER_SIZE));
+
+        /* the neighbours' links may be changed by other threads meanwhile */
+        g_mutex_lock(&allocator->lock);
+        block =  (wmem_block_mt_jumbo_t*)wmem_realloc(NULL, block,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        if (block->prev) {
+            block->prev->next = block;
+        }
+        else {
+            allocator->jumbo_list = block;
+        }
+        if (block->next) {
+            block->next->prev = block;
+        }
+        g_mutex_unlock(&allocator->lock);
+
+        return ((void*)((guint8*)(block) + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE));
+    }
+    else if (chunk->len < size) {
+        /* grow */
+        void *newptr;
+
+        /* need to alloc and copy; free is no-op, so don't call it */
+        newptr = wmem_block_mt_alloc(private_data, size);
+        memcpy(newptr, ptr, chunk->len);
+
+        return newptr;
+    }
+
+    /* shrink or same space - great we can do nothing */
+    return ptr;
+}
+
+static void
+wmem_block_mt_free_all(void *private_data)
+{
+    wmem_block_mt_allocator_t *allocator = (wmem_block_mt_allocator_t*) private_data;
+    wmem_block_mt_arena_t     *arena;
+    wmem_block_mt_hdr_t       *cur, *nxt, *free_blocks;
+    wmem_block_mt_jumbo_t     *cur_jum, *nxt_jum;
+
+    g_mutex_lock(&allocator->lock);
+
+    /* move the blocks of every arena to the free stack, keeping the arenas
+     * themselves since the threads' caches point to them */
+    free_blocks = (wmem_block_mt_hdr_t *)g_atomic_pointer_get(&allocator->free_blocks);
+    for (arena = allocator->arenas; arena; arena = arena->next) {
+        cur = arena->block_list;
+        while (cur) {
+            nxt = cur->next;
+            cur->next = free_blocks;
+            free_blocks = cur;
+            cur = nxt;
+        }
+        arena->block_list = NULL;
+    }
+    g_atomic_pointer_set(&allocator->free_blocks, free_blocks);
+
+    /* now do the jumbo blocks, freeing all of them */
+    cur_jum = allocator->jumbo_list;
+    while (cur_jum) {
+        nxt_jum  = cur_jum->next;
+        wmem_free(NULL, cur_jum);
+        cur_jum = nxt_jum;
+    }
+    allocator->jumbo_list = NULL;
+
+    g_mutex_unlock(&allocator->lock);
+}
+
+static void
+wmem_block_mt_gc(void *private_data)
+{
+    wmem_block_mt_allocator_t *allocator = (wmem_block_mt_allocator_t*) private_data;
+    wmem_block_mt_hdr_t       *cur, *nxt;
+
+    cur = (wmem_block_mt_hdr_t *)g_atomic_pointer_get(&allocator->free_blocks);
+    g_atomic_pointer_set(&allocator->free_blocks, NULL);
+
+    while (cur) {
+        nxt = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+}
+
+static void
+wmem_block_mt_allocator_cleanup(void *private_data)
+{
+    wmem_block_mt_allocator_t *allocator = (wmem_block_mt_allocator_t*) private_data;
+    wmem_block_mt_arena_t     *arena, *next;
+
+    /* wmem guarantees that free_all() is called directly before this, so
+     * all the blocks are on the free stack */
+    wmem_block_mt_gc(private_data);
+
+    for (arena = allocator->arenas; arena; arena = next) {
+        next = arena->next;
+        wmem_free(NULL, arena);
+    }
+
+    g_mutex_clear(&allocator->lock);
+
+    /* then just free the allocator structs */
+    wmem_free(NULL, private_data);
+}
+
+void
+wmem_block_mt_allocator_init(wmem_allocator_t *allocator)
+{
+    wmem_block_mt_allocator_t *block_allocator;
+
+    block_allocator = wmem_new0(NULL, wmem_block_mt_allocator_t);
+
+    allocator->walloc   = &wmem_block_mt_alloc;
+    allocator->wrealloc = &wmem_block_mt_realloc;
+    allocator->wfree    = &wmem_block_mt_free;
+
+    allocator->free_all = &wmem_block_mt_free_all;
+    allocator->gc       = &wmem_block_mt_gc;
+    allocator->cleanup  = &wmem_block_mt_allocator_cleanup;
+
+    allocator->private_data = (void*) block_allocator;
+
+    /* 0 is never used, so that it matches no fresh cache */
+    do {
+        block_allocator->id = (guint)g_atomic_int_add(&wmem_block_mt_last_id, 1) + 1;
+    } while (block_allocator->id == 0);
+    g_mutex_init(&block_allocator->lock);
+    block_allocator->arenas      = NULL;
+    block_allocator->jumbo_list  = NULL;
+    block_allocator->free_blocks = NULL;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -21,6 +21,7 @@
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_mt.h"
 #include "wmem_allocator_strict.h"
 
 #include <wsutil/ws_printf.h> /* ws_g_warning */
@@ -155,6 +156,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_MT:
+            wmem_block_mt_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -188,15 +192,19 @@ wmem_init(void)
         if (strncmp(override_env, "simple", strlen("simple")) == 0) {
             override_type = WMEM_ALLOCATOR_SIMPLE;
         }
+        /* "block" is a prefix of the next two, so check it after them */
+        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
+            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
+        }
+        else if (strncmp(override_env, "block_mt", strlen("block_mt")) == 0) {
+            override_type = WMEM_ALLOCATOR_BLOCK_MT;
+        }
         else if (strncmp(override_env, "block", strlen("block")) == 0) {
             override_type = WMEM_ALLOCATOR_BLOCK;
         }
         else if (strncmp(override_env, "strict", strlen("strict")) == 0) {
             override_type = WMEM_ALLOCATOR_STRICT;
         }
-        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
-            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
-        }
         else {
             ws_g_warning("Unrecognized wmem override");
             do_override = FALSE;
@@ -54,11 +54,16 @@ typedef enum _wmem_allocator_type_t {
                 memory usage via things like canaries and scrubbing freed
                 memory. Valgrind is the better choice on platforms that support
                 it. */
-    WMEM_ALLOCATOR_BLOCK_FAST /**< A block allocator like WMEM_ALLOCATOR_BLOCK
+    WMEM_ALLOCATOR_BLOCK_FAST, /**< A block allocator like WMEM_ALLOCATOR_BLOCK
                 but even faster by tracking absolutely minimal metadata and
                 making 'free' a no-op. Useful only for very short-lived scopes
                 where there's no reason to free individual allocations because
                 the next free_all is always just around the corner. */
+    WMEM_ALLOCATOR_BLOCK_MT /**< Like WMEM_ALLOCATOR_BLOCK_FAST, but safe to
+                allocate from (and reallocate) in several threads at once, each
+                thread getting blocks of its own. free_all, gc and destroying
+                the allocator must still only be done while no other thread
+                is using it. */
 } wmem_allocator_type_t;
 
 /** Allocate the requested amount of memory in the given pool.
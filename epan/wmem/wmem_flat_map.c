@@ -0,0 +1,194 @@
+/* wmem_flat_map.c
+ * Wireshark Memory Manager Flat Map
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_flat_map.h"
+
+/* Initial number of entries allocated on the first insert. */
+#define WMEM_FLAT_MAP_INITIAL_SIZE 8
+
+/* Holds a sorted, wmem-allocated map.
+ *  keys and values are parallel arrays of alloc_count entries, of which the
+ *      first count are used; keys is kept sorted in ascending order. Keeping
+ *      the keys apart from the values means a binary search only touches the
+ *      (densely packed) key array.
+ */
+struct _wmem_flat_map_t {
+    wmem_allocator_t *allocator;
+
+    guint32 *keys;
+    void   **values;
+
+    guint count;
+    guint alloc_count;
+};
+
+wmem_flat_map_t *
+wmem_flat_map_new(wmem_allocator_t *allocator)
+{
+    wmem_flat_map_t *map;
+
+    map = wmem_new(allocator, wmem_flat_map_t);
+
+    map->allocator   = allocator;
+    map->keys        = NULL;
+    map->values      = NULL;
+    map->count       = 0;
+    map->alloc_count = 0;
+
+    return map;
+}
+
+gboolean
+wmem_flat_map_is_empty(wmem_flat_map_t *map)
+{
+    return map->count == 0;
+}
+
+guint
+wmem_flat_map_count(wmem_flat_map_t *map)
+{
+    return map->count;
+}
+
+/* Returns the index of the first entry whose key is strictly greater than
+ * key, or map->count if there is none. The entry at the returned index - 1
+ * (if any) is therefore the largest key less than or equal to key. */
+static guint
+wmem_flat_map_upper_bound(const wmem_flat_map_t *map, guint32 key)
+{
+    guint low, high, mid;
+
+    /* Fast path: in-order streams almost always look up at or past the
+     * most recently added key. */
+    if (map->count == 0 || key >= map->keys[map->count - 1]) {
+        return map->count;
+    }
+
+    low  = 0;
+    high = map->count - 1;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (map->keys[mid] > key) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
+        }
+    }
+
+    return low;
+}
+
+static void
+wmem_flat_map_grow(wmem_flat_map_t *map)
+{
+    guint new_alloc_count;
+
+    if (map->count < map->alloc_count) {
+        return;
+    }
+
+    new_alloc_count = map->alloc_count ? map->alloc_count * 2 : WMEM_FLAT_MAP_INITIAL_SIZE;
+
+    map->keys = (guint32 *)wmem_realloc(map->allocator, map->keys,
+            new_alloc_count * sizeof(guint32));
+    map->values = (void **)wmem_realloc(map->allocator, map->values,
+            new_alloc_count * sizeof(void *));
+
+    map->alloc_count = new_alloc_count;
+}
+
+void
+wmem_flat_map_insert32(wmem_flat_map_t *map, guint32 key, void *data)
+{
+    guint pos;
+
+    pos = wmem_flat_map_upper_bound(map, key);
+
+    if (pos > 0 && map->keys[pos - 1] == key) {
+        map->values[pos - 1] = data;
+        return;
+    }
+
+    wmem_flat_map_grow(map);
+
+    if (pos < map->count) {
+        memmove(&map->keys[pos + 1], &map->keys[pos],
+                (map->count - pos) * sizeof(guint32));
+        memmove(&map->values[pos + 1], &map->values[pos],
+                (map->count - pos) * sizeof(void *));
+    }
+
+    map->keys[pos]   = key;
+    map->values[pos] = data;
+    map->count++;
+}
+
+void *
+wmem_flat_map_lookup32(wmem_flat_map_t *map, guint32 key)
+{
+    guint pos;
+
+    pos = wmem_flat_map_upper_bound(map, key);
+
+    if (pos > 0 && map->keys[pos - 1] == key) {
+        return map->values[pos - 1];
+    }
+
+    return NULL;
+}
+
+void *
+wmem_flat_map_lookup32_le(wmem_flat_map_t *map, guint32 key)
+{
+    guint pos;
+
+    pos = wmem_flat_map_upper_bound(map, key);
+
+    if (pos > 0) {
+        return map->values[pos - 1];
+    }
+
+    return NULL;
+}
+
+gboolean
+wmem_flat_map_foreach(wmem_flat_map_t *map, wmem_foreach_func callback,
+        void *user_data)
+{
+    guint i;
+
+    for (i = 0; i < map->count; i++) {
+        if (callback(&map->keys[i], map->values[i], user_data)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
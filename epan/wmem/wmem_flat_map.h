@@ -0,0 +1,117 @@
+/* wmem_flat_map.h
+ * Definitions for the Wireshark Memory Manager Flat Map
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_FLAT_MAP_H__
+#define __WMEM_FLAT_MAP_H__
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_tree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wmem
+ *  @{
+ *    @defgroup wmem-flat-map Flat Map
+ *
+ *    An ordered map from guint32 keys to values, stored as two parallel
+ *    sorted arrays instead of a tree of individually allocated nodes. It
+ *    offers the same insert/lookup semantics as the guint32 functions of
+ *    wmem_tree, including wmem_flat_map_lookup32_le, but lookups are a binary
+ *    search over a contiguous key array and no allocation is done per entry.
+ *
+ *    It is intended for indexes that are (mostly) filled in ascending key
+ *    order, such as the per-flow tables of PDUs kept by stream reassemblers
+ *    keyed on sequence numbers: appending past the current maximum key is
+ *    O(1) amortized, as is looking up any key at or above it. Inserting in
+ *    the middle is O(n) as the tail has to be moved, so it is a poor choice
+ *    for randomly ordered keys; use wmem_tree for those.
+ *
+ *    @{
+ */
+
+struct _wmem_flat_map_t;
+typedef struct _wmem_flat_map_t wmem_flat_map_t;
+
+/** Creates an empty map with the given allocator scope. No storage for
+ * entries is allocated until the first insert. When the scope is emptied,
+ * the map is fully destroyed. */
+WS_DLL_PUBLIC
+wmem_flat_map_t *
+wmem_flat_map_new(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
+/** Returns true if the map is empty (has no entries). */
+WS_DLL_PUBLIC
+gboolean
+wmem_flat_map_is_empty(wmem_flat_map_t *map);
+
+/** Returns the number of entries in the map. */
+WS_DLL_PUBLIC
+guint
+wmem_flat_map_count(wmem_flat_map_t *map);
+
+/** Insert a value indexed by a guint32 key.
+ *
+ * As with wmem_tree_insert32, if the key already exists in the map the old
+ * value is simply overwritten.
+ */
+WS_DLL_PUBLIC
+void
+wmem_flat_map_insert32(wmem_flat_map_t *map, guint32 key, void *data);
+
+/** Look up a value indexed by a guint32 key. If no entry is found the
+ * function will return NULL.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_flat_map_lookup32(wmem_flat_map_t *map, guint32 key);
+
+/** Look up a value indexed by a guint32 key.
+ * Returns the value that has the largest key that is less than or equal
+ * to the search key, or NULL if no such key exists.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_flat_map_lookup32_le(wmem_flat_map_t *map, guint32 key);
+
+/** Traverse the map in ascending key order and call callback(key, value,
+ * userdata) for each entry. The key passed to the callback is a pointer to
+ * the guint32 key. If callback returns TRUE the traversal stops and this
+ * function returns TRUE as well. */
+WS_DLL_PUBLIC
+gboolean
+wmem_flat_map_foreach(wmem_flat_map_t *map, wmem_foreach_func callback,
+        void *user_data);
+
+/**   @}
+ *  @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_FLAT_MAP_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
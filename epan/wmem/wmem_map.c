@@ -10,8 +10,14 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "wmem_core.h"
 #include "wmem_list.h"
 #include "wmem_map.h"
@@ -41,6 +47,12 @@ typedef struct _wmem_map_item_t {
     struct _wmem_map_item_t *next;
 } wmem_map_item_t;
 
+/* A slot of an open addressing map */
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void *value;
+} wmem_map_slot_t;
+
 struct _wmem_map_t {
     guint count; /* number of items stored */
 
@@ -52,6 +64,12 @@ struct _wmem_map_t {
 
     wmem_map_item_t **table;
 
+    /* Open addressing maps only (see below); table is unused. */
+    gboolean         open_addressing;
+    guint8          *ctrl;
+    wmem_map_slot_t *slots;
+    guint            growth_left; /* items that can be inserted into empty slots before growing */
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -90,7 +108,7 @@ wmem_map_new(wmem_allocator_t *allocator,
 {
     wmem_map_t *map;
 
-    map = wmem_new(allocator, wmem_map_t);
+    map = wmem_new0(allocator, wmem_map_t);
 
     map->hash_func = hash_func;
     map->eql_func  = eql_func;
@@ -102,6 +120,18 @@ wmem_map_new(wmem_allocator_t *allocator,
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_open_addressing(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->open_addressing = TRUE;
+
+    return map;
+}
+
 static gboolean
 wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
         void *user_data)
@@ -110,6 +140,8 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 
     map->count = 0;
     map->table = NULL;
+    map->ctrl  = NULL;
+    map->slots = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->master, map->master_cb_id);
@@ -136,7 +168,7 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
 {
     wmem_map_t *map;
 
-    map = wmem_new(master, wmem_map_t);
+    map = wmem_new0(master, wmem_map_t);
 
     map->hash_func = hash_func;
     map->eql_func  = eql_func;
@@ -151,6 +183,273 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_autoreset_open_addressing(wmem_allocator_t *master, wmem_allocator_t *slave,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(master, slave, hash_func, eql_func);
+    map->open_addressing = TRUE;
+
+    return map;
+}
+
+/*
+ * Open addressing maps.
+ *
+ * The items are stored in an array of slots, without any per-item
+ * allocation, and each slot has a control byte in a separate array: either
+ * CTRL_EMPTY, CTRL_DELETED (a removed item, which lookups have to probe
+ * past) or, for a slot holding an item, 7 other bits of the hash of its
+ * key. A lookup starts at the slot given by the top bits of the hash and
+ * checks the control bytes of OA_GROUP_WIDTH slots at a time (with a
+ * single SSE2 comparison where available), only calling the equality
+ * function for the slots whose control byte matches, until it finds the
+ * key or a group with an empty slot. Successive groups are probed at
+ * triangular offsets, which visits every group of a power-of-2 table.
+ *
+ * The first OA_GROUP_WIDTH control bytes are repeated after the last one,
+ * so that a group starting near the end of the table can be loaded in one
+ * go. At most 7/8 of the slots are used; when there are no empty slots
+ * left, the table is rebuilt, twice as large unless enough of the used
+ * slots were only holding removed items.
+ */
+
+#define OA_GROUP_WIDTH   16
+#define OA_MIN_CAPACITY  4 /* base-2 logarithm; 2^4 slots is one group */
+#define CTRL_EMPTY       ((guint8)0x80)
+#define CTRL_DELETED     ((guint8)0xFE)
+#define CTRL_IS_FULL(c)  (((c) & 0x80) == 0)
+
+#define OA_MAX_LOAD(CAP) ((CAP) - (CAP) / 8)
+
+/* The universal hash of the key; the position is taken from its top bits,
+ * as in the chained maps. */
+#define OA_HASH(MAP, KEY) ((guint32)((MAP)->hash_func(KEY) * x))
+#define OA_POS(MAP, HASH) ((size_t)((HASH) >> (32 - (MAP)->capacity)))
+
+/* The control byte of a hash: 7 bits of it that don't depend on the
+ * position, mixed with the finalization step of MurmurHash3 so that they
+ * also depend on its top bits. */
+static inline guint8
+wmem_map_oa_h2(guint32 h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    return (guint8)(h & 0x7f);
+}
+
+/* Bit i of the result is set if the control byte of slot pos+i equals c. */
+static inline guint32
+wmem_map_oa_match(const guint8 *group, guint8 c)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (guint32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)c)));
+#else
+    guint32 mask = 0;
+    int i;
+
+    for (i = 0; i < OA_GROUP_WIDTH; i++) {
+        if (group[i] == c)
+            mask |= 1U << i;
+    }
+    return mask;
+#endif
+}
+
+/* Bit i of the result is set if slot pos+i is empty or deleted. */
+static inline guint32
+wmem_map_oa_match_free(const guint8 *group)
+{
+#ifdef __SSE2__
+    return (guint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    guint32 mask = 0;
+    int i;
+
+    for (i = 0; i < OA_GROUP_WIDTH; i++) {
+        if (!CTRL_IS_FULL(group[i]))
+            mask |= 1U << i;
+    }
+    return mask;
+#endif
+}
+
+static inline void
+wmem_map_oa_set_ctrl(wmem_map_t *map, size_t i, guint8 c)
+{
+    map->ctrl[i] = c;
+    if (i < OA_GROUP_WIDTH)
+        map->ctrl[CAPACITY(map) + i] = c;
+}
+
+/* Returns the index of the slot holding key, or -1. */
+static gssize
+wmem_map_oa_find(const wmem_map_t *map, const void *key)
+{
+    size_t  mask = CAPACITY(map) - 1;
+    guint32 hash = OA_HASH(map, key);
+    guint8  h2 = wmem_map_oa_h2(hash);
+    size_t  pos = OA_POS(map, hash);
+    size_t  stride = 0;
+    guint32 matches;
+
+    for (;;) {
+        const guint8 *group = &map->ctrl[pos];
+
+        matches = wmem_map_oa_match(group, h2);
+        while (matches) {
+            size_t i = (pos + (size_t)g_bit_nth_lsf(matches, -1)) & mask;
+
+            if (map->eql_func(key, map->slots[i].key))
+                return (gssize)i;
+            matches &= matches - 1;
+        }
+        if (wmem_map_oa_match(group, CTRL_EMPTY))
+            return -1;
+
+        stride += OA_GROUP_WIDTH;
+        pos = (pos + stride) & mask;
+    }
+}
+
+/* Returns the index of the first empty or deleted slot on the probe
+ * sequence of hash. */
+static size_t
+wmem_map_oa_find_free(const wmem_map_t *map, guint32 hash)
+{
+    size_t  mask = CAPACITY(map) - 1;
+    size_t  pos = OA_POS(map, hash);
+    size_t  stride = 0;
+    guint32 matches;
+
+    for (;;) {
+        matches = wmem_map_oa_match_free(&map->ctrl[pos]);
+        if (matches)
+            return (pos + (size_t)g_bit_nth_lsf(matches, -1)) & mask;
+
+        stride += OA_GROUP_WIDTH;
+        pos = (pos + stride) & mask;
+    }
+}
+
+static void
+wmem_map_oa_alloc(wmem_map_t *map, size_t log2_capacity)
+{
+    size_t capacity = ((size_t)1) << log2_capacity;
+
+    map->capacity    = log2_capacity;
+    map->ctrl        = (guint8 *)wmem_alloc(map->allocator, capacity + OA_GROUP_WIDTH);
+    map->slots       = wmem_alloc_array(map->allocator, wmem_map_slot_t, capacity);
+    map->growth_left = (guint)(OA_MAX_LOAD(capacity) - map->count);
+    memset(map->ctrl, CTRL_EMPTY, capacity + OA_GROUP_WIDTH);
+}
+
+/* Rebuild the table, dropping the deleted slots, and making it larger if
+ * it is more than half full. */
+static void
+wmem_map_oa_rehash(wmem_map_t *map)
+{
+    guint8          *old_ctrl  = map->ctrl;
+    wmem_map_slot_t *old_slots = map->slots;
+    size_t           old_cap   = CAPACITY(map);
+    size_t           log2_capacity = map->capacity;
+    size_t           i, slot;
+    guint32          hash;
+
+    if (map->count >= OA_MAX_LOAD(old_cap) / 2)
+        log2_capacity++;
+    wmem_map_oa_alloc(map, log2_capacity);
+
+    for (i = 0; i < old_cap; i++) {
+        if (!CTRL_IS_FULL(old_ctrl[i]))
+            continue;
+        hash = OA_HASH(map, old_slots[i].key);
+        slot = wmem_map_oa_find_free(map, hash);
+        wmem_map_oa_set_ctrl(map, slot, wmem_map_oa_h2(hash));
+        map->slots[slot] = old_slots[i];
+    }
+
+    wmem_free(map->allocator, old_ctrl);
+    wmem_free(map->allocator, old_slots);
+}
+
+static void *
+wmem_map_oa_insert(wmem_map_t *map, const void *key, void *value)
+{
+    gssize  found;
+    size_t  slot;
+    guint32 hash;
+    void   *old_val;
+
+    if (map->ctrl == NULL) {
+        map->count = 0;
+        wmem_map_oa_alloc(map, OA_MIN_CAPACITY);
+    } else {
+        found = wmem_map_oa_find(map, key);
+        if (found >= 0) {
+            /* replace and return old value for this key */
+            old_val = map->slots[found].value;
+            map->slots[found].value = value;
+            return old_val;
+        }
+    }
+
+    hash = OA_HASH(map, key);
+    slot = wmem_map_oa_find_free(map, hash);
+    if (map->growth_left == 0 && map->ctrl[slot] == CTRL_EMPTY) {
+        wmem_map_oa_rehash(map);
+        slot = wmem_map_oa_find_free(map, hash);
+    }
+    if (map->ctrl[slot] == CTRL_EMPTY)
+        map->growth_left--;
+    wmem_map_oa_set_ctrl(map, slot, wmem_map_oa_h2(hash));
+    map->slots[slot].key   = key;
+    map->slots[slot].value = value;
+    map->count++;
+
+    return NULL;
+}
+
+static gboolean
+wmem_map_oa_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key, void **value)
+{
+    gssize found;
+
+    if (map->ctrl == NULL)
+        return FALSE;
+
+    found = wmem_map_oa_find(map, key);
+    if (found < 0)
+        return FALSE;
+    if (orig_key)
+        *orig_key = map->slots[found].key;
+    if (value)
+        *value = map->slots[found].value;
+    return TRUE;
+}
+
+static gboolean
+wmem_map_oa_remove(wmem_map_t *map, const void *key, void **value)
+{
+    gssize found;
+
+    if (map->ctrl == NULL)
+        return FALSE;
+
+    found = wmem_map_oa_find(map, key);
+    if (found < 0)
+        return FALSE;
+    if (value)
+        *value = map->slots[found].value;
+    wmem_map_oa_set_ctrl(map, (size_t)found, CTRL_DELETED);
+    map->count--;
+    return TRUE;
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map)
 {
@@ -189,6 +488,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->open_addressing) {
+        return wmem_map_oa_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -231,6 +534,10 @@ wmem_map_contains(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->open_addressing) {
+        return wmem_map_oa_lookup_extended(map, key, NULL, NULL);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -255,6 +562,13 @@ wmem_map_lookup(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->open_addressing) {
+        void *value = NULL;
+
+        wmem_map_oa_lookup_extended(map, key, NULL, &value);
+        return value;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -279,6 +593,10 @@ wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key
 {
     wmem_map_item_t *item;
 
+    if (map->open_addressing) {
+        return wmem_map_oa_lookup_extended(map, key, orig_key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -310,6 +628,12 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map->open_addressing) {
+        value = NULL;
+        wmem_map_oa_remove(map, key, &value);
+        return value;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -341,6 +665,10 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map->open_addressing) {
+        return wmem_map_oa_remove(map, key, NULL);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -372,6 +700,18 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->open_addressing) {
+        if (map->ctrl != NULL) {
+            capacity = CAPACITY(map);
+            for (i=0; i<capacity; i++) {
+                if (CTRL_IS_FULL(map->ctrl[i])) {
+                    wmem_list_prepend(list, (void*)map->slots[i].key);
+                }
+            }
+        }
+        return list;
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -394,6 +734,18 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map->open_addressing) {
+        if (map->ctrl == NULL) {
+            return;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (CTRL_IS_FULL(map->ctrl[i])) {
+                foreach_func((gpointer)map->slots[i].key, map->slots[i].value, user_data);
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return;
@@ -76,6 +76,32 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
         GHashFunc hash_func, GEqualFunc eql_func)
 G_GNUC_MALLOC;
 
+/** Creates a map like wmem_map_new(), but which keeps its items in a single
+ * open addressing table instead of in per-bucket lists. It doesn't allocate
+ * anything per item, and lookups compare the keys of a whole group of slots
+ * at once (using SSE2 when available), which makes it faster for maps of
+ * many small items that are looked up much more often than they are
+ * removed.
+ *
+ * All the other wmem_map functions work the same on both kinds of map,
+ * except that the order of wmem_map_foreach() and wmem_map_get_keys() is
+ * different.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_open_addressing(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
+/** Creates an open addressing map (see wmem_map_new_open_addressing()) with
+ * two allocator scopes, as wmem_map_new_autoreset() does.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_autoreset_open_addressing(wmem_allocator_t *master, wmem_allocator_t *slave,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
 /** Inserts a value into the map.
  *
  * @param map The map to insert into.
@@ -33,41 +33,102 @@
  * We do, however, use some extra booleans and a mountain of assertions to try
  * and catch anybody accessing the pools out of the correct scope. It's not
  * perfect, but it should stop most of the bad behaviour that emem permitted.
+ *
+ * For dissecting in several threads, each thread can have a packet scope of
+ * its own, which it then gets instead of the global one, and the file scope
+ * can be made an allocator that all of them can use at once. The epan scope
+ * is left alone, as it is only supposed to be used when nothing else runs.
  */
 
-/* TODO: Make these thread-local */
 static wmem_allocator_t *packet_scope = NULL;
 static wmem_allocator_t *file_scope   = NULL;
 static wmem_allocator_t *epan_scope   = NULL;
 
+static gboolean thread_safe_file_scope = FALSE;
+
+/* The packet scopes of the threads that have one, and how many they are, so
+ * that the threads of programs that have none don't have to look. */
+static GPrivate thread_packet_scope;
+static gint     thread_packet_scopes = 0;
+
 /* Packet Scope */
 
+static inline wmem_allocator_t *
+wmem_current_packet_scope(void)
+{
+    wmem_allocator_t *scope;
+
+    if (g_atomic_int_get(&thread_packet_scopes) > 0) {
+        scope = (wmem_allocator_t *)g_private_get(&thread_packet_scope);
+        if (scope) {
+            return scope;
+        }
+    }
+
+    return packet_scope;
+}
+
 wmem_allocator_t *
 wmem_packet_scope(void)
 {
-    g_assert(packet_scope);
+    wmem_allocator_t *scope = wmem_current_packet_scope();
 
-    return packet_scope;
+    g_assert(scope);
+
+    return scope;
 }
 
 void
 wmem_enter_packet_scope(void)
 {
-    g_assert(packet_scope);
+    wmem_allocator_t *scope = wmem_current_packet_scope();
+
+    g_assert(scope);
     g_assert(file_scope->in_scope);
-    g_assert(!packet_scope->in_scope);
+    g_assert(!scope->in_scope);
 
-    packet_scope->in_scope = TRUE;
+    scope->in_scope = TRUE;
 }
 
 void
 wmem_leave_packet_scope(void)
 {
-    g_assert(packet_scope);
-    g_assert(packet_scope->in_scope);
+    wmem_allocator_t *scope = wmem_current_packet_scope();
 
-    wmem_free_all(packet_scope);
-    packet_scope->in_scope = FALSE;
+    g_assert(scope);
+    g_assert(scope->in_scope);
+
+    wmem_free_all(scope);
+    scope->in_scope = FALSE;
+}
+
+void
+wmem_init_thread_packet_scope(void)
+{
+    wmem_allocator_t *scope;
+
+    g_assert(g_private_get(&thread_packet_scope) == NULL);
+
+    scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    scope->in_scope = FALSE;
+
+    g_private_set(&thread_packet_scope, scope);
+    g_atomic_int_inc(&thread_packet_scopes);
+}
+
+void
+wmem_cleanup_thread_packet_scope(void)
+{
+    wmem_allocator_t *scope;
+
+    scope = (wmem_allocator_t *)g_private_get(&thread_packet_scope);
+    g_assert(scope);
+    g_assert(scope->in_scope == FALSE);
+
+    g_private_set(&thread_packet_scope, NULL);
+    g_atomic_int_add(&thread_packet_scopes, -1);
+
+    wmem_destroy_allocator(scope);
 }
 
 /* File Scope */
@@ -116,6 +177,14 @@ wmem_epan_scope(void)
 
 /* Scope Management */
 
+void
+wmem_set_thread_safe_file_scope(void)
+{
+    g_assert(file_scope == NULL);
+
+    thread_safe_file_scope = TRUE;
+}
+
 void
 wmem_init_scopes(void)
 {
@@ -124,7 +193,8 @@ wmem_init_scopes(void)
     g_assert(epan_scope   == NULL);
 
     packet_scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
-    file_scope   = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    file_scope   = wmem_allocator_new(thread_safe_file_scope ?
+            WMEM_ALLOCATOR_BLOCK_MT : WMEM_ALLOCATOR_BLOCK);
     epan_scope   = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
 
     /* Scopes are initialized to TRUE by default on creation */
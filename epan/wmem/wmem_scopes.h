@@ -38,6 +38,23 @@ WS_DLL_LOCAL
 void
 wmem_leave_packet_scope(void);
 
+/** Gives the calling thread a packet scope of its own, which it gets from
+ * wmem_packet_scope() (and enters and leaves when it dissects a packet)
+ * instead of the global one, until it calls
+ * wmem_cleanup_thread_packet_scope(). Threads that dissect in parallel must
+ * each have one.
+ */
+WS_DLL_PUBLIC
+void
+wmem_init_thread_packet_scope(void);
+
+/** Destroys the packet scope of the calling thread, which must not be in
+ * it; the thread goes back to using the global packet scope.
+ */
+WS_DLL_PUBLIC
+void
+wmem_cleanup_thread_packet_scope(void);
+
 /* File Scope */
 
 WS_DLL_PUBLIC
@@ -54,6 +71,15 @@ wmem_leave_file_scope(void);
 
 /* Scope Management */
 
+/** Makes the file scope a WMEM_ALLOCATOR_BLOCK_MT allocator, which several
+ * threads can allocate from at once. Frees in it are no-ops, so it uses more
+ * memory than the default one. Must be called before wmem_init(), i.e.
+ * before epan_init().
+ */
+WS_DLL_PUBLIC
+void
+wmem_set_thread_safe_file_scope(void);
+
 WS_DLL_LOCAL
 void
 wmem_init_scopes(void);
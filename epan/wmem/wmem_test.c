@@ -19,6 +19,7 @@
 #include "wmem_allocator.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_mt.h"
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_strict.h"
 
@@ -54,6 +55,9 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_MT:
+            wmem_block_mt_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -369,6 +373,139 @@ wmem_test_allocator_strict(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_STRICT, &wmem_strict_check_canaries);
 }
 
+static void
+wmem_test_allocator_block_mt(void)
+{
+    wmem_test_allocator(WMEM_ALLOCATOR_BLOCK_MT, NULL,
+            MAX_SIMULTANEOUS_ALLOCS*4);
+    wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK_MT, NULL);
+}
+
+#define MT_THREADS       8
+#define MT_ROUNDS        4
+#define MT_ALLOCS        (16 * 1024)
+
+typedef struct {
+    wmem_allocator_t *allocator;
+    guint8            fill;
+    guint32           seed;
+    guint             allocs;
+    gboolean          use_packet_scope;
+    guint8          **ptrs;
+    gsize            *lens;
+} wmem_test_mt_thread_t;
+
+/* Allocates (and sometimes reallocates) blocks of random sizes, a few of them
+ * jumbo ones, filling each with the thread's byte, then checks that no other
+ * thread wrote over them. */
+static gpointer
+wmem_test_mt_thread(gpointer data)
+{
+    wmem_test_mt_thread_t *t = (wmem_test_mt_thread_t *)data;
+    GRand *rand = g_rand_new_with_seed(t->seed);
+    wmem_allocator_t *packet_scope = NULL;
+    guint i;
+    gsize j;
+
+    if (t->use_packet_scope) {
+        wmem_init_thread_packet_scope();
+        wmem_enter_packet_scope();
+        packet_scope = wmem_packet_scope();
+    }
+
+    for (i = 0; i < t->allocs; i++) {
+        if (i % 4096 == 4095) {
+            t->lens[i] = 3*1024*1024;
+        } else {
+            t->lens[i] = g_rand_int_range(rand, 1, 512);
+        }
+        t->ptrs[i] = (guint8 *)wmem_alloc(t->allocator, t->lens[i]);
+        memset(t->ptrs[i], t->fill, t->lens[i]);
+        if (i > 0 && g_rand_boolean(rand)) {
+            gsize len = t->lens[i-1] + g_rand_int_range(rand, 0, 512);
+
+            t->ptrs[i-1] = (guint8 *)wmem_realloc(t->allocator, t->ptrs[i-1], len);
+            memset(t->ptrs[i-1], t->fill, len);
+            t->lens[i-1] = len;
+        }
+        if (packet_scope) {
+            g_assert(wmem_packet_scope() == packet_scope);
+            memset(wmem_alloc(packet_scope, 64), t->fill, 64);
+        }
+    }
+
+    for (i = 0; i < t->allocs; i++) {
+        for (j = 0; j < t->lens[i]; j++) {
+            g_assert(t->ptrs[i][j] == t->fill);
+        }
+    }
+
+    if (packet_scope) {
+        wmem_leave_packet_scope();
+        wmem_cleanup_thread_packet_scope();
+    }
+
+    g_rand_free(rand);
+    return NULL;
+}
+
+static void
+wmem_test_mt_run(wmem_allocator_t *allocator, wmem_test_mt_thread_t *threads,
+        guint num_threads, guint allocs, gboolean use_packet_scope)
+{
+    GThread *ids[MT_THREADS];
+    guint i;
+
+    for (i = 0; i < num_threads; i++) {
+        threads[i].allocator = allocator;
+        threads[i].fill = (guint8)(i + 1);
+        threads[i].seed = g_test_rand_int();
+        threads[i].allocs = allocs;
+        threads[i].use_packet_scope = use_packet_scope;
+        ids[i] = g_thread_new("wmem_test", wmem_test_mt_thread, &threads[i]);
+    }
+    for (i = 0; i < num_threads; i++) {
+        g_thread_join(ids[i]);
+    }
+}
+
+static void
+wmem_test_allocator_block_mt_threads(void)
+{
+    wmem_allocator_t      *allocator;
+    wmem_test_mt_thread_t  threads[MT_THREADS];
+    wmem_allocator_t      *packet_scope;
+    guint                  i, round;
+
+    for (i = 0; i < MT_THREADS; i++) {
+        threads[i].ptrs = g_new(guint8 *, MT_ALLOCS);
+        threads[i].lens = g_new(gsize, MT_ALLOCS);
+    }
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK_MT);
+
+    /* the blocks released by each free_all are reused by the next round */
+    for (round = 0; round < MT_ROUNDS; round++) {
+        wmem_test_mt_run(allocator, threads, MT_THREADS, MT_ALLOCS, FALSE);
+        wmem_free_all(allocator);
+    }
+    wmem_gc(allocator);
+
+    /* the same with each thread using a packet scope of its own */
+    packet_scope = wmem_packet_scope();
+    wmem_enter_file_scope();
+    wmem_test_mt_run(allocator, threads, MT_THREADS, MT_ALLOCS, TRUE);
+    wmem_leave_file_scope();
+    g_assert(wmem_packet_scope() == packet_scope);
+
+    wmem_destroy_allocator(allocator);
+
+    for (i = 0; i < MT_THREADS; i++) {
+        g_free(threads[i].ptrs);
+        g_free(threads[i].lens);
+    }
+}
+
 /* UTILITY TESTING FUNCTIONS (/wmem/utils/) */
 
 static void
@@ -869,14 +1006,26 @@ check_val_map(gpointer key _U_, gpointer val, gpointer user_data)
     g_assert(val == user_data);
 }
 
+/* Run with the chained maps if data is NULL, otherwise with the open
+ * addressing ones. */
+static wmem_map_t *
+wmem_test_map_new(gconstpointer data, wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    if (data)
+        return wmem_map_new_open_addressing(allocator, hash_func, eql_func);
+    return wmem_map_new(allocator, hash_func, eql_func);
+}
+
 static void
-wmem_test_map(void)
+wmem_test_map(gconstpointer data)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_map_t       *map;
+    wmem_list_t      *keys;
     gchar            *str_key;
     const void       *str_key_ret;
-    unsigned int      i;
+    unsigned int      i, j;
     unsigned int     *key_ret;
     unsigned int     *value_ret;
     void             *ret;
@@ -885,7 +1034,7 @@ wmem_test_map(void)
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
     /* insertion, lookup and removal of simple integer keys */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = wmem_test_map_new(data, allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
 
     for (i=0; i<CONTAINER_ITERS; i++) {
@@ -922,8 +1071,39 @@ wmem_test_map(void)
     }
     wmem_free_all(allocator);
 
+    /* removal interleaved with insertion, which leaves removed items in the
+     * middle of the probe sequences of open addressing maps */
+    map = wmem_test_map_new(data, allocator, g_direct_hash, g_direct_equal);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        if (i % 3 == 0) {
+            g_assert(wmem_map_steal(map, GINT_TO_POINTER(i / 3)) == TRUE);
+        }
+    }
+    g_assert(wmem_map_size(map) == CONTAINER_ITERS - (CONTAINER_ITERS + 2) / 3);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        gboolean removed = (i <= (CONTAINER_ITERS - 1) / 3);
+
+        g_assert(wmem_map_contains(map, GINT_TO_POINTER(i)) == !removed);
+    }
+    for (j=0; j<4; j++) {
+        for (i=0; i<CONTAINER_ITERS; i++) {
+            wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        }
+        for (i=0; i<CONTAINER_ITERS; i++) {
+            g_assert(wmem_map_remove(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+        }
+        g_assert(wmem_map_size(map) == 0);
+    }
+    keys = wmem_map_get_keys(allocator, map);
+    g_assert(wmem_list_count(keys) == 0);
+    wmem_free_all(allocator);
+
     /* test auto-reset functionality */
-    map = wmem_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    if (data)
+        map = wmem_map_new_autoreset_open_addressing(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    else
+        map = wmem_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
@@ -937,9 +1117,13 @@ wmem_test_map(void)
     for (i=0; i<CONTAINER_ITERS; i++) {
         g_assert(wmem_map_lookup(map, GINT_TO_POINTER(i)) == NULL);
     }
+    g_assert(wmem_map_size(map) == 0);
+    wmem_map_insert(map, GINT_TO_POINTER(1), GINT_TO_POINTER(1));
+    g_assert(wmem_map_lookup(map, GINT_TO_POINTER(1)) == GINT_TO_POINTER(1));
+    wmem_free_all(extra_allocator);
     wmem_free_all(allocator);
 
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = wmem_test_map_new(data, allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
 
     /* string keys and for-each */
@@ -957,7 +1141,7 @@ wmem_test_map(void)
     }
 
     /* test foreach */
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = wmem_test_map_new(data, allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
@@ -966,13 +1150,17 @@ wmem_test_map(void)
     wmem_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
 
     /* test size */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = wmem_test_map_new(data, allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
     }
     g_assert(wmem_map_size(map) == CONTAINER_ITERS);
 
+    /* test get_keys */
+    keys = wmem_map_get_keys(allocator, map);
+    g_assert(wmem_list_count(keys) == CONTAINER_ITERS);
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
@@ -1132,6 +1320,249 @@ wmem_test_strbuf(void)
     wmem_destroy_allocator(allocator);
 }
 
+static gboolean
+wmem_test_flat_map_order_cb(const void *key, void *value _U_, void *user_data)
+{
+    guint32 *last_key = (guint32 *)user_data;
+
+    g_assert(*(const guint32 *)key >= *last_key);
+    *last_key = *(const guint32 *)key;
+
+    return FALSE;
+}
+
+static void
+wmem_test_flat_map(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_flat_map_t    *map;
+    wmem_tree_t        *tree;
+    guint32             i, key, last_key;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    map = wmem_flat_map_new(allocator);
+    g_assert(map);
+    g_assert(wmem_flat_map_is_empty(map));
+    g_assert(wmem_flat_map_lookup32(map, 0) == NULL);
+    g_assert(wmem_flat_map_lookup32_le(map, G_MAXUINT32) == NULL);
+
+    /* ascending inserts (the fast path) */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert(wmem_flat_map_lookup32(map, i*2) == NULL);
+        if (i > 0) {
+            g_assert(wmem_flat_map_lookup32_le(map, i*2) == GINT_TO_POINTER(i-1));
+            g_assert(wmem_flat_map_lookup32_le(map, i*2-1) == GINT_TO_POINTER(i-1));
+        }
+        wmem_flat_map_insert32(map, i*2, GINT_TO_POINTER(i));
+        g_assert(wmem_flat_map_lookup32(map, i*2) == GINT_TO_POINTER(i));
+        g_assert(!wmem_flat_map_is_empty(map));
+    }
+    g_assert(wmem_flat_map_count(map) == CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert(wmem_flat_map_lookup32_le(map, i*2+1) == GINT_TO_POINTER(i));
+        g_assert(wmem_flat_map_lookup32(map, i*2+1) == NULL);
+    }
+
+    /* overwriting an existing key does not add an entry */
+    wmem_flat_map_insert32(map, 10, GINT_TO_POINTER(12345));
+    g_assert(wmem_flat_map_lookup32(map, 10) == GINT_TO_POINTER(12345));
+    g_assert(wmem_flat_map_count(map) == CONTAINER_ITERS);
+    wmem_strict_check_canaries(allocator);
+    wmem_free_all(allocator);
+
+    /* random inserts must behave exactly like wmem_tree */
+    map  = wmem_flat_map_new(allocator);
+    tree = wmem_tree_new(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int();
+        wmem_flat_map_insert32(map, key, GINT_TO_POINTER(i));
+        wmem_tree_insert32(tree, key, GINT_TO_POINTER(i));
+    }
+    g_assert(wmem_flat_map_count(map) == wmem_tree_count(tree));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int();
+        g_assert(wmem_flat_map_lookup32(map, key) ==
+                wmem_tree_lookup32(tree, key));
+        g_assert(wmem_flat_map_lookup32_le(map, key) ==
+                wmem_tree_lookup32_le(tree, key));
+    }
+    last_key = 0;
+    g_assert(!wmem_flat_map_foreach(map, wmem_test_flat_map_order_cb, &last_key));
+    wmem_strict_check_canaries(allocator);
+
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_test_flat_map_perf(void)
+{
+#define FLAT_MAP_PERF_COUNT (100 * 1000)
+#define FLAT_MAP_PERF_LOOKUPS 20
+    wmem_allocator_t   *allocator;
+    wmem_flat_map_t    *map;
+    wmem_tree_t        *tree;
+    guint32             i, j, seq;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    /* Emulate a TCP stream: PDUs stored in ascending sequence order, and
+     * each segment looking up the PDU it belongs to a few times. */
+    RESOURCE_USAGE_START;
+    tree = wmem_tree_new(allocator);
+    for (i = 0, seq = 1000; i < FLAT_MAP_PERF_COUNT; i++, seq += 1448) {
+        wmem_tree_insert32(tree, seq, GUINT_TO_POINTER(seq));
+        for (j = 0; j < FLAT_MAP_PERF_LOOKUPS; j++) {
+            g_assert(wmem_tree_lookup32_le(tree, seq + j * 64) == GUINT_TO_POINTER(seq));
+        }
+    }
+    for (i = 0, seq = 1000; i < FLAT_MAP_PERF_COUNT; i++, seq += 1448) {
+        g_assert(wmem_tree_lookup32_le(tree, seq + 1) == GUINT_TO_POINTER(seq));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_tree in-order insert/lookup32_le: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    wmem_free_all(allocator);
+
+    RESOURCE_USAGE_START;
+    map = wmem_flat_map_new(allocator);
+    for (i = 0, seq = 1000; i < FLAT_MAP_PERF_COUNT; i++, seq += 1448) {
+        wmem_flat_map_insert32(map, seq, GUINT_TO_POINTER(seq));
+        for (j = 0; j < FLAT_MAP_PERF_LOOKUPS; j++) {
+            g_assert(wmem_flat_map_lookup32_le(map, seq + j * 64) == GUINT_TO_POINTER(seq));
+        }
+    }
+    for (i = 0, seq = 1000; i < FLAT_MAP_PERF_COUNT; i++, seq += 1448) {
+        g_assert(wmem_flat_map_lookup32_le(map, seq + 1) == GUINT_TO_POINTER(seq));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_flat_map in-order insert/lookup32_le: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    wmem_free_all(allocator);
+
+    wmem_destroy_allocator(allocator);
+}
+
+typedef struct {
+    wmem_allocator_t *allocator;
+    guint             allocs;
+} wmem_test_mt_perf_thread_t;
+
+static gpointer
+wmem_test_mt_perf_thread(gpointer data)
+{
+    wmem_test_mt_perf_thread_t *t = (wmem_test_mt_perf_thread_t *)data;
+    guint i;
+
+    for (i = 0; i < t->allocs; i++) {
+        *(guint *)wmem_alloc(t->allocator, 16 + (i % 16) * 16) = i;
+    }
+    return NULL;
+}
+
+/* The same number of allocations, by one thread from a BLOCK_FAST allocator
+ * and then split among 1 to MT_THREADS threads allocating from a BLOCK_MT
+ * one. This measures wall-clock time, as the CPU time of the threads adds
+ * up. */
+static void
+wmem_test_allocator_block_mt_perf(void)
+{
+#define MT_PERF_ALLOCS (8 * 1000 * 1000)
+    wmem_allocator_t           *allocator;
+    wmem_test_mt_perf_thread_t  threads[MT_THREADS];
+    GThread                    *ids[MT_THREADS];
+    guint                       num_threads, i;
+    gint64                      start;
+    double                      elapsed_ms;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    threads[0].allocator = allocator;
+    threads[0].allocs = MT_PERF_ALLOCS;
+    start = g_get_monotonic_time();
+    wmem_test_mt_perf_thread(&threads[0]);
+    elapsed_ms = (g_get_monotonic_time() - start) / 1000.0;
+    g_test_minimized_result(elapsed_ms,
+        "BLOCK_FAST, 1 thread: %.3f ms", elapsed_ms);
+    wmem_destroy_allocator(allocator);
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK_MT);
+    for (num_threads = 1; num_threads <= MT_THREADS; num_threads *= 2) {
+        start = g_get_monotonic_time();
+        for (i = 0; i < num_threads; i++) {
+            threads[i].allocator = allocator;
+            threads[i].allocs = MT_PERF_ALLOCS / num_threads;
+            ids[i] = g_thread_new("wmem_test", wmem_test_mt_perf_thread, &threads[i]);
+        }
+        for (i = 0; i < num_threads; i++) {
+            g_thread_join(ids[i]);
+        }
+        elapsed_ms = (g_get_monotonic_time() - start) / 1000.0;
+        g_test_minimized_result(elapsed_ms,
+            "BLOCK_MT, %u thread(s): %.3f ms", num_threads, elapsed_ms);
+        wmem_free_all(allocator);
+    }
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_map_perf(void)
+{
+#define MAP_PERF_COUNT (500 * 1000)
+#define MAP_PERF_LOOKUPS 4
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    guint32             i, j, key;
+    int                 open_addressing;
+    const char         *kind;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (open_addressing = 0; open_addressing <= 1; open_addressing++) {
+        kind = open_addressing ? "open addressing" : "chained";
+
+        map = wmem_test_map_new(open_addressing ? GINT_TO_POINTER(1) : NULL,
+                allocator, g_direct_hash, g_direct_equal);
+
+        RESOURCE_USAGE_START;
+        for (i = 1; i <= MAP_PERF_COUNT; i++) {
+            wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_map (%s) insert: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        /* Look the keys up in another order than they were inserted in, as
+         * that would favour the chained map's items that were allocated one
+         * after the other; half of the lookups miss. */
+        RESOURCE_USAGE_START;
+        for (j = 0; j < MAP_PERF_LOOKUPS; j++) {
+            for (i = 1; i <= MAP_PERF_COUNT; i++) {
+                key = (guint32)(((guint64)i * 7919) % MAP_PERF_COUNT) + 1;
+                g_assert(wmem_map_lookup(map, GUINT_TO_POINTER(key)) == GUINT_TO_POINTER(key));
+                g_assert(wmem_map_lookup(map, GUINT_TO_POINTER(key + MAP_PERF_COUNT)) == NULL);
+            }
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_map (%s) lookup: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 1; i <= MAP_PERF_COUNT; i++) {
+            g_assert(wmem_map_remove(map, GUINT_TO_POINTER(i)) == GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_map (%s) remove: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_tree(void)
 {
@@ -1408,6 +1839,8 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
+    g_test_add_func("/wmem/allocator/block_mt",  wmem_test_allocator_block_mt);
+    g_test_add_func("/wmem/allocator/block_mt_threads", wmem_test_allocator_block_mt_threads);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
@@ -1415,11 +1848,16 @@ main(int argc, char **argv)
 
     if (!g_test_perf ()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/datastruct/flat_map_perf", wmem_test_flat_map_perf);
+        g_test_add_func("/wmem/datastruct/map_perf", wmem_test_map_perf);
+        g_test_add_func("/wmem/allocator/block_mt_perf", wmem_test_allocator_block_mt_perf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
+    g_test_add_func("/wmem/datastruct/flat_map", wmem_test_flat_map);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
-    g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_data_func("/wmem/datastruct/map",      NULL,               wmem_test_map);
+    g_test_add_data_func("/wmem/datastruct/map_open", GINT_TO_POINTER(1), wmem_test_map);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
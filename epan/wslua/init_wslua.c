@@ -756,6 +756,7 @@ wslua_get_expert_field(const int group, const int severity)
     return &ei_lua_error;
 }
 
+#ifndef HAVE_LUAJIT
 static void *
 wslua_allocf(void *ud _U_, void *ptr, size_t osize _U_, size_t nsize)
 {
@@ -763,6 +764,7 @@ wslua_allocf(void *ud _U_, void *ptr, size_t osize _U_, size_t nsize)
      * Furthermore it simplifies error handling by aborting on OOM */
     return g_realloc(ptr, nsize);
 }
+#endif
 
 void wslua_init(register_cb cb, gpointer client_data) {
     gchar* filename;
@@ -878,7 +880,13 @@ void wslua_init(register_cb cb, gpointer client_data) {
     wslua_logger = ops ? ops->logger : basic_logger;
 
     if (!L) {
+#ifdef HAVE_LUAJIT
+        /* 64-bit LuaJIT needs its own allocator, to keep its objects
+         * in the low 2GB of the address space (unless built with GC64) */
+        L = luaL_newstate();
+#else
         L = lua_newstate(wslua_allocf, NULL);
+#endif
     }
 
     WSLUA_INIT(L);
@@ -1042,6 +1050,7 @@ void wslua_cleanup(void) {
         lua_close(L);
         L = NULL;
     }
+    cleanup_Tvbs();
     init_routine_initialized = FALSE;
 }
 
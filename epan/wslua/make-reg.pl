@@ -74,7 +74,11 @@ print C "void wslua_register_classes(lua_State* L) { \n";
 for (@classes) {
 	print C "\twslua_reg_module(L, \"${_}\", ${_}_register);\n";
 }
+# LuaJIT has a built-in bit module with the same API, which its JIT compiler
+# understands; don't replace it with ours.
+print C "#ifndef HAVE_LUAJIT\n";
 print C "\twslua_reg_module(L, \"bit\", luaopen_bit);\n";
+print C "#endif\n";
 print C "\twslua_reg_module(L, \"GRegex\", luaopen_rex_glib);\n";
 print C "}\n\n";
 
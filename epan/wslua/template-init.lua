@@ -138,4 +138,8 @@ persconffile_path = Dir.personal_config_path
 
 
 dofile(DATA_DIR.."console.lua")
+-- FFI based TvbRange methods, when running on LuaJIT
+if jit and file_exists(DATA_DIR.."tvb_ffi.lua") then
+    dofile(DATA_DIR.."tvb_ffi.lua")
+end
 --dofile(DATA_DIR.."dtd_gen.lua")
@@ -0,0 +1,163 @@
+-- tvb_ffi.lua
+--
+-- When Wireshark is built with LuaJIT, this replaces the TvbRange methods
+-- that read integers with ones that read the packet data through the
+-- LuaJIT FFI. Calls to C functions through the Lua C API stop LuaJIT from
+-- compiling the loops of a dissector, FFI calls and reads don't.
+--
+-- The methods behave exactly like the C ones; in the cases they don't
+-- handle (unsupported lengths, expired TvbRanges, ...) they call the C ones,
+-- so that the errors are the same.
+--
+-- It also looks up the methods of Tvb and TvbRange objects with a Lua
+-- __index, so that "tvbr:uint()" does not go through the C __index. Getting
+-- attributes (tvbr.len, ...) and creating TvbRanges ("tvb(off, len)",
+-- tvbr:range()) still call C functions.
+--
+-- Wireshark - Network traffic analyzer
+-- By Gerald Combs <gerald@wireshark.org>
+-- Copyright 1998 Gerald Combs
+--
+-- SPDX-License-Identifier: GPL-2.0-or-later
+
+if not jit then
+    return
+end
+
+local ffi = require("ffi")
+
+local ok = pcall(ffi.cdef, [[
+const uint8_t *wslua_tvbrange_bytes(void *tvbr, int *len);
+]])
+-- the symbol can only be found through ffi.C where the Wireshark library
+-- is in the global namespace (not on Windows)
+if not ok or not pcall(function() return ffi.C.wslua_tvbrange_bytes end) then
+    return
+end
+
+local C = ffi.C
+local mt = debug.getregistry()["TvbRange"]
+local methods = mt and mt.__methods
+if not methods then
+    return
+end
+
+local getmetatable = getmetatable
+local len_out = ffi.new("int[1]")
+
+-- the bytes of a TvbRange and their number, or nil
+local function range_bytes(tvbr)
+    if getmetatable(tvbr) ~= mt then
+        return nil
+    end
+    local p = C.wslua_tvbrange_bytes(tvbr, len_out)
+    if p == nil then
+        return nil
+    end
+    return p, len_out[0]
+end
+
+local c_uint, c_le_uint = methods.uint, methods.le_uint
+local c_int, c_le_int = methods.int, methods.le_int
+
+-- the replaced C methods, for test/lua/tvb_ffi.lua to compare with
+mt.__c_methods = { uint = c_uint, le_uint = c_le_uint, int = c_int, le_int = c_le_int }
+
+local function be_uint(p, len)
+    if len == 1 then
+        return p[0]
+    elseif len == 2 then
+        return p[0] * 0x100 + p[1]
+    elseif len == 3 then
+        return (p[0] * 0x100 + p[1]) * 0x100 + p[2]
+    elseif len == 4 then
+        return ((p[0] * 0x100 + p[1]) * 0x100 + p[2]) * 0x100 + p[3]
+    end
+    return nil
+end
+
+local function le_uint(p, len)
+    if len == 1 then
+        return p[0]
+    elseif len == 2 then
+        return p[1] * 0x100 + p[0]
+    elseif len == 3 then
+        return (p[2] * 0x100 + p[1]) * 0x100 + p[0]
+    elseif len == 4 then
+        return ((p[3] * 0x100 + p[2]) * 0x100 + p[1]) * 0x100 + p[0]
+    end
+    return nil
+end
+
+local sign_bit = { [1] = 0x80, [2] = 0x8000, [3] = 0x800000, [4] = 0x80000000 }
+local function to_signed(v, len)
+    if v >= sign_bit[len] then
+        return v - sign_bit[len] * 2
+    end
+    return v
+end
+
+function methods.uint(tvbr, ...)
+    local p, len = range_bytes(tvbr)
+    local v = p and be_uint(p, len)
+    if v then
+        return v
+    end
+    return c_uint(tvbr, ...)
+end
+
+function methods.le_uint(tvbr, ...)
+    local p, len = range_bytes(tvbr)
+    local v = p and le_uint(p, len)
+    if v then
+        return v
+    end
+    return c_le_uint(tvbr, ...)
+end
+
+function methods.int(tvbr, ...)
+    local p, len = range_bytes(tvbr)
+    if p and sign_bit[len] then
+        return to_signed(be_uint(p, len), len)
+    end
+    return c_int(tvbr, ...)
+end
+
+function methods.le_int(tvbr, ...)
+    local p, len = range_bytes(tvbr)
+    if p and sign_bit[len] then
+        return to_signed(le_uint(p, len), len)
+    end
+    return c_le_int(tvbr, ...)
+end
+
+-- Replaces the C __index of the instances of a class with a Lua function that
+-- returns the methods itself and leaves the rest (attributes, errors) to the
+-- C one. Names that are both attributes and methods keep going to the C
+-- __index, which gives the attribute precedence.
+local function lua_index(class_mt)
+    local c_index = class_mt and class_mt.__index
+    local all_methods = class_mt and class_mt.__methods
+    local getters = class_mt and class_mt.__getters
+    if type(c_index) ~= "function" or not all_methods or not getters then
+        return
+    end
+
+    local lookup = {}
+    for name, func in pairs(all_methods) do
+        if getters[name] == nil then
+            lookup[name] = func
+        end
+    end
+
+    class_mt.__index = function(obj, key)
+        local m = lookup[key]
+        if m ~= nil then
+            return m
+        end
+        return c_index(obj, key)
+    end
+end
+
+lua_index(mt)
+lua_index(debug.getregistry()["Tvb"])
@@ -223,6 +223,12 @@ struct _wslua_field_info {
     gboolean expired;
 };
 
+struct _wslua_field_extractor {
+    header_field_info *hfinfo;  /* NULL until the fields are primed */
+    gchar *name;                /* the filter name, until the fields are primed */
+    guint slot;                 /* index in the per-packet field cache */
+};
+
 typedef void (*tap_extractor_t)(lua_State*,const void*);
 
 struct _wslua_tap {
@@ -321,7 +327,7 @@ typedef address* Address;
 typedef nstime_t* NSTime;
 typedef gint64 Int64;
 typedef guint64 UInt64;
-typedef header_field_info** Field;
+typedef struct _wslua_field_extractor* Field;
 typedef struct _wslua_field_info* FieldInfo;
 typedef struct _wslua_tap* Listener;
 typedef struct _wslua_tw* TextWindow;
@@ -766,8 +772,10 @@ extern int UInt64_unpack(lua_State* L, const gchar *buff, gboolean asLittleEndia
 extern Tvb* push_Tvb(lua_State* L, tvbuff_t* tvb);
 extern int push_wsluaTvb(lua_State* L, Tvb t);
 extern gboolean push_TvbRange(lua_State* L, tvbuff_t* tvb, int offset, int len);
+WS_DLL_PUBLIC const guint8* wslua_tvbrange_bytes(const TvbRange* tvbr, gint* len);
 extern void clear_outstanding_Tvb(void);
 extern void clear_outstanding_TvbRange(void);
+extern void cleanup_Tvbs(void);
 
 extern Pinfo* push_Pinfo(lua_State* L, packet_info* p);
 extern void clear_outstanding_Pinfo(void);
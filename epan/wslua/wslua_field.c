@@ -519,6 +519,18 @@ WSLUA_CLASS_DEFINE(Field,FAIL_ON_NULL("Field"));
 static GPtrArray* wanted_fields = NULL;
 static dfilter_t* wslua_dfilter = NULL;
 
+/*
+ * The primed fields, in slot order, and the first field_info of each of
+ * them in the current packet, for Field.values(). The cache is filled at
+ * once for all the fields the first time it is needed in a packet, and is
+ * only filled again if items were added to the tree since (a Lua dissector
+ * running mid-dissection) or when the packet changes.
+ */
+static GPtrArray* primed_fields = NULL;
+static field_info** field_cache = NULL;
+static const tree_data_t* field_cache_tree = NULL;
+static gint field_cache_count = 0;
+
 /* We use a fake dfilter for Lua field extractors, so that
  * epan_dissect_run() will populate the fields.  This won't happen
  * if the passed-in edt->tree is NULL, which it will be if the
@@ -554,28 +566,37 @@ void lua_prime_all_fields(proto_tree* tree _U_) {
     guint i;
     gchar *err_msg;
 
+    if (!primed_fields)
+        primed_fields = g_ptr_array_new();
+
     for(i=0; i < wanted_fields->len; i++) {
         Field f = (Field)g_ptr_array_index(wanted_fields,i);
-        gchar* name = *((gchar**)f);
 
-        *f = proto_registrar_get_byname(name);
+        f->hfinfo = proto_registrar_get_byname(f->name);
 
-        if (!*f) {
-            report_failure("Could not find field `%s'",name);
-            *f = NULL;
-            g_free(name);
+        if (!f->hfinfo) {
+            report_failure("Could not find field `%s'",f->name);
+            g_free(f->name);
+            f->name = NULL;
             continue;
         }
 
-        g_free(name);
+        g_free(f->name);
+        f->name = NULL;
+
+        f->slot = primed_fields->len;
+        g_ptr_array_add(primed_fields,f);
 
-        g_string_append_printf(fake_tap_filter," || %s",(*f)->abbrev);
+        g_string_append_printf(fake_tap_filter," || %s",f->hfinfo->abbrev);
         fake_tap = TRUE;
     }
 
     g_ptr_array_free(wanted_fields,TRUE);
     wanted_fields = NULL;
 
+    field_cache = g_new0(field_info*, primed_fields->len);
+    field_cache_tree = NULL;
+
     if (fake_tap && fake_tap_filter->len > strlen("frame")) {
         /* a boring tap :-) */
         GString* error = register_tap_listener("frame",
@@ -613,8 +634,8 @@ WSLUA_CONSTRUCTOR Field_new(lua_State *L) {
         return 0;
     }
 
-    f = (Field)g_malloc(sizeof(void*));
-    *f = (header_field_info*)(void*)g_strdup(name); /* cheating */
+    f = g_new0(struct _wslua_field_extractor, 1);
+    f->name = g_strdup(name);
 
     g_ptr_array_add(wanted_fields,f);
 
@@ -657,8 +678,8 @@ WSLUA_CONSTRUCTOR Field_list(lua_State *L) {
 /* the following is used in Field_get_xxx functions later */
 #define GET_HFINFO_MEMBER(luafunc, member)                          \
     if (wanted_fields) {                                            \
-        /* before registration, so it's a gchar** of the abbrev */  \
-        const gchar* name = (const gchar*) *fi;                     \
+        /* before registration, so we only have the abbrev */       \
+        const gchar* name = fi->name;                               \
         if (name) {                                                 \
             hfinfo = proto_registrar_get_byname(name);              \
             if (!hfinfo) {                                          \
@@ -674,7 +695,7 @@ WSLUA_CONSTRUCTOR Field_list(lua_State *L) {
             return 0;                                               \
         }                                                           \
     } else {                                                        \
-        hfinfo = *fi;                                               \
+        hfinfo = fi->hfinfo;                                        \
     }                                                               \
                                                                     \
     if (hfinfo) {                                                   \
@@ -725,7 +746,7 @@ static int Field_get_type(lua_State* L) {
 WSLUA_METAMETHOD Field__call (lua_State* L) {
     /* Obtain all values (see `FieldInfo`) for this field. */
     Field f = checkField(L,1);
-    header_field_info* in = *f;
+    header_field_info* in = f->hfinfo;
     int items_found = 0;
 
     if (! in) {
@@ -753,14 +774,183 @@ WSLUA_METAMETHOD Field__call (lua_State* L) {
     WSLUA_RETURN(items_found); /* All the values of this field */
 }
 
+static gboolean field_cache_end(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+        void *user_data _U_) {
+    field_cache_tree = NULL;
+
+    /* keep invoking this callback later? */
+    return FALSE;
+}
+
+static void fill_field_cache(proto_tree* tree) {
+    guint i;
+
+    for (i = 0; i < primed_fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(primed_fields,i);
+        header_field_info* in = f->hfinfo;
+
+        field_cache[i] = NULL;
+        while (in) {
+            GPtrArray* found = proto_get_finfo_ptr_array(tree, in->id);
+            if (found && found->len) {
+                field_cache[i] = (field_info *) g_ptr_array_index(found,0);
+                break;
+            }
+            in = (in->same_name_prev_id != -1) ? proto_registrar_get_nth(in->same_name_prev_id) : NULL;
+        }
+    }
+
+    if (field_cache_tree != PTREE_DATA(tree)) {
+        wmem_register_callback(lua_pinfo->pool, field_cache_end, NULL);
+    }
+    field_cache_tree = PTREE_DATA(tree);
+    field_cache_count = PTREE_DATA(tree)->count;
+}
+
+/* Pushes the value of a field as a plain Lua value: unlike FieldInfo__call(),
+ * this never creates a userdata. */
+static void push_field_value(lua_State* L, field_info* fi) {
+    switch(fi->hfinfo->type) {
+        case FT_BOOLEAN:
+                lua_pushboolean(L,(int)fvalue_get_uinteger64(&fi->value));
+                break;
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_FRAMENUM:
+                lua_pushnumber(L,(lua_Number)fvalue_get_uinteger(&fi->value));
+                break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+                lua_pushnumber(L,(lua_Number)fvalue_get_sinteger(&fi->value));
+                break;
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+                lua_pushnumber(L,(lua_Number)fvalue_get_uinteger64(&fi->value));
+                break;
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+                lua_pushnumber(L,(lua_Number)fvalue_get_sinteger64(&fi->value));
+                break;
+        case FT_FLOAT:
+        case FT_DOUBLE:
+                lua_pushnumber(L,(lua_Number)fvalue_get_floating(&fi->value));
+                break;
+        case FT_ABSOLUTE_TIME:
+        case FT_RELATIVE_TIME: {
+                const nstime_t* t = (const nstime_t*)fvalue_get(&fi->value);
+                lua_pushnumber(L,(lua_Number)t->secs + (lua_Number)t->nsecs / 1000000000.0);
+                break;
+            }
+        case FT_BYTES:
+        case FT_UINT_BYTES:
+        case FT_REL_OID:
+        case FT_SYSTEM_ID:
+        case FT_OID:
+                lua_pushlstring(L,(const char *)fvalue_get(&fi->value),fvalue_length(&fi->value));
+                break;
+        case FT_PROTOCOL: {
+                tvbuff_t* tvb = (tvbuff_t *) fvalue_get(&fi->value);
+                guint len = tvb_captured_length(tvb);
+                lua_pushlstring(L,(const char *)tvb_get_ptr(tvb,0,len),len);
+                break;
+            }
+        case FT_NONE:
+                if (fi->length > 0 && fi->rep) {
+                    lua_pushstring(L,fi->rep->representation);
+                } else {
+                    lua_pushnil(L);
+                }
+                break;
+        default: {
+                /* strings, addresses, GUIDs... */
+                gchar* repr = fvalue_to_string_repr(NULL,&fi->value,FTREPR_DISPLAY,fi->hfinfo->display);
+                if (repr) {
+                    lua_pushstring(L,repr);
+                    wmem_free(NULL,repr);
+                } else {
+                    lua_pushnil(L);
+                }
+                break;
+            }
+    }
+}
+
+WSLUA_CONSTRUCTOR Field_values(lua_State* L) {
+    /* Obtain the values of several fields of the current packet at once.
+
+       For each of the given `Field` extractors, this returns the value of its first
+       occurrence in the packet, or nil if it isn't in the packet. To get all the
+       occurrences of a field, call the `Field` itself instead.
+
+       The values are plain Lua values rather than `FieldInfo` objects: numbers for
+       the integer, floating point and time (in seconds) types, booleans, and strings
+       for everything else; the bytes types and protocols give their raw bytes, and
+       addresses their display string. 64-bit integers are converted to Lua numbers,
+       so they lose precision above 2^53.
+
+       This is meant for taps and post-dissectors that read many fields of every
+       packet: the fields are looked up in the tree once per packet for all the
+       `Field` extractors, and no per-value objects are created.
+
+       @since 2.9.0
+     */
+#define WSLUA_ARG_Field_values_FIELD 1 /* The first `Field` extractor; more can follow. */
+    int n = lua_gettop(L);
+    int i;
+
+    if (! lua_pinfo ) {
+        WSLUA_ERROR(Field_values,"Fields cannot be used outside dissectors or taps");
+        return 0;
+    }
+
+    if (n < 1) {
+        WSLUA_ARG_ERROR(Field_values,FIELD,"at least one Field is needed");
+        return 0;
+    }
+
+    luaL_checkstack(L,n,"too many fields");
+
+    if (lua_tree && lua_tree->tree &&
+        (field_cache_tree != PTREE_DATA(lua_tree->tree) ||
+         field_cache_count != PTREE_DATA(lua_tree->tree)->count)) {
+        fill_field_cache(lua_tree->tree);
+    }
+
+    for (i = 1; i <= n; i++) {
+        Field f = checkField(L,i);
+
+        if (! f->hfinfo) {
+            luaL_argerror(L,i,"invalid field");
+            return 0;
+        }
+
+        if (lua_tree && lua_tree->tree && field_cache[f->slot]) {
+            push_field_value(L, field_cache[f->slot]);
+        } else {
+            lua_pushnil(L);
+        }
+    }
+
+    WSLUA_RETURN(n); /* The value of each field, in the order given */
+}
+
 WSLUA_METAMETHOD Field__tostring(lua_State* L) {
     /* Obtain a string with the field filter name. */
     Field f = checkField(L,1);
 
     if (wanted_fields) {
-        lua_pushstring(L,*((gchar**)f));
+        lua_pushstring(L,f->name);
     } else {
-        lua_pushstring(L,(*f)->abbrev);
+        lua_pushstring(L,f->hfinfo->abbrev);
     }
 
     return 1;
@@ -781,6 +971,7 @@ WSLUA_ATTRIBUTES Field_attributes[] = {
 WSLUA_METHODS Field_methods[] = {
     WSLUA_CLASS_FNREG(Field,new),
     WSLUA_CLASS_FNREG(Field,list),
+    WSLUA_CLASS_FNREG(Field,values),
     { NULL, NULL }
 };
 
@@ -812,6 +1003,15 @@ int wslua_deregister_fields(lua_State* L _U_) {
         fake_tap = FALSE;
     }
 
+    if (primed_fields) {
+        g_ptr_array_free(primed_fields,TRUE);
+        primed_fields = NULL;
+    }
+
+    g_free(field_cache);
+    field_cache = NULL;
+    field_cache_tree = NULL;
+
     return 0;
 }
 
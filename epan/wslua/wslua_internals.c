@@ -519,10 +519,18 @@ void wslua_register_classinstance_meta(lua_State *L, const wslua_class *cls_def)
         lua_pushnil(L);
     }
 
+#ifdef HAVE_LUAJIT
+    /* Make the methods table reachable from Lua code, so that tvb_ffi.lua
+     * can replace some of the methods with FFI based ones. */
+    lua_pushvalue(L, -1);
+    lua_rawsetfield(L, -3, "__methods");
+#endif
+
     /* Prepare __index method on metatable. */
     lua_pushstring(L, cls_def->name);                       /* upval 1: class name */
     wslua_push_attributes(L, cls_def->attrs, TRUE, -2);     /* upval 2: getters table */
-#ifdef WSLUA_WITH_INTROSPECTION
+#if defined(WSLUA_WITH_INTROSPECTION) || defined(HAVE_LUAJIT)
+    /* With LuaJIT, tvb_ffi.lua needs it to know which names are not methods. */
     lua_pushvalue(L, -1);
     lua_rawsetfield(L, -5, "__getters"); /* set (transition) property on mt, remove later! */
 #endif
@@ -65,6 +65,43 @@ WSLUA_CLASS_DEFINE(Tvb,FAIL_ON_NULL_OR_EXPIRED("Tvb"));
 static GPtrArray* outstanding_Tvb = NULL;
 static GPtrArray* outstanding_TvbRange = NULL;
 
+/*
+ * Dissectors slice their Tvbs into TvbRanges by the thousands per packet, so
+ * instead of being freed, the chunks of the Tvbs and TvbRanges that are
+ * done with are kept in these pools, and reused for the next ones. A TvbRange
+ * and the Tvb it refers to are a single chunk.
+ *
+ * The pools are capped, so that a packet that made lots of them does not keep
+ * them allocated for good, and are freed by wslua_cleanup().
+ */
+#define MAX_FREE_TVBS 4096
+
+static GPtrArray* free_Tvbs = NULL;
+static GPtrArray* free_TvbRanges = NULL;
+
+typedef struct _wslua_tvbrange_chunk {
+    struct _wslua_tvbrange tvbr;
+    struct _wslua_tvb tvb;
+} wslua_tvbrange_chunk;
+
+static Tvb alloc_Tvb(void) {
+    if (free_Tvbs->len)
+        return (Tvb)g_ptr_array_remove_index_fast(free_Tvbs,free_Tvbs->len-1);
+
+    return (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+}
+
+static TvbRange alloc_TvbRange(void) {
+    wslua_tvbrange_chunk* chunk;
+
+    if (free_TvbRanges->len)
+        return (TvbRange)g_ptr_array_remove_index_fast(free_TvbRanges,free_TvbRanges->len-1);
+
+    chunk = g_new(wslua_tvbrange_chunk, 1);
+    chunk->tvbr.tvb = &chunk->tvb;
+    return &chunk->tvbr;
+}
+
 /* this is used to push Tvbs that were created brand new by wslua code */
 int push_wsluaTvb(lua_State* L, Tvb t) {
     g_ptr_array_add(outstanding_Tvb,t);
@@ -83,7 +120,10 @@ static void free_Tvb(Tvb tvb) {
     } else {
         if (tvb->need_free)
             tvb_free(tvb->ws_tvb);
-        g_free(tvb);
+        if (free_Tvbs->len < MAX_FREE_TVBS)
+            g_ptr_array_add(free_Tvbs,tvb);
+        else
+            g_free(tvb);
     }
 }
 
@@ -96,7 +136,7 @@ void clear_outstanding_Tvb(void) {
 
 /* this is used to push Tvbs that just point to pre-existing C-code Tvbs */
 Tvb* push_Tvb(lua_State* L, tvbuff_t* ws_tvb) {
-    Tvb tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    Tvb tvb = alloc_Tvb();
     tvb->ws_tvb = ws_tvb;
     tvb->expired = FALSE;
     tvb->need_free = FALSE;
@@ -315,6 +355,8 @@ WSLUA_META Tvb_meta[] = {
 int Tvb_register(lua_State* L) {
     WSLUA_REGISTER_CLASS(Tvb);
     outstanding_Tvb = g_ptr_array_new();
+    if (!free_Tvbs)
+        free_Tvbs = g_ptr_array_new();
     return 0;
 }
 
@@ -336,8 +378,11 @@ static void free_TvbRange(TvbRange tvbr) {
     if (!tvbr->tvb->expired) {
         tvbr->tvb->expired = TRUE;
     } else {
-        free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        /* the Tvb is part of the chunk, and never needs freeing itself */
+        if (free_TvbRanges->len < MAX_FREE_TVBS)
+            g_ptr_array_add(free_TvbRanges,tvbr);
+        else
+            g_free(tvbr);
     }
 }
 
@@ -348,6 +393,38 @@ void clear_outstanding_TvbRange(void) {
     }
 }
 
+static void free_Tvb_pool(GPtrArray** pool) {
+    guint i;
+
+    if (!*pool) return;
+
+    /* a TvbRange is at the start of its chunk */
+    for (i = 0; i < (*pool)->len; i++)
+        g_free(g_ptr_array_index(*pool,i));
+
+    g_ptr_array_free(*pool,TRUE);
+    *pool = NULL;
+}
+
+/* Called once the Lua state is closed: by then the garbage collector has
+ * expired every Tvb and TvbRange, so clearing the outstanding ones releases
+ * all of them. */
+void cleanup_Tvbs(void) {
+    if (outstanding_Tvb) {
+        clear_outstanding_Tvb();
+        g_ptr_array_free(outstanding_Tvb,TRUE);
+        outstanding_Tvb = NULL;
+    }
+    if (outstanding_TvbRange) {
+        clear_outstanding_TvbRange();
+        g_ptr_array_free(outstanding_TvbRange,TRUE);
+        outstanding_TvbRange = NULL;
+    }
+
+    free_Tvb_pool(&free_Tvbs);
+    free_Tvb_pool(&free_TvbRanges);
+}
+
 
 gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
     TvbRange tvbr;
@@ -368,8 +445,7 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvbr = alloc_TvbRange();
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
@@ -382,6 +458,24 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
 }
 
 
+/*
+ * For the LuaJIT FFI methods of tvb_ffi.lua: the bytes of a TvbRange, given
+ * the TvbRange userdata (which the FFI passes as a pointer to its contents),
+ * or NULL if the TvbRange has expired.
+ */
+const guint8* wslua_tvbrange_bytes(const TvbRange* tvbr, gint* len) {
+    TvbRange r = tvbr ? *tvbr : NULL;
+
+    if (!(r && r->tvb) || r->tvb->expired)
+        return NULL;
+
+    if (!tvb_bytes_exist(r->tvb->ws_tvb,r->offset,r->len))
+        return NULL;
+
+    *len = r->len;
+    return tvb_get_ptr(r->tvb->ws_tvb,r->offset,r->len);
+}
+
 WSLUA_METHOD TvbRange_tvb(lua_State *L) {
     /* Creates a (sub)`Tvb` from a `TvbRange`. */
 
@@ -395,7 +489,7 @@ WSLUA_METHOD TvbRange_tvb(lua_State *L) {
     }
 
     if (tvb_offset_exists(tvbr->tvb->ws_tvb,  tvbr->offset + tvbr->len -1 )) {
-        tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+        tvb = alloc_Tvb();
         tvb->expired = FALSE;
         tvb->need_free = FALSE;
         tvb->ws_tvb = tvb_new_subset_length_caplen(tvbr->tvb->ws_tvb,tvbr->offset,tvbr->len, tvbr->len);
@@ -1452,6 +1546,8 @@ WSLUA_META TvbRange_meta[] = {
 
 int TvbRange_register(lua_State* L) {
     outstanding_TvbRange = g_ptr_array_new();
+    if (!free_TvbRanges)
+        free_TvbRanges = g_ptr_array_new();
     WSLUA_REGISTER_CLASS(TvbRange);
     return 0;
 }
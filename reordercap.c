@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <glib.h>
 
 #ifdef HAVE_GETOPT_H
@@ -30,6 +31,8 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
 #include <wsutil/privileges.h>
+#include <wsutil/clopts_common.h>
+#include <wsutil/tempfile.h>
 #include <version_info.h>
 #include <wiretap/wtap_opttypes.h>
 
@@ -54,6 +57,13 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -m <frames>\n");
+    fprintf(output, "            sort at most <frames> frames in memory at a time, using\n");
+    fprintf(output, "            temporary files for the sorted runs of frames.\n");
+    fprintf(output, "  -w <frames>\n");
+    fprintf(output, "            only reorder frames within a window of <frames> frames, for\n");
+    fprintf(output, "            input that is nearly in order; the output is written while\n");
+    fprintf(output, "            the input is read.\n");
     fprintf(output, "  -h        display this help and exit.\n");
 }
 
@@ -65,6 +75,21 @@ typedef struct FrameRecord_t {
     nstime_t     frame_time;
 } FrameRecord_t;
 
+/* A sorted run of frames saved in a temporary file (-m) */
+typedef struct SortRun_t {
+    FILE          *fh;          /* only open while writing or merging it */
+    char          *path;
+    guint          level;       /* number of merges the frames went through */
+    FrameRecord_t  frame;       /* next frame of the run, while merging */
+} SortRun_t;
+
+/*
+ * Maximum number of runs merged at once. When MAX_MERGE_RUNS runs of the
+ * same level have been saved, they are merged into one run of the next
+ * level, like the digits of a counter in base MAX_MERGE_RUNS, so that each
+ * frame is written to O(log(number of runs)) temporary files.
+ */
+#define MAX_MERGE_RUNS 256
 
 /**************************************************/
 /* Debugging only                                 */
@@ -122,17 +147,250 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
    negative if (t1 < t2)
    zero     if (t1 == t2)
    positive if (t1 > t2)
+   Frames with the same timestamp are kept in the order they were read.
 */
 static int
 frames_compare(gconstpointer a, gconstpointer b)
 {
-    const FrameRecord_t *frame1 = *(const FrameRecord_t *const *) a;
-    const FrameRecord_t *frame2 = *(const FrameRecord_t *const *) b;
+    const FrameRecord_t *frame1 = (const FrameRecord_t *) a;
+    const FrameRecord_t *frame2 = (const FrameRecord_t *) b;
 
     const nstime_t *time1 = &frame1->frame_time;
     const nstime_t *time2 = &frame2->frame_time;
 
-    return nstime_cmp(time1, time2);
+    int cmp = nstime_cmp(time1, time2);
+
+    if (cmp != 0)
+        return cmp;
+    return frame1->num < frame2->num ? -1 : frame1->num > frame2->num;
+}
+
+static int
+runs_compare(gconstpointer a, gconstpointer b)
+{
+    return frames_compare(&((const SortRun_t *) a)->frame,
+                          &((const SortRun_t *) b)->frame);
+}
+
+/*
+ * Binary heaps of pointers, with the smallest item according to cmp
+ * at the top, used to merge the sorted runs (-m) and for the reorder
+ * window (-w).
+ */
+static void
+heap_push(GPtrArray *heap, gpointer item, GCompareFunc cmp)
+{
+    guint i = heap->len;
+
+    g_ptr_array_add(heap, item);
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+
+        if (cmp(heap->pdata[parent], item) <= 0)
+            break;
+        heap->pdata[i] = heap->pdata[parent];
+        i = parent;
+    }
+    heap->pdata[i] = item;
+}
+
+static gpointer
+heap_pop(GPtrArray *heap, GCompareFunc cmp)
+{
+    gpointer top, last;
+    guint i = 0;
+
+    if (heap->len == 0)
+        return NULL;
+
+    top = heap->pdata[0];
+    last = heap->pdata[heap->len - 1];
+    g_ptr_array_set_size(heap, heap->len - 1);
+    if (heap->len == 0)
+        return top;
+
+    for (;;) {
+        guint child = 2 * i + 1;
+
+        if (child >= heap->len)
+            break;
+        if (child + 1 < heap->len
+            && cmp(heap->pdata[child + 1], heap->pdata[child]) < 0)
+            child++;
+        if (cmp(last, heap->pdata[child]) <= 0)
+            break;
+        heap->pdata[i] = heap->pdata[child];
+        i = child;
+    }
+    heap->pdata[i] = last;
+    return top;
+}
+
+static void
+run_file_failure(const SortRun_t *run)
+{
+    fprintf(stderr,
+            "reordercap: An error occurred while using the temporary file \"%s\": %s.\n",
+            run->path, g_strerror(errno));
+    exit(1);
+}
+
+static SortRun_t *
+run_new(void)
+{
+    SortRun_t *run = g_new0(SortRun_t, 1);
+    char *path;
+    int fd;
+
+    fd = create_tempfile(&path, "reordercap", NULL);
+    if (fd == -1) {
+        fprintf(stderr,
+                "reordercap: Can't create a temporary file: %s.\n",
+                g_strerror(errno));
+        exit(1);
+    }
+    run->path = g_strdup(path);
+    run->fh = ws_fdopen(fd, "w+b");
+    if (run->fh == NULL)
+        run_file_failure(run);
+    return run;
+}
+
+/* Close a run once it has been written, until it's merged */
+static void
+run_close(SortRun_t *run)
+{
+    if (fclose(run->fh) == EOF)
+        run_file_failure(run);
+    run->fh = NULL;
+}
+
+static void
+run_write(SortRun_t *run, const FrameRecord_t *frames, guint count)
+{
+    if (fwrite(frames, sizeof (FrameRecord_t), count, run->fh) != count)
+        run_file_failure(run);
+}
+
+/* Read the next frame of a run, return FALSE at its end */
+static gboolean
+run_read(SortRun_t *run)
+{
+    if (fread(&run->frame, sizeof (FrameRecord_t), 1, run->fh) == 1)
+        return TRUE;
+    if (ferror(run->fh))
+        run_file_failure(run);
+    return FALSE;
+}
+
+static void
+run_free(SortRun_t *run)
+{
+    if (run->fh != NULL)
+        fclose(run->fh);
+    ws_unlink(run->path);
+    g_free(run->path);
+    g_free(run);
+}
+
+/*
+ * Start merging the runs from runs->pdata[first] on, which are removed
+ * from runs and freed as they are exhausted
+ */
+static void
+merge_start(GPtrArray *heap, GPtrArray *runs, guint first)
+{
+    guint i;
+
+    for (i = first; i < runs->len; i++) {
+        SortRun_t *run = (SortRun_t *)runs->pdata[i];
+
+        run->fh = ws_fopen(run->path, "rb");
+        if (run->fh == NULL)
+            run_file_failure(run);
+        if (run_read(run))
+            heap_push(heap, run, runs_compare);
+        else
+            run_free(run);
+    }
+    g_ptr_array_set_size(runs, first);
+}
+
+/* Get the next frame in order from the runs, return FALSE at their end */
+static gboolean
+merge_next(GPtrArray *heap, FrameRecord_t *frame)
+{
+    SortRun_t *run = (SortRun_t *)heap_pop(heap, runs_compare);
+
+    if (run == NULL)
+        return FALSE;
+
+    *frame = run->frame;
+    if (run_read(run))
+        heap_push(heap, run, runs_compare);
+    else
+        run_free(run);
+    return TRUE;
+}
+
+/*
+ * Merge the runs from runs->pdata[first] on into a single one, to limit
+ * the number of open files
+ */
+static void
+runs_merge(GPtrArray *runs, guint first)
+{
+    GPtrArray *heap = g_ptr_array_new();
+    SortRun_t *merged = run_new();
+    FrameRecord_t frame;
+
+    merged->level = ((SortRun_t *)runs->pdata[first])->level + 1;
+    merge_start(heap, runs, first);
+    while (merge_next(heap, &frame))
+        run_write(merged, &frame, 1);
+    g_ptr_array_free(heap, TRUE);
+    run_close(merged);
+    g_ptr_array_add(runs, merged);
+}
+
+/*
+ * Sort the frames in memory and save them as a new run, then merge the
+ * last MAX_MERGE_RUNS runs as long as they have the same level. The levels
+ * of the runs never increase from the first run to the last.
+ */
+static void
+runs_add(GPtrArray *runs, GArray *frames)
+{
+    SortRun_t *run = run_new();
+
+    g_array_sort(frames, frames_compare);
+    run_write(run, (FrameRecord_t *)(void *)frames->data, frames->len);
+    run_close(run);
+    g_array_set_size(frames, 0);
+    g_ptr_array_add(runs, run);
+
+    while (runs->len >= MAX_MERGE_RUNS) {
+        guint first = runs->len - MAX_MERGE_RUNS;
+
+        if (((SortRun_t *)runs->pdata[first])->level
+            != ((SortRun_t *)runs->pdata[runs->len - 1])->level)
+            break;
+        runs_merge(runs, first);
+    }
+}
+
+/*
+ * Merge the last runs, the smallest ones, until at most MAX_MERGE_RUNS
+ * are left to merge into the output file
+ */
+static void
+runs_reduce(GPtrArray *runs)
+{
+    while (runs->len > MAX_MERGE_RUNS) {
+        guint count = MIN(runs->len - MAX_MERGE_RUNS + 1, MAX_MERGE_RUNS);
+
+        runs_merge(runs, runs->len - count);
+    }
 }
 
 /*
@@ -182,8 +440,16 @@ main(int argc, char *argv[])
     GArray                      *nrb_hdrs = NULL;
     int                          ret = EXIT_SUCCESS;
 
-    GPtrArray *frames;
-    FrameRecord_t *prevFrame = NULL;
+    guint max_run_frames = 0;           /* -m, 0 for no limit */
+    guint reorder_window = 0;           /* -w, 0 for no window */
+    guint frame_count = 0;
+    guint late_count = 0;
+    GArray *frames = NULL;
+    GPtrArray *runs = NULL;
+    GPtrArray *heap = NULL;
+    FrameRecord_t newFrameRecord;
+    FrameRecord_t prevFrame;
+    FrameRecord_t lastWritten;
 
     int opt;
     static const struct option long_options[] = {
@@ -236,11 +502,17 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hm:nvw:", long_options, NULL)) != -1) {
         switch (opt) {
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'm':
+                max_run_frames = get_nonzero_guint32(optarg, "number of frames to sort in memory");
+                break;
+            case 'w':
+                reorder_window = get_nonzero_guint32(optarg, "reorder window");
+                break;
             case 'h':
                 printf("Reordercap (Wireshark) %s\n"
                        "Reorder timestamps of input file frames into output file.\n"
@@ -262,6 +534,12 @@ main(int argc, char *argv[])
         }
     }
 
+    if (reorder_window > 0 && (max_run_frames > 0 || !write_output_regardless)) {
+        fprintf(stderr, "reordercap: -w can't be used with -m or -n.\n");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - optind;
     if (file_count == 2) {
@@ -309,54 +587,106 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
-    /* Allocate the array of frame pointers. */
-    frames = g_ptr_array_new();
+    /*
+     * Without -w, the frames are sorted in memory, in runs of at most
+     * max_run_frames frames with -m, which are saved in temporary files
+     * and merged once all the frames have been read. With -w, frames are
+     * written as soon as reorder_window frames have been read after them.
+     */
+    frames = g_array_new(FALSE, FALSE, sizeof (FrameRecord_t));
+    runs = g_ptr_array_new();
+    heap = g_ptr_array_new();
+    wtap_rec_init(&dump_rec);
+    ws_buffer_init(&buf, 1500);
+    lastWritten.num = 0;
 
     /* Read each frame from infile */
     while (wtap_read(wth, &err, &err_info, &data_offset)) {
-        FrameRecord_t *newFrameRecord;
-
         rec = wtap_get_rec(wth);
 
-        newFrameRecord = g_slice_new(FrameRecord_t);
-        newFrameRecord->num = frames->len + 1;
-        newFrameRecord->offset = data_offset;
+        newFrameRecord.num = ++frame_count;
+        newFrameRecord.offset = data_offset;
         if (rec->presence_flags & WTAP_HAS_TS) {
-            newFrameRecord->frame_time = rec->ts;
+            newFrameRecord.frame_time = rec->ts;
         } else {
-            nstime_set_unset(&newFrameRecord->frame_time);
+            nstime_set_unset(&newFrameRecord.frame_time);
         }
 
-        if (prevFrame && frames_compare(&newFrameRecord, &prevFrame) < 0) {
+        if (frame_count > 1 && frames_compare(&newFrameRecord, &prevFrame) < 0) {
            wrong_order_count++;
         }
-
-        g_ptr_array_add(frames, newFrameRecord);
         prevFrame = newFrameRecord;
+
+        if (reorder_window > 0) {
+            heap_push(heap, g_slice_dup(FrameRecord_t, &newFrameRecord), frames_compare);
+            if (heap->len > reorder_window) {
+                FrameRecord_t *frame = (FrameRecord_t *)heap_pop(heap, frames_compare);
+
+                if (lastWritten.num != 0 && frames_compare(frame, &lastWritten) < 0) {
+                    late_count++;
+                }
+                frame_write(frame, wth, pdh, &dump_rec, &buf, infile, outfile);
+                lastWritten = *frame;
+                g_slice_free(FrameRecord_t, frame);
+            }
+            continue;
+        }
+
+        g_array_append_val(frames, newFrameRecord);
+        if (max_run_frames > 0 && frames->len >= max_run_frames) {
+            runs_add(runs, frames);
+        }
     }
     if (err != 0) {
       /* Print a message noting that the read failed somewhere along the line. */
       cfile_read_failure_message("reordercap", infile, err, err_info);
     }
 
-    printf("%u frames, %u out of order\n", frames->len, wrong_order_count);
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
 
-    /* Sort the frames */
-    if (wrong_order_count > 0) {
-        g_ptr_array_sort(frames, frames_compare);
-    }
+    if (reorder_window > 0) {
+        /* Write out the frames left in the window */
+        FrameRecord_t *frame;
 
-    /* Write out each sorted frame in turn */
-    wtap_rec_init(&dump_rec);
-    ws_buffer_init(&buf, 1500);
-    for (i = 0; i < frames->len; i++) {
-        FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
-
-        /* Avoid writing if already sorted and configured to */
-        if (write_output_regardless || (wrong_order_count > 0)) {
+        while ((frame = (FrameRecord_t *)heap_pop(heap, frames_compare)) != NULL) {
+            if (lastWritten.num != 0 && frames_compare(frame, &lastWritten) < 0) {
+                late_count++;
+            }
+            lastWritten = *frame;
             frame_write(frame, wth, pdh, &dump_rec, &buf, infile, outfile);
+            g_slice_free(FrameRecord_t, frame);
+        }
+        if (late_count > 0) {
+            fprintf(stderr,
+                    "reordercap: %u frames were more than %u frames out of place and are still out of order.\n",
+                    late_count, reorder_window);
+        }
+    } else if (write_output_regardless || (wrong_order_count > 0)) {
+        if (runs->len == 0) {
+            /* Sort the frames */
+            if (wrong_order_count > 0) {
+                g_array_sort(frames, frames_compare);
+            }
+
+            /* Write out each sorted frame in turn */
+            for (i = 0; i < frames->len; i++) {
+                frame_write(&g_array_index(frames, FrameRecord_t, i), wth, pdh,
+                            &dump_rec, &buf, infile, outfile);
+            }
+        } else {
+            FrameRecord_t frame;
+
+            if (frames->len > 0) {
+                runs_add(runs, frames);
+            }
+
+            /* Write out the frames of all the runs in order */
+            runs_reduce(runs);
+            merge_start(heap, runs, 0);
+            while (merge_next(heap, &frame)) {
+                frame_write(&frame, wth, pdh, &dump_rec, &buf, infile, outfile);
+            }
         }
-        g_slice_free(FrameRecord_t, frame);
     }
     wtap_rec_cleanup(&dump_rec);
     ws_buffer_free(&buf);
@@ -365,8 +695,13 @@ main(int argc, char *argv[])
         printf("Not writing output file because input file is already in order.\n");
     }
 
-    /* Free the whole array */
-    g_ptr_array_free(frames, TRUE);
+    /* Free the frames, and the runs which haven't been merged */
+    g_array_free(frames, TRUE);
+    for (i = 0; i < runs->len; i++) {
+        run_free((SortRun_t *)runs->pdata[i]);
+    }
+    g_ptr_array_free(runs, TRUE);
+    g_ptr_array_free(heap, TRUE);
 
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err)) {
@@ -26,12 +26,25 @@
  * the files at switch and not the capture stop, and by closing them which
  * makes possible their move or deletion after a switch).
  *
+ * Flushing and closing the previous file, removing the file that drops
+ * out of the ring and creating (and preallocating) the next file are done
+ * by a helper thread, so that switching files doesn't stall the capture
+ * loop. ringbuf_previous_files_closed() tells once the previous files are
+ * complete on disk. The next file is created ahead of time under a
+ * temporary name and renamed to its final name when we switch to it; if it
+ * isn't ready yet, we create it directly as before.
+ *
  */
 
 #include <config.h>
 
 #ifdef HAVE_LIBPCAP
 
+#ifdef HAVE_FALLOCATE
+#define _GNU_SOURCE /* Otherwise fallocate() and FALLOC_FL_KEEP_SIZE won't be defined */
+#include <fcntl.h>
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -43,6 +56,7 @@
 
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
+#include "writecap/pcapio.h"
 
 
 /* Ringbuffer file structure */
@@ -50,6 +64,37 @@ typedef struct _rb_file {
   gchar         *name;
 } rb_file;
 
+/* Work for the helper thread */
+typedef enum {
+  RB_JOB_CLOSE,                      /* close a file we've switched away from */
+  RB_JOB_UNLINK,                     /* remove a file that dropped out of the ring */
+  RB_JOB_PREPARE,                    /* create the spare file for the next switch */
+  RB_JOB_STOP                        /* terminate the helper thread */
+} rb_job_type;
+
+typedef struct _rb_job {
+  rb_job_type   type;
+  FILE         *pdh;                 /* RB_JOB_CLOSE */
+  void         *pdh_buf;             /* RB_JOB_CLOSE */
+  gchar        *name;                /* RB_JOB_UNLINK */
+} rb_job;
+
+/* A file created ahead of time by the helper thread */
+typedef struct _rb_spare {
+  int           fd;                  /* -1 if the file couldn't be created */
+  gchar        *name;                /* temporary name */
+} rb_spare;
+
+/*
+ * Files can't be renamed while they are open on Windows, so there we don't
+ * create the next file ahead of time.
+ */
+#ifdef _WIN32
+#define RINGBUF_PREPARE_NEXT_FILE FALSE
+#else
+#define RINGBUF_PREPARE_NEXT_FILE TRUE
+#endif
+
 /* Ringbuffer data structure */
 typedef struct _ringbuf_data {
   rb_file      *files;
@@ -61,11 +106,135 @@ typedef struct _ringbuf_data {
 
   int           fd;                  /* Current ringbuffer file descriptor */
   FILE         *pdh;
+  void         *pdh_buf;             /* stdio buffer of pdh */
   gboolean      group_read_access;   /* TRUE if files need to be opened with group read access */
+  guint64       prealloc_size;       /* Number of bytes to preallocate for each file, 0 for none */
+
+  GThread      *helper;              /* Helper thread, see above */
+  GAsyncQueue  *job_q;               /* rb_job's for the helper thread */
+  GAsyncQueue  *spare_q;             /* rb_spare's prepared by the helper thread */
+  GAsyncQueue  *closed_q;            /* one item per file closed by the helper thread */
+  guint         closes_pending;      /* files queued for closing not in closed_q yet */
+  gboolean      spare_pending;       /* TRUE if we asked for a spare we didn't get yet */
+  volatile gint helper_err;          /* First error the helper thread got closing a file */
 } ringbuf_data;
 
 static ringbuf_data rb_data;
 
+/*
+ * Reserve disk space for a new ringbuffer file, without changing its size,
+ * so that the file system doesn't have to allocate it piecemeal while we
+ * are writing packets. This is only a hint; errors are ignored.
+ */
+static void ringbuf_preallocate(int fd)
+{
+#ifdef HAVE_FALLOCATE
+  if (rb_data.prealloc_size > 0) {
+    (void) fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)rb_data.prealloc_size);
+  }
+#else
+  (void) fd;
+#endif
+}
+
+static gpointer ringbuf_helper_thread(gpointer data _U_)
+{
+  rb_job   *job;
+  rb_spare *spare;
+  gboolean  stop = FALSE;
+
+  while (!stop) {
+    job = (rb_job *)g_async_queue_pop(rb_data.job_q);
+    switch (job->type) {
+
+    case RB_JOB_CLOSE:
+      if (fclose(job->pdh) == EOF) {
+        (void) g_atomic_int_compare_and_exchange(&rb_data.helper_err, 0, errno ? errno : EIO);
+      }
+      g_free(job->pdh_buf);
+      g_async_queue_push(rb_data.closed_q, GINT_TO_POINTER(1));
+      break;
+
+    case RB_JOB_UNLINK:
+      /* remove old file (if any, so ignore error) */
+      ws_unlink(job->name);
+      g_free(job->name);
+      break;
+
+    case RB_JOB_PREPARE:
+      spare = g_new(rb_spare, 1);
+      /* in the same directory, so that it can be renamed; never reuse a
+         file that exists already */
+      spare->name = g_strdup_printf("%s_next_%u%s", rb_data.fprefix,
+                                    (guint)ws_getpid(),
+                                    rb_data.fsuffix ? rb_data.fsuffix : "");
+      spare->fd = ws_open(spare->name, O_RDWR|O_BINARY|O_EXCL|O_CREAT,
+                          rb_data.group_read_access ? 0640 : 0600);
+      if (spare->fd != -1) {
+        ringbuf_preallocate(spare->fd);
+      }
+      /* Hand it over even if it failed, so that another one can be requested */
+      g_async_queue_push(rb_data.spare_q, spare);
+      break;
+
+    case RB_JOB_STOP:
+      stop = TRUE;
+      break;
+    }
+    g_free(job);
+  }
+
+  return NULL;
+}
+
+static void ringbuf_queue_job(rb_job_type type, FILE *pdh, void *pdh_buf, gchar *name)
+{
+  rb_job *job = g_new(rb_job, 1);
+
+  job->type = type;
+  job->pdh = pdh;
+  job->pdh_buf = pdh_buf;
+  job->name = name;
+  g_async_queue_push(rb_data.job_q, job);
+}
+
+/*
+ * Wait for the helper thread to finish everything it was asked to do and
+ * get rid of the spare file, if any.
+ * Returns the first error the helper thread got closing a file, or 0.
+ */
+static int ringbuf_stop_helper(void)
+{
+  rb_spare *spare;
+
+  if (rb_data.helper == NULL) {
+    return 0;
+  }
+
+  ringbuf_queue_job(RB_JOB_STOP, NULL, NULL, NULL);
+  g_thread_join(rb_data.helper);
+  rb_data.helper = NULL;
+
+  while ((spare = (rb_spare *)g_async_queue_try_pop(rb_data.spare_q)) != NULL) {
+    if (spare->fd != -1) {
+      ws_close(spare->fd);
+      ws_unlink(spare->name);
+    }
+    g_free(spare->name);
+    g_free(spare);
+  }
+  rb_data.spare_pending = FALSE;
+  g_async_queue_unref(rb_data.spare_q);
+  rb_data.spare_q = NULL;
+  rb_data.closes_pending = 0;
+  g_async_queue_unref(rb_data.closed_q);
+  rb_data.closed_q = NULL;
+  g_async_queue_unref(rb_data.job_q);
+  rb_data.job_q = NULL;
+
+  return g_atomic_int_get(&rb_data.helper_err);
+}
+
 
 /*
  * create the next filename and open a new binary file with that name
@@ -77,13 +246,8 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
   time_t  current_time;
   struct tm *tm;
 
-  if (rfile->name != NULL) {
-    if (rb_data.unlimited == FALSE) {
-      /* remove old file (if any, so ignore error) */
-      ws_unlink(rfile->name);
-    }
-    g_free(rfile->name);
-  }
+  gchar  *old_name = rfile->name;
+  rb_spare *spare = NULL;
 
 #ifdef _WIN32
   _tzset();
@@ -99,17 +263,58 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
   rfile->name = g_strconcat(rb_data.fprefix, "_", filenum, "_", timestr,
                             rb_data.fsuffix, NULL);
 
-  if (rfile->name == NULL) {
-    if (err != NULL)
-      *err = ENOMEM;
-    return -1;
+  if (old_name != NULL) {
+    if (rb_data.unlimited == FALSE) {
+      /* remove old file (if any, so ignore error) */
+      if (rb_data.helper != NULL && strcmp(old_name, rfile->name) != 0) {
+        ringbuf_queue_job(RB_JOB_UNLINK, NULL, NULL, old_name);
+        old_name = NULL;
+      } else {
+        ws_unlink(old_name);
+      }
+    }
+    g_free(old_name);
+  }
+
+  /* use the file the helper thread created for us, if it's ready */
+  if (rb_data.spare_pending) {
+    spare = (rb_spare *)g_async_queue_try_pop(rb_data.spare_q);
+  }
+  if (spare != NULL) {
+    rb_data.spare_pending = FALSE;
+    if (spare->fd != -1 && ws_rename(spare->name, rfile->name) == 0) {
+      rb_data.fd = spare->fd;
+    } else {
+      if (spare->fd != -1) {
+        ws_close(spare->fd);
+        ws_unlink(spare->name);
+      }
+      g_free(spare->name);
+      g_free(spare);
+      spare = NULL;
+    }
   }
 
-  rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
-                            rb_data.group_read_access ? 0640 : 0600);
+  if (spare == NULL) {
+    rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+                              rb_data.group_read_access ? 0640 : 0600);
 
-  if (rb_data.fd == -1 && err != NULL) {
-    *err = errno;
+    if (rb_data.fd == -1 && err != NULL) {
+      *err = errno;
+    }
+    if (rb_data.fd != -1) {
+      ringbuf_preallocate(rb_data.fd);
+    }
+  } else {
+    g_free(spare->name);
+    g_free(spare);
+  }
+
+  /* get the file after this one ready */
+  if (RINGBUF_PREPARE_NEXT_FILE && rb_data.helper != NULL &&
+      rb_data.fd != -1 && !rb_data.spare_pending) {
+    ringbuf_queue_job(RB_JOB_PREPARE, NULL, NULL, NULL);
+    rb_data.spare_pending = TRUE;
   }
 
   return rb_data.fd;
@@ -119,7 +324,8 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
  * Initialize the ringbuffer data structures
  */
 int
-ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access)
+ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access,
+             guint64 prealloc_size)
 {
   unsigned int i;
   char        *pfx, *last_pathsep;
@@ -132,7 +338,16 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.unlimited = FALSE;
   rb_data.fd = -1;
   rb_data.pdh = NULL;
+  rb_data.pdh_buf = NULL;
   rb_data.group_read_access = group_read_access;
+  rb_data.prealloc_size = prealloc_size;
+  rb_data.helper = NULL;
+  rb_data.job_q = NULL;
+  rb_data.spare_q = NULL;
+  rb_data.spare_pending = FALSE;
+  rb_data.closed_q = NULL;
+  rb_data.closes_pending = 0;
+  rb_data.helper_err = 0;
 
   /* just to be sure ... */
   if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -193,6 +408,11 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     rb_data.files[i].name = NULL;
   }
 
+  rb_data.job_q = g_async_queue_new();
+  rb_data.spare_q = g_async_queue_new();
+  rb_data.closed_q = g_async_queue_new();
+  rb_data.helper = g_thread_new("Ringbuffer helper", ringbuf_helper_thread, NULL);
+
   /* create the first file */
   if (ringbuf_open_file(&rb_data.files[0], NULL) == -1) {
     ringbuf_error_cleanup();
@@ -219,6 +439,8 @@ ringbuf_init_libpcap_fdopen(int *err)
     if (err != NULL) {
       *err = errno;
     }
+  } else {
+    rb_data.pdh_buf = pcapio_set_write_buffer(rb_data.pdh, PCAPIO_WRITE_BUFFER_SIZE);
   }
   return rb_data.pdh;
 }
@@ -232,20 +454,40 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
   int     next_file_index;
   rb_file *next_rfile = NULL;
 
-  /* close current file */
+  int     helper_err;
 
-  if (fclose(rb_data.pdh) == EOF) {
+  /* report an error the helper thread got closing an earlier file */
+
+  helper_err = g_atomic_int_get(&rb_data.helper_err);
+  if (helper_err != 0) {
+    if (err != NULL) {
+      *err = helper_err;
+    }
+    return FALSE;
+  }
+
+  /* close current file (in the background, if we can) */
+
+  if (rb_data.helper != NULL) {
+    ringbuf_queue_job(RB_JOB_CLOSE, rb_data.pdh, rb_data.pdh_buf, NULL);
+    rb_data.closes_pending++;
+  } else if (fclose(rb_data.pdh) == EOF) {
     if (err != NULL) {
       *err = errno;
     }
     ws_close(rb_data.fd);  /* XXX - the above should have closed this already */
     rb_data.pdh = NULL;    /* it's still closed, we just got an error while closing */
     rb_data.fd = -1;
+    g_free(rb_data.pdh_buf);
+    rb_data.pdh_buf = NULL;
     return FALSE;
+  } else {
+    g_free(rb_data.pdh_buf);
   }
 
   rb_data.pdh = NULL;
   rb_data.fd  = -1;
+  rb_data.pdh_buf = NULL;
 
   /* get the next file number and open it */
 
@@ -269,6 +511,25 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
   return TRUE;
 }
 
+/*
+ * Returns TRUE if the files we switched away from have been flushed and
+ * closed by the helper thread, so that they are complete on disk. If wait
+ * is TRUE, waits for that first.
+ */
+gboolean
+ringbuf_previous_files_closed(gboolean wait)
+{
+  while (rb_data.closes_pending > 0) {
+    if (wait) {
+      (void) g_async_queue_pop(rb_data.closed_q);
+    } else if (g_async_queue_try_pop(rb_data.closed_q) == NULL) {
+      return FALSE;
+    }
+    rb_data.closes_pending--;
+  }
+  return TRUE;
+}
+
 /*
  * Calls fclose() for the current ringbuffer file
  */
@@ -276,6 +537,16 @@ gboolean
 ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 {
   gboolean  ret_val = TRUE;
+  int       helper_err;
+
+  /* wait for the previous files to be closed */
+  helper_err = ringbuf_stop_helper();
+  if (helper_err != 0) {
+    if (err != NULL) {
+      *err = helper_err;
+    }
+    ret_val = FALSE;
+  }
 
   /* close current file, if it's open */
   if (rb_data.pdh != NULL) {
@@ -288,6 +559,8 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
     }
     rb_data.pdh = NULL;
     rb_data.fd  = -1;
+    g_free(rb_data.pdh_buf);
+    rb_data.pdh_buf = NULL;
   }
 
   /* set the save file name to the current file */
@@ -331,12 +604,16 @@ ringbuf_error_cleanup(void)
 {
   unsigned int i;
 
+  (void) ringbuf_stop_helper();
+
   /* try to close via wtap */
   if (rb_data.pdh != NULL) {
     if (fclose(rb_data.pdh) == 0) {
       rb_data.fd = -1;
     }
     rb_data.pdh = NULL;
+    g_free(rb_data.pdh_buf);
+    rb_data.pdh_buf = NULL;
   }
 
   /* close directly if still open */
@@ -0,0 +1,482 @@
+#!/usr/bin/env python3
+#
+# Measure how fast TShark dissects a capture in a few standard pipelines,
+# how fast dftest compiles display filters, how fast dumpcap writes a
+# capture it reads from a pipe, and how fast capinfos counts packets, so
+# that regressions in the dissection and capture hot paths show up. For every pipeline it prints the packets and
+# bytes per second and the peak resident set size.
+#
+# The capture is generated with benchmark_traffic.py unless one is given
+# with -r. The numbers can be saved with --save and compared with the
+# ones of another build with --compare, e.g.:
+#
+#   test/benchmark.py --bin-dir old/run --save old.json
+#   test/benchmark.py --bin-dir new/run --compare old.json
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+import argparse
+import gzip
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import benchmark_traffic
+
+DISPLAY_FILTER = ('tcp.flags.syn == 1 || http.request || dns.flags.response == 1'
+                  ' || ssl.handshake.type == 1 || rtp.marker == 1'
+                  ' || ip.flags.mf == 1 || wlan.fc.type_subtype == 0x08')
+
+FIELDS = ['frame.time_relative', 'ip.src', 'ip.dst', 'tcp.stream',
+          'udp.length', 'http.host', 'ssl.handshake.extensions_server_name',
+          'dns.qry.name', 'rtp.seq', 'wlan.ta']
+
+# name, description, arguments; the arguments are those after "-n -r <file>"
+PIPELINES = [
+    ('summary', 'one summary line per packet', []),
+    ('tree', 'full protocol tree (-V)', ['-V']),
+    ('filter', 'display filter (-Y)', ['-Y', DISPLAY_FILTER]),
+    ('fields', 'fields output (-T fields)',
+     ['-T', 'fields'] + [arg for field in FIELDS for arg in ('-e', field)]),
+    ('two-pass', 'two-pass analysis (-2)', ['-2']),
+    ('stats', 'statistics (-z conv,tcp -z io,phs)',
+     ['-q', '-z', 'conv,tcp', '-z', 'io,phs']),
+]
+
+# name, description, arguments, input format; the arguments are those
+# after "-q -i - -w <file>", with the capture on the standard input.
+# dumpcap writes pcapng when it reads pcapng, so -P gets a pcap input.
+DUMPCAP_PIPELINES = [
+    ('write', 'write pcapng from a pipe', [], 'pcapng'),
+    ('write-pcap', 'write pcap from a pipe (-P)', ['-P'], 'pcap'),
+]
+
+# name, description, arguments, input; the arguments are those before the
+# file name. "isb" input is the capture with an Interface Statistics Block
+# giving the number of packets of each interface appended to it. No hashes
+# are asked for, so capinfos only reads what the infos need.
+CAPINFOS_PIPELINES = [
+    ('count', 'count packets (-c -s -t)', ['-c', '-s', '-t'], 'capture'),
+    ('count-isb', 'count packets from ISBs (-c -s -t --isb-counts)',
+     ['-c', '-s', '-t', '--isb-counts'], 'isb'),
+]
+
+DFTEST_FILTERS = [
+    'tcp',
+    'ip.addr == 192.0.2.1',
+    'tcp.port == 80 || tcp.port == 443',
+    'ip.src == 10.0.1.0/24 && !(udp.port == 53)',
+    'http.request.method == "GET" && http.host contains "example"',
+    'dns.qry.name matches "^www\\\\." && dns.flags.rcode != 0',
+    'frame.len > 1000 && tcp.len > 0 && tcp.analysis.flags',
+    'wlan.fc.type_subtype == 0x08 && wlan.ssid == "bench-net"',
+    'sip.Method == "INVITE" || rtp.p_type in {0 8 101}',
+    DISPLAY_FILTER,
+]
+
+
+def capture_counts(path):
+    '''The number of packets in a pcap or pcapng file and their bytes.'''
+    with open(path, 'rb') as f:
+        magic = f.read(2)
+    opener = gzip.open if magic == b'\x1f\x8b' else open
+    packets = 0
+    total = 0
+    # Read the file a record at a time, not to make the RSS of the
+    # programs run from here bigger than it is (see run())
+    with opener(path, 'rb') as f:
+        magic = f.read(4)
+        if magic == b'\x0a\x0d\x0d\x0a':
+            header = magic + f.read(8)
+            while len(header) == 12:
+                if header[:4] == b'\x0a\x0d\x0d\x0a':
+                    endian = '<' if header[8:12] == b'\x4d\x3c\x2b\x1a' else '>'
+                block_type, length = struct.unpack(endian + 'II', header[:8])
+                if length < 12:
+                    break
+                body = header[8:] + f.read(length - 12)
+                if block_type == 6:
+                    packets += 1
+                    total += struct.unpack_from(endian + 'I', body, 12)[0]
+                elif block_type == 3:
+                    packets += 1
+                    total += struct.unpack_from(endian + 'I', body, 0)[0]
+                header = f.read(12)
+        elif magic in (b'\xd4\xc3\xb2\xa1', b'\x4d\x3c\xb2\xa1',
+                       b'\xa1\xb2\xc3\xd4', b'\xa1\xb2\x3c\x4d'):
+            endian = '<' if magic[0] in (0xd4, 0x4d) else '>'
+            f.read(20)
+            header = f.read(16)
+            while len(header) == 16:
+                caplen = struct.unpack_from(endian + 'I', header, 8)[0]
+                packets += 1
+                total += caplen
+                f.seek(caplen, 1)
+                header = f.read(16)
+        else:
+            raise ValueError('%s is not a pcap or pcapng file' % path)
+    return packets, total
+
+
+def pcapng_to_pcap(path, out):
+    '''Writes the packets of the first interface of the pcapng file path to
+    the pcap file out; returns their number and bytes, or None if path is
+    not a pcapng file.'''
+    with open(path, 'rb') as f:
+        magic = f.read(2)
+    opener = gzip.open if magic == b'\x1f\x8b' else open
+    packets = 0
+    total = 0
+    with opener(path, 'rb') as f:
+        header = f.read(12)
+        if header[:4] != b'\x0a\x0d\x0d\x0a':
+            return None
+        endian = '<'
+        linktype = None
+        units = 1000000
+        while len(header) == 12:
+            if header[:4] == b'\x0a\x0d\x0d\x0a':
+                endian = '<' if header[8:12] == b'\x4d\x3c\x2b\x1a' else '>'
+            block_type, length = struct.unpack(endian + 'II', header[:8])
+            if length < 12:
+                break
+            body = header[8:] + f.read(length - 12)
+            if block_type == 1 and linktype is None:
+                linktype = struct.unpack_from(endian + 'H', body, 0)[0]
+                out.write(struct.pack(endian + 'IHHiIII', 0xa1b2c3d4, 2, 4,
+                                      0, 0, 262144, linktype))
+                offset = 8
+                while offset + 4 <= len(body) - 4:
+                    code, optlen = struct.unpack_from(endian + 'HH', body, offset)
+                    if code == 0:
+                        break
+                    if code == 9 and optlen == 1:
+                        tsresol = body[offset + 4]
+                        units = 2 ** (tsresol & 0x7f) if tsresol & 0x80 \
+                            else 10 ** tsresol
+                    offset += 4 + optlen + (-optlen % 4)
+            elif block_type == 6 and linktype is not None:
+                iface, ts_high, ts_low, caplen, origlen = \
+                    struct.unpack_from(endian + 'IIIII', body, 0)
+                if iface == 0:
+                    ts = (ts_high << 32 | ts_low) * 1000000 // units
+                    out.write(struct.pack(endian + 'IIII', ts // 1000000,
+                                          ts % 1000000, caplen, origlen))
+                    out.write(body[20:20 + caplen])
+                    packets += 1
+                    total += caplen
+            header = f.read(12)
+    return packets, total
+
+
+def append_isbs(path, out):
+    '''Copies the pcapng file path to out with an ISB for each interface of
+    its last section appended, whose isb_usrdeliv is the number of packets
+    of that interface. Returns False if path is not an uncompressed pcapng
+    file.'''
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x0a\x0d\x0d\x0a':
+        return False
+    out.write(data)
+    endian = '<'
+    counts = []
+    pos = 0
+    while pos + 12 <= len(data):
+        if data[pos:pos + 4] == b'\x0a\x0d\x0d\x0a':
+            endian = '<' if data[pos + 8:pos + 12] == b'\x4d\x3c\x2b\x1a' else '>'
+            counts = []
+        block_type, length = struct.unpack_from(endian + 'II', data, pos)
+        if length < 12:
+            break
+        if block_type == 1:
+            counts.append(0)
+        elif block_type == 6:
+            counts[struct.unpack_from(endian + 'I', data, pos + 8)[0]] += 1
+        elif block_type == 3:
+            counts[0] += 1
+        pos += length
+    for iface, count in enumerate(counts):
+        options = struct.pack(endian + 'HHQ', 8, 8, count) + struct.pack(endian + 'HH', 0, 0)
+        length = 20 + len(options) + 4
+        out.write(struct.pack(endian + 'IIIII', 5, length, iface, 0, 0) + options +
+                  struct.pack(endian + 'I', length))
+    return True
+
+
+def find_bin_dir():
+    '''Where the binaries are, as test.sh and config.sh look for them.'''
+    if os.environ.get('WS_BIN_PATH'):
+        return os.environ['WS_BIN_PATH']
+    for name in ('tshark', 'tshark.exe'):
+        if os.path.exists(os.path.join('run', name)):
+            return os.path.abspath('run')
+    return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def program(bin_dir, name):
+    path = os.path.join(bin_dir, name)
+    if not os.path.exists(path) and os.path.exists(path + '.exe'):
+        path += '.exe'
+    return path
+
+
+def run(args, env, stdin=None):
+    '''Runs args; returns the wall time and the peak RSS in bytes, or None.
+
+    If stdin is given, it is the path of a file to read the standard input
+    from.
+
+    The peak RSS of a process includes the RSS it had before it ran the
+    program, which is that of this script; it is small, but it is there.
+    '''
+    stdin_file = open(stdin, 'rb') if stdin else subprocess.DEVNULL
+    start = time.perf_counter()
+    proc = subprocess.Popen(args, stdin=stdin_file, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, env=env)
+    if hasattr(os, 'wait4'):
+        stderr = proc.stderr.read()
+        _, status, usage = os.wait4(proc.pid, 0)
+        elapsed = time.perf_counter() - start
+        proc.returncode = os.waitstatus_to_exitcode(status) \
+            if hasattr(os, 'waitstatus_to_exitcode') else status >> 8
+        # kilobytes, except on macOS
+        rss = usage.ru_maxrss if sys.platform == 'darwin' else usage.ru_maxrss * 1024
+    else:
+        _, stderr = proc.communicate()
+        elapsed = time.perf_counter() - start
+        rss = None
+    proc.stderr.close()
+    if stdin:
+        stdin_file.close()
+    if proc.returncode != 0:
+        raise RuntimeError('%s failed (exit status %d):\n%s'
+                           % (' '.join(args), proc.returncode,
+                              stderr.decode('utf-8', 'replace')))
+    return elapsed, rss
+
+
+def measure(commands, repeat, env, stdin=None):
+    '''The best time of running commands repeat times, and the peak RSS.'''
+    best = None
+    peak = None
+    for _ in range(repeat):
+        elapsed = 0
+        for args in commands:
+            seconds, rss = run(args, env, stdin)
+            elapsed += seconds
+            if rss is not None:
+                peak = max(peak or 0, rss)
+        best = elapsed if best is None else min(best, elapsed)
+    return best, peak
+
+
+def print_results(results, baseline):
+    print('%-10s %9s %12s %10s %10s%s' % (
+        'pipeline', 'seconds', 'packets/s', 'MB/s', 'peak RSS',
+        '   change' if baseline else ''))
+    for name, result in results.items():
+        if result.get('packets_per_sec') is not None:
+            rate = '%12.0f %10.2f' % (result['packets_per_sec'],
+                                      result['bytes_per_sec'] / 1e6)
+        else:
+            rate = '%12s %10s' % ('%.1f f/s' % result['filters_per_sec'], '-')
+        rss = '%7.1f MB' % (result['peak_rss'] / 1e6) if result['peak_rss'] else '%10s' % 'n/a'
+        change = ''
+        if baseline and name in baseline:
+            change = '  %+6.1f%%' % ((result['seconds'] / baseline[name]['seconds'] - 1) * 100)
+        print('%-10s %9.3f %s %s%s' % (name, result['seconds'], rate, rss, change))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure the throughput of TShark, dftest and dumpcap.')
+    parser.add_argument('--bin-dir', help='directory of tshark, dftest and dumpcap '
+                        '(default: $WS_BIN_PATH, ./run or the source directory)')
+    parser.add_argument('-r', '--read-file', metavar='CAPTURE',
+                        help='capture to use instead of a generated one')
+    parser.add_argument('-c', '--packets', type=int,
+                        default=benchmark_traffic.DEFAULT_PACKETS,
+                        help='packets of the generated capture (default %(default)s)')
+    parser.add_argument('-s', '--seed', type=int,
+                        default=benchmark_traffic.DEFAULT_SEED,
+                        help='seed of the generated capture (default %(default)s)')
+    parser.add_argument('-m', '--mix', default=benchmark_traffic.DEFAULT_MIX,
+                        help='traffic mix of the generated capture '
+                        '(default %(default)s)')
+    parser.add_argument('-p', '--pipeline', action='append',
+                        choices=[p[0] for p in PIPELINES + DUMPCAP_PIPELINES
+                                 + CAPINFOS_PIPELINES] + ['dftest'],
+                        help='pipeline to run; may be given more than once '
+                        '(default: all of them)')
+    parser.add_argument('-l', '--list', action='store_true',
+                        help='list the pipelines and exit')
+    parser.add_argument('-n', '--repeat', type=int, default=3,
+                        help='runs of every pipeline, of which the fastest '
+                        'counts (default %(default)s)')
+    parser.add_argument('--save', metavar='FILE',
+                        help='save the results in FILE, as JSON')
+    parser.add_argument('--compare', metavar='FILE',
+                        help='compare with the results saved in FILE')
+    parser.add_argument('--threshold', type=float, default=10,
+                        help='with --compare, fail if a pipeline is slower '
+                        'by more than this percentage (default %(default)s)')
+    args = parser.parse_args()
+
+    if args.list:
+        for name, description, _ in PIPELINES:
+            print('%-10s tshark: %s' % (name, description))
+        print('%-10s dftest: compile %d display filters' % ('dftest', len(DFTEST_FILTERS)))
+        for name, description, _, _ in DUMPCAP_PIPELINES:
+            print('%-10s dumpcap: %s' % (name, description))
+        for name, description, _, _ in CAPINFOS_PIPELINES:
+            print('%-10s capinfos: %s' % (name, description))
+        return 0
+
+    bin_dir = args.bin_dir or find_bin_dir()
+    tshark = program(bin_dir, 'tshark')
+    dftest = program(bin_dir, 'dftest')
+    dumpcap = program(bin_dir, 'dumpcap')
+    capinfos = program(bin_dir, 'capinfos')
+    selected = args.pipeline or [p[0] for p in PIPELINES] + ['dftest'] + \
+        [p[0] for p in DUMPCAP_PIPELINES + CAPINFOS_PIPELINES]
+    needs = {
+        'tshark': [p[0] for p in PIPELINES],
+        'dftest': ['dftest'],
+        'dumpcap': [p[0] for p in DUMPCAP_PIPELINES],
+        'capinfos': [p[0] for p in CAPINFOS_PIPELINES],
+    }
+    for name, path in (('tshark', tshark), ('dftest', dftest), ('dumpcap', dumpcap),
+                       ('capinfos', capinfos)):
+        needed = any(p in selected for p in needs[name])
+        if needed and not os.path.exists(path):
+            parser.error('%s not found; use --bin-dir' % path)
+
+    baseline = None
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)['results']
+
+    workdir = tempfile.mkdtemp(prefix='wsbench')
+    results = {}
+    try:
+        # Run with empty preferences, so that the user's don't count
+        env = dict(os.environ)
+        env['HOME'] = workdir
+        env['APPDATA'] = workdir
+        env.pop('WIRESHARK_CONFIG_DIR', None)
+
+        if args.read_file:
+            capture = args.read_file
+            packets, total = capture_counts(capture)
+        else:
+            capture = os.path.join(workdir, 'benchmark.pcapng')
+            with open(capture, 'wb') as f:
+                packets, total = benchmark_traffic.generate(
+                    f, args.seed, args.packets, None, args.mix)
+        print('Capture: %s, %d packets, %d bytes' % (
+            args.read_file or 'generated (seed %d, mix %s)' % (args.seed, args.mix),
+            packets, total))
+
+        for name, _, extra in PIPELINES:
+            if name not in selected:
+                continue
+            seconds, rss = measure([[tshark, '-n', '-r', capture] + extra],
+                                   args.repeat, env)
+            results[name] = {
+                'seconds': seconds,
+                'packets_per_sec': packets / seconds,
+                'bytes_per_sec': total / seconds,
+                'peak_rss': rss,
+            }
+        if 'dftest' in selected:
+            seconds, rss = measure([[dftest, f] for f in DFTEST_FILTERS],
+                                   args.repeat, env)
+            results['dftest'] = {
+                'seconds': seconds,
+                'filters_per_sec': len(DFTEST_FILTERS) / seconds,
+                'peak_rss': rss,
+            }
+        for name, _, extra, input_format in DUMPCAP_PIPELINES:
+            if name not in selected:
+                continue
+            source, source_packets, source_total = capture, packets, total
+            if input_format == 'pcap':
+                source = os.path.join(workdir, 'benchmark.pcap')
+                with open(source, 'wb') as f:
+                    counts = pcapng_to_pcap(capture, f)
+                if counts is None:
+                    # Already a pcap file
+                    source = capture
+                else:
+                    source_packets, source_total = counts
+            output = os.path.join(workdir, 'dumpcap.out')
+            seconds, rss = measure([[dumpcap, '-q', '-i', '-', '-w', output] + extra],
+                                   args.repeat, env, stdin=source)
+            os.remove(output)
+            results[name] = {
+                'seconds': seconds,
+                'packets_per_sec': source_packets / seconds,
+                'bytes_per_sec': source_total / seconds,
+                'peak_rss': rss,
+            }
+        for name, _, extra, input_kind in CAPINFOS_PIPELINES:
+            if name not in selected:
+                continue
+            source = capture
+            if input_kind == 'isb':
+                source = os.path.join(workdir, 'benchmark-isb.pcapng')
+                with open(source, 'wb') as f:
+                    if not append_isbs(capture, f):
+                        raise ValueError('%s: %s needs an uncompressed pcapng file'
+                                         % (name, capture))
+            seconds, rss = measure([[capinfos] + extra + [source]],
+                                   args.repeat, env)
+            results[name] = {
+                'seconds': seconds,
+                'packets_per_sec': packets / seconds,
+                'bytes_per_sec': total / seconds,
+                'peak_rss': rss,
+            }
+    except (RuntimeError, ValueError) as e:
+        sys.stderr.write('%s\n' % e)
+        return 2
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    print_results(results, baseline)
+
+    if args.save:
+        with open(args.save, 'w') as f:
+            json.dump({
+                'capture': args.read_file or {'seed': args.seed,
+                                              'packets': args.packets,
+                                              'mix': args.mix},
+                'results': results,
+            }, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+    if baseline:
+        slower = [name for name in results if name in baseline and
+                  results[name]['seconds'] >
+                  baseline[name]['seconds'] * (1 + args.threshold / 100)]
+        if slower:
+            print('Slower by more than %g%%: %s' % (args.threshold,
+                                                   ', '.join(slower)))
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,774 @@
+#!/usr/bin/env python3
+#
+# Generate a synthetic but realistic capture file to measure the
+# performance of the dissectors with. The traffic is a mix of:
+#
+#   http   TCP connections with HTTP/1.1 requests and responses
+#   tls    TCP connections with a TLS 1.3 handshake and application data
+#   dns    DNS queries and responses over UDP
+#   frag   large ICMP echo requests and replies, in IPv4 fragments
+#   voip   SIP calls, with the RTP streams set up by their SDP
+#   wlan   DNS lookups and HTTP connections of stations of an 802.11
+#          network, along with the beacons of its access point
+#
+# The output only depends on the arguments: the same seed, size and mix
+# always give the same file, byte for byte, so that the numbers measured
+# with it can be compared between builds.
+#
+# The file is written in pcapng format, with an Ethernet interface and,
+# if the mix has "wlan" traffic, an 802.11 one.
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+import argparse
+import heapq
+import random
+import struct
+import sys
+import time
+
+DEFAULT_SEED = 1
+DEFAULT_PACKETS = 100000
+DEFAULT_MIX = 'http=30,tls=30,dns=20,frag=5,voip=2,wlan=10'
+DEFAULT_RATE = 40
+
+# 2018-01-01 00:00:00 UTC, in microseconds
+START_TIME = 1514764800 * 1000000
+
+LINKTYPE_ETHERNET = 1
+LINKTYPE_IEEE802_11 = 105
+
+IFACE_ETH = 0
+IFACE_WLAN = 1
+
+MSS = 1460
+MTU = 1500
+
+TCP_FIN = 0x01
+TCP_SYN = 0x02
+TCP_PSH = 0x08
+TCP_ACK = 0x10
+
+IPPROTO_ICMP = 1
+IPPROTO_TCP = 6
+IPPROTO_UDP = 17
+
+SERVER_NAMES = [
+    'www.example.com', 'static.example.com', 'cdn.example.net',
+    'api.example.org', 'images.example.net', 'mail.example.com',
+    'news.example.org', 'video.example.net', 'shop.example.com',
+    'login.example.org', 'updates.example.net', 'docs.example.com',
+]
+
+URL_PATHS = [
+    '/', '/index.html', '/css/site.css', '/js/app.js', '/img/logo.png',
+    '/api/v1/items?page=2', '/news/2018/01/01/story.html',
+    '/images/photo-1024.jpg', '/favicon.ico', '/search?q=wireshark',
+]
+
+USER_AGENT = ('Mozilla/5.0 (X11; Linux x86_64; rv:57.0) '
+              'Gecko/20100101 Firefox/57.0')
+
+SSID = b'bench-net'
+
+
+def checksum(data):
+    '''The Internet checksum of data.'''
+    if len(data) % 2:
+        data += b'\0'
+    # The one's complement sum of the 16 bit words is the number the
+    # words make up, modulo 0xffff.
+    n = int.from_bytes(data, 'big')
+    s = n % 0xffff
+    if s == 0 and n != 0:
+        s = 0xffff
+    return ~s & 0xffff
+
+
+def ip_addr(s):
+    return bytes(int(b) for b in s.split('.'))
+
+
+def mac_addr(s):
+    return bytes(int(b, 16) for b in s.split(':'))
+
+
+def dns_name(name):
+    encoded = b''
+    for label in name.split('.'):
+        encoded += bytes([len(label)]) + label.encode('ascii')
+    return encoded + b'\0'
+
+
+class PcapngWriter:
+    '''Writes the packets to a pcapng file.'''
+
+    def __init__(self, f):
+        self.f = f
+        self.f.write(struct.pack('<IIIHHq', 0x0a0d0d0a, 28, 0x1a2b3c4d,
+                                 1, 0, -1) + struct.pack('<I', 28))
+        self.packets = 0
+        self.bytes = 0
+
+    def add_interface(self, linktype, name):
+        name = name.encode('ascii')
+        opt = struct.pack('<HH', 2, len(name)) + name
+        opt += b'\0' * (-len(opt) % 4) + struct.pack('<HH', 0, 0)
+        length = 20 + len(opt)
+        self.f.write(struct.pack('<IIHHI', 1, length, linktype, 0, 262144) +
+                     opt + struct.pack('<I', length))
+
+    def write(self, iface, ts, data):
+        pad = b'\0' * (-len(data) % 4)
+        length = 32 + len(data) + len(pad)
+        self.f.write(struct.pack('<IIIIIII', 6, length, iface,
+                                 ts >> 32, ts & 0xffffffff,
+                                 len(data), len(data)) +
+                     data + pad + struct.pack('<I', length))
+        self.packets += 1
+        self.bytes += len(data)
+
+
+class Host:
+    def __init__(self, ip, mac):
+        self.ip = ip_addr(ip)
+        self.mac = mac_addr(mac)
+        self.ip_id = 0
+        self.port = 0
+
+    def next_ip_id(self):
+        self.ip_id = (self.ip_id + 1) & 0xffff
+        return self.ip_id
+
+    def next_port(self):
+        self.port = 49152 + (self.port - 49152 + 1) % 16384
+        return self.port
+
+
+class Link:
+    '''How the IP packets of a client are framed on the capture interface.'''
+
+    def __init__(self, traffic, client):
+        self.traffic = traffic
+        self.client = client
+
+    def frames(self, ts, from_client, packet):
+        '''The (timestamp, interface, frame) tuples carrying packet.'''
+        router = self.traffic.router
+        if from_client:
+            eth = router.mac + self.client.mac
+        else:
+            eth = self.client.mac + router.mac
+        return [(ts, IFACE_ETH, eth + b'\x08\x00' + packet)]
+
+
+class WlanLink(Link):
+    '''Framing of the packets of a station, as 802.11 data frames.'''
+
+    def frames(self, ts, from_client, packet):
+        traffic = self.traffic
+        bssid = traffic.bssid
+        llc = b'\xaa\xaa\x03\x00\x00\x00\x08\x00'
+        if from_client:
+            # To DS: receiver is the BSSID, the destination the router
+            hdr = struct.pack('<BBH', 0x08, 0x01, 44) + bssid + \
+                self.client.mac + traffic.router.mac
+            seq = traffic.next_wlan_seq(self.client.mac)
+            ack_to = self.client.mac
+        else:
+            # From DS: the source is the router
+            hdr = struct.pack('<BBH', 0x08, 0x02, 44) + self.client.mac + \
+                bssid + traffic.router.mac
+            seq = traffic.next_wlan_seq(bssid)
+            ack_to = bssid
+        data = hdr + struct.pack('<H', seq << 4) + llc + packet
+        ack = struct.pack('<BBH', 0xd4, 0x00, 0) + ack_to
+        # The ACK comes a SIFS after the end of the frame, at 54 Mbit/s
+        ack_ts = ts + 16 + len(data) * 8 // 54
+        return [(ts, IFACE_WLAN, data), (ack_ts, IFACE_WLAN, ack)]
+
+
+class Session:
+    '''The packets of one session, which all go through one link.'''
+
+    def __init__(self, traffic, link):
+        self.traffic = traffic
+        self.rng = traffic.rng
+        self.link = link
+        self.client = link.client
+        self.frames = []
+
+    def ip(self, ts, from_client, server, proto, payload, ttl=64,
+           flags=0x4000, ip_id=None):
+        if from_client:
+            src, dst = self.client, server
+        else:
+            src, dst = server, self.client
+            ttl -= 8
+        if ip_id is None:
+            ip_id = src.next_ip_id()
+        hdr = struct.pack('!BBHHHBBH4s4s', 0x45, 0, 20 + len(payload), ip_id,
+                          flags, ttl, proto, 0, src.ip, dst.ip)
+        hdr = hdr[:10] + struct.pack('!H', checksum(hdr)) + hdr[12:]
+        self.frames.extend(self.link.frames(ts, from_client, hdr + payload))
+
+    def udp(self, ts, from_client, server, sport, dport, payload):
+        if from_client:
+            src, dst = self.client, server
+        else:
+            src, dst = server, self.client
+        length = 8 + len(payload)
+        pseudo = src.ip + dst.ip + struct.pack('!BBH', 0, IPPROTO_UDP, length)
+        hdr = struct.pack('!HHHH', sport, dport, length, 0)
+        csum = checksum(pseudo + hdr + payload) or 0xffff
+        hdr = hdr[:6] + struct.pack('!H', csum)
+        self.ip(ts, from_client, server, IPPROTO_UDP, hdr + payload)
+
+    def dns_lookup(self, ts, name, resolver):
+        '''Looks up name; returns when the answer came.'''
+        rng = self.rng
+        qid = rng.getrandbits(16)
+        sport = self.client.next_port()
+        qtype = 28 if rng.random() < 0.3 else 1
+        question = dns_name(name) + struct.pack('!HH', qtype, 1)
+        query = struct.pack('!HHHHHH', qid, 0x0100, 1, 0, 0, 1) + question + \
+            b'\x00\x00\x29\x10\x00\x00\x00\x00\x00\x00\x00'
+        self.udp(ts, True, resolver, sport, 53, query)
+
+        answers = b''
+        ancount = 0
+        flags = 0x8180
+        if rng.random() < 0.05:
+            flags = 0x8183
+        else:
+            owner = 0xc00c
+            if rng.random() < 0.4:
+                target = dns_name('edge%d.cdn.example.net' % rng.randrange(64))
+                answers += struct.pack('!HHHIH', owner, 5, 1, 300,
+                                       len(target)) + target
+                ancount += 1
+                owner = 0xc000 | (12 + len(question) + 12)
+            for _ in range(rng.randint(1, 4)):
+                if qtype == 1:
+                    rdata = bytes([203, 0, 113, rng.randrange(1, 255)])
+                else:
+                    rdata = b'\x20\x01\x0d\xb8' + bytes(10) + \
+                        struct.pack('!H', rng.randrange(1, 0xffff))
+                answers += struct.pack('!HHHIH', owner, qtype, 1,
+                                       rng.randint(30, 3600), len(rdata)) + rdata
+                ancount += 1
+        response = struct.pack('!HHHHHH', qid, flags, 1, ancount, 0, 1) + \
+            question + answers + b'\x00\x00\x29\x10\x00\x00\x00\x00\x00\x00\x00'
+        ts += rng.randint(2000, 40000)
+        self.udp(ts, False, resolver, 53, sport, response)
+        return ts
+
+
+class TcpConnection:
+    '''A TCP connection of a session, seen from close to the client.'''
+
+    def __init__(self, session, ts, server, dport, rtt):
+        rng = session.rng
+        self.session = session
+        self.server = server
+        self.sport = session.client.next_port()
+        self.dport = dport
+        self.rtt = rtt
+        self.seq = [rng.getrandbits(32), rng.getrandbits(32)]
+        self.ts = ts
+
+    def segment(self, ts, from_client, flags, payload=b'', options=b'',
+                window=None):
+        side = 0 if from_client else 1
+        session = self.session
+        if from_client:
+            src, dst = session.client, self.server
+            sport, dport = self.sport, self.dport
+        else:
+            src, dst = self.server, session.client
+            sport, dport = self.dport, self.sport
+        if window is None:
+            window = 502 if from_client else 235
+        ack = self.seq[1 - side] if flags & TCP_ACK else 0
+        hdr_len = 20 + len(options)
+        hdr = struct.pack('!HHIIHHHH', sport, dport, self.seq[side], ack,
+                          (hdr_len // 4) << 12 | flags, window, 0, 0) + options
+        pseudo = src.ip + dst.ip + struct.pack('!BBH', 0, IPPROTO_TCP,
+                                               hdr_len + len(payload))
+        csum = checksum(pseudo + hdr + payload)
+        hdr = hdr[:16] + struct.pack('!H', csum) + hdr[18:]
+        session.ip(ts, from_client, self.server, IPPROTO_TCP, hdr + payload,
+                   ttl=64 if from_client else 128)
+        self.seq[side] = (self.seq[side] + len(payload) +
+                          (1 if flags & (TCP_SYN | TCP_FIN) else 0)) & 0xffffffff
+
+    def connect(self):
+        options = b'\x02\x04\x05\xb4\x01\x03\x03\x07\x01\x01\x04\x02'
+        self.segment(self.ts, True, TCP_SYN, options=options, window=64240)
+        self.ts += self.rtt
+        self.segment(self.ts, False, TCP_SYN | TCP_ACK, options=options,
+                     window=65535)
+        self.ts += 60
+        self.segment(self.ts, True, TCP_ACK)
+
+    def send(self, from_client, data, delay):
+        '''Sends data, delay microseconds after the last packet.'''
+        self.ts += delay
+        # the client ACKs right away, the server one round trip later
+        ack_delay = self.rtt if from_client else 40
+        # 100 Mbit/s
+        gap = MSS * 8 // 100
+        unacked = 0
+        for off in range(0, len(data), MSS):
+            chunk = data[off:off + MSS]
+            last = off + MSS >= len(data)
+            self.segment(self.ts, from_client,
+                         TCP_ACK | (TCP_PSH if last else 0), chunk)
+            unacked += 1
+            if unacked == 2 or last:
+                self.segment(self.ts + ack_delay, not from_client, TCP_ACK)
+                unacked = 0
+            if not last:
+                self.ts += gap
+        if from_client:
+            self.ts += self.rtt
+
+    def close(self):
+        self.ts += 50
+        self.segment(self.ts, True, TCP_FIN | TCP_ACK)
+        self.ts += self.rtt
+        self.segment(self.ts, False, TCP_FIN | TCP_ACK)
+        self.ts += 40
+        self.segment(self.ts, True, TCP_ACK)
+
+
+class Traffic:
+    '''Generates the sessions of the capture.'''
+
+    def __init__(self, seed, mix, rate):
+        self.rng = random.Random(seed)
+        self.mix = mix
+        self.rate = rate
+
+        self.router = Host('10.0.1.1', '02:00:0a:00:01:01')
+        self.clients = [Host('10.0.1.%d' % i, '02:00:0a:00:01:%02x' % i)
+                        for i in range(10, 250)]
+        self.stations = [Host('10.0.2.%d' % i, '02:00:0a:00:02:%02x' % i)
+                         for i in range(10, 60)]
+        self.resolver = Host('192.0.2.53', '00:00:00:00:00:00')
+        self.servers = {}
+        for i, name in enumerate(SERVER_NAMES):
+            net = ['192.0.2', '198.51.100', '203.0.113'][i % 3]
+            self.servers[name] = Host('%s.%d' % (net, 10 + i),
+                                      '00:00:00:00:00:00')
+        self.voip_peers = [Host('203.0.113.%d' % i, '00:00:00:00:00:00')
+                           for i in range(100, 110)]
+        self.bssid = mac_addr('02:00:00:00:aa:01')
+        self.wlan_seq = {}
+
+        self.text = self.make_text(65536)
+        self.kinds = [kind for kind, weight in mix for _ in range(weight)]
+        self.sessions = {
+            'http': self.http_session,
+            'tls': self.tls_session,
+            'dns': self.dns_session,
+            'frag': self.frag_session,
+            'voip': self.voip_session,
+            'wlan': self.wlan_session,
+        }
+
+    def make_text(self, size):
+        words = ['packet', 'capture', 'network', 'protocol', 'analyzer',
+                 'the', 'a', 'of', 'and', 'to', 'in', 'is', 'for', 'with',
+                 'frame', 'stream', 'filter', 'display', 'column', 'data']
+        out = []
+        length = 0
+        while length < size:
+            para = ' '.join(self.rng.choice(words)
+                            for _ in range(self.rng.randint(20, 80)))
+            para = '<p>' + para.capitalize() + '.</p>\n'
+            out.append(para)
+            length += len(para)
+        return ''.join(out).encode('ascii')
+
+    def random_bytes(self, n):
+        return self.rng.getrandbits(8 * n).to_bytes(n, 'little') if n else b''
+
+    def next_wlan_seq(self, mac):
+        seq = self.wlan_seq.get(mac, 0)
+        self.wlan_seq[mac] = (seq + 1) & 0xfff
+        return seq
+
+    def new_session(self, ts):
+        '''The frames of a new session starting at ts.'''
+        kind = self.rng.choice(self.kinds)
+        return self.sessions[kind](ts)
+
+    def pick_server(self):
+        name = self.rng.choice(SERVER_NAMES)
+        return name, self.servers[name]
+
+    def http_exchanges(self, session, ts, name, server):
+        rng = self.rng
+        conn = TcpConnection(session, ts, server, 80, rng.randint(5000, 80000))
+        conn.connect()
+        for i in range(rng.randint(1, 4)):
+            path = rng.choice(URL_PATHS)
+            request = ('GET %s HTTP/1.1\r\n'
+                       'Host: %s\r\n'
+                       'User-Agent: %s\r\n'
+                       'Accept: text/html,application/xhtml+xml,*/*;q=0.8\r\n'
+                       'Accept-Language: en-US,en;q=0.5\r\n'
+                       'Accept-Encoding: identity\r\n'
+                       'Connection: keep-alive\r\n\r\n'
+                       % (path, name, USER_AGENT)).encode('ascii')
+            conn.send(True, request, rng.randint(100, 200000) if i else 100)
+
+            if path.endswith(('.png', '.jpg', '.ico')):
+                ctype = 'image/' + ('jpeg' if path.endswith('.jpg') else 'png')
+                body = self.random_bytes(min(int(rng.lognormvariate(9, 1.2)),
+                                             262144))
+            else:
+                ctype = 'text/html; charset=utf-8'
+                size = min(int(rng.lognormvariate(8.5, 1.0)), len(self.text))
+                start = rng.randrange(len(self.text) - size + 1)
+                body = self.text[start:start + size]
+            date = time.strftime('%a, %d %b %Y %H:%M:%S GMT',
+                                 time.gmtime(conn.ts // 1000000))
+            response = ('HTTP/1.1 200 OK\r\n'
+                        'Date: %s\r\n'
+                        'Server: nginx/1.12.2\r\n'
+                        'Content-Type: %s\r\n'
+                        'Content-Length: %d\r\n'
+                        'Cache-Control: max-age=3600\r\n'
+                        'Connection: keep-alive\r\n\r\n'
+                        % (date, ctype, len(body))).encode('ascii') + body
+            conn.send(False, response, rng.randint(500, 50000))
+        conn.close()
+
+    def http_session(self, ts, link=None):
+        session = Session(self, link or Link(self, self.rng.choice(self.clients)))
+        name, server = self.pick_server()
+        if self.rng.random() < 0.5:
+            ts = session.dns_lookup(ts, name, self.resolver) + 200
+        self.http_exchanges(session, ts, name, server)
+        return session.frames
+
+    def tls_records(self, content_type, data, version=0x0303):
+        # protected records can have up to 256 more bytes than 2^14
+        size = 16384 + (256 if content_type == 23 else 0)
+        out = b''
+        for off in range(0, len(data), size):
+            chunk = data[off:off + size]
+            out += struct.pack('!BHH', content_type, version, len(chunk)) + chunk
+        return out
+
+    def client_hello(self, name):
+        rng = self.rng
+        ciphers = [0x1301, 0x1302, 0x1303, 0xc02b, 0xc02f, 0xc02c, 0xc030,
+                   0xcca9, 0xcca8, 0x009c, 0x009d, 0x002f, 0x0035]
+        host = name.encode('ascii')
+
+        def ext(ext_type, data):
+            return struct.pack('!HH', ext_type, len(data)) + data
+
+        exts = ext(0, struct.pack('!HBH', len(host) + 3, 0, len(host)) + host)
+        exts += ext(10, struct.pack('!HHHH', 6, 0x001d, 0x0017, 0x0018))
+        exts += ext(11, b'\x01\x00')
+        exts += ext(13, struct.pack('!9H', 16, 0x0403, 0x0804, 0x0401, 0x0503,
+                                    0x0805, 0x0501, 0x0806, 0x0601))
+        exts += ext(16, b'\x00\x0c\x02h2\x08http/1.1')
+        exts += ext(43, b'\x04\x03\x04\x03\x03')
+        exts += ext(45, b'\x01\x01')
+        exts += ext(51, struct.pack('!HHH', 36, 0x001d, 32) +
+                    self.random_bytes(32))
+        body = struct.pack('!H', 0x0303) + self.random_bytes(32) + \
+            b'\x20' + self.random_bytes(32) + \
+            struct.pack('!H%dH' % len(ciphers), 2 * len(ciphers), *ciphers) + \
+            b'\x01\x00' + struct.pack('!H', len(exts)) + exts
+        hello = struct.pack('!I', 0x01000000 | len(body)) + body
+        return self.tls_records(22, hello, 0x0301), body[35:67]
+
+    def server_hello(self, session_id):
+        exts = struct.pack('!HHH', 43, 2, 0x0304)
+        exts += struct.pack('!HHHH', 51, 36, 0x001d, 32) + self.random_bytes(32)
+        body = struct.pack('!H', 0x0303) + self.random_bytes(32) + \
+            b'\x20' + session_id + struct.pack('!HB', 0x1301, 0) + \
+            struct.pack('!H', len(exts)) + exts
+        hello = struct.pack('!I', 0x02000000 | len(body)) + body
+        return self.tls_records(22, hello)
+
+    def tls_session(self, ts):
+        rng = self.rng
+        session = Session(self, Link(self, rng.choice(self.clients)))
+        name, server = self.pick_server()
+        if rng.random() < 0.5:
+            ts = session.dns_lookup(ts, name, self.resolver) + 200
+        conn = TcpConnection(session, ts, server, 443, rng.randint(5000, 80000))
+        conn.connect()
+        ccs = self.tls_records(20, b'\x01')
+        hello, session_id = self.client_hello(name)
+        conn.send(True, hello, 100)
+        # encrypted extensions, certificate, certificate verify, finished
+        flight = self.tls_records(23, self.random_bytes(rng.randint(2500, 4500)))
+        conn.send(False, self.server_hello(session_id) + ccs + flight,
+                  rng.randint(500, 5000))
+        conn.send(True, ccs + self.tls_records(23, self.random_bytes(53)), 200)
+        for i in range(rng.randint(1, 6)):
+            request = self.random_bytes(rng.randint(200, 700) + 22)
+            conn.send(True, self.tls_records(23, request),
+                      rng.randint(100, 300000) if i else 100)
+            size = min(int(rng.lognormvariate(9, 1.3)), 524288)
+            response = b''.join(
+                self.tls_records(23, self.random_bytes(min(16384, size - off) + 17))
+                for off in range(0, size, 16384))
+            conn.send(False, response, rng.randint(500, 50000))
+        conn.send(True, self.tls_records(23, self.random_bytes(19)), 100)
+        conn.close()
+        return session.frames
+
+    def dns_session(self, ts):
+        session = Session(self, Link(self, self.rng.choice(self.clients)))
+        for _ in range(self.rng.randint(1, 3)):
+            name, _ = self.pick_server()
+            ts = session.dns_lookup(ts, name, self.resolver) + \
+                self.rng.randint(100, 5000)
+        return session.frames
+
+    def frag_session(self, ts):
+        rng = self.rng
+        session = Session(self, Link(self, rng.choice(self.clients)))
+        _, server = self.pick_server()
+        ident = rng.getrandbits(16)
+        data = self.random_bytes(rng.randint(2000, 8000))
+        for seq in range(1, rng.randint(2, 5)):
+            for from_client, icmp_type in ((True, 8), (False, 0)):
+                src = session.client if from_client else server
+                msg = struct.pack('!BBHHH', icmp_type, 0, 0, ident, seq) + data
+                msg = msg[:2] + struct.pack('!H', checksum(msg)) + msg[4:]
+                ip_id = src.next_ip_id()
+                step = (MTU - 20) // 8 * 8
+                frags = [(off, msg[off:off + step])
+                         for off in range(0, len(msg), step)]
+                # some stacks send the last fragment first
+                if not from_client and rng.random() < 0.2:
+                    frags.reverse()
+                for off, frag in frags:
+                    more = 0x2000 if off + len(frag) < len(msg) else 0
+                    session.ip(ts, from_client, server, IPPROTO_ICMP, frag,
+                               flags=more | off // 8, ip_id=ip_id)
+                    ts += len(frag) * 8 // 100
+                ts += rng.randint(10000, 60000)
+            ts += 1000000
+        return session.frames
+
+    def sdp(self, user, ip, port, session_id):
+        return ('v=0\r\n'
+                'o=%s %d %d IN IP4 %s\r\n'
+                's=-\r\n'
+                'c=IN IP4 %s\r\n'
+                't=0 0\r\n'
+                'm=audio %d RTP/AVP 0 8 101\r\n'
+                'a=rtpmap:0 PCMU/8000\r\n'
+                'a=rtpmap:8 PCMA/8000\r\n'
+                'a=rtpmap:101 telephone-event/8000\r\n'
+                'a=fmtp:101 0-15\r\n'
+                'a=ptime:20\r\n'
+                'a=sendrecv\r\n'
+                % (user, session_id, session_id, ip, ip, port)).encode('ascii')
+
+    def voip_session(self, ts):
+        rng = self.rng
+        session = Session(self, Link(self, rng.choice(self.clients)))
+        peer = rng.choice(self.voip_peers)
+        caller_ip = '.'.join(str(b) for b in session.client.ip)
+        callee_ip = '.'.join(str(b) for b in peer.ip)
+        caller_port = 16384 + 2 * rng.randrange(8192)
+        callee_port = 16384 + 2 * rng.randrange(8192)
+        call_id = '%032x@%s' % (rng.getrandbits(128), caller_ip)
+        from_tag = '%08x' % rng.getrandbits(32)
+        to_tag = '%08x' % rng.getrandbits(32)
+        ext = 1000 + rng.randrange(9000)
+
+        def sip(from_client, start, cseq, to_tagged, body=b''):
+            branch = 'z9hG4bK%016x' % rng.getrandbits(64)
+            msg = start + '\r\n'
+            msg += 'Via: SIP/2.0/UDP %s:5060;branch=%s\r\n' % (caller_ip, branch)
+            if start.startswith(('INVITE', 'ACK', 'BYE')):
+                msg += 'Max-Forwards: 70\r\n'
+            msg += 'From: "Caller" <sip:caller@%s>;tag=%s\r\n' % (caller_ip, from_tag)
+            msg += 'To: <sip:%d@%s>%s\r\n' % (ext, callee_ip,
+                                              ';tag=' + to_tag if to_tagged else '')
+            msg += 'Call-ID: %s\r\n' % call_id
+            msg += 'CSeq: %s\r\n' % cseq
+            if start.startswith('INVITE'):
+                msg += 'Contact: <sip:caller@%s:5060>\r\n' % caller_ip
+            elif start.endswith('200 OK') and body:
+                msg += 'Contact: <sip:%d@%s:5060>\r\n' % (ext, callee_ip)
+            msg += 'User-Agent: bench-phone/1.0\r\n'
+            if body:
+                msg += 'Content-Type: application/sdp\r\n'
+            msg += 'Content-Length: %d\r\n\r\n' % len(body)
+            session.udp(ts, from_client, peer, 5060, 5060,
+                        msg.encode('ascii') + body)
+
+        uri = 'sip:%d@%s' % (ext, callee_ip)
+        sip(True, 'INVITE %s SIP/2.0' % uri, '1 INVITE', False,
+            self.sdp('caller', caller_ip, caller_port, rng.getrandbits(31)))
+        ts += rng.randint(5000, 30000)
+        sip(False, 'SIP/2.0 100 Trying', '1 INVITE', False)
+        ts += rng.randint(10000, 100000)
+        sip(False, 'SIP/2.0 180 Ringing', '1 INVITE', True)
+        ts += rng.randint(1000000, 5000000)
+        sip(False, 'SIP/2.0 200 OK', '1 INVITE', True,
+            self.sdp('callee', callee_ip, callee_port, rng.getrandbits(31)))
+        ts += rng.randint(5000, 30000)
+        sip(True, 'ACK %s SIP/2.0' % uri, '1 ACK', True)
+
+        packets = rng.randint(50, 500)
+        for from_client, sport, dport in ((True, caller_port, callee_port),
+                                          (False, callee_port, caller_port)):
+            ssrc = rng.getrandbits(32)
+            seq = rng.getrandbits(16)
+            rtp_ts = rng.getrandbits(32)
+            t = ts + rng.randint(0, 20000)
+            for i in range(packets):
+                hdr = struct.pack('!BBHII', 0x80, 0x80 if i == 0 else 0x00,
+                                  (seq + i) & 0xffff,
+                                  (rtp_ts + 160 * i) & 0xffffffff, ssrc)
+                session.udp(t + 20000 * i + rng.randint(0, 2000), from_client,
+                            peer, sport, dport, hdr + self.random_bytes(160))
+        ts += 20000 * packets + 40000
+        sip(True, 'BYE %s SIP/2.0' % uri, '2 BYE', True)
+        ts += rng.randint(5000, 30000)
+        sip(False, 'SIP/2.0 200 OK', '2 BYE', True)
+        return session.frames
+
+    def wlan_session(self, ts):
+        link = WlanLink(self, self.rng.choice(self.stations))
+        return self.http_session(ts, link)
+
+    def beacons(self):
+        '''The beacons of the access point, every 102.4 ms, forever.'''
+        ies = bytes([0, len(SSID)]) + SSID
+        ies += b'\x01\x08\x82\x84\x8b\x96\x0c\x12\x18\x24'
+        ies += b'\x03\x01\x06'
+        ies += b'\x05\x04\x00\x01\x00\x00'
+        ies += b'\x2a\x01\x00'
+        ies += b'\x32\x04\x30\x48\x60\x6c'
+        uptime = 3600 * 1000000
+        ts = START_TIME
+        while True:
+            hdr = struct.pack('<BBH', 0x80, 0x00, 0) + b'\xff' * 6 + \
+                self.bssid + self.bssid + \
+                struct.pack('<H', self.next_wlan_seq(self.bssid) << 4)
+            body = struct.pack('<QHH', uptime + ts - START_TIME, 100, 0x0401)
+            yield ts, IFACE_WLAN, hdr + body + ies
+            ts += 102400
+
+    def generate(self, writer, max_packets, max_bytes):
+        '''Writes packets until there are max_packets or max_bytes of them.'''
+        writer.add_interface(LINKTYPE_ETHERNET, 'eth0')
+        have_wlan = any(kind == 'wlan' for kind, _ in self.mix)
+        if have_wlan:
+            writer.add_interface(LINKTYPE_IEEE802_11, 'wlan0')
+
+        # The next frame of every session, ordered by time, then by
+        # session, so that frames with the same timestamp are written
+        # in the same order every time.
+        pending = []
+        serial = 0
+
+        def add(frames):
+            nonlocal serial
+            frames = iter(frames)
+            for frame in frames:
+                heapq.heappush(pending, (frame[0], serial, frame, frames))
+                serial += 1
+                break
+
+        if have_wlan:
+            add(self.beacons())
+        next_start = START_TIME
+        while writer.packets < max_packets and writer.bytes < max_bytes:
+            while not pending or next_start <= pending[0][0]:
+                add(sorted(self.new_session(next_start), key=lambda f: f[0]))
+                next_start += max(1, int(self.rng.expovariate(self.rate) * 1000000))
+            _, order, (ts, iface, data), frames = heapq.heappop(pending)
+            writer.write(iface, ts, data)
+            for frame in frames:
+                heapq.heappush(pending, (frame[0], order, frame, frames))
+                break
+
+
+def parse_mix(text):
+    mix = []
+    for item in text.split(','):
+        kind, _, weight = item.partition('=')
+        kind = kind.strip()
+        if kind not in ('http', 'tls', 'dns', 'frag', 'voip', 'wlan'):
+            raise ValueError('unknown traffic type "%s"' % kind)
+        weight = int(weight) if weight else 1
+        if weight < 0:
+            raise ValueError('negative weight for "%s"' % kind)
+        if weight:
+            mix.append((kind, weight))
+    if not mix:
+        raise ValueError('no traffic in the mix')
+    return mix
+
+
+def generate(f, seed=DEFAULT_SEED, packets=DEFAULT_PACKETS, size=None,
+             mix=DEFAULT_MIX, rate=DEFAULT_RATE):
+    '''Writes a capture to the binary file f; returns (packets, bytes).'''
+    traffic = Traffic(seed, parse_mix(mix), rate)
+    writer = PcapngWriter(f)
+    traffic.generate(writer, packets if packets else float('inf'),
+                     size if size else float('inf'))
+    return writer.packets, writer.bytes
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate a reproducible capture for benchmarks.')
+    parser.add_argument('-s', '--seed', type=int, default=DEFAULT_SEED,
+                        help='seed of the generator (default %(default)s)')
+    parser.add_argument('-c', '--packets', type=int,
+                        help='number of packets (default %d, unless -S is given)'
+                        % DEFAULT_PACKETS)
+    parser.add_argument('-S', '--size', type=float,
+                        help='megabytes of packet data')
+    parser.add_argument('-m', '--mix', default=DEFAULT_MIX,
+                        help='weights of the kinds of traffic '
+                        '(default %(default)s)')
+    parser.add_argument('-r', '--rate', type=float, default=DEFAULT_RATE,
+                        help='new sessions per second (default %(default)s)')
+    parser.add_argument('outfile', help='output file, or - for the standard output')
+    args = parser.parse_args()
+
+    packets = args.packets
+    if packets is None and args.size is None:
+        packets = DEFAULT_PACKETS
+    size = int(args.size * 1000000) if args.size else None
+    try:
+        parse_mix(args.mix)
+    except ValueError as e:
+        parser.error(str(e))
+
+    if args.outfile == '-':
+        f = sys.stdout.buffer
+    else:
+        f = open(args.outfile, 'wb')
+    with f:
+        packets, size = generate(f, args.seed, packets, size, args.mix,
+                                 args.rate)
+    sys.stderr.write('%d packets, %d bytes\n' % (packets, size))
+
+
+if __name__ == '__main__':
+    main()
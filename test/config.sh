@@ -53,7 +53,10 @@ TSHARK=$WS_BIN_PATH/tshark
 RAWSHARK=$WS_BIN_PATH/rawshark
 CAPINFOS=$WS_BIN_PATH/capinfos
 MERGECAP=$WS_BIN_PATH/mergecap
+EDITCAP=$WS_BIN_PATH/editcap
+REORDERCAP=$WS_BIN_PATH/reordercap
 TEXT2PCAP=$WS_BIN_PATH/text2pcap
+SHARKD=$WS_BIN_PATH/sharkd
 DUMPCAP=$WS_BIN_PATH/dumpcap
 
 # interface with at least a few packets/sec traffic on it
@@ -97,10 +100,22 @@ TSHARK_VERSION=$($TSHARK -v | tr '\n' ' ')
 echo "$TSHARK_VERSION" | grep -q "with Lua"
 HAVE_LUA=$?
 
+# LuaJIT also runs the tests of its FFI based TvbRange readers.
+echo "$TSHARK_VERSION" | grep -q "with LuaJIT"
+HAVE_LUAJIT=$?
+
 # Check whether we need to skip the HTTP2/HPACK decryption test.
 echo "$TSHARK_VERSION" | grep -q "with nghttp2"
 HAVE_NGHTTP2=$?
 
+# Check whether we can uncompress HTTP bodies.
+echo "$TSHARK_VERSION" | grep -q "with zlib"
+HAVE_ZLIB=$?
+
+# Check whether we can resolve names with c-ares.
+echo "$TSHARK_VERSION" | grep -q "with c-ares"
+HAVE_C_ARES=$?
+
 # Check whether we need to skip a certain decryption test.
 # XXX What do we print for Nettle?
 echo "$TSHARK_VERSION" | egrep -q "with MIT Kerberos|with Heimdal Kerberos"
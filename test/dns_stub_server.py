@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Minimal DNS server for the name resolution tests. It answers every PTR
+# query for an IPv4 address a.b.c.d with "stub-a-b-c-d.example" and every
+# other query with NXDOMAIN. It listens on 127.0.0.1, on the given UDP
+# port or, by default, on any free one, and prints the port it listens
+# on before serving requests until it is killed.
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+import socket
+import struct
+import sys
+
+TYPE_PTR = 12
+CLASS_IN = 1
+
+
+def parse_question(msg):
+    labels = []
+    offset = 12
+    while msg[offset] != 0:
+        length = msg[offset]
+        labels.append(msg[offset + 1:offset + 1 + length].decode('ascii'))
+        offset += 1 + length
+    offset += 1
+    qtype, qclass = struct.unpack_from('!HH', msg, offset)
+    return labels, qtype, qclass, offset + 4
+
+
+def encode_name(name):
+    encoded = b''
+    for label in name.split('.'):
+        encoded += bytes([len(label)]) + label.encode('ascii')
+    return encoded + b'\0'
+
+
+def answer(msg):
+    qid, = struct.unpack_from('!H', msg, 0)
+    labels, qtype, qclass, end = parse_question(msg)
+    question = msg[12:end]
+
+    lowered = [label.lower() for label in labels]
+    if qtype == TYPE_PTR and qclass == CLASS_IN and len(labels) == 6 \
+            and lowered[4:] == ['in-addr', 'arpa']:
+        name = 'stub-%s.example' % '-'.join(reversed(labels[:4]))
+        rdata = encode_name(name)
+        header = struct.pack('!HHHHHH', qid, 0x8180, 1, 1, 0, 0)
+        rr = struct.pack('!HHHIH', 0xc00c, TYPE_PTR, CLASS_IN, 60, len(rdata))
+        return header + question + rr + rdata
+
+    header = struct.pack('!HHHHHH', qid, 0x8183, 1, 0, 0, 0)
+    return header + question
+
+
+def main():
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 0
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', port))
+    print(sock.getsockname()[1])
+    sys.stdout.flush()
+
+    while True:
+        msg, peer = sock.recvfrom(512)
+        try:
+            sock.sendto(answer(msg), peer)
+        except (IndexError, struct.error, UnicodeDecodeError):
+            # Not a query we understand; ignore it.
+            pass
+
+
+if __name__ == '__main__':
+    main()
@@ -86,6 +86,7 @@ test("Field.type-5", f_bootp_opt.type == ftypes.UINT8)
 
 -- make sure can't create a FieldInfo outside tap
 test("Field__call-1",not pcall(makeFieldInfo,f_eth_src))
+test("Field.values-0",not pcall(Field.values,f_eth_src))
 
 local tap = Listener.new()
 
@@ -164,6 +165,19 @@ function tap.packet(pinfo,tvb)
     test("FieldInfo.len-1", fi_eth_src.len == 6)
     test("FieldInfo.len-2",not pcall(setFieldInfo,fi_eth_src,"len",6))
 
+    testing("Field.values")
+
+    local v_eth_src, v_ip_src, v_udp_srcport, v_frame_proto, v_bootp_opt =
+        Field.values(f_eth_src, f_ip_src, f_udp_srcport, f_frame_proto, f_bootp_opt)
+    test("Field.values-1", v_eth_src == fi_eth_src.label)
+    test("Field.values-2", v_ip_src == tostring(f_ip_src()))
+    test("Field.values-3", v_udp_srcport == finfo_udp_srcport())
+    test("Field.values-4", v_frame_proto == f_frame_proto()())
+    test("Field.values-5", v_bootp_opt == f_bootp_opt()())
+    test("Field.values-6", select('#', Field.values(f_ip_dst, f_ip_dst)) == 2)
+    test("Field.values-7", Field.values(f_udp_dstport) == f_udp_dstport()())
+    test("Field.values-8",not pcall(Field.values))
+
     if packet_count == 4 then
         print("\n-----------------------------\n")
         print("All tests passed!\n\n")
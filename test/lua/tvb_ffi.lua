@@ -0,0 +1,133 @@
+----------------------------------------
+-- script-name: tvb_ffi.lua
+-- A post-dissector that checks that the FFI based TvbRange methods that
+-- tvb_ffi.lua installs when Wireshark is built with LuaJIT give the same
+-- results and errors as the C methods they replace, and measures how fast
+-- both read integers.
+--
+-- The optional script argument is the number of times every TvbRange of a
+-- frame is read when timing, which defaults to 100:
+--
+--   tshark -r capture.pcap -X lua_script:tvb_ffi.lua -X lua_script1:1000
+----------------------------------------
+
+local arg = {...}
+local rounds = tonumber(arg[1]) or 100
+
+local mt = debug.getregistry()["TvbRange"]
+local c_methods = mt and mt.__c_methods
+local method_names = { "uint", "le_uint", "int", "le_int" }
+
+local frames = 0
+local reads = 0
+local failures = 0
+local ffi_elapsed = 0
+local c_elapsed = 0
+local old_range
+
+local function fail(pinfo, msg)
+    failures = failures + 1
+    print("frame " .. pinfo.number .. ": " .. msg)
+end
+
+-- calls both versions of a method on a TvbRange, and checks that they
+-- return the same value or raise the same error
+local function compare(pinfo, range, name, desc)
+    local ffi_ok, ffi_res = pcall(range[name], range)
+    local c_ok, c_res = pcall(c_methods[name], range)
+    if ffi_ok ~= c_ok or ffi_res ~= c_res then
+        fail(pinfo, name .. "() of " .. desc .. ": FFI gave " .. tostring(ffi_res) ..
+             ", C gave " .. tostring(c_res))
+    end
+end
+
+local function time_reads(ranges, read)
+    local start = os.clock()
+    local sum = 0
+    for _ = 1, rounds do
+        for i = 1, #ranges do
+            sum = sum + read(ranges[i])
+        end
+    end
+    return os.clock() - start, sum
+end
+
+local test = Proto("tvb_ffi", "TvbRange FFI reader tests")
+
+function test.dissector(tvb, pinfo, tree)
+    if not c_methods then
+        return
+    end
+
+    local len = tvb:len()
+    local ranges = {}
+
+    -- lengths 1 to 4 are read through the FFI, the others by the C methods
+    for size = 1, 8 do
+        for offset = 0, len - size do
+            local range = tvb(offset, size)
+            for _, name in ipairs(method_names) do
+                compare(pinfo, range, name, tostring(offset) .. "," .. tostring(size))
+            end
+            if size <= 4 then
+                ranges[#ranges + 1] = range
+            end
+        end
+    end
+
+    if len > 0 then
+        for _, name in ipairs(method_names) do
+            compare(pinfo, tvb(0, 0), name, "an empty TvbRange")
+        end
+    end
+
+    -- a TvbRange of the previous frame has expired
+    if old_range then
+        for _, name in ipairs(method_names) do
+            compare(pinfo, old_range, name, "an expired TvbRange")
+        end
+    end
+    if len > 0 then
+        old_range = tvb(0, 1)
+    end
+
+    for _, name in ipairs(method_names) do
+        local c_read = c_methods[name]
+        local ffi_elapsed1, ffi_sum = time_reads(ranges, function(r) return r[name](r) end)
+        local c_elapsed1, c_sum = time_reads(ranges, c_read)
+        if ffi_sum ~= c_sum then
+            fail(pinfo, name .. "(): FFI sum " .. ffi_sum .. ", C sum " .. c_sum)
+        end
+        ffi_elapsed = ffi_elapsed + ffi_elapsed1
+        c_elapsed = c_elapsed + c_elapsed1
+        reads = reads + rounds * #ranges
+    end
+
+    frames = frames + 1
+end
+
+register_postdissector(test)
+
+local tap = Listener.new("frame")
+
+function tap.draw()
+    if not jit then
+        print("Not running LuaJIT, skipped")
+        return
+    end
+    if not c_methods then
+        print("The FFI based TvbRange methods are not installed, skipped")
+        return
+    end
+
+    local function rate(elapsed)
+        return elapsed > 0 and reads / elapsed or 0
+    end
+    print(string.format("%s: %d frames, %d reads: FFI %.3f seconds, %.0f reads/sec; " ..
+                        "C %.3f seconds, %.0f reads/sec",
+                        jit.version, frames, reads, ffi_elapsed, rate(ffi_elapsed),
+                        c_elapsed, rate(c_elapsed)))
+    if frames > 0 and failures == 0 then
+        print("All tests passed!")
+    end
+end
@@ -0,0 +1,79 @@
+----------------------------------------
+-- script-name: tvb_slices.lua
+-- A post-dissector that slices every frame into TvbRanges the way Lua
+-- dissectors of byte-oriented protocols do, to measure how fast TvbRanges
+-- are created and read, and to check that the values read through them
+-- are right. The FFI based TvbRange methods of LuaJIT builds are compared
+-- with the C ones by tvb_ffi.lua.
+--
+-- The optional script argument is the number of slices per frame, which
+-- defaults to 10000:
+--
+--   tshark -r capture.pcap -X lua_script:tvb_slices.lua -X lua_script1:100000
+----------------------------------------
+
+local arg = {...}
+local slices_per_frame = tonumber(arg[1]) or 10000
+
+local slices = 0
+local frames = 0
+local failures = 0
+local elapsed = 0
+
+local bench = Proto("tvb_slices", "TvbRange slicing benchmark")
+
+function bench.dissector(tvb, pinfo, tree)
+    local len = tvb:len()
+    if len < 4 then
+        return
+    end
+
+    local raw = tvb:raw()
+    local start = os.clock()
+    local sum, expected = 0, 0
+    local offset = 0
+    local n = slices_per_frame
+
+    for i = 1, slices_per_frame do
+        local range = tvb(offset, 1)
+        sum = sum + range:uint()
+        -- slice a range too, and read a wider value once in a while
+        if i % 16 == 0 and offset + 4 <= len then
+            sum = sum + tvb(offset, 4):range(2, 2):uint()
+            n = n + 2
+        end
+        offset = (offset + 1) % len
+    end
+
+    elapsed = elapsed + (os.clock() - start)
+
+    offset = 0
+    for i = 1, slices_per_frame do
+        expected = expected + raw:byte(offset + 1)
+        if i % 16 == 0 and offset + 4 <= len then
+            expected = expected + raw:byte(offset + 3) * 256 + raw:byte(offset + 4)
+        end
+        offset = (offset + 1) % len
+    end
+
+    if sum ~= expected then
+        failures = failures + 1
+        print("frame " .. pinfo.number .. ": got " .. sum .. ", expected " .. expected)
+    end
+
+    slices = slices + n
+    frames = frames + 1
+end
+
+register_postdissector(bench)
+
+local tap = Listener.new("frame")
+
+function tap.draw()
+    print(string.format("%s: %d frames, %d slices in %.3f seconds: %.0f slices/sec",
+                        jit and jit.version or _VERSION, frames, slices, elapsed,
+                        elapsed > 0 and slices / elapsed or 0))
+    if frames > 0 and failures == 0 then
+        print("All tests passed!")
+    end
+end
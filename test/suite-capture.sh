@@ -259,6 +259,47 @@ capture_step_stdin() {
 	fi
 }
 
+# TShark dissects the packets dumpcap hands it in shared memory (where
+# available) while capturing; that must give the same result as reading
+# the capture file afterwards
+capture_step_shm_ring() {
+	FIELDS="-T fields -e frame.number -e frame.time_epoch -e frame.len
+		-e frame.cap_len -e frame.protocols -e _ws.col.Info"
+
+	(cat "${CAPTURE_DIR}dhcp.pcap"
+	 for ((i = 0; i < 50; i++)); do
+		tail -c +25 "${CAPTURE_DIR}dhcp.pcap"
+	 done) | \
+	$DUT -i - -w ./testout.pcap -P $FIELDS > ./testout.txt 2> ./testerr.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		capture_test_output_print ./testout.txt ./testerr.txt
+		test_step_failed "Exit status of $DUT: $RETURNVALUE"
+		return
+	fi
+
+	$TSHARK -r ./testout.pcap $FIELDS > ./testout2.txt 2> ./testerr.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		capture_test_output_print ./testerr.txt
+		test_step_failed "Exit status of $TSHARK reading the capture: $RETURNVALUE"
+		return
+	fi
+
+	if [ $(wc -l < ./testout2.txt) -ne 204 ]; then
+		capture_test_output_print ./testout2.txt
+		test_step_failed "The capture doesn't have 204 packets."
+		return
+	fi
+	diff -u ./testout2.txt ./testout.txt > ./testerr.txt 2>&1
+	if [ $? -ne 0 ]; then
+		capture_test_output_print ./testerr.txt
+		test_step_failed "Packets dissected while capturing differ from the capture file."
+		return
+	fi
+	test_step_ok
+}
+
 # capture exactly 2 times 10 packets (multiple files)
 capture_step_2multi_10packets() {
 	if [ $SKIP_CAPTURE -ne 0 ] ; then
@@ -452,6 +493,7 @@ tshark_capture_suite() {
 		test_step_add "Capture via fifo" capture_step_fifo
 	fi
 	test_step_add "Capture via stdin" capture_step_stdin
+	test_step_add "Dissect while capturing via stdin" capture_step_shm_ring
 	# tshark now using dumpcap for capturing, read filters won't work by definition
 	#test_step_add "Capture read filter (${TRAFFIC_CAPTURE_DURATION}s)" capture_step_read_filter
 	test_step_add "Capture snapshot length 68 bytes (${TRAFFIC_CAPTURE_DURATION}s)" capture_step_snapshot
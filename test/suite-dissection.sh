@@ -30,8 +30,139 @@ dissection_http2_data_reassembly_test() {
 	return
 }
 
+# The capture generated for test/benchmark.py must be the same for the
+# same seed, and dissect without malformed packets; and the pipelines of
+# the benchmark must run.
+dissection_benchmark_traffic_test() {
+	if ! which python3 > /dev/null 2>&1; then
+		test_step_skipped
+		return
+	fi
+
+	python3 "$TESTS_DIR/benchmark_traffic.py" -s 7 -c 5000 \
+		./testout_bench1.pcapng 2> /dev/null &&
+	python3 "$TESTS_DIR/benchmark_traffic.py" -s 7 -c 5000 \
+		./testout_bench2.pcapng 2> /dev/null
+	if [ $? -ne 0 ]; then
+		test_step_failed "benchmark_traffic.py failed"
+		return
+	fi
+	if ! cmp -s ./testout_bench1.pcapng ./testout_bench2.pcapng; then
+		test_step_failed "benchmark_traffic.py gave different captures for the same seed"
+		return
+	fi
+
+	$TESTS_DIR/run_and_catch_crashes $TSHARK -n -r ./testout_bench1.pcapng \
+		-Y _ws.malformed > ./testout_bench.txt 2> /dev/null
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ] || [ -s ./testout_bench.txt ]; then
+		cat ./testout_bench.txt
+		test_step_failed "malformed packets in the benchmark traffic"
+		return
+	fi
+
+	python3 "$TESTS_DIR/benchmark.py" --bin-dir "$WS_BIN_PATH" \
+		-r ./testout_bench1.pcapng -n 1 -p summary -p filter -p fields -p write -p write-pcap -p count -p count-isb \
+		> ./testout_bench.txt 2>&1
+	if [ $? -ne 0 ]; then
+		cat ./testout_bench.txt
+		test_step_failed "benchmark.py failed"
+		return
+	fi
+	rm -f ./testout_bench1.pcapng ./testout_bench2.pcapng ./testout_bench.txt
+	test_step_ok
+}
+
+# Check that S1AP PDUs, hand-encoded in aligned PER, decode to the values
+# they were encoded from. This gives a baseline for regenerating
+# packet-s1ap.c with asn2wrs -t (dissect_per_type()).
+dissection_s1ap_per_test() {
+	local filter1='s1ap.procedureCode == 17 && s1ap.id == 59 && s1ap.id == 60 && s1ap.id == 64 && s1ap.id == 137 && s1ap.ENBname == "test-enb" && s1ap.macroENB_ID && s1ap.tAC == 1 && s1ap.PagingDRX == 2'
+	local filter2='s1ap.procedureCode == 15 && s1ap.id == 2 && s1ap.misc == 3'
+
+	$TEXT2PCAP -q -S 36412,36412,18 "${CAPTURE_DIR}/s1ap-setup.txt" \
+		./testout_s1ap.pcap > /dev/null 2>&1
+	if [ $? -ne 0 ]; then
+		test_step_failed "text2pcap failed"
+		return
+	fi
+
+	$TESTS_DIR/run_and_catch_crashes $TSHARK -n -r ./testout_s1ap.pcap \
+		-Y "(frame.number == 1 && $filter1) || (frame.number == 2 && $filter2)" \
+		> ./testout_s1ap.txt 2> /dev/null
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ] || [ "$(wc -l < ./testout_s1ap.txt)" -ne 2 ]; then
+		$TSHARK -n -V -r ./testout_s1ap.pcap
+		test_step_failed "S1AP PDUs not decoded as expected"
+		return
+	fi
+
+	$TSHARK -n -r ./testout_s1ap.pcap \
+		-Y '_ws.malformed || _ws.expert.severity == "Error" || _ws.expert.severity == "Warning"' \
+		> ./testout_s1ap.txt 2> /dev/null
+	if [ -s ./testout_s1ap.txt ]; then
+		$TSHARK -n -V -r ./testout_s1ap.pcap
+		test_step_failed "S1AP PDUs dissected with errors"
+		return
+	fi
+	rm -f ./testout_s1ap.pcap ./testout_s1ap.txt
+	test_step_ok
+}
+
+# tvb_uncompress() caches uncompressed bodies. Open two files in one sharkd
+# session and check that the second one shows its own bodies, not those
+# of the first.
+dissection_uncompress_two_files_test() {
+	if [ $HAVE_ZLIB -ne 0 ] || [ ! -x "$SHARKD" ]; then
+		test_step_skipped
+		return
+	fi
+
+	for n in 1 2; do
+		$TEXT2PCAP -q -T 80,1234 "${CAPTURE_DIR}/http-gzip-$n.txt" \
+			./testout_gzip$n.pcap > /dev/null 2>&1
+		if [ $? -ne 0 ]; then
+			test_step_failed "text2pcap failed"
+			return
+		fi
+	done
+
+	$TESTS_DIR/run_and_catch_crashes $SHARKD - > ./testout_sharkd.txt 2> /dev/null <<-EOF
+		{"req":"load","file":"./testout_gzip1.pcap"}
+		{"req":"frame","frame":1,"proto":true}
+		{"req":"load","file":"./testout_gzip2.pcap"}
+		{"req":"frame","frame":1,"proto":true}
+		{"req":"load","file":"./testout_gzip1.pcap"}
+		{"req":"frame","frame":1,"proto":true}
+	EOF
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		test_step_failed "exit status of sharkd: $RETURNVALUE"
+		return
+	fi
+
+	# One reply per line, so the frame replies are lines 2, 4 and 6
+	for check in 2:first:second 4:second:first 6:first:second; do
+		IFS=: read line body other_body <<-EOF
+			$check
+		EOF
+		sed -n "${line}p" ./testout_sharkd.txt > ./testout_frame.txt
+		if ! grep -q "$body capture body" ./testout_frame.txt ||
+			grep -q "$other_body capture body" ./testout_frame.txt; then
+			cat ./testout_sharkd.txt
+			test_step_failed "reply $line does not show the $body body"
+			return
+		fi
+	done
+	rm -f ./testout_gzip1.pcap ./testout_gzip2.pcap ./testout_sharkd.txt ./testout_frame.txt
+	test_step_ok
+}
+
 dissection_suite() {
 	test_step_add "testing http2 data reassembly" dissection_http2_data_reassembly_test
+	test_step_add "testing the benchmark traffic" dissection_benchmark_traffic_test
+	test_step_add "testing table-driven S1AP PER" dissection_s1ap_per_test
+	test_step_add "testing uncompressed bodies of two files in one session" dissection_uncompress_two_files_test
 }
 
 #
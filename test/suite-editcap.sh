@@ -0,0 +1,87 @@
+#!/bin/bash
+#
+# Run the editcap unit tests
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+# Run editcap with the given options on the duplicate frames capture and
+# check the number of packets it wrote.
+# arg 1 = editcap options
+# arg 2 = number of packets written
+editcap_dup_check() {
+	$EDITCAP $1 ./testin.pcap ./testout.pcap > ./testout.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of editcap $1: $RETURNVALUE"
+		return 1
+	fi
+
+	$CAPINFOS -cM ./testout.pcap > ./capinfo_testout.txt 2>&1
+	grep -Eq "Number of packets:[[:blank:]]+$2\$" ./capinfo_testout.txt
+	if [ $? -ne 0 ]; then
+		cat ./capinfo_testout.txt
+		test_step_failed "editcap $1 didn't write $2 packets"
+		return 1
+	fi
+	return 0
+}
+
+# The capture has 8 frames, see the comments in editcap-dups.txt:
+# 1 A, 2 B, 3 A, 4 A with another TTL, 5 A on a VLAN, 6 C, 7 C (0.5s
+# before 6) and 8 C (0.1s after 6 but 0.6s after 7).
+editcap_step_dups() {
+	$TEXT2PCAP -q -t "%Y-%m-%d %H:%M:%S." \
+		"${CAPTURE_DIR}editcap-dups.txt" ./testin.pcap > ./testout.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of text2pcap: $RETURNVALUE"
+		return
+	fi
+
+	# 3 is a duplicate of 1, 7 of 6 and 8 of 6 or 7
+	editcap_dup_check "-d" 5 || return
+	# 7 is a duplicate of 6 and 8 of 7
+	editcap_dup_check "-D 2" 6 || return
+	# 3 is a duplicate of 1, 4 of 3 and 5 of 4 with the TTL, IP checksum and
+	# VLAN tag masked, 7 of 6 and 8 of 7
+	editcap_dup_check "-D 3 --dup-mask ttl,ipcsum,vlan" 3 || return
+	# 3 is a duplicate of 1 and 8 of 6, even though 7 arrived before it
+	editcap_dup_check "-w 0.5" 6 || return
+	# ... and 4, without the TTL and the IP checksum
+	editcap_dup_check "-w 0.5 --dup-mask ttl,ipcsum" 5 || return
+	# ... and 5, without the VLAN tag
+	editcap_dup_check "-w 0.5 --dup-mask ttl,ipcsum,vlan" 4 || return
+	test_step_ok
+}
+
+editcap_cleanup_step() {
+	rm -f ./testout.txt
+	rm -f ./capinfo_testout.txt
+	rm -f ./testout.pcap
+	rm -f ./testin.pcap
+}
+
+editcap_suite() {
+	test_step_set_pre editcap_cleanup_step
+	test_step_set_post editcap_cleanup_step
+	test_step_add "Duplicate removal (-d, -D, -w, --dup-mask)" editcap_step_dups
+}
+
+#
+# Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+#
+# Local variables:
+# sh-basic-offset: 8
+# tab-width: 8
+# indent-tabs-mode: t
+# End:
+#
+# vi: set shiftwidth=8 tabstop=8 noexpandtab:
+# :indentSize=8:tabSize=8:noTabs=false:
+#
@@ -130,6 +130,71 @@ io_step_rawshark_pcap_stdin() {
 	test_step_ok
 }
 
+# Capinfos must report on files in the same order, with the same infos,
+# whether it uses several threads or not
+io_step_capinfos_threads() {
+	CAPINFOS_FILES="${CAPTURE_DIR}dhcp.pcap ${CAPTURE_DIR}dhcp.pcapng
+		${CAPTURE_DIR}dhcp-nanosecond.pcap ${CAPTURE_DIR}sip.pcapng
+		${CAPTURE_DIR}dns_port.pcap ${CAPTURE_DIR}many_interfaces.pcapng.1
+		${CAPTURE_DIR}many_interfaces.pcapng.2 ${CAPTURE_DIR}many_interfaces.pcapng.3
+		${CAPTURE_DIR}c1222_std_example8.pcap ${CAPTURE_DIR}rsasnakeoil2.pcap"
+	for CAPINFOS_FORMAT in -L -T ; do
+		$CAPINFOS $CAPINFOS_FORMAT $CAPINFOS_FILES > ./testout.txt 2>&1
+		RETURNVALUE=$?
+		if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+			cat ./testout.txt
+			test_step_failed "exit status of capinfos: $RETURNVALUE"
+			return
+		fi
+		$CAPINFOS -j 4 $CAPINFOS_FORMAT $CAPINFOS_FILES > ./testout2.txt 2>&1
+		RETURNVALUE=$?
+		if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+			cat ./testout2.txt
+			test_step_failed "exit status of capinfos -j 4: $RETURNVALUE"
+			return
+		fi
+		diff -u --strip-trailing-cr ./testout.txt ./testout2.txt > $DIFF_OUT 2>&1
+		RETURNVALUE=$?
+		if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+			cat $DIFF_OUT
+			test_step_failed "Output of capinfos -j 4 $CAPINFOS_FORMAT differs"
+			return
+		fi
+	done
+	test_step_ok
+}
+
+# dhcp-isb.pcapng is dhcp.pcapng with an Interface Statistics Block at its
+# end whose isb_usrdeliv is 1000, not the 4 packets of the file, so that
+# the count shows whether it was taken from the ISB or from the packets.
+io_step_capinfos_isb_counts() {
+	cat "${CAPTURE_DIR}dhcp-isb.pcapng" "${CAPTURE_DIR}dhcp-isb.pcapng" > ./testout.pcap
+	# file, options, expected number of packets
+	for CAPINFOS_CHECK in "${CAPTURE_DIR}dhcp-isb.pcapng||4" \
+		"${CAPTURE_DIR}dhcp-isb.pcapng|--isb-counts|1000" \
+		"${CAPTURE_DIR}dhcp-isb.pcapng|-s --isb-counts|1000" \
+		"${CAPTURE_DIR}dhcp-isb.pcapng|-u --isb-counts|4" \
+		"${CAPTURE_DIR}dhcp.pcapng|--isb-counts|4" \
+		"./testout.pcap|--isb-counts|8" ; do
+		IFS="|" read CAPINFOS_FILE CAPINFOS_OPTS CAPINFOS_COUNT <<-EOF
+			$CAPINFOS_CHECK
+		EOF
+		$CAPINFOS -cM $CAPINFOS_OPTS "$CAPINFOS_FILE" > ./testout.txt 2>&1
+		RETURNVALUE=$?
+		if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+			cat ./testout.txt
+			test_step_failed "exit status of capinfos $CAPINFOS_OPTS $CAPINFOS_FILE: $RETURNVALUE"
+			return
+		fi
+		grep -Eq "Number of packets:[[:blank:]]+$CAPINFOS_COUNT\$" ./testout.txt
+		if [ $? -ne 0 ]; then
+			cat ./testout.txt
+			test_step_failed "capinfos $CAPINFOS_OPTS $CAPINFOS_FILE didn't count $CAPINFOS_COUNT packets"
+			return
+		fi
+	done
+	test_step_ok
+}
 
 wireshark_io_suite() {
 	# Q: quit after cap, k: start capture immediately
@@ -155,6 +220,11 @@ rawshark_io_suite() {
 	test_step_add "Rawshark pcap stdin" io_step_rawshark_pcap_stdin
 }
 
+capinfos_io_suite() {
+	test_step_add "Capinfos with several threads" io_step_capinfos_threads
+	test_step_add "Capinfos packet counts from ISBs" io_step_capinfos_isb_counts
+}
+
 io_cleanup_step() {
 	rm -f ./testout.txt
 	rm -f ./testout2.txt
@@ -169,6 +239,7 @@ io_suite() {
 	test_suite_add "TShark file I/O" tshark_io_suite
 	#test_suite_add "Dumpcap file I/O" dumpcap_io_suite
 	test_suite_add "Rawshark file I/O" rawshark_io_suite
+	test_suite_add "Capinfos file I/O" capinfos_io_suite
 }
 #
 # Editor modelines  -  http://www.wireshark.org/tools/modelines.html
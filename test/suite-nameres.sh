@@ -129,6 +129,52 @@ name_resolution_net_t_ext_f_hosts_t_custom() {
 	test_step_ok
 }
 
+# nameres.network_name: True
+# nameres.use_external_name_resolver: True
+# nameres.dns_servers: local stub server
+# Two passes: addresses are resolved in one batch between them
+name_resolution_net_t_ext_t_two_pass() {
+	# nameres.dns_servers is only used by c-ares
+	if [ $HAVE_C_ARES -ne 0 ] || ! which python3 > /dev/null 2>&1; then
+		test_step_skipped
+		return
+	fi
+
+	python3 "$TESTS_DIR/dns_stub_server.py" > ./testout_dns_port.txt &
+	DNS_STUB_PID=$!
+	for i in 1 2 3 4 5 6 7 8 9 10; do
+		[ -s ./testout_dns_port.txt ] && break
+		sleep 1
+	done
+	DNS_STUB_PORT=$(cat ./testout_dns_port.txt)
+
+	$TESTS_DIR/run_and_catch_crashes env $TS_NR_ENV $TSHARK $TS_NR_ARGS -2 \
+		-o "nameres.network_name: TRUE" \
+		-o "nameres.use_external_name_resolver: TRUE" \
+		-o "nameres.dns_servers: 127.0.0.1:$DNS_STUB_PORT" \
+		> ./testout.txt 2> ./testout_stderr.txt
+	RETURNVALUE=$?
+	kill $DNS_STUB_PID > /dev/null 2>&1
+	rm -f ./testout_dns_port.txt
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		test_step_failed "exit status of $TSHARK: $RETURNVALUE"
+		return
+	fi
+	grep stub-192-168-43-9.example ./testout.txt > /dev/null 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		test_step_failed "Failed to resolve 192.168.43.9 using the stub DNS server."
+		return
+	fi
+	grep "^Resolved [1-9][0-9]* of " ./testout_stderr.txt > /dev/null 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		test_step_failed "No name resolution statistics."
+		return
+	fi
+	test_step_ok
+}
+
 tshark_name_resolution_suite() {
 	test_step_add "Name resolution, no external, no profile hosts, global profile" name_resolution_net_t_ext_f_hosts_f_global
 	test_step_add "Name resolution, no external, no profile hosts, personal profile" name_resolution_net_t_ext_f_hosts_f_personal
@@ -137,6 +183,8 @@ tshark_name_resolution_suite() {
 	test_step_add "Name resolution, no external, profile hosts, global profile" name_resolution_net_t_ext_f_hosts_t_global
 	test_step_add "Name resolution, no external, profile hosts, personal profile" name_resolution_net_t_ext_f_hosts_t_personal
 	test_step_add "Name resolution, no external, profile hosts, custom profile" name_resolution_net_t_ext_f_hosts_t_custom
+
+	test_step_add "Name resolution, external, stub DNS server, two passes" name_resolution_net_t_ext_t_two_pass
 }
 
 name_resolution_cleanup_step() {
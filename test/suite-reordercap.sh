@@ -0,0 +1,104 @@
+#!/bin/bash
+#
+# Run the reordercap unit tests
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+# Number of frames of the shuffled capture; with -m 3, there are more runs
+# than reordercap merges at once.
+REORDERCAP_FRAMES=1000
+
+# Write a capture of $REORDERCAP_FRAMES frames with shuffled timestamps,
+# each frame holding its timestamp, to ./testin.pcap
+reordercap_shuffled_capture() {
+	for ((i = 0; i < REORDERCAP_FRAMES; i++)); do
+		t=$(( (i * 7919) % REORDERCAP_FRAMES ))
+		printf "2018-01-01 %02d:%02d:%02d.000000\n\n" \
+			$((t / 3600)) $((t / 60 % 60)) $((t % 60))
+		printf "0000  ff ff ff ff ff ff 00 00 00 00 00 01 88 b5 %02x %02x\n\n" \
+			$((t / 256)) $((t % 256))
+	done > ./testin.txt
+	$TEXT2PCAP -q -t "%Y-%m-%d %H:%M:%S." ./testin.txt ./testin.pcap > ./testout.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of text2pcap: $RETURNVALUE"
+		return 1
+	fi
+	return 0
+}
+
+# The output of reordercap with the given options must be the same as
+# the output of the in-memory sort, ./testout.pcap
+# arg 1 = reordercap options
+reordercap_same_output() {
+	$REORDERCAP $1 ./testin.pcap ./testout2.pcap > ./testout.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of reordercap $1: $RETURNVALUE"
+		return 1
+	fi
+	cmp -s ./testout.pcap ./testout2.pcap
+	if [ $? -ne 0 ]; then
+		test_step_failed "reordercap $1 output differs from the in-memory sort"
+		return 1
+	fi
+	return 0
+}
+
+reordercap_step_sort() {
+	reordercap_shuffled_capture || return
+
+	$REORDERCAP ./testin.pcap ./testout.pcap > ./testout.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of reordercap: $RETURNVALUE"
+		return
+	fi
+	grep -q "^$REORDERCAP_FRAMES frames, [1-9][0-9]* out of order" ./testout.txt
+	if [ $? -ne 0 ]; then
+		cat ./testout.txt
+		test_step_failed "reordercap didn't find the capture out of order"
+		return
+	fi
+
+	reordercap_same_output "-m 100" || return
+	# more runs than merged at once
+	reordercap_same_output "-m 3" || return
+	# a window as large as the capture
+	reordercap_same_output "-w $REORDERCAP_FRAMES" || return
+	test_step_ok
+}
+
+reordercap_cleanup_step() {
+	rm -f ./testout.txt
+	rm -f ./testin.txt
+	rm -f ./testin.pcap
+	rm -f ./testout.pcap
+	rm -f ./testout2.pcap
+}
+
+reordercap_suite() {
+	test_step_set_pre reordercap_cleanup_step
+	test_step_set_post reordercap_cleanup_step
+	test_step_add "Sort with -m and -w" reordercap_step_sort
+}
+
+#
+# Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+#
+# Local variables:
+# sh-basic-offset: 8
+# tab-width: 8
+# indent-tabs-mode: t
+# End:
+#
+# vi: set shiftwidth=8 tabstop=8 noexpandtab:
+# :indentSize=8:tabSize=8:noTabs=false:
+#
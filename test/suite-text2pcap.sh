@@ -300,11 +300,53 @@ text2pcap_step_hash_at_eol() {
 	test_step_ok
 }
 
+# Convert the same hexdump with the line parser and with the flex scanner,
+# check that the output files are the same and show how long each took.
+text2pcap_step_flex_scanner() {
+	text2pcap_generate_input "${CAPTURE_DIR}http2-data-reassembly.pcap"
+	for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+		cat testin.txt
+	done > testin_large.txt
+
+	TIMEFORMAT="%R"
+	{ time $TEXT2PCAP -q -t "%Y-%m-%d %H:%M:%S." \
+		testin_large.txt testout.pcap > testout.txt 2>&1 ; } 2> testout_time.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of text2pcap: $RETURNVALUE"
+		return
+	fi
+	parser_time=`cat testout_time.txt`
+
+	{ time $TEXT2PCAP -q --flex-scanner -t "%Y-%m-%d %H:%M:%S." \
+		testin_large.txt testout_flex.pcap > testout.txt 2>&1 ; } 2> testout_time.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout.txt
+		test_step_failed "exit status of text2pcap --flex-scanner: $RETURNVALUE"
+		return
+	fi
+	scanner_time=`cat testout_time.txt`
+	unset TIMEFORMAT
+
+	cmp -s testout.pcap testout_flex.pcap
+	if [ $? -ne 0 ]; then
+		test_step_failed "the line parser and the flex scanner gave different output"
+		return
+	fi
+	printf " (line parser %ss, flex scanner %ss)" "$parser_time" "$scanner_time"
+	test_step_ok
+}
+
 text2pcap_cleanup_step() {
 	rm -f ./testin.txt
 	rm -f ./testout.txt
 	rm -f ./capinfo_testout.txt
 	rm -f ./testout.pcap
+	rm -f ./testin_large.txt
+	rm -f ./testout_flex.pcap
+	rm -f ./testout_time.txt
 }
 
 text2pcap_suite() {
@@ -332,6 +374,7 @@ text2pcap_suite() {
 	test_step_add "testing with packet-h2-14_headers.pcapng" text2pcap_packet_h2_14_headers_pcapng_test
 	test_step_add "testing with sip.pcapng" text2pcap_sip_pcapng_test
 	test_step_add "hash sign at the end of the line" text2pcap_step_hash_at_eol
+	test_step_add "line parser and flex scanner give the same output" text2pcap_step_flex_scanner
 }
 
 #
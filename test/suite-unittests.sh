@@ -56,6 +56,12 @@ check_dut() {
 	fi
 }
 
+unittests_step_capture_reduce_test() {
+	check_dut capture_reduce_test || return
+	ARGS=
+	unittests_step_test
+}
+
 unittests_step_exntest() {
 	check_dut exntest || return
 	ARGS=
@@ -105,6 +111,7 @@ unittests_cleanup_step() {
 unittests_suite() {
 	test_step_set_pre unittests_cleanup_step
 	test_step_set_post unittests_cleanup_step
+	test_step_add "capture_reduce_test" unittests_step_capture_reduce_test
 	test_step_add "exntest" unittests_step_exntest
 	test_step_add "oids_test" unittests_step_oids_test
 	test_step_add "reassemble_test" unittests_step_reassemble_test
@@ -476,6 +476,43 @@ wslua_step_tvb_test() {
 	fi
 }
 
+wslua_step_tvb_slices_test() {
+	if [ $HAVE_LUA -ne 0 ]; then
+		test_step_skipped
+		return
+	fi
+
+	# Tshark catches lua script failures, so we have to parse the output.
+	$TSHARK -r $CAPTURE_DIR/dhcp.pcap -X lua_script:$TESTS_DIR/lua/tvb_slices.lua > testout.txt 2>&1
+	if grep -q "All tests passed!" testout.txt; then
+		grep "slices/sec" testout.txt
+		test_step_ok
+	else
+		cat testout.txt
+		test_step_failed "didn't find pass marker"
+	fi
+}
+
+wslua_step_tvb_ffi_test() {
+	if [ $HAVE_LUAJIT -ne 0 ]; then
+		test_step_skipped
+		return
+	fi
+
+	# Tshark catches lua script failures, so we have to parse the output.
+	$TSHARK -r $CAPTURE_DIR/dhcp.pcap -X lua_script:$TESTS_DIR/lua/tvb_ffi.lua > testout.txt 2>&1
+	if grep -q "All tests passed!" testout.txt; then
+		grep "reads/sec" testout.txt
+		test_step_ok
+	elif grep -q "are not installed, skipped" testout.txt; then
+		# ffi.C can't find the Wireshark symbols on Windows
+		test_step_skipped
+	else
+		cat testout.txt
+		test_step_failed "didn't find pass marker"
+	fi
+}
+
 wslua_cleanup_step() {
 	rm -f ./testout.txt
 	rm -f ./testin.txt
@@ -500,6 +537,8 @@ wslua_suite() {
 	test_step_add "wslua script arguments" wslua_step_args_test
 	test_step_add "wslua struct" wslua_step_struct_test
 	test_step_add "wslua tvb" wslua_step_tvb_test
+	test_step_add "wslua tvb slicing" wslua_step_tvb_slices_test
+	test_step_add "wslua tvb FFI readers" wslua_step_tvb_ffi_test
 }
 #
 # Editor modelines  -  https://www.wireshark.org/tools/modelines.html
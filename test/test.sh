@@ -44,10 +44,12 @@ Usage: $THIS [-c] [-h] [-s <suite>]
       capture
       clopts
       decryption
+      editcap
       fileformats
       io
       nameres
       prerequisites
+      reordercap
       unittests
       wslua
       dissection
@@ -98,6 +100,8 @@ source $TESTS_DIR/suite-decryption.sh
 source $TESTS_DIR/suite-nameres.sh
 source $TESTS_DIR/suite-wslua.sh
 source $TESTS_DIR/suite-mergecap.sh
+source $TESTS_DIR/suite-editcap.sh
+source $TESTS_DIR/suite-reordercap.sh
 source $TESTS_DIR/suite-text2pcap.sh
 source $TESTS_DIR/suite-dissection.sh
 
@@ -160,6 +164,8 @@ test_suite() {
 	test_suite_add "Name Resolution" name_resolution_suite
 	test_suite_add "Lua API" wslua_suite
 	test_suite_add "Mergecap" mergecap_suite
+	test_suite_add "Editcap" editcap_suite
+	test_suite_add "Reordercap" reordercap_suite
 	test_suite_add "File formats" fileformats_suite
 	test_suite_add "Text2pcap" text2pcap_suite
 	test_suite_add "Dissection" dissection_suite
@@ -193,6 +199,9 @@ if [ -n "$RUN_SUITE" ] ; then
 		"decryption")
 			test_suite_run "Decryption" decryption_suite
 			exit $? ;;
+		"editcap")
+			test_suite_run "Editcap" editcap_suite
+			exit $? ;;
 		"fileformats")
 			test_suite_run "File formats" fileformats_suite
 			exit $? ;;
@@ -205,6 +214,9 @@ if [ -n "$RUN_SUITE" ] ; then
 		"prerequisites")
 			test_suite_run "Prerequisites" prerequisites_suite
 			exit $? ;;
+		"reordercap")
+			test_suite_run "Reordercap" reordercap_suite
+			exit $? ;;
 		"unittests")
 			test_suite_run "Unit tests" unittests_suite
 			exit $? ;;
@@ -102,6 +102,7 @@
 #include <wsutil/crash_info.h>
 #include <version_info.h>
 #include <wsutil/inet_addr.h>
+#include <wsutil/ws_mempbrk.h>
 
 #ifdef _WIN32
 #include <io.h>     /* for _setmode */
@@ -145,6 +146,10 @@ static int debug = 0;
 /* Be quiet */
 static int quiet = FALSE;
 
+/* Parse the input with the flex scanner instead of the line parser */
+#define LONGOPT_FLEX_SCANNER (65536+1)
+static gboolean use_flex_scanner = FALSE;
+
 /* Dummy Ethernet header */
 static int hdr_ethernet = FALSE;
 static guint32 hdr_ethernet_proto = 0;
@@ -230,6 +235,7 @@ static FILE       *input_file  = NULL;
 /* Output file */
 static char *output_filename;
 static FILE       *output_file = NULL;
+#define OUTPUT_BUFSIZE (1024 * 1024)
 
 /* Offset base to parse */
 static guint32 offset_base = 16;
@@ -1355,6 +1361,275 @@ fail_null_str:
     return EXIT_FAILURE;
 }
 
+/*----------------------------------------------------------------------
+ * Hexdump line parser
+ *
+ * This splits the input into the same tokens as the flex scanner in
+ * text2pcap-scanner.l and hands them to parse_token() in the same order,
+ * but it reads the input in large blocks, finds the ends of lines and of
+ * words with memchr() and ws_mempbrk_exec() (which use SIMD instructions
+ * where they are available), and decodes the runs of bytes that make up
+ * most of a hexdump straight into the packet buffer.
+ *
+ * Like the scanner, it takes the rule matching the longest text and,
+ * between matches of the same length, the first rule; the rules below
+ * are in the order of the scanner's, and must be kept in sync with them.
+ */
+typedef enum {
+    R_BYTE,         /* [hex][hex][ \t]          */
+    R_BYTE_EOL,     /* [hex][hex]\r?\n          */
+    R_OFFSET,       /* [hex]+[: \t]             */
+    R_OFFSET_EOL,   /* [hex]+\r?\n              */
+    R_MAILFWD,      /* >[hex]+[: \t]            */
+    R_EOL,          /* \r?\n\r?                 */
+    R_WS,           /* [ \t]                    */
+    R_DIRECTIVE,    /* ^#TEXT2PCAP.*\r?\n       */
+    R_COMMENT,      /* ^[\t ]*#.*\r?\n          */
+    R_TEXT          /* [^ \n\t]+                */
+} hexdump_rule_t;
+
+#define HEXDUMP_BUFSIZE (1024 * 1024)
+
+static gint8 hex_value[256];
+static ws_mempbrk_pattern pbrk_text_end;
+
+/*
+ * Length of the line end at p, if there is one
+ */
+static size_t
+hexdump_eol_len(const guint8 *p, const guint8 *end)
+{
+    if (p < end && *p == '\n')
+        return 1;
+    if (p + 1 < end && p[0] == '\r' && p[1] == '\n')
+        return 2;
+    return 0;
+}
+
+/*
+ * Find the rule matching at p and the length of the text it matches.
+ * The text up to end contains a complete line or the end of the input.
+ */
+static hexdump_rule_t
+hexdump_match(const guint8 *p, const guint8 *end, gboolean bol, size_t *lenp)
+{
+    const guint8   *q, *nl;
+    size_t          hex, n;
+    hexdump_rule_t  rule = R_TEXT;
+    size_t          len = 0;
+    guchar          found;
+
+#define HEXDUMP_MATCH(r, l) \
+    do { if ((size_t)(l) > len) { rule = (r); len = (l); } } while (0)
+
+    for (q = p; q < end && hex_value[*q] >= 0; q++)
+        ;
+    hex = q - p;
+    if (hex > 0) {
+        if (hex == 2 && q < end && (*q == ' ' || *q == '\t'))
+            HEXDUMP_MATCH(R_BYTE, 3);
+        if (hex == 2 && (n = hexdump_eol_len(q, end)) != 0)
+            HEXDUMP_MATCH(R_BYTE_EOL, 2 + n);
+        if (q < end && (*q == ':' || *q == ' ' || *q == '\t'))
+            HEXDUMP_MATCH(R_OFFSET, hex + 1);
+        if ((n = hexdump_eol_len(q, end)) != 0)
+            HEXDUMP_MATCH(R_OFFSET_EOL, hex + n);
+    }
+
+    if (*p == '>') {
+        for (q = p + 1; q < end && hex_value[*q] >= 0; q++)
+            ;
+        if (q > p + 1 && q < end && (*q == ':' || *q == ' ' || *q == '\t'))
+            HEXDUMP_MATCH(R_MAILFWD, q - p + 1);
+    }
+
+    if ((n = hexdump_eol_len(p, end)) != 0)
+        HEXDUMP_MATCH(R_EOL, (p + n < end && p[n] == '\r') ? n + 1 : n);
+
+    if (*p == ' ' || *p == '\t')
+        HEXDUMP_MATCH(R_WS, 1);
+
+    if (bol) {
+        nl = (const guint8 *)memchr(p, '\n', end - p);
+        if (nl != NULL) {
+            if (end - p >= 10 && memcmp(p, "#TEXT2PCAP", 10) == 0)
+                HEXDUMP_MATCH(R_DIRECTIVE, nl - p + 1);
+            for (q = p; q < nl && (*q == ' ' || *q == '\t'); q++)
+                ;
+            if (*q == '#')
+                HEXDUMP_MATCH(R_COMMENT, nl - p + 1);
+        }
+    }
+
+    if (*p != ' ' && *p != '\t' && *p != '\n') {
+        /* The hex digits at p are part of the text, so start after them */
+        q = p + hex;
+        if (q < end && *q != ' ' && *q != '\t' && *q != '\n') {
+            q = ws_mempbrk_exec(q, end - q, &pbrk_text_end, &found);
+            if (q == NULL)
+                q = end;
+        }
+        HEXDUMP_MATCH(R_TEXT, (size_t)(q - p));
+    }
+
+#undef HEXDUMP_MATCH
+
+    *lenp = len;
+    return rule;
+}
+
+/*
+ * Hand the len bytes of text at str to parse_token()
+ */
+static int
+hexdump_token(token_t token, guint8 *str, size_t len)
+{
+    guint8 saved = str[len];
+    int    ret;
+
+    str[len] = '\0';
+    ret = parse_token(token, (char *)str);
+    str[len] = saved;
+    return ret;
+}
+
+/*
+ * Parse the hexdump in the given file
+ */
+static int
+hexdump_scan(FILE *in)
+{
+    guint8         *buf;
+    size_t          bufsize = HEXDUMP_BUFSIZE;
+    size_t          avail = 0, pos = 0, line_end, len, nread;
+    const guint8   *nl;
+    gboolean        eof = FALSE;
+    gboolean        bol = TRUE;
+    hexdump_rule_t  rule;
+    gint8           hi, lo;
+    guint8         *p;
+    int             ret = EXIT_SUCCESS;
+    int             i;
+
+    for (i = 0; i < 256; i++)
+        hex_value[i] = (gint8)g_ascii_xdigit_value((gchar)i);
+    ws_mempbrk_compile(&pbrk_text_end, " \t\n");
+
+    /* One more byte for the NUL at the end of the last token */
+    buf = (guint8 *)g_malloc(bufsize + 1);
+
+    while (ret == EXIT_SUCCESS) {
+        /*
+         * Make sure we have a whole line, and the byte after it that
+         * an end of line can take, unless the input ends first.
+         */
+        nl = (const guint8 *)memchr(buf + pos, '\n', avail - pos);
+        if (!eof && (nl == NULL || nl + 1 == buf + avail)) {
+            if (pos > 0) {
+                memmove(buf, buf + pos, avail - pos);
+                avail -= pos;
+                pos = 0;
+            }
+            if (avail == bufsize) {
+                bufsize *= 2;
+                buf = (guint8 *)g_realloc(buf, bufsize + 1);
+            }
+            nread = fread(buf + avail, 1, bufsize - avail, in);
+            if (nread == 0) {
+                if (ferror(in)) {
+                    fprintf(stderr, "Error reading [%s]: %s\n",
+                            input_filename, g_strerror(errno));
+                    ret = EXIT_FAILURE;
+                    break;
+                }
+                eof = TRUE;
+            }
+            avail += nread;
+            continue;
+        }
+        if (pos == avail)
+            break;
+        line_end = nl ? (size_t)(nl + 1 - buf) : avail;
+
+        while (pos < line_end && ret == EXIT_SUCCESS) {
+            /*
+             * Bytes of a packet line; this is what parse_token() does with
+             * them, without the tokenizing and the parsing of the numbers.
+             * The whitespace after a byte can't start a comment, so it's
+             * skipped.
+             */
+            if ((state == READ_OFFSET || state == READ_BYTE) && debug < 2) {
+                while (pos + 2 < line_end) {
+                    p = buf + pos;
+                    hi = hex_value[p[0]];
+                    lo = hex_value[p[1]];
+                    if (hi < 0 || lo < 0 || (p[2] != ' ' && p[2] != '\t'))
+                        break;
+                    state = READ_BYTE;
+                    packet_buf[curr_offset] = (guint8)((hi << 4) | lo);
+                    curr_offset++;
+                    pos += 3;
+                    bol = FALSE;
+                    if (curr_offset - header_length >= max_offset) { /* packet full */
+                        if (start_new_packet(TRUE) != EXIT_SUCCESS) {
+                            ret = EXIT_FAILURE;
+                            break;
+                        }
+                    }
+                    while (pos < line_end && (buf[pos] == ' ' || buf[pos] == '\t'))
+                        pos++;
+                }
+                if (ret != EXIT_SUCCESS || pos >= line_end)
+                    break;
+            }
+
+            p = buf + pos;
+            rule = hexdump_match(p, buf + avail, bol, &len);
+            bol = (p[len - 1] == '\n');
+            pos += len;
+
+            switch (rule) {
+            case R_BYTE:
+                ret = hexdump_token(T_BYTE, p, len);
+                break;
+            case R_OFFSET:
+                ret = hexdump_token(T_OFFSET, p, len);
+                break;
+            case R_MAILFWD:
+                ret = hexdump_token(T_OFFSET, p + 1, len - 1);
+                break;
+            case R_BYTE_EOL:
+                ret = hexdump_token(T_BYTE, p, len);
+                if (ret == EXIT_SUCCESS)
+                    ret = parse_token(T_EOL, NULL);
+                break;
+            case R_OFFSET_EOL:
+                ret = hexdump_token(T_OFFSET, p, len);
+                if (ret == EXIT_SUCCESS)
+                    ret = parse_token(T_EOL, NULL);
+                break;
+            case R_DIRECTIVE:
+                ret = hexdump_token(T_DIRECTIVE, p, len);
+                if (ret == EXIT_SUCCESS)
+                    ret = parse_token(T_EOL, NULL);
+                break;
+            case R_EOL:
+            case R_COMMENT:
+                ret = parse_token(T_EOL, NULL);
+                break;
+            case R_WS:
+                break;
+            case R_TEXT:
+                ret = hexdump_token(T_TEXT, p, len);
+                break;
+            }
+        }
+    }
+
+    g_free(buf);
+    return ret;
+}
+
 /*----------------------------------------------------------------------
  * Print usage string and exit
  */
@@ -1390,6 +1665,8 @@ print_usage (FILE *output)
             "                         like a HEX dump.\n"
             "                         NOTE: Do not enable it if the input file does not\n"
             "                         contain the ASCII text dump.\n"
+            "  --flex-scanner         parse the input with the flex scanner instead of the\n"
+            "                         faster line parser; the output is the same.\n"
             "\n"
             "Output:\n"
             "  -l <typenum>           link-layer type number; default is 1 (Ethernet).  See\n"
@@ -1455,6 +1732,7 @@ parse_options (int argc, char *argv[])
     static const struct option long_options[] = {
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
+        {"flex-scanner", no_argument, NULL, LONGOPT_FLEX_SCANNER},
         {0, 0, 0, 0 }
     };
     struct tm *now_tm;
@@ -1497,6 +1775,7 @@ parse_options (int argc, char *argv[])
         case 'l': pcap_link_type = (guint32)strtol(optarg, NULL, 0); break;
         case 'm': max_offset = (guint32)strtol(optarg, NULL, 0); break;
         case 'n': use_pcapng = TRUE; break;
+        case LONGOPT_FLEX_SCANNER: use_flex_scanner = TRUE; break;
         case 'o':
             if (optarg[0] != 'h' && optarg[0] != 'o' && optarg[0] != 'd') {
                 fprintf(stderr, "Bad argument for '-o': %s\n", optarg);
@@ -1811,6 +2090,12 @@ parse_options (int argc, char *argv[])
         output_file = stdout;
     }
 
+    /*
+     * The packets are written with a few small writes each; collect them
+     * in a large buffer, so that they go out in few large writes.
+     */
+    setvbuf(output_file, NULL, _IOFBF, OUTPUT_BUFSIZE);
+
     /* Some validation */
     if (pcap_link_type != 1 && hdr_ethernet) {
         fprintf(stderr, "Dummy headers (-e, -i, -u, -s, -S -T) cannot be specified with link type override (-l)\n");
@@ -1907,12 +2192,15 @@ main(int argc, char *argv[])
     }
     curr_offset = header_length;
 
-    text2pcap_in = input_file;
-    if (text2pcap_scan() == EXIT_SUCCESS) {
+    if (use_flex_scanner) {
+        text2pcap_in = input_file;
+        ret = text2pcap_scan();
+    } else {
+        ret = hexdump_scan(input_file);
+    }
+    if (ret == EXIT_SUCCESS) {
         if (write_current_packet(FALSE) != EXIT_SUCCESS)
             ret = EXIT_FAILURE;
-    } else {
-        ret = EXIT_FAILURE;
     }
     if (debug)
         fprintf(stderr, "\n-------------------------\n");
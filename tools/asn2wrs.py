@@ -1468,6 +1468,27 @@ class EthCtx:
         out += ";\n"
         return out
 
+    #--- eth_type_desc ----------------------------------------------------------
+    def eth_type_desc(self, tname):
+        """Name of the per_type_t description of the type, or None if it is
+        only dissected by its function"""
+        if not self.table_driven or not self.Per():
+            return None
+        t = self.eth_type[tname]
+        if t['import'] or (t['user_def'] & EF_TYPE) or (t['no_emit'] & EF_TYPE):
+            return None
+        # cycles are broken with forward declarations of the functions only
+        if tname in self.dep_cycle_eth_type:
+            return None
+        ref = t['ref'][0]
+        if self.conform.get_fn_presence(ref) or self.conform.check_item('FN_PARS', tname) or self.conform.check_item('FN_PARS', ref):
+            return None
+        if not t['val'].eth_type_default_desc(self, tname):
+            return None
+        if (self.merge_modules):
+            return '%s_type' % (tname)
+        return '%s_%s_type' % (t['proto'], tname)
+
     #--- eth_fn_call ------------------------------------------------------------
     def eth_fn_call(self, fname, ret=None, indent=2, par=None):
         out = indent * ' '
@@ -2741,6 +2762,9 @@ class EthCnf:
         elif opt in ("-u", "UNALIGNED"):
             par = self.check_par(par, 0, 0, fn, lineno)
             self.ectx.aligned = False
+        elif opt in ("-t", "TABLE_DRIVEN"):
+            par = self.check_par(par, 0, 0, fn, lineno)
+            self.ectx.table_driven = True
         elif opt in ("-d",):
             par = self.check_par(par, 1, 1, fn, lineno)
             if not par: return
@@ -3315,6 +3339,16 @@ class Type (Node):
         print(self.str_depth(1))
         return ''
 
+    def eth_type_default_desc(self, ectx, tname):
+        return None
+
+    def eth_type_default_types(self, ectx, tname):
+        return []
+
+    def eth_per_type_desc(self, kind, ett='NULL', min='0', max='0', min_len='0', max_len='0',
+                          ext='FALSE', value_map='NULL', sequence='NULL', choice='NULL', types='NULL'):
+        return '{ %s }' % (', '.join((kind, ett, min, max, min_len, max_len, ext, value_map, sequence, choice, types)))
+
     def eth_type_default_pars(self, ectx, tname):
         pars = {
           'TNAME' : tname,
@@ -3343,6 +3377,16 @@ class Type (Node):
             pars.update(ectx.conform.use_item('FN_PARS', tname))
         elif ectx.conform.check_item('FN_PARS', ectx.eth_type[tname]['ref'][0]):
             pars.update(ectx.conform.use_item('FN_PARS', ectx.eth_type[tname]['ref'][0]))
+        desc = ectx.eth_type_desc(tname)
+        if desc:
+            types = [ectx.eth_type_desc(t) for t in self.eth_type_default_types(ectx, tname)]
+            pars['TYPE_DESC'] = desc
+            pars['TYPES'] = 'NULL'
+            if [t for t in types if t]:
+                pars['TYPES'] = '%(PROTOP)s%(TNAME)s_types'
+            body = ectx.eth_fn_call('dissect_%(ER)s_type', ret='offset',
+                                    par=(('%(TVB)s', '%(OFFSET)s', '%(ACTX)s', '%(TREE)s', '%(HF_INDEX)s'),
+                                         ('&%(TYPE_DESC)s',),))
         pars['DEFAULT_BODY'] = body
         for i in range(4):
             for k in list(pars.keys()):
@@ -3352,6 +3396,14 @@ class Type (Node):
                     raise sys.exc_info()[0]("%s\n%s" % (str(pars), sys.exc_info()[1]))
         out = '\n'
         out += self.eth_type_default_table(ectx, tname) % pars
+        if desc:
+            if pars['TYPES'] != 'NULL':
+                out += 'static const per_type_t * const %s[] = {\n' % (pars['TYPES'])
+                for t in types:
+                    if t: out += '  &%s,\n' % (t)
+                    else: out += '  NULL,\n'
+                out += '};\n'
+            out += 'static const per_type_t %s = %s;\n' % (desc, self.eth_type_default_desc(ectx, tname) % pars)
         out += ectx.eth_type_fn_hdr(tname)
         out += ectx.eth_type_fn_body(tname, body, pars=pars)
         out += ectx.eth_type_fn_ftr(tname)
@@ -3881,14 +3933,17 @@ class TaggedType (Type):
 
 #--- SqType -----------------------------------------------------------
 class SqType (Type):
+    def item_type(self, f, val, ectx):
+        if (val.eth_omit_field()):
+            return ectx.type[val.ident]['ethname']
+        return ectx.eth_hf[ectx.field[f]['ethname']]['ethtype']
+
     def out_item(self, f, val, optional, ext, ectx):
+        t = self.item_type(f, val, ectx)
         if (val.eth_omit_field()):
-            t = ectx.type[val.ident]['ethname']
             fullname = ectx.dummy_eag_field
         else:
-            ef = ectx.field[f]['ethname']
-            t = ectx.eth_hf[ef]['ethtype']
-            fullname = ectx.eth_hf[ef]['fullname']
+            fullname = ectx.eth_hf[ectx.field[f]['ethname']]['fullname']
         if (ectx.Ber()):
             #print "optional=%s, e.val.HasOwnTag()=%s, e.val.IndetermTag()=%s" % (str(e.optional), str(e.val.HasOwnTag()), str(e.val.IndetermTag(ectx)))
             #print val.str_depth(1)
@@ -4053,6 +4108,15 @@ class SeqType (SqType):
             table += "  { NULL, %s, 0, NULL }\n};\n" % (empty_ext_flag)
         return table
 
+    def eth_type_default_types(self, ectx, tname):
+        fname = ectx.eth_type[tname]['ref'][0]
+        lst = self.elt_list[:]
+        if hasattr(self, 'ext_list'):
+            lst.extend(self.ext_list)
+        if hasattr(self, 'elt_list2'):
+            lst.extend(self.elt_list2)
+        return [self.item_type(fname + '/' + e.val.name, e.val, ectx) for e in lst]
+
 #--- SeqOfType -----------------------------------------------------------
 class SeqOfType (SqType):
     def eth_type_default_table(self, ectx, tname):
@@ -4067,6 +4131,14 @@ class SeqOfType (SqType):
         table += "};\n"
         return table
 
+    def eth_type_default_types(self, ectx, tname):
+        fname = ectx.eth_type[tname]['ref'][0]
+        if self.val.IsNamed ():
+            f = fname + '/' + self.val.name
+        else:
+            f = fname + '/' + ITEM_FIELD_NAME
+        return [self.item_type(f, self.val, ectx)]
+
 #--- SequenceOfType -----------------------------------------------------------
 class SequenceOfType (SeqOfType):
     def to_python (self, ctx):
@@ -4133,6 +4205,18 @@ class SequenceOfType (SeqOfType):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if not ectx.eth_type[tname]['tree']:
+            return None
+        if not self.HasConstraint():
+            return self.eth_per_type_desc('PER_TYPE_SEQUENCE_OF', ett='&%(ETT_INDEX)s',
+                                          sequence='%(TABLE)s', types='%(TYPES)s')
+        elif self.constr.type == 'Size':
+            return self.eth_per_type_desc('PER_TYPE_CONSTRAINED_SEQUENCE_OF', ett='&%(ETT_INDEX)s',
+                                          min_len='%(MIN_VAL)s', max_len='%(MAX_VAL)s', ext='%(EXT)s',
+                                          sequence='%(TABLE)s', types='%(TYPES)s')
+        return None
+
 
 #--- SetOfType ----------------------------------------------------------------
 class SetOfType (SeqOfType):
@@ -4269,6 +4353,12 @@ class SequenceType (SeqType):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if not ectx.eth_type[tname]['tree']:
+            return None
+        return self.eth_per_type_desc('PER_TYPE_SEQUENCE', ett='&%(ETT_INDEX)s',
+                                      sequence='%(TABLE)s', types='%(TYPES)s')
+
 #--- ExtensionAdditionGroup ---------------------------------------------------
 class ExtensionAdditionGroup (SeqType):
     def __init__(self,*args, **kw) :
@@ -4597,6 +4687,19 @@ class ChoiceType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if not ectx.eth_type[tname]['tree']:
+            return None
+        return self.eth_per_type_desc('PER_TYPE_CHOICE', ett='&%(ETT_INDEX)s',
+                                      choice='%(TABLE)s', types='%(TYPES)s')
+
+    def eth_type_default_types(self, ectx, tname):
+        fname = ectx.eth_type[tname]['ref'][0]
+        lst = self.elt_list[:]
+        if hasattr(self, 'ext_list'):
+            lst.extend(self.ext_list)
+        return [ectx.eth_hf[ectx.field[fname + '/' + e.name]['ethname']]['ethtype'] for e in lst]
+
 #--- ChoiceValue ----------------------------------------------------
 class ChoiceValue (Value):
     def to_str(self, ectx):
@@ -4732,6 +4835,10 @@ class EnumeratedType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        return self.eth_per_type_desc('PER_TYPE_ENUMERATED', min='%(ROOT_NUM)s', max='%(EXT_NUM)s',
+                                      ext='%(EXT)s', value_map='%(TABLE)s')
+
 #--- EmbeddedPDVType -----------------------------------------------------------
 class EmbeddedPDVType (Type):
     def eth_tname(self):
@@ -4913,6 +5020,9 @@ class NullType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        return self.eth_per_type_desc('PER_TYPE_NULL')
+
 #--- NullValue ----------------------------------------------------
 class NullValue (Value):
     def to_str(self, ectx):
@@ -4969,6 +5079,9 @@ class BooleanType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        return self.eth_per_type_desc('PER_TYPE_BOOLEAN')
+
 #--- OctetStringType ----------------------------------------------------------
 class OctetStringType (Type):
     def to_python (self, ctx):
@@ -5041,6 +5154,12 @@ class OctetStringType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if self.HasContentsConstraint():
+            return None
+        return self.eth_per_type_desc('PER_TYPE_OCTET_STRING', min_len='%(MIN_VAL)s', max_len='%(MAX_VAL)s',
+                                      ext='%(EXT)s')
+
 #--- CharacterStringType ------------------------------------------------------
 class CharacterStringType (Type):
     def eth_tname(self):
@@ -5423,6 +5542,14 @@ class IntegerType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if not self.HasValueConstraint():
+            return self.eth_per_type_desc('PER_TYPE_INTEGER')
+        if self.constr.Needs64b(ectx):
+            return None
+        return self.eth_per_type_desc('PER_TYPE_CONSTRAINED_INTEGER', min='%(MIN_VAL)s', max='%(MAX_VAL)s',
+                                      ext='%(EXT)s')
+
 #--- BitStringType ------------------------------------------------------------
 class BitStringType (Type):
     def to_python (self, ctx):
@@ -5524,6 +5651,12 @@ class BitStringType (Type):
             body = '#error Can not decode %s' % (tname)
         return body
 
+    def eth_type_default_desc(self, ectx, tname):
+        if self.HasContentsConstraint():
+            return None
+        return self.eth_per_type_desc('PER_TYPE_BIT_STRING', min_len='%(MIN_VAL)s', max_len='%(MAX_VAL)s',
+                                      ext='%(EXT)s')
+
 #--- BStringValue ------------------------------------------------------------
 bstring_tab = {
   '0000' : '0',
@@ -7828,6 +7961,8 @@ def eth_usage():
     -h|?          : Usage
     -b            : BER (default is PER)
     -u            : Unaligned (default is aligned)
+    -t            : Table driven (PER only): describe the types with
+                    constant per_type_t tables dissected by dissect_per_type()
     -p proto      : Protocol name (implies -S). Default is module-name
                     from input_file (renamed by #.MODULE if present)
     -o name       : Output files name core (default is <proto>)
@@ -7865,7 +8000,7 @@ def eth_main():
     global lexer
     print("ASN.1 to Wireshark dissector compiler");
     try:
-        opts, args = getopt.getopt(sys.argv[1:], "h?d:D:buXp:FTo:O:c:I:eESs:kLCr:");
+        opts, args = getopt.getopt(sys.argv[1:], "h?d:D:butXp:FTo:O:c:I:eESs:kLCr:");
     except getopt.GetoptError:
         eth_usage(); sys.exit(2)
     if len(args) < 1:
@@ -7892,6 +8027,7 @@ def eth_main():
     ectx.output.outnm = None
     ectx.output.single_file = None
     ectx.constraints_check = False;
+    ectx.table_driven = False
     for o, a in opts:
         if o in ("-h", "-?"):
             eth_usage(); sys.exit(2)
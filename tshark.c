@@ -102,6 +102,7 @@
 
 #ifdef HAVE_LIBPCAP
 #include "caputils/capture_ifinfo.h"
+#include "caputils/capture_shm_ring.h"
 #ifdef _WIN32
 #include "caputils/capture-wpcap.h"
 #include <wsutil/os_version_info.h>
@@ -2177,6 +2178,10 @@ main(int argc, char *argv[])
        starting the statistics taps. */
     do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
 
+    /* If we dissect the packets, have dumpcap hand them to us in shared
+       memory, so we don't have to read them back from the capture file. */
+    global_capture_opts.use_shm_ring = do_dissection;
+
     /*
      * XXX - this returns FALSE if an error occurred, but it also
      * returns FALSE if the capture stops because a time limit
@@ -2617,6 +2622,122 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
 }
 
 
+#ifdef HAVE_SHM_OPEN
+/*
+ * Number of packets we got from the shared memory ring dumpcap hands
+ * them to us in that the capture file reader hasn't read yet; if we go
+ * back to reading the file, it has to skip them first.
+ */
+static guint32 shm_ring_skip;
+
+/*
+ * Link-layer type and time stamp precision of the interfaces of the
+ * capture file, for the packets from the ring; the interfaces are only
+ * looked up again when a packet is on one we don't know about yet.
+ */
+typedef struct {
+  int encap;
+  int tsprec;
+} shm_ring_iface_t;
+
+static GArray *shm_ring_ifaces;
+
+static const shm_ring_iface_t *
+shm_ring_get_iface(capture_file *cf, guint32 interface_id)
+{
+  wtapng_iface_descriptions_t *idb_inf;
+  wtapng_if_descr_mandatory_t *if_descr;
+  shm_ring_iface_t             iface;
+  guint                        i;
+
+  if (shm_ring_ifaces == NULL)
+    shm_ring_ifaces = g_array_new(FALSE, FALSE, sizeof (shm_ring_iface_t));
+  if (interface_id >= shm_ring_ifaces->len) {
+    idb_inf = wtap_file_get_idb_info(cf->provider.wth);
+    g_array_set_size(shm_ring_ifaces, 0);
+    for (i = 0; i < idb_inf->interface_data->len; i++) {
+      if_descr = (wtapng_if_descr_mandatory_t *)wtap_block_get_mandatory_data(
+          g_array_index(idb_inf->interface_data, wtap_block_t, i));
+      iface.encap = if_descr->wtap_encap;
+      iface.tsprec = if_descr->tsprecision;
+      g_array_append_val(shm_ring_ifaces, iface);
+    }
+    g_free(idb_inf);
+    if (interface_id >= shm_ring_ifaces->len)
+      return NULL;
+  }
+  return &g_array_index(shm_ring_ifaces, shm_ring_iface_t, interface_id);
+}
+
+/*
+ * Get the next packet from the shared memory ring and fill in rec for it.
+ *
+ * Returns NULL if the ring is empty, which means dumpcap stopped using it
+ * because we didn't keep up, or if the packet has a link-layer type for
+ * which only the capture file reader can fill in the pseudo-header; in
+ * both cases, the ring is closed and the packets have to be read from the
+ * capture file from now on.
+ */
+static const capture_shm_record *
+capture_shm_ring_next_packet(capture_session *cap_session, capture_file *cf,
+                             wtap_rec *rec)
+{
+  const capture_shm_record *srec;
+  const shm_ring_iface_t   *iface;
+  int                       encap = WTAP_ENCAP_UNKNOWN;
+  int                       tsprec = WTAP_TSPREC_UNKNOWN;
+
+  srec = capture_shm_ring_get(cap_session->shm_ring);
+  if (srec != NULL &&
+      (iface = shm_ring_get_iface(cf, srec->interface_id)) != NULL) {
+    encap = iface->encap;
+    tsprec = iface->tsprec;
+  }
+
+  memset(&rec->rec_header.packet_header.pseudo_header, 0,
+         sizeof rec->rec_header.packet_header.pseudo_header);
+  switch (srec != NULL ? encap : WTAP_ENCAP_UNKNOWN) {
+
+  case WTAP_ENCAP_ETHERNET:
+    /* We don't know whether there's an FCS in this frame or not. */
+    rec->rec_header.packet_header.pseudo_header.eth.fcs_len = -1;
+    break;
+
+  case WTAP_ENCAP_IEEE_802_11_RADIOTAP:
+    /* That's indicated in the radiotap header. */
+    rec->rec_header.packet_header.pseudo_header.ieee_802_11.fcs_len = -1;
+    break;
+
+  case WTAP_ENCAP_SLL:
+  case WTAP_ENCAP_RAW_IP:
+  case WTAP_ENCAP_RAW_IP4:
+  case WTAP_ENCAP_RAW_IP6:
+  case WTAP_ENCAP_NULL:
+  case WTAP_ENCAP_LOOP:
+    /* No pseudo-header. */
+    break;
+
+  default:
+    capture_shm_ring_close(cap_session->shm_ring);
+    cap_session->shm_ring = NULL;
+    return NULL;
+  }
+
+  rec->rec_type = REC_TYPE_PACKET;
+  rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
+  if (wtap_file_type_subtype(cf->provider.wth) == WTAP_FILE_TYPE_SUBTYPE_PCAPNG)
+    rec->presence_flags |= WTAP_HAS_INTERFACE_ID;
+  rec->ts.secs = (time_t)srec->ts_secs;
+  rec->ts.nsecs = (int)srec->ts_nsecs;
+  rec->tsprec = tsprec;
+  rec->rec_header.packet_header.caplen = srec->caplen;
+  rec->rec_header.packet_header.len = srec->len;
+  rec->rec_header.packet_header.pkt_encap = encap;
+  rec->rec_header.packet_header.interface_id = srec->interface_id;
+  return srec;
+}
+#endif /* HAVE_SHM_OPEN */
+
 /* capture child tells us we have new packets to read */
 void
 capture_input_new_packets(capture_session *cap_session, int to_read)
@@ -2647,6 +2768,10 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
   if (do_dissection) {
     gboolean create_proto_tree;
     epan_dissect_t *edt;
+#ifdef HAVE_SHM_OPEN
+    wtap_rec shm_rec;
+    const capture_shm_record *srec;
+#endif
 
     /*
      * Determine whether we need to create a protocol tree.
@@ -2678,13 +2803,50 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+#ifdef HAVE_SHM_OPEN
+    wtap_rec_init(&shm_rec);
+#endif
 
     while (to_read-- && cf->provider.wth) {
+#ifdef HAVE_SHM_OPEN
+      if (cap_session->shm_ring != NULL &&
+          (srec = capture_shm_ring_next_packet(cap_session, cf, &shm_rec)) != NULL) {
+        /* dumpcap handed us this one, no need to read it from the file. */
+        reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+        ret = process_packet_single_pass(cf, edt, srec->file_offset, &shm_rec,
+                                         (const guchar *)(srec + 1), tap_flags);
+        capture_shm_ring_release(cap_session->shm_ring, srec);
+        shm_ring_skip++;
+        if (ret != FALSE)
+          packet_count++;
+        continue;
+      }
+
+      /*
+       * Skip the packets we already got from the ring. dumpcap told us
+       * about them after writing them, so failing to read them, even
+       * because of an EOF, is the same as failing to read this packet.
+       */
+      ret = TRUE;
+      while (shm_ring_skip != 0 && ret) {
+        wtap_cleareof(cf->provider.wth);
+        ret = wtap_read(cf->provider.wth, &err, &err_info, &data_offset);
+        if (ret)
+          shm_ring_skip--;
+      }
+      if (ret) {
+        wtap_cleareof(cf->provider.wth);
+        ret = wtap_read(cf->provider.wth, &err, &err_info, &data_offset);
+      }
+#else
       wtap_cleareof(cf->provider.wth);
       ret = wtap_read(cf->provider.wth, &err, &err_info, &data_offset);
+#endif
       reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
       if (ret == FALSE) {
         /* read from file failed, tell the capture child to stop */
+        if (err != 0)
+          cfile_read_failure_message("TShark", cf->filename, err, err_info);
         sync_pipe_stop(cap_session);
         wtap_close(cf->provider.wth);
         cf->provider.wth = NULL;
@@ -2699,6 +2861,9 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
       }
     }
 
+#ifdef HAVE_SHM_OPEN
+    wtap_rec_cleanup(&shm_rec);
+#endif
     epan_dissect_free(edt);
 
   } else {
@@ -2860,6 +3025,31 @@ capture_cleanup(int signum _U_)
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+/*
+ * Resolve all the addresses gathered during the first pass, in as many
+ * concurrent requests as the name resolution preferences allow, so that
+ * the second pass finds their names.
+ */
+static void
+resolve_first_pass_addresses(void)
+{
+  host_name_lookup_stats_t stats;
+  guint answered;
+
+  host_name_lookup_wait();
+
+  host_name_lookup_get_stats(&stats);
+  if (stats.queued == 0 || really_quiet)
+    return;
+  answered = stats.resolved + stats.failed + stats.timed_out;
+  fprintf(stderr,
+          "Resolved %u of %u addresses (%u not found, %u timed out); "
+          "lookup time %.1f ms average, %.1f ms maximum\n",
+          stats.resolved, stats.queued, stats.failed, stats.timed_out,
+          answered ? stats.total_latency / 1000.0 / answered : 0.0,
+          stats.max_latency / 1000.0);
+}
+
 static gboolean
 process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
                           gint64 offset, wtap_rec *rec,
@@ -2917,6 +3107,14 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     /* Run the read filter if we have one. */
     if (cf->rfcode)
       passed = dfilter_apply_edt(cf->rfcode, edt);
+
+    /* Gather the addresses to resolve; they're all resolved at once
+       before the second pass. */
+    if (passed && gbl_resolv_flags.network_name &&
+        gbl_resolv_flags.use_external_net_name_resolver) {
+      host_name_lookup_queue(&edt->pi.net_src);
+      host_name_lookup_queue(&edt->pi.net_dst);
+    }
   }
 
   if (passed) {
@@ -3221,6 +3419,10 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
      * don't need after the sequential run-through of the packets. */
     postseq_cleanup_all_protocols();
 
+    if (do_dissection && gbl_resolv_flags.network_name &&
+        gbl_resolv_flags.use_external_net_name_resolver)
+      resolve_first_pass_addresses();
+
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
     ws_buffer_init(&buf, 1500);
@@ -47,10 +47,33 @@ typedef struct expert_entry
 /* Overall struct for storing all data seen */
 typedef struct expert_tapdata_t {
     GArray       *ei_array[max_level]; /* expert info items */
+    GHashTable   *ei_index[max_level]; /* expert_entry (protocol, summary) -> index in ei_array + 1 */
     GStringChunk *text;         /* for efficient storage of summary strings */
+    gboolean      use_summaries; /* no filter, take the first pass summaries instead of tapping */
 } expert_tapdata_t;
 
 
+/* The protocol and summary of the keys are interned in the GStringChunk, so
+   they can be hashed and compared by address */
+static guint
+expert_entry_hash(gconstpointer key)
+{
+    const expert_entry *entry = (const expert_entry *)key;
+
+    return g_direct_hash(entry->protocol) ^ g_direct_hash(entry->summary);
+}
+
+static gboolean
+expert_entry_equal(gconstpointer a, gconstpointer b)
+{
+    const expert_entry *entry_a = (const expert_entry *)a;
+    const expert_entry *entry_b = (const expert_entry *)b;
+
+    return entry_a->protocol == entry_b->protocol &&
+           entry_a->summary == entry_b->summary;
+}
+
+
 /* Reset expert stats */
 static void
 expert_stat_reset(void *tapdata)
@@ -65,9 +88,68 @@ expert_stat_reset(void *tapdata)
     /* Empty each of the arrays */
     for (n=0; n < max_level; n++) {
         g_array_set_size(etd->ei_array[n], 0);
+        g_hash_table_remove_all(etd->ei_index[n]);
+    }
+}
+
+static gboolean
+expert_severity_level(int severity, severity_level_t *severity_level)
+{
+    switch (severity) {
+        case PI_CHAT:
+            *severity_level = chat_level;
+            return TRUE;
+        case PI_NOTE:
+            *severity_level = note_level;
+            return TRUE;
+        case PI_WARN:
+            *severity_level = warn_level;
+            return TRUE;
+        case PI_ERROR:
+            *severity_level = error_level;
+            return TRUE;
+        default:
+            return FALSE;
     }
 }
 
+/* Count an expert item frequency times */
+static void
+expert_stat_add(expert_tapdata_t *data, severity_level_t severity_level,
+                guint32 group, const gchar *protocol, const gchar *summary,
+                int frequency)
+{
+    expert_entry  tmp_entry;
+    expert_entry *entry;
+    guint         n;
+
+    /* Copy/Store protocol and summary strings efficiently using GStringChunk.
+       Identical strings are only stored once, so this also gives us keys
+       that can be compared by address */
+    tmp_entry.protocol = g_string_chunk_insert_const(data->text, protocol);
+    tmp_entry.summary = g_string_chunk_insert_const(data->text, summary);
+
+    /* If a duplicate just bump up frequency */
+    n = GPOINTER_TO_UINT(g_hash_table_lookup(data->ei_index[severity_level], &tmp_entry));
+    if (n != 0) {
+        entry = &g_array_index(data->ei_array[severity_level], expert_entry, n - 1);
+        entry->frequency += frequency;
+        return;
+    }
+
+    /* Else Add new item to end of list for severity level */
+    tmp_entry.group = group;
+    tmp_entry.frequency = frequency;
+    /* Store a copy of the expert entry */
+    g_array_append_val(data->ei_array[severity_level], tmp_entry);
+
+    /* The array may move when it grows, so index it by position */
+    entry = g_new(expert_entry, 1);
+    *entry = tmp_entry;
+    g_hash_table_insert(data->ei_index[severity_level], entry,
+                        GUINT_TO_POINTER(data->ei_array[severity_level]->len));
+}
+
 /* Process stat struct for an expert frame */
 static gboolean
 expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_,
@@ -76,26 +158,10 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
     const expert_info_t *ei   = (const expert_info_t *)pointer;
     expert_tapdata_t    *data = (expert_tapdata_t *)tapdata;
     severity_level_t     severity_level;
-    expert_entry         tmp_entry;
-    expert_entry        *entry;
-    guint                n;
 
-    switch (ei->severity) {
-        case PI_CHAT:
-            severity_level = chat_level;
-            break;
-        case PI_NOTE:
-            severity_level = note_level;
-            break;
-        case PI_WARN:
-            severity_level = warn_level;
-            break;
-        case PI_ERROR:
-            severity_level = error_level;
-            break;
-        default:
-            g_assert_not_reached();
-            return FALSE;
+    if (!expert_severity_level(ei->severity, &severity_level)) {
+        g_assert_not_reached();
+        return FALSE;
     }
 
     /* Don't store details at a lesser severity than we are interested in */
@@ -103,28 +169,56 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
         return TRUE;
     }
 
-    /* If a duplicate just bump up frequency.
-       TODO: could make more efficient by avoiding linear search...*/
-    for (n=0; n < data->ei_array[severity_level]->len; n++) {
-        entry = &g_array_index(data->ei_array[severity_level], expert_entry, n);
-        if ((strcmp(ei->protocol, entry->protocol) == 0) &&
-            (strcmp(ei->summary, entry->summary) == 0)) {
-            entry->frequency++;
-            return TRUE;
+    expert_stat_add(data, severity_level, ei->group, ei->protocol, ei->summary, 1);
+
+    return TRUE;
+}
+
+static void
+expert_stat_summary_cb(const expert_summary_t *summary, void *user_data)
+{
+    GPtrArray *summaries = (GPtrArray *)user_data;
+
+    g_ptr_array_add(summaries, (gpointer)summary);
+}
+
+/* Order summaries by the frame they were first seen in, which is the order
+   the tap would have delivered them in. Summaries first seen in the same
+   frame keep no particular order. */
+static gint
+expert_stat_summary_compare(gconstpointer a, gconstpointer b)
+{
+    const expert_summary_t *es_a = *(const expert_summary_t * const *)a;
+    const expert_summary_t *es_b = *(const expert_summary_t * const *)b;
+    guint32 frame_a = *(guint32 *)wmem_array_index(es_a->frames, 0);
+    guint32 frame_b = *(guint32 *)wmem_array_index(es_b->frames, 0);
+
+    return frame_a < frame_b ? -1 : frame_a > frame_b ? 1 : 0;
+}
+
+/* Fill in the stats from the expert infos collected during the first pass */
+static void
+expert_stat_add_summaries(expert_tapdata_t *data)
+{
+    GPtrArray              *summaries;
+    const expert_summary_t *es;
+    severity_level_t        severity_level;
+    guint                   n;
+
+    summaries = g_ptr_array_sized_new(expert_summary_get_count());
+    expert_summary_foreach(expert_stat_summary_cb, summaries);
+    g_ptr_array_sort(summaries, expert_stat_summary_compare);
+
+    for (n=0; n < summaries->len; n++) {
+        es = (const expert_summary_t *)g_ptr_array_index(summaries, n);
+        if (!expert_severity_level(es->severity, &severity_level) ||
+            severity_level < lowest_report_level) {
+            continue;
         }
+        expert_stat_add(data, severity_level, es->group, es->protocol, es->summary, es->count);
     }
 
-    /* Else Add new item to end of list for severity level */
-    entry = &tmp_entry;
-    /* Copy/Store protocol and summary strings efficiently using GStringChunk */
-    entry->protocol = g_string_chunk_insert_const(data->text, ei->protocol);
-    entry->summary = g_string_chunk_insert_const(data->text, ei->summary);
-    entry->group = ei->group;
-    entry->frequency = 1;
-    /* Store a copy of the expert entry */
-    g_array_append_val(data->ei_array[severity_level], tmp_entry);
-
-    return TRUE;
+    g_ptr_array_free(summaries, TRUE);
 }
 
 /* Output for all of the items of one severity */
@@ -172,6 +266,11 @@ expert_stat_draw(void *phs _U_)
     /* Look up the statistics struct */
     expert_tapdata_t *hs = (expert_tapdata_t *)phs;
 
+    if (hs->use_summaries) {
+        expert_stat_reset(hs);
+        expert_stat_add_summaries(hs);
+    }
+
     draw_items_for_severity(hs->ei_array[error_level], "Errors");
     draw_items_for_severity(hs->ei_array[warn_level],  "Warns");
     draw_items_for_severity(hs->ei_array[note_level],  "Notes");
@@ -231,17 +330,30 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
     /* Allocate GArray for each severity level */
     for (n=0; n < max_level; n++) {
         hs->ei_array[n] = g_array_sized_new(FALSE, FALSE, sizeof(expert_entry), 1000);
+        hs->ei_index[n] = g_hash_table_new_full(expert_entry_hash, expert_entry_equal, g_free, NULL);
     }
 
     /**********************************************/
     /* Register the tap listener                  */
     /**********************************************/
 
-    error_string = register_tap_listener("expert", hs,
-                                         filter, 0,
-                                         expert_stat_reset,
-                                         expert_stat_packet,
-                                         expert_stat_draw);
+    /* Without a filter every expert info counts, and they have all been
+       collected by the first pass already (expert_summary_foreach()), so
+       only a draw callback is needed. */
+    if (filter == NULL || filter[0] == '\0') {
+        hs->use_summaries = TRUE;
+        error_string = register_tap_listener("frame", hs,
+                                             NULL, 0,
+                                             NULL,
+                                             NULL,
+                                             expert_stat_draw);
+    } else {
+        error_string = register_tap_listener("expert", hs,
+                                             filter, 0,
+                                             expert_stat_reset,
+                                             expert_stat_packet,
+                                             expert_stat_draw);
+    }
     if (error_string) {
         printf("Expert tap error (%s)!\n", error_string->str);
         g_string_free(error_string, TRUE);
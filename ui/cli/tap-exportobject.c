@@ -76,9 +76,18 @@ local_eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
     return TRUE;
 }
 
+/* Objects are written to the destination directory as soon as they are
+ * complete, i.e. when they are added for most protocols, and at the end of
+ * the capture for protocols that keep updating their entries (see
+ * get_eo_is_incremental). Once written, an entry's payload is released so
+ * that only the metadata is kept in memory.
+ */
 typedef struct _export_object_list_gui_t {
-    GSList *entries;
+    GPtrArray *entries;
     register_eo_t* eo;
+    gchar *save_in_path;
+    GHashTable *saved_digests;  /* SHA256 of the contents of every object written */
+    gboolean all_saved;
 } export_object_list_gui_t;
 
 static GHashTable* eo_opts = NULL;
@@ -132,86 +141,107 @@ gboolean eo_tap_opt_add(const char *option_string)
     return FALSE;
 }
 
+/* Save an object under a name that doesn't exist yet in the destination
+ * directory, unless an object with the same contents was written before.
+ * The payload is released in either case. */
+static void
+eo_save_and_release_entry(export_object_list_gui_t *object_list, export_object_entry_t *entry)
+{
+    const gchar *save_in_path = object_list->save_in_path;
+    GString *safe_filename = NULL;
+    gchar *save_as_fullpath = NULL;
+    gchar *digest;
+    int count = 0;
+
+    if (!save_in_path || (!entry->payload_data && entry->payload_len)) {
+        object_list->all_saved = FALSE;
+        goto release;
+    }
+
+    digest = g_compute_checksum_for_data(G_CHECKSUM_SHA256, entry->payload_data, (gsize)entry->payload_len);
+    if (g_hash_table_contains(object_list->saved_digests, digest)) {
+        g_free(digest);
+        goto release;
+    }
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            g_snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
+        }
+        save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < 1000);
+
+    if (local_eo_save_entry(save_as_fullpath, entry)) {
+        g_hash_table_insert(object_list->saved_digests, digest, NULL);
+    } else {
+        object_list->all_saved = FALSE;
+        g_free(digest);
+    }
+    g_free(save_as_fullpath);
+
+release:
+    g_free(entry->payload_data);
+    entry->payload_data = NULL;
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    object_list->entries = g_slist_append(object_list->entries, entry);
+    g_ptr_array_add(object_list->entries, entry);
+
+    if (!get_eo_is_incremental(object_list->eo))
+        eo_save_and_release_entry(object_list, entry);
 }
 
 static export_object_entry_t*
 object_list_get_entry(void *gui_data, int row) {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    return (export_object_entry_t *)g_slist_nth_data(object_list->entries, row);
+    if (row < 0 || (guint)row >= object_list->entries->len)
+        return NULL;
+
+    return (export_object_entry_t *)g_ptr_array_index(object_list->entries, row);
 }
 
-/* This is just for writing Exported Objects to a file */
+/* Write out whatever is still pending and report failures */
 static void
 eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
     export_object_entry_t *entry;
-    gboolean all_saved = TRUE;
-    gchar* save_in_path = (gchar*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    gchar *save_as_fullpath = NULL;
-    int count = 0;
+    guint i;
 
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
+    if (get_eo_is_incremental(object_list->eo)) {
+        for (i = 0; i < object_list->entries->len; i++) {
+            entry = (export_object_entry_t *)g_ptr_array_index(object_list->entries, i);
+            eo_save_and_release_entry(object_list, entry);
         }
     }
 
-    if ((strlen(save_in_path) < EXPORT_OBJECT_MAXFILELEN)) {
-        while (slist) {
-            entry = (export_object_entry_t *)slist->data;
-            do {
-                g_free(save_as_fullpath);
-                if (entry->filename) {
-                    safe_filename = eo_massage_str(entry->filename,
-                        EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
-                } else {
-                    char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                    const char *ext;
-                    ext = eo_ct2ext(entry->content_type);
-                    g_snprintf(generic_name, sizeof(generic_name),
-                        "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                    safe_filename = eo_massage_str(generic_name,
-                        EXPORT_OBJECT_MAXFILELEN - strlen(save_in_path), count);
-                }
-                save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-                g_string_free(safe_filename, TRUE);
-            } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < 1000);
-            count = 0;
-            if (!local_eo_save_entry(save_as_fullpath, entry))
-                all_saved = FALSE;
-            g_free(save_as_fullpath);
-            save_as_fullpath = NULL;
-            slist = slist->next;
-        }
-    }
-    else
-    {
-        all_saved = FALSE;
-    }
-
-    if (!all_saved)
+    if (!object_list->all_saved)
         fprintf(stderr, "Export objects (%s): Some files could not be saved.\n",
                     proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
+    gchar *save_in_path;
     export_object_list_t *tap_data;
     export_object_list_gui_t *object_list;
     register_eo_t* eo;
@@ -223,6 +253,16 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
         return;
     }
 
+    save_in_path = (gchar*)value;
+    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
+        /* If the destination directory (or its parents) do not exist, create them. */
+        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
+            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                    save_in_path, g_strerror(errno));
+            return;
+        }
+    }
+
     tap_data = g_new0(export_object_list_t,1);
     object_list = g_new0(export_object_list_gui_t,1);
 
@@ -231,6 +271,13 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->entries = g_ptr_array_new();
+    object_list->saved_digests = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    object_list->all_saved = TRUE;
+    /* Objects can't be saved at all if the name of the directory doesn't
+     * leave room for a file name. */
+    if (strlen(save_in_path) < EXPORT_OBJECT_MAXFILELEN)
+        object_list->save_in_path = save_in_path;
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
@@ -239,6 +286,8 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     if (error_msg) {
         fprintf(stderr, "tshark: Can't register %s tap: %s\n", (const char*)key, error_msg->str);
         g_string_free(error_msg, TRUE);
+        g_ptr_array_free(object_list->entries, TRUE);
+        g_hash_table_destroy(object_list->saved_digests);
         g_free(tap_data);
         g_free(object_list);
         return;
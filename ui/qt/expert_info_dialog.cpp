@@ -138,9 +138,11 @@ void ExpertInfoDialog::retapPackets()
     clearAllData();
     removeTapListeners();
 
+    bool limit = ui->limitCheckBox->isChecked() && !display_filter_.isEmpty();
+
     if (!registerTapListener("expert",
                              expert_info_model_,
-                             ui->limitCheckBox->isChecked() ? display_filter_.toUtf8().constData(): NULL,
+                             limit ? display_filter_.toUtf8().constData(): NULL,
                              TL_REQUIRES_COLUMNS,
                              ExpertInfoModel::tapReset,
                              ExpertInfoModel::tapPacket,
@@ -148,6 +150,15 @@ void ExpertInfoDialog::retapPackets()
         return;
     }
 
+    // Without a display filter every expert info in the capture is wanted,
+    // and the first pass has already collected them. The tap listener
+    // stays registered so frames arriving during a live capture are added.
+    if (!limit) {
+        expert_info_model_->addExpertSummaries();
+        updateWidgets();
+        return;
+    }
+
     cap_file_.retapPackets();
 }
 
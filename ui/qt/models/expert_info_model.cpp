@@ -12,6 +12,10 @@
 #include <ui/qt/utils/color_utils.h>
 
 #include "file.h"
+#include "frame_tvbuff.h"
+
+#include <epan/epan_dissect.h>
+#include <epan/column.h>
 
 ExpertPacketItem::ExpertPacketItem(expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent) :
     packet_num_(expert_info.packet_num),
@@ -20,6 +24,7 @@ ExpertPacketItem::ExpertPacketItem(expert_info_t& expert_info, column_info *cinf
     hf_id_(expert_info.hf_index),
     protocol_(expert_info.protocol),
     summary_(expert_info.summary),
+    has_info_(cinfo != NULL),
     parentItem_(parent)
 {
     if (cinfo) {
@@ -94,13 +99,15 @@ ExpertInfoModel::ExpertInfoModel(CaptureFile& capture_file, QObject *parent) :
     QAbstractItemModel(parent),
     capture_file_(capture_file),
     group_by_summary_(true),
-    root_(createRootItem())
+    root_(createRootItem()),
+    info_cinfo_valid_(false)
 {
 }
 
 ExpertInfoModel::~ExpertInfoModel()
 {
     delete root_;
+    clearColInfo();
 }
 
 void ExpertInfoModel::clear()
@@ -110,6 +117,7 @@ void ExpertInfoModel::clear()
     eventCounts_.clear();
     delete root_;
     root_ = createRootItem();
+    clearColInfo();
 
     emit endResetModel();
 }
@@ -250,8 +258,11 @@ QVariant ExpertInfoModel::data(const QModelIndex &index, int role) const
     case colSummary:
         if (index.parent().isValid())
         {
-            if (group_by_summary_)
+            if (group_by_summary_) {
+                if (!item->hasColInfo())
+                    item->setColInfo(frameColInfo(item->packetNum()));
                 return item->colInfo().simplified();
+            }
 
             return item->summary().simplified();
         }
@@ -334,20 +345,25 @@ int ExpertInfoModel::columnCount(const QModelIndex& ) const
 }
 
 void ExpertInfoModel::addExpertInfo(struct expert_info_s& expert_info)
+{
+    addExpertInfo(expert_info, &(capture_file_.capFile()->cinfo));
+}
+
+void ExpertInfoModel::addExpertInfo(struct expert_info_s& expert_info, column_info *cinfo)
 {
     QString groupKey = ExpertPacketItem::groupKey(FALSE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
     QString summaryKey = ExpertPacketItem::groupKey(TRUE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
 
     ExpertPacketItem* expert_root = root_->child(groupKey);
     if (expert_root == NULL) {
-        ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), root_);
+        ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, cinfo, root_);
 
         root_->appendChild(new_item, groupKey);
 
         expert_root = new_item;
     }
 
-    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
+    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, cinfo, expert_root);
     expert_root->appendChild(expert, groupKey);
 
     //add the summary children off of the first child of the root children
@@ -356,16 +372,107 @@ void ExpertInfoModel::addExpertInfo(struct expert_info_s& expert_info)
     //make a summary child
     ExpertPacketItem* expert_summary_root = summary_root->child(summaryKey);
     if (expert_summary_root == NULL) {
-        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), summary_root);
+        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, cinfo, summary_root);
 
         summary_root->appendChild(new_summary, summaryKey);
         expert_summary_root = new_summary;
     }
 
-    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
+    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, cinfo, expert_summary_root);
     expert_summary_root->appendChild(expert_summary, summaryKey);
 }
 
+void ExpertInfoModel::summaryForeach(const expert_summary_t *summary, void *model_ptr)
+{
+    ExpertInfoModel *model = static_cast<ExpertInfoModel*>(model_ptr);
+    expert_info_t expert_info;
+
+    expert_info.group     = summary->group;
+    expert_info.severity  = summary->severity;
+    expert_info.hf_index  = summary->hf_index;
+    expert_info.protocol  = summary->protocol;
+    expert_info.summary   = (gchar *)summary->summary;
+    expert_info.pitem     = NULL;
+
+    for (guint i = 0; i < wmem_array_get_count(summary->frames); i++) {
+        expert_info.packet_num = *(guint32 *)wmem_array_index(summary->frames, i);
+        model->addExpertInfo(expert_info, NULL);
+    }
+
+    model->eventCounts_[(enum ExpertSeverity)summary->severity] += summary->count;
+}
+
+// The index lists each frame once per distinct summary, so unlike the tap a
+// frame that raises the same expert info twice gets a single row.
+void ExpertInfoModel::addExpertSummaries()
+{
+    emit beginResetModel();
+
+    eventCounts_.clear();
+    delete root_;
+    root_ = createRootItem();
+    expert_summary_foreach(summaryForeach, this);
+
+    emit endResetModel();
+}
+
+// Dissect a single frame for its Info column, see PacketListRecord::dissect.
+// This runs with a private column_info holding only COL_INFO so it neither
+// disturbs the packet list's columns nor needs a protocol tree for custom
+// columns.
+QByteArray ExpertInfoModel::frameColInfo(unsigned int packet_num) const
+{
+    capture_file *cap_file = capture_file_.capFile();
+    frame_data *fdata;
+    epan_dissect_t edt;
+    wtap_rec rec;
+    Buffer buf;
+    QByteArray info;
+
+    if (!cap_file || !cap_file->provider.frames)
+        return info;
+
+    fdata = frame_data_sequence_find(cap_file->provider.frames, packet_num);
+    if (!fdata)
+        return info;
+
+    if (!info_cinfo_valid_) {
+        col_setup(&info_cinfo_, 1);
+        info_cinfo_.columns[0].col_fmt = COL_INFO;
+        info_cinfo_.columns[0].col_title = NULL;
+        info_cinfo_.columns[0].col_fence = 0;
+        col_finalize(&info_cinfo_);
+        info_cinfo_valid_ = true;
+    }
+
+    memset(&rec, 0, sizeof rec);
+    ws_buffer_init(&buf, 1500);
+    if (!cf_read_record_r(cap_file, fdata, &rec, &buf)) {
+        ws_buffer_free(&buf);
+        return info;
+    }
+
+    epan_dissect_init(&edt, cap_file->epan, FALSE, FALSE);
+    epan_dissect_run(&edt, cap_file->cd_t, &rec,
+                     frame_tvbuff_new_buffer(&cap_file->provider, fdata, &buf),
+                     fdata, &info_cinfo_);
+    epan_dissect_fill_in_columns(&edt, FALSE, FALSE);
+    info = col_get_text(&info_cinfo_, COL_INFO);
+
+    epan_dissect_cleanup(&edt);
+    ws_buffer_free(&buf);
+
+    return info;
+}
+
+void ExpertInfoModel::clearColInfo()
+{
+    if (info_cinfo_valid_) {
+        col_cleanup(&info_cinfo_);
+        info_cinfo_valid_ = false;
+    }
+}
+
 void ExpertInfoModel::tapReset(void *eid_ptr)
 {
     ExpertInfoModel *model = static_cast<ExpertInfoModel*>(eid_ptr);
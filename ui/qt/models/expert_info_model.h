@@ -35,6 +35,9 @@ public:
     QString protocol() const { return protocol_; }
     QString summary() const { return summary_; }
     QString colInfo() const { return info_; }
+    // Items built without column info fetch it on demand.
+    bool hasColInfo() const { return has_info_; }
+    void setColInfo(const QByteArray &info) { info_ = info; has_info_ = true; }
 
     static QString groupKey(bool group_by_summary, int severity, int group, QString protocol, int expert_hf);
     QString groupKey(bool group_by_summary);
@@ -56,6 +59,7 @@ private:
     QByteArray protocol_;
     QByteArray summary_;
     QByteArray info_;
+    bool has_info_;
 
     QList<ExpertPacketItem*> childItems_;
     ExpertPacketItem* parentItem_;
@@ -110,6 +114,10 @@ public:
     // Called from tapPacket
     void addExpertInfo(struct expert_info_s& expert_info);
 
+    // Fill the model from the expert infos collected during the first
+    // pass (expert_summary_foreach()) instead of retapping the capture.
+    void addExpertSummaries();
+
     // Callbacks for register_tap_listener
     static void tapReset(void *eid_ptr);
     static gboolean tapPacket(void *eid_ptr, struct _packet_info *pinfo, struct epan_dissect *, const void *data);
@@ -119,10 +127,20 @@ private:
     CaptureFile& capture_file_;
 
     ExpertPacketItem* createRootItem();
+    void addExpertInfo(struct expert_info_s& expert_info, column_info *cinfo);
+    QByteArray frameColInfo(unsigned int packet_num) const;
+    void clearColInfo();
+
+    static void summaryForeach(const expert_summary_t *summary, void *model_ptr);
 
     bool group_by_summary_;
     ExpertPacketItem* root_;
 
+    // Info-only columns for frameColInfo. The capture file's column_info
+    // belongs to the packet list.
+    mutable column_info info_cinfo_;
+    mutable bool info_cinfo_valid_;
+
     QHash<enum ExpertSeverity, int> eventCounts_;
 };
 #endif // EXPERT_INFO_MODEL_H
@@ -164,6 +164,11 @@ struct option {
 #define ISB_USRDELIV      8
 #define ADD_PADDING(x) ((((x) + 3) >> 2) << 2)
 
+/* Packets with at most this many captured bytes are assembled into a
+   single buffer along with their record header (and trailer) and written
+   with one fwrite() call rather than one per part. */
+#define INLINE_PACKET_MAX 256
+
 /* Write to capture file */
 static gboolean
 write_to_file(FILE* pfile, const guint8* data, size_t data_length,
@@ -185,6 +190,19 @@ write_to_file(FILE* pfile, const guint8* data, size_t data_length,
         return TRUE;
 }
 
+void *
+pcapio_set_write_buffer(FILE* pfile, size_t size)
+{
+        void *buf;
+
+        buf = g_malloc(size);
+        if (setvbuf(pfile, (char *)buf, _IOFBF, size) != 0) {
+                g_free(buf);
+                return NULL;
+        }
+        return buf;
+}
+
 /* Writing pcap files */
 
 /* Write the file header to a dump file.
@@ -217,11 +235,17 @@ libpcap_write_packet(FILE* pfile,
                      guint64 *bytes_written, int *err)
 {
         struct pcaprec_hdr rec_hdr;
+        guint8 buff[sizeof(struct pcaprec_hdr) + INLINE_PACKET_MAX];
 
         rec_hdr.ts_sec = (guint32)sec; /* Y2.038K issue in pcap format.... */
         rec_hdr.ts_usec = usec;
         rec_hdr.incl_len = caplen;
         rec_hdr.orig_len = len;
+        if (caplen <= INLINE_PACKET_MAX) {
+                memcpy(buff, &rec_hdr, sizeof(rec_hdr));
+                memcpy(&buff[sizeof(rec_hdr)], pd, caplen);
+                return write_to_file(pfile, buff, sizeof(rec_hdr) + caplen, bytes_written, err);
+        }
         if (!write_to_file(pfile, (const guint8*)&rec_hdr, sizeof(rec_hdr), bytes_written, err))
                 return FALSE;
 
@@ -532,8 +556,8 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
         guint64 timestamp;
         guint32 options_length;
         const guint32 padding = 0;
-        guint8 buff[8];
-        guint8 i;
+        guint8 buff[sizeof(struct epb) + INLINE_PACKET_MAX + 8];
+        guint32 i;
         guint8 pad_len = 0;
 
         block_total_length = (guint32)(sizeof(struct epb) +
@@ -558,14 +582,28 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
         epb.timestamp_low = (guint32)(timestamp & 0xffffffff);
         epb.captured_len = caplen;
         epb.packet_len = len;
+        if(caplen % 4) {
+            pad_len = 4 - (caplen % 4);
+        }
+        /*
+         * If we have no options to write and the packet is small, write
+         * the whole block with one fwrite() call.
+         */
+        if(options_length == 0 && caplen <= INLINE_PACKET_MAX){
+            memcpy(buff, &epb, sizeof(struct epb));
+            i = sizeof(struct epb);
+            memcpy(&buff[i], pd, caplen);
+            i += caplen;
+            memset(&buff[i], 0, pad_len);
+            i += pad_len;
+            memcpy(&buff[i], &block_total_length, sizeof(guint32));
+            i += sizeof(guint32);
+            return write_to_file(pfile, buff, i, bytes_written, err);
+        }
         if (!write_to_file(pfile, (const guint8*)&epb, sizeof(struct epb), bytes_written, err))
                 return FALSE;
         if (!write_to_file(pfile, pd, caplen, bytes_written, err))
                 return FALSE;
-        /* Use more efficient write in case of no "extras" */
-        if(caplen % 4) {
-            pad_len = 4 - (caplen % 4);
-        }
         /*
          * If we have no options to write, just write out the padding and
          * the block total length with one fwrite() call.
@@ -11,6 +11,21 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+/** Size of the write buffer that dumpcap gives to its capture files */
+#define PCAPIO_WRITE_BUFFER_SIZE (1024 * 1024)
+
+/** Replace the stdio buffer of a freshly opened capture file with one of
+   the given size, so that the file is written in few large writes instead
+   of writes of the default stdio buffer size (often only a few KiB).
+   This is how pcapio batches writes: the buffer is written out once it
+   holds size bytes, and callers fflush() it to bound how long packets
+   stay in it (dumpcap does so every DUMPCAP_UPD_TIME milliseconds).
+   Must be called before anything is read from or written to pfile.
+   Returns the buffer, which must be g_free()d only after pfile has been
+   closed, or NULL if the buffer could not be replaced. */
+extern void *
+pcapio_set_write_buffer(FILE* pfile, size_t size);
+
 /* Writing pcap files */
 
 /** Write the file header to a dump file.